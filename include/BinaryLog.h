@@ -0,0 +1,447 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include "FixedFormat.h"
+
+/**
+ * @file BinaryLog.h
+ * @brief 固定長レコードのバイナリログ形式（自己記述ヘッダ + CRC 付きブロック）
+ *
+ * @details
+ * CSV 1 行（約 60〜70 バイト）は状態を文字列で、アラームを true / false で
+ * 繰り返し書き、%f 6 個の snprintf を伴う。バイナリ形式では 1 レコード
+ * 20 バイトの整数に詰め、整形はホスト側（tools/logconv.cpp）で行う。
+ *
+ * 【ファイル構成】（すべてリトルエンディアン、512 バイト = 1 セクタ単位）
+ * - ファイルヘッダ（512B）: マジック "STLOGBIN"・スキーマ版数・サンプル周期・
+ *   閾値・ファームウェア識別・CSV 列名。末尾 4 バイトが CRC-32
+ * - ブロック（512B）× n : 12B のブロックヘッダ + ペイロード 500B
+ *     [0] 0xB1 / [1] 種別（DATA / TEXT）/ [2..3] 件数 / [4..7] ブロック番号 /
+ *     [8..11] CRC-32（ヘッダ 8B + ペイロード全体）
+ *   - DATA: レコード最大 25 件（20B × 25 = 500B、余りはゼロ埋め）
+ *   - TEXT: '#' で始まるフッタ行（CSV と同じ内容）を件数バイト分
+ *   - DELTA: 差分符号化した温度系列（DeltaCodec.h）、件数はサンプル数
+ *
+ * ヘッダの encoding が ENCODING_RECORDS なら DATA ブロック（固定長レコード）、
+ * ENCODING_DELTA なら DELTA ブロック（値の量子化幅 = quantumMilliC）で記録する。
+ * ENCODING_RAW は生データ記録（RawCapture.h）で、DELTA ブロックのフラグに故障コードを入れる。
+ * ヘッダの validBytes は事前確保したファイルの実データ長（LogPrealloc.h）で、
+ * RUN 中は同期ごとに更新される（closed はクローズ時に 1）。それ以降の領域は未使用（不定値）として読まない。
+ *
+ * 【レコード】（20B）
+ *   u32 経過時間 [ms]（schema 1 は経過秒）/ u32 サンプル数 / i16 温度・平均・標準偏差・最高・最低 [0.1°C] /
+ *   u8 状態 / u8 フラグ（bit0 = HI_ALARM, bit1 = LO_ALARM）
+ * 温度は CSV の %.1f と同じ規則（最近接・同値は偶数側）で 0.1°C に量子化し、
+ * NaN は NAN_DECI（-32768）で表す。
+ * schema 2 から行は「新しいセンサ値」ごと（間隔不定）のため、経過時間を ms で持つ。
+ * decodeRecord() は schema 1 のファイルも ms に換算して読む。
+ *
+ * ブロック単位の CRC のため、破損は 512B 以内に局所化される（変換ツールは
+ * 壊れたブロックだけを飛ばす）。全ゼロのブロックは「未使用（ファイル終端）」。
+ */
+
+/**
+ * @brief ファイルヘッダの内容
+ */
+struct BinLogHeader {
+  uint16_t schemaVersion;     // レコード形式の版数
+  uint32_t samplePeriodMs;    // レコード間隔（公称値）[ms]
+  int16_t  hiThresholdDeci;   // RUN 開始時の上限アラーム閾値 [0.1°C]
+  int16_t  loThresholdDeci;   // RUN 開始時の下限アラーム閾値 [0.1°C]
+  char     firmware[32];      // ファームウェア識別（版数・ビルド日時）
+  char     columns[128];      // CSV 列名（変換時のヘッダ行、改行無し）
+  uint8_t  encoding;          // ENCODING_RECORDS / ENCODING_DELTA / ENCODING_RAW
+  uint16_t quantumMilliC;     // DELTA の値 1 単位 [m°C]（RECORDS では 100 固定）
+  uint32_t validBytes;        // 有効長マーカー（0 = 不明、ファイル末尾まで読む）
+  uint8_t  closed;            // 1 = 正常にクローズ済み（0 のまま残ったファイルは起動時に復旧）
+};
+
+/**
+ * @brief 1 レコード（CSV 1 行に相当）
+ */
+struct BinLogRecord {
+  uint32_t elapsedMs;     // RUN 開始からの経過時間 [ms]
+  uint32_t sampleCount;
+  int16_t  temperature;   // [0.1°C]、NaN は NAN_DECI
+  int16_t  average;
+  int16_t  stdDev;
+  int16_t  maxTemp;
+  int16_t  minTemp;
+  uint8_t  state;         // enum class State の数値
+  uint8_t  flags;         // FLAG_HI_ALARM | FLAG_LO_ALARM
+};
+
+class BinaryLog {
+public:
+  static constexpr uint16_t SCHEMA_VERSION      = 2;   // 2: 経過時間を ms で記録
+  static constexpr size_t   HEADER_SIZE         = 512;
+  static constexpr size_t   BLOCK_SIZE          = 512;
+  static constexpr size_t   BLOCK_HEADER_SIZE   = 12;
+  static constexpr size_t   PAYLOAD_SIZE        = BLOCK_SIZE - BLOCK_HEADER_SIZE;
+  static constexpr size_t   RECORD_SIZE         = 20;
+  static constexpr size_t   RECORDS_PER_BLOCK   = PAYLOAD_SIZE / RECORD_SIZE;
+  static constexpr uint8_t  BLOCK_MAGIC         = 0xB1;
+  static constexpr uint8_t  BLOCK_DATA          = 1;
+  static constexpr uint8_t  BLOCK_TEXT          = 2;
+  static constexpr uint8_t  BLOCK_DELTA         = 3;
+  static constexpr uint8_t  ENCODING_RECORDS    = 0;
+  static constexpr uint8_t  ENCODING_DELTA      = 1;
+  static constexpr uint8_t  ENCODING_RAW        = 2;   // DELTA ブロック + 故障コード（RawCapture.h）
+  static constexpr uint8_t  FLAG_HI_ALARM       = 0x01;
+  static constexpr uint8_t  FLAG_LO_ALARM       = 0x02;
+  static constexpr int16_t  NAN_DECI            = -32768;
+  static constexpr uint8_t  STATE_UNKNOWN       = 0xFF;
+
+  /**
+   * @brief ブロック検査の結果
+   */
+  enum class BlockStatus : uint8_t {
+    OK,       // 正常
+    EMPTY,    // 全ゼロ（未使用領域 = ファイル終端）
+    CORRUPT   // マジック・件数・CRC のいずれかが不正
+  };
+
+  // ── CRC-32（IEEE 802.3、反射、初期値・最終 XOR 0xFFFFFFFF）────────────────
+
+  /**
+   * @brief CRC-32 の逐次計算
+   * @param crc 前回の戻り値（初回は 0）
+   */
+  static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    const uint32_t* table = crcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+      crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+  }
+
+  // ── リトルエンディアンの読み書き（索引・カタログ・カード情報のファイルも共通）──
+
+  static void put16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+  }
+  static void put32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+  }
+  static uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+  }
+  static uint32_t get32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+  }
+
+  // ── 量子化 ────────────────────────────────────────────────────────────────
+
+  /**
+   * @brief °C → 0.1°C 整数（%.1f と同じ丸め、NaN は NAN_DECI、範囲外は飽和）
+   */
+  static int16_t toDeci(float celsius) {
+    if (std::isnan(celsius)) return NAN_DECI;
+    // float × 10 は double で誤差無く表せるため、rint（最近接偶数）で
+    // printf("%.1f") の丸めと一致する
+    const double scaled = std::rint(static_cast<double>(celsius) * 10.0);
+    if (scaled >  32767.0) return  32767;
+    if (scaled < -32767.0) return -32767;
+    return static_cast<int16_t>(scaled);
+  }
+
+  /**
+   * @brief 状態文字列 → 数値（SDData::state 用。未知は STATE_UNKNOWN）
+   */
+  static uint8_t stateCode(const char* name) {
+    if (name == nullptr) return STATE_UNKNOWN;
+    for (uint8_t i = 0; i < STATE_COUNT; ++i) {
+      if (strcmp(name, stateName(i)) == 0) return i;
+    }
+    return STATE_UNKNOWN;
+  }
+
+  /**
+   * @brief 状態数値 → 文字列（enum class State の順）
+   */
+  static const char* stateName(uint8_t code) {
+    static const char* const names[STATE_COUNT] = {"IDLE", "RUN", "RESULT", "ALARM_SETTING"};
+    return (code < STATE_COUNT) ? names[code] : "?";
+  }
+
+  // ── エンコード（デバイス側）───────────────────────────────────────────────
+
+  /**
+   * @brief ファイルヘッダを 512B に整形（CRC 付き）
+   */
+  static void encodeHeader(const BinLogHeader& h, uint8_t* out) {
+    memset(out, 0, HEADER_SIZE);
+    memcpy(out, fileMagic(), 8);
+    put16(out + 8, h.schemaVersion);
+    put16(out + 10, static_cast<uint16_t>(HEADER_SIZE));
+    put16(out + 12, static_cast<uint16_t>(BLOCK_SIZE));
+    put16(out + 14, static_cast<uint16_t>(RECORD_SIZE));
+    put32(out + 16, h.samplePeriodMs);
+    put16(out + 20, static_cast<uint16_t>(h.hiThresholdDeci));
+    put16(out + 22, static_cast<uint16_t>(h.loThresholdDeci));
+    copyString(reinterpret_cast<char*>(out + 24), sizeof(h.firmware), h.firmware);
+    copyString(reinterpret_cast<char*>(out + 56), sizeof(h.columns), h.columns);
+    out[184] = h.encoding;
+    put16(out + 186, h.quantumMilliC);
+    put32(out + 188, h.validBytes);
+    out[192] = h.closed;
+    put32(out + HEADER_SIZE - 4, crc32(0, out, HEADER_SIZE - 4));
+  }
+
+  /**
+   * @brief レコードを 20B に整形
+   */
+  static void encodeRecord(const BinLogRecord& r, uint8_t* out) {
+    put32(out + 0, r.elapsedMs);
+    put32(out + 4, r.sampleCount);
+    put16(out + 8,  static_cast<uint16_t>(r.temperature));
+    put16(out + 10, static_cast<uint16_t>(r.average));
+    put16(out + 12, static_cast<uint16_t>(r.stdDev));
+    put16(out + 14, static_cast<uint16_t>(r.maxTemp));
+    put16(out + 16, static_cast<uint16_t>(r.minTemp));
+    out[18] = r.state;
+    out[19] = r.flags;
+  }
+
+  /**
+   * @brief ブロックヘッダ（番号・CRC）を書き込んで 512B のブロックを完成させる
+   * @param block ペイロード（BLOCK_HEADER_SIZE 以降）を書き込み済みの 512B
+   */
+  static void sealBlock(uint8_t* block, uint8_t type, uint16_t count, uint32_t seq) {
+    block[0] = BLOCK_MAGIC;
+    block[1] = type;
+    put16(block + 2, count);
+    put32(block + 4, seq);
+    put32(block + 8, blockCrc(block));
+  }
+
+  /**
+   * @brief TEXT ブロックを作成（len は PAYLOAD_SIZE 以下）
+   */
+  static void encodeTextBlock(const char* text, size_t len, uint32_t seq, uint8_t* block) {
+    if (len > PAYLOAD_SIZE) len = PAYLOAD_SIZE;
+    memset(block, 0, BLOCK_SIZE);
+    memcpy(block + BLOCK_HEADER_SIZE, text, len);
+    sealBlock(block, BLOCK_TEXT, static_cast<uint16_t>(len), seq);
+  }
+
+  // ── デコード（ホスト側・テスト）───────────────────────────────────────────
+
+  /**
+   * @brief ファイルヘッダの解析
+   * @return false: マジック・寸法・CRC のいずれかが不正、または未対応の版数
+   */
+  static bool decodeHeader(const uint8_t* in, BinLogHeader& h) {
+    if (memcmp(in, fileMagic(), 8) != 0) return false;
+    if (get32(in + HEADER_SIZE - 4) != crc32(0, in, HEADER_SIZE - 4)) return false;
+    if (get16(in + 10) != HEADER_SIZE || get16(in + 12) != BLOCK_SIZE ||
+        get16(in + 14) != RECORD_SIZE) {
+      return false;
+    }
+    h.schemaVersion   = get16(in + 8);
+    h.samplePeriodMs  = get32(in + 16);
+    h.hiThresholdDeci = static_cast<int16_t>(get16(in + 20));
+    h.loThresholdDeci = static_cast<int16_t>(get16(in + 22));
+    copyString(h.firmware, sizeof(h.firmware), reinterpret_cast<const char*>(in + 24));
+    copyString(h.columns, sizeof(h.columns), reinterpret_cast<const char*>(in + 56));
+    h.encoding      = in[184];
+    h.quantumMilliC = get16(in + 186);
+    h.validBytes    = get32(in + 188);
+    h.closed        = in[192];
+    if (h.encoding == ENCODING_RECORDS && h.quantumMilliC == 0) h.quantumMilliC = 100;
+    return h.schemaVersion >= 1 && h.schemaVersion <= SCHEMA_VERSION &&
+           (h.encoding == ENCODING_RECORDS || h.encoding == ENCODING_DELTA ||
+            h.encoding == ENCODING_RAW);
+  }
+
+  /**
+   * @brief ブロックの検査
+   * @param type  [out] 種別
+   * @param count [out] 件数（DATA はレコード数、TEXT はバイト数）
+   * @param seq   [out] ブロック番号
+   */
+  static BlockStatus checkBlock(const uint8_t* block, uint8_t& type, uint16_t& count,
+                                uint32_t& seq) {
+    if (block[0] != BLOCK_MAGIC) {
+      for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        if (block[i] != 0) return BlockStatus::CORRUPT;
+      }
+      return BlockStatus::EMPTY;
+    }
+    type  = block[1];
+    count = get16(block + 2);
+    seq   = get32(block + 4);
+    if (get32(block + 8) != blockCrc(block)) return BlockStatus::CORRUPT;
+    if (type == BLOCK_DATA && count <= RECORDS_PER_BLOCK) return BlockStatus::OK;
+    if (type == BLOCK_TEXT && count <= PAYLOAD_SIZE) return BlockStatus::OK;
+    if (type == BLOCK_DELTA && count <= PAYLOAD_SIZE * 8) return BlockStatus::OK;
+    return BlockStatus::CORRUPT;
+  }
+
+  /**
+   * @brief 20B からレコードを復元
+   * @param schemaVersion ファイルヘッダの版数（1 は経過秒のため ms に換算）
+   */
+  static void decodeRecord(const uint8_t* in, BinLogRecord& r,
+                           uint16_t schemaVersion = SCHEMA_VERSION) {
+    r.elapsedMs      = get32(in + 0);
+    if (schemaVersion < 2) r.elapsedMs *= 1000UL;
+    r.sampleCount    = get32(in + 4);
+    r.temperature    = static_cast<int16_t>(get16(in + 8));
+    r.average        = static_cast<int16_t>(get16(in + 10));
+    r.stdDev         = static_cast<int16_t>(get16(in + 12));
+    r.maxTemp        = static_cast<int16_t>(get16(in + 14));
+    r.minTemp        = static_cast<int16_t>(get16(in + 16));
+    r.state          = in[18];
+    r.flags          = in[19];
+  }
+
+  /**
+   * @brief レコードを CSV 1 行（CRLF 付き）に整形
+   *
+   * @details
+   * SDManager::formatCSVLine() と同じ列・同じ NaN 規則
+   * （温度が NaN なら統計列もすべて NaN、温度が数値なら NaN の統計列は 0.0）。
+   * printf を使わない（FixedFormat）ため、ホスト側で大量のレコードを高速に変換できる。
+   *
+   * @param buf    112 バイト以上
+   * @param withMs 末尾に ElapsedMs 列を付ける（schema 1 のファイルは列名に無いため false）
+   * @return 書き込んだ文字数（終端 '\0' を除く）
+   */
+  static size_t formatCsvRow(const BinLogRecord& r, char* buf, bool withMs = true) {
+    char* p = buf;
+    p = FixedFormat::putUint(p, r.elapsedMs / 1000UL);
+    *p++ = ',';
+    const bool tempNan = (r.temperature == NAN_DECI);
+    p = putDeci(p, r.temperature, tempNan);
+    *p++ = ',';
+    p = FixedFormat::putStr(p, stateName(r.state));
+    *p++ = ',';
+    p = FixedFormat::putUint(p, r.sampleCount);
+    const int16_t stats[4] = {r.average, r.stdDev, r.maxTemp, r.minTemp};
+    for (int i = 0; i < 4; ++i) {
+      *p++ = ',';
+      p = putDeci(p, (stats[i] == NAN_DECI) ? 0 : stats[i], tempNan);
+    }
+    *p++ = ',';
+    p = FixedFormat::putBool(p, (r.flags & FLAG_HI_ALARM) != 0);
+    *p++ = ',';
+    p = FixedFormat::putBool(p, (r.flags & FLAG_LO_ALARM) != 0);
+    if (withMs) {
+      *p++ = ',';
+      p = FixedFormat::putUint(p, r.elapsedMs);
+    }
+    *p++ = '\r';
+    *p++ = '\n';
+    *p   = '\0';
+    return static_cast<size_t>(p - buf);
+  }
+
+private:
+  static constexpr uint8_t STATE_COUNT = 4;
+
+  static const char* fileMagic() { return "STLOGBIN"; }
+
+  struct CrcTable {
+    uint32_t v[256];
+    CrcTable() {
+      for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1u) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+        v[i] = c;
+      }
+    }
+  };
+
+  /**
+   * @details 制御タスク（カタログ読み込み）と SDWriter タスクの両方から呼ばれるため、
+   *          関数内 static の初期化（初回に 1 回だけ、完了まで他方を待たせる）で生成する（1KB）
+   */
+  static const uint32_t* crcTable() {
+    static const CrcTable table;
+    return table.v;
+  }
+
+  static uint32_t blockCrc(const uint8_t* block) {
+    const uint32_t crc = crc32(0, block, 8);
+    return crc32(crc, block + BLOCK_HEADER_SIZE, PAYLOAD_SIZE);
+  }
+
+  static void copyString(char* dst, size_t dstLen, const char* src) {
+    size_t i = 0;
+    for (; i + 1 < dstLen && src[i] != '\0'; ++i) dst[i] = src[i];
+    for (; i < dstLen; ++i) dst[i] = '\0';
+  }
+
+  static char* putDeci(char* p, int16_t deci, bool nan) {
+    return nan ? FixedFormat::putStr(p, "NaN") : FixedFormat::putFixed(p, deci, 1);
+  }
+};
+
+/**
+ * @brief DATA ブロック 1 個分の組み立てバッファ（デバイス側、512B）
+ *
+ * @details
+ * add() でレコードを詰め、満杯（または RUN 終了時の途中ブロック）で seal() した
+ * 512B をそのまま SectorWriter へ渡す。ブロックがセクタと同じ大きさのため、
+ * ファイル上のブロック境界は常にセクタ境界と一致する。
+ */
+class BinLogBlock {
+public:
+  BinLogBlock() { reset(0); }
+
+  /**
+   * @brief 空にしてブロック番号を設定（新しいファイルの開始時）
+   */
+  void reset(uint32_t seq) {
+    m_seq   = seq;
+    m_count = 0;
+    memset(m_buf, 0, sizeof(m_buf));
+  }
+
+  /**
+   * @brief レコードを追加
+   * @return true: 満杯になった（seal() して書き出すこと）
+   */
+  bool add(const BinLogRecord& r) {
+    if (m_count >= BinaryLog::RECORDS_PER_BLOCK) return true;
+    BinaryLog::encodeRecord(r, m_buf + BinaryLog::BLOCK_HEADER_SIZE +
+                                   m_count * BinaryLog::RECORD_SIZE);
+    ++m_count;
+    return m_count == BinaryLog::RECORDS_PER_BLOCK;
+  }
+
+  /**
+   * @brief ブロックヘッダ・CRC を書いて完成した 512B を返し、次のブロックへ進む
+   * @details 戻り値のバッファは次の add() まで有効
+   */
+  const uint8_t* seal() {
+    BinaryLog::sealBlock(m_buf, BinaryLog::BLOCK_DATA, m_count, m_seq);
+    memcpy(m_out, m_buf, sizeof(m_out));
+    reset(m_seq + 1);
+    return m_out;
+  }
+
+  uint16_t count() const { return m_count; }
+  bool     empty() const { return m_count == 0; }
+
+  /**
+   * @brief 次に seal() するブロックの番号
+   */
+  uint32_t seq() const { return m_seq; }
+
+private:
+  alignas(4) uint8_t m_buf[BinaryLog::BLOCK_SIZE];   // 組み立て中
+  alignas(4) uint8_t m_out[BinaryLog::BLOCK_SIZE];   // seal() 済み（書き出し用）
+  uint32_t m_seq;
+  uint16_t m_count;
+};
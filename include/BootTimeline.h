@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstddef>
+
+/**
+ * @file BootTimeline.h
+ * @brief 起動シーケンスの段階別所要時間の記録と 1 行サマリの整形
+ *
+ * @details
+ * 起動は「setup() 内で同期的に済ませる段階」と「タスク起動後に並行して
+ * 進む段階（センサ初回サンプル、SD マウント）」に分かれるため、各段階の
+ * 開始・終了時刻（millis()、リセット起点）を個別に保持する。
+ *
+ * 出力例:
+ *   [BOOT] pre_setup=312ms hardware=185ms eeprom=3ms tasks=1ms
+ *          first_sample=96ms sd_mount=241ms ready=742ms
+ *
+ * 失敗した段階は `first_sample=3000ms(timeout)` / `sd_mount=120ms(fail)` と表示。
+ */
+
+/**
+ * @brief 起動段階
+ */
+enum class BootStage : uint8_t {
+  HARDWARE,      // M5.begin()・シリアル・LCD 初期化
+  EEPROM,        // アラーム設定ロード
+  TASKS,         // SPI・バス排他の初期化（タスク生成直前まで）
+  FIRST_SAMPLE,  // IO コアが初回の有効サンプルを公開するまで（並行）
+  SD_MOUNT,      // SD マウント（制御コア、並行）
+  COUNT
+};
+
+class BootTimeline {
+public:
+  static constexpr uint8_t STAGES = static_cast<uint8_t>(BootStage::COUNT);
+
+  BootTimeline() : m_setupStartMs(0) {
+    for (uint8_t i = 0; i < STAGES; ++i) {
+      m_stages[i].startMs = 0;
+      m_stages[i].endMs   = 0;
+      m_stages[i].done    = false;
+      m_stages[i].ok      = false;
+    }
+  }
+
+  /**
+   * @brief setup() 開始時刻（= リセットからアプリ開始までの時間）を記録
+   */
+  void begin(uint32_t nowMs) { m_setupStartMs = nowMs; }
+
+  /**
+   * @brief 段階の開始を記録
+   */
+  void start(BootStage stage, uint32_t nowMs) {
+    Stage& s = m_stages[index(stage)];
+    s.startMs = nowMs;
+    s.done    = false;
+  }
+
+  /**
+   * @brief 段階の完了を記録
+   * @param ok false ならタイムアウト・失敗として表示
+   */
+  void finish(BootStage stage, uint32_t nowMs, bool ok = true) {
+    Stage& s = m_stages[index(stage)];
+    s.endMs = nowMs;
+    s.done  = true;
+    s.ok    = ok;
+  }
+
+  bool isDone(BootStage stage) const { return m_stages[index(stage)].done; }
+  bool isOk(BootStage stage) const { return m_stages[index(stage)].ok; }
+
+  /**
+   * @brief 全段階が完了（成否は問わない）したか
+   */
+  bool allDone() const {
+    for (uint8_t i = 0; i < STAGES; ++i) {
+      if (!m_stages[i].done) return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief 段階の所要時間 [ms]（未完了なら 0）
+   */
+  uint32_t durationMs(BootStage stage) const {
+    const Stage& s = m_stages[index(stage)];
+    return s.done ? (s.endMs - s.startMs) : 0;
+  }
+
+  /**
+   * @brief 全段階が完了した時刻 [ms]（リセット起点）
+   */
+  uint32_t readyAtMs() const {
+    uint32_t latest = m_setupStartMs;
+    for (uint8_t i = 0; i < STAGES; ++i) {
+      if (m_stages[i].done && m_stages[i].endMs > latest) latest = m_stages[i].endMs;
+    }
+    return latest;
+  }
+
+  /**
+   * @brief 1 行サマリを整形（改行無し）
+   * @return 書き込んだ文字数（切り詰め時は len-1）
+   */
+  size_t format(char* buf, size_t len) const {
+    if (buf == nullptr || len == 0) return 0;
+    size_t pos = 0;
+    append(buf, len, pos, "[BOOT] pre_setup=%lums", (unsigned long)m_setupStartMs);
+    for (uint8_t i = 0; i < STAGES; ++i) {
+      const Stage& s = m_stages[i];
+      const BootStage stage = static_cast<BootStage>(i);
+      if (!s.done) {
+        append(buf, len, pos, " %s=pending", stageName(stage));
+      } else {
+        append(buf, len, pos, " %s=%lums%s", stageName(stage),
+               (unsigned long)(s.endMs - s.startMs), s.ok ? "" : failSuffix(stage));
+      }
+    }
+    append(buf, len, pos, " ready=%lums", (unsigned long)readyAtMs());
+    return pos;
+  }
+
+  static const char* stageName(BootStage stage) {
+    switch (stage) {
+      case BootStage::HARDWARE:     return "hardware";
+      case BootStage::EEPROM:       return "eeprom";
+      case BootStage::TASKS:        return "tasks";
+      case BootStage::FIRST_SAMPLE: return "first_sample";
+      case BootStage::SD_MOUNT:     return "sd_mount";
+      default:                      return "?";
+    }
+  }
+
+private:
+  struct Stage {
+    uint32_t startMs;
+    uint32_t endMs;
+    bool     done;
+    bool     ok;
+  };
+
+  static uint8_t index(BootStage stage) {
+    const uint8_t i = static_cast<uint8_t>(stage);
+    return (i < STAGES) ? i : 0;
+  }
+
+  static const char* failSuffix(BootStage stage) {
+    return (stage == BootStage::FIRST_SAMPLE) ? "(timeout)" : "(fail)";
+  }
+
+  template <typename... Args>
+  static void append(char* buf, size_t len, size_t& pos, const char* fmt, Args... args) {
+    if (pos + 1 >= len) return;
+    const int n = snprintf(buf + pos, len - pos, fmt, args...);
+    if (n <= 0) return;
+    pos += static_cast<size_t>(n);
+    if (pos > len - 1) pos = len - 1;
+  }
+
+  uint32_t m_setupStartMs;
+  Stage    m_stages[STAGES];
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include "BinaryLog.h"
+
+/**
+ * @file CardProfile.h
+ * @brief SD カードの性能プロファイル（マウント時の自己ベンチマーク結果と同期方針の選択）
+ *
+ * @details
+ * 同じファームウェアでも、カードによって 1 回の書き込み + flush() が数 ms で
+ * 終わるものと数百 ms 止まるものがある。マウント時に一時ファイルへブロック長を
+ * 変えて書き込み・読み出しを行い、ブロック長ごとの転送速度と書き込みレイテンシ
+ * （p50 / p99 / max）を測って、ロガーの同期方針を決める。
+ *
+ * 【同期方針の選択（tune()）】
+ * - 同期バイト数: 最速の書き込み速度の throughputPct % 以上が出る最小のブロック長
+ *   （1 回の同期で書く量。小さいほど電源断時の損失が少ない）
+ * - 同期間隔   : 選んだブロック長の p99 × syncDutyDiv（同期に費やす時間を
+ *   1 / syncDutyDiv 以下にする）。遅いカードほど間隔を延ばす
+ * いずれも Limits の範囲に収める。
+ *
+ * 【判定（grade）】
+ * 最大レイテンシが badLatencyUs を超える、または最速でも minWriteKBps に届かない
+ * カードは BAD とし、ログに残す（機種の使用禁止リスト作成用）。
+ *
+ * 【保存形式】（144B、リトルエンディアン）
+ * - [0..3]   マジック "CPRF" / [4] 版数 / [5] カード種別 / [6] 結果数 / [7] 判定
+ * - [8..11]  容量 [512B セクタ]（[5] と合わせてカードの識別に使う）
+ * - [12..15] 同期バイト数 / [16..19] 同期間隔 [ms]
+ * - [20..139] ブロック長ごとの結果 × MAX_RESULTS（各 24B）
+ * - [140..143] CRC-32（先頭 140B）
+ */
+
+/**
+ * @brief マウント時の計測をいつ行うか
+ */
+enum class CardProfileMode : uint8_t {
+  OFF,      // 計測しない（Global.h の同期方針のまま）
+  CACHED,   // 保存済みプロファイルが同じカードのものなら再利用
+  ALWAYS,   // 毎回計測
+};
+
+/**
+ * @brief 1 ブロック長ぶんの計測結果
+ */
+struct CardBlockResult {
+  uint32_t blockBytes;
+  uint32_t writeKBps;    // write() + flush() を含む書き込み速度
+  uint32_t readKBps;
+  uint32_t writeP50Us;   // 1 ブロックの write() + flush()
+  uint32_t writeP99Us;
+  uint32_t writeMaxUs;
+};
+
+class CardProfile {
+public:
+  static constexpr uint8_t VERSION     = 1;
+  static constexpr size_t  RECORD_SIZE = 144;
+  static constexpr uint8_t MAX_RESULTS = 5;
+
+  static constexpr uint8_t GRADE_OK   = 0;
+  static constexpr uint8_t GRADE_SLOW = 1;   // 同期間隔を既定より延ばした
+  static constexpr uint8_t GRADE_BAD  = 2;
+
+  /**
+   * @brief 計測するブロック長（512B 〜 8KB）
+   */
+  static uint32_t blockSize(uint8_t i) { return 512UL << i; }
+
+  /**
+   * @brief 同期方針の選択範囲と判定基準
+   */
+  struct Limits {
+    uint32_t minSyncBytes;
+    uint32_t maxSyncBytes;
+    uint32_t minIntervalMs;
+    uint32_t maxIntervalMs;
+    uint32_t defaultIntervalMs;   // これを超えたら GRADE_SLOW
+    uint32_t throughputPct;
+    uint32_t syncDutyDiv;
+    uint32_t badLatencyUs;
+    uint32_t minWriteKBps;
+  };
+
+  uint8_t         cardType       = 0;
+  uint32_t        sectors        = 0;
+  uint8_t         count          = 0;
+  uint8_t         grade          = GRADE_OK;
+  uint32_t        syncBytes      = 0;
+  uint32_t        syncIntervalMs = 0;
+  CardBlockResult results[MAX_RESULTS] = {};
+
+  /**
+   * @brief 同じカード（種別・容量）の結果か
+   */
+  bool matches(uint8_t type, uint32_t sectorCount) const {
+    return count > 0 && cardType == type && sectors == sectorCount;
+  }
+
+  /**
+   * @brief 計測結果から同期方針と判定を決める
+   */
+  void tune(const Limits& lim) {
+    uint32_t best   = 0;
+    uint32_t maxLat = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+      if (results[i].writeKBps > best) best = results[i].writeKBps;
+      if (results[i].writeMaxUs > maxLat) maxLat = results[i].writeMaxUs;
+    }
+
+    const CardBlockResult* chosen = nullptr;
+    for (uint8_t i = 0; i < count && chosen == nullptr; ++i) {
+      if (static_cast<uint64_t>(results[i].writeKBps) * 100 >=
+          static_cast<uint64_t>(best) * lim.throughputPct) {
+        chosen = &results[i];
+      }
+    }
+
+    syncBytes      = clamp(chosen ? chosen->blockBytes : lim.minSyncBytes,
+                           lim.minSyncBytes, lim.maxSyncBytes);
+    const uint64_t intervalUs = chosen ? static_cast<uint64_t>(chosen->writeP99Us) * lim.syncDutyDiv : 0;
+    syncIntervalMs = clamp(static_cast<uint32_t>(intervalUs / 1000), lim.minIntervalMs,
+                           lim.maxIntervalMs);
+
+    if (count == 0 || maxLat > lim.badLatencyUs || best < lim.minWriteKBps) {
+      grade = GRADE_BAD;
+    } else if (syncIntervalMs > lim.defaultIntervalMs) {
+      grade = GRADE_SLOW;
+    } else {
+      grade = GRADE_OK;
+    }
+  }
+
+  static const char* gradeName(uint8_t g) {
+    return (g == GRADE_OK) ? "OK" : (g == GRADE_SLOW) ? "SLOW" : "BAD";
+  }
+
+  // ── エンコード / デコード ────────────────────────────────────────────────
+
+  void encode(uint8_t* out) const {
+    memset(out, 0, RECORD_SIZE);
+    memcpy(out, magic(), 4);
+    out[4] = VERSION;
+    out[5] = cardType;
+    out[6] = count;
+    out[7] = grade;
+    BinaryLog::put32(out + 8, sectors);
+    BinaryLog::put32(out + 12, syncBytes);
+    BinaryLog::put32(out + 16, syncIntervalMs);
+    for (uint8_t i = 0; i < count && i < MAX_RESULTS; ++i) {
+      uint8_t* p = out + 20 + i * 24;
+      BinaryLog::put32(p, results[i].blockBytes);
+      BinaryLog::put32(p + 4, results[i].writeKBps);
+      BinaryLog::put32(p + 8, results[i].readKBps);
+      BinaryLog::put32(p + 12, results[i].writeP50Us);
+      BinaryLog::put32(p + 16, results[i].writeP99Us);
+      BinaryLog::put32(p + 20, results[i].writeMaxUs);
+    }
+    BinaryLog::put32(out + 140, BinaryLog::crc32(0, out, 140));
+  }
+
+  /**
+   * @return false : マジック・版数・CRC のいずれかが不正
+   */
+  bool decode(const uint8_t* in) {
+    if (memcmp(in, magic(), 4) != 0 || in[4] != VERSION || in[6] > MAX_RESULTS ||
+        BinaryLog::get32(in + 140) != BinaryLog::crc32(0, in, 140)) {
+      return false;
+    }
+    cardType       = in[5];
+    count          = in[6];
+    grade          = in[7];
+    sectors        = BinaryLog::get32(in + 8);
+    syncBytes      = BinaryLog::get32(in + 12);
+    syncIntervalMs = BinaryLog::get32(in + 16);
+    for (uint8_t i = 0; i < MAX_RESULTS; ++i) {
+      const uint8_t* p = in + 20 + i * 24;
+      results[i].blockBytes = BinaryLog::get32(p);
+      results[i].writeKBps  = BinaryLog::get32(p + 4);
+      results[i].readKBps   = BinaryLog::get32(p + 8);
+      results[i].writeP50Us = BinaryLog::get32(p + 12);
+      results[i].writeP99Us = BinaryLog::get32(p + 16);
+      results[i].writeMaxUs = BinaryLog::get32(p + 20);
+    }
+    return true;
+  }
+
+  // ── 記録用の文字列 ───────────────────────────────────────────────────────
+
+  /**
+   * @brief 1 ブロック長ぶんの結果（"block=4096 w_kBps=812 r_kBps=1650 p50_us=... "）
+   */
+  static int formatResult(const CardBlockResult& r, char* out, size_t len) {
+    return snprintf(out, len, "block=%lu w_kBps=%lu r_kBps=%lu p50_us=%lu p99_us=%lu max_us=%lu",
+                    static_cast<unsigned long>(r.blockBytes), static_cast<unsigned long>(r.writeKBps),
+                    static_cast<unsigned long>(r.readKBps), static_cast<unsigned long>(r.writeP50Us),
+                    static_cast<unsigned long>(r.writeP99Us), static_cast<unsigned long>(r.writeMaxUs));
+  }
+
+  /**
+   * @brief カード履歴ファイル（CARDS.LOG）の 1 行
+   *
+   * @details
+   * "uptime_ms,type,sectors,grade,sync_bytes,sync_ms,<block>:<w>/<r>/<p99>/<max>,..."
+   * 複数台の履歴を集めて、BAD の多い容量・種別を洗い出すために使う。
+   */
+  int formatLogLine(uint32_t uptimeMs, char* out, size_t len) const {
+    int n = snprintf(out, len, "%lu,%u,%lu,%s,%lu,%lu", static_cast<unsigned long>(uptimeMs),
+                     static_cast<unsigned>(cardType), static_cast<unsigned long>(sectors),
+                     gradeName(grade), static_cast<unsigned long>(syncBytes),
+                     static_cast<unsigned long>(syncIntervalMs));
+    for (uint8_t i = 0; i < count && n > 0 && static_cast<size_t>(n) < len; ++i) {
+      const CardBlockResult& r = results[i];
+      n += snprintf(out + n, len - n, ",%lu:%lu/%lu/%lu/%lu",
+                    static_cast<unsigned long>(r.blockBytes), static_cast<unsigned long>(r.writeKBps),
+                    static_cast<unsigned long>(r.readKBps), static_cast<unsigned long>(r.writeP99Us),
+                    static_cast<unsigned long>(r.writeMaxUs));
+    }
+    if (n > 0 && static_cast<size_t>(n) + 2 < len) {
+      out[n++] = '\r';
+      out[n++] = '\n';
+      out[n]   = '\0';
+    }
+    return n;
+  }
+
+private:
+  static uint32_t clamp(uint32_t v, uint32_t lo, uint32_t hi) {
+    return (v < lo) ? lo : (v > hi) ? hi : v;
+  }
+
+  static const uint8_t* magic() {
+    static const uint8_t m[4] = {'C', 'P', 'R', 'F'};
+    return m;
+  }
+};
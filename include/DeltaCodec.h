@@ -0,0 +1,388 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include "BinaryLog.h"
+#include "FixedFormat.h"
+
+/**
+ * @file DeltaCodec.h
+ * @brief 温度系列の差分符号化（時刻: delta-of-delta / 値: 量子化差分の可変長符号）
+ *
+ * @details
+ * 温度はゆっくりしか変化せず、センサ周期もほぼ一定のため、1 サンプルごとに
+ * 固定長レコードを書くのは無駄が大きい。本符号化は Gorilla（Facebook の時系列 DB）
+ * と同じ考え方で、サンプル列をビット単位の可変長符号に詰める。
+ *
+ * 【1 ブロック内の符号】（MSB から順に詰める。ブロックごとに独立して復号可能）
+ * - 先頭サンプル : 時刻 32bit / 値 zigzag 32bit / フラグ 2bit
+ * - 以降の時刻   : 間隔の変化量 dod = (t[i] - t[i-1]) - (t[i-1] - t[i-2]) を zigzag 化し
+ *     0 → '0' / <128 → '10'+7bit / <512 → '110'+9bit / <4096 → '1110'+12bit / 他 → '1111'+32bit
+ * - 以降の値     : 差分 v[i] - v[i-1] を zigzag 化し
+ *     0 → '0' / <16 → '10'+4bit / <256 → '110'+8bit / 他 → '111'+32bit
+ * - 以降のフラグ : 変化無し → '0' / 変化 → '1'+2bit
+ *
+ * 500ms 周期（IO 周期分の揺らぎあり）・0.25°C 量子化の温度では 1 サンプル
+ * 約 1〜2 バイトになる（固定長 20B レコードの 1/10 以下）。
+ *
+ * 符号化は固定長のバッファ内で完結し（動的確保無し）、1 サンプルの最大長
+ * MAX_SAMPLE_BITS が入らなくなった時点で add() が false を返す（ブロック満杯）。
+ */
+
+/**
+ * @brief MSB ファーストのビット書き込み（固定長バッファ）
+ */
+class BitWriter {
+public:
+  BitWriter() : m_buf(nullptr), m_capBits(0), m_bits(0) {}
+
+  void reset(uint8_t* buf, size_t capBytes) {
+    m_buf     = buf;
+    m_capBits = capBytes * 8;
+    m_bits    = 0;
+    memset(buf, 0, capBytes);
+  }
+
+  /**
+   * @brief 下位 nbits ビットを書き込む（nbits <= 32、容量確認は呼び出し側）
+   */
+  void put(uint32_t value, uint8_t nbits) {
+    while (nbits > 0) {
+      const size_t  byte  = m_bits >> 3;
+      const uint8_t used  = static_cast<uint8_t>(m_bits & 7);
+      const uint8_t room  = static_cast<uint8_t>(8 - used);
+      const uint8_t n     = (nbits < room) ? nbits : room;
+      const uint8_t chunk = static_cast<uint8_t>((value >> (nbits - n)) & ((1u << n) - 1));
+      m_buf[byte] |= static_cast<uint8_t>(chunk << (room - n));
+      m_bits += n;
+      nbits   = static_cast<uint8_t>(nbits - n);
+    }
+  }
+
+  size_t bits() const { return m_bits; }
+  size_t remaining() const { return m_capBits - m_bits; }
+
+private:
+  uint8_t* m_buf;
+  size_t   m_capBits;
+  size_t   m_bits;
+};
+
+/**
+ * @brief MSB ファーストのビット読み出し
+ */
+class BitReader {
+public:
+  BitReader() : m_buf(nullptr), m_capBits(0), m_bits(0) {}
+
+  void reset(const uint8_t* buf, size_t lenBytes) {
+    m_buf     = buf;
+    m_capBits = lenBytes * 8;
+    m_bits    = 0;
+  }
+
+  /**
+   * @brief nbits ビットを読む（nbits <= 32）
+   * @return false: バッファ終端を越えた
+   */
+  bool get(uint8_t nbits, uint32_t& value) {
+    if (m_capBits - m_bits < nbits) return false;
+    uint32_t v = 0;
+    while (nbits > 0) {
+      const size_t  byte = m_bits >> 3;
+      const uint8_t used = static_cast<uint8_t>(m_bits & 7);
+      const uint8_t room = static_cast<uint8_t>(8 - used);
+      const uint8_t n    = (nbits < room) ? nbits : room;
+      const uint8_t bits = static_cast<uint8_t>((m_buf[byte] >> (room - n)) & ((1u << n) - 1));
+      v = (v << n) | bits;
+      m_bits += n;
+      nbits   = static_cast<uint8_t>(nbits - n);
+    }
+    value = v;
+    return true;
+  }
+
+  /**
+   * @brief 先頭から連続する '1' の数を数える（'0' を読んだところで止まる、最大 maxOnes）
+   */
+  bool prefix(uint8_t maxOnes, uint8_t& ones) {
+    ones = 0;
+    uint32_t bit = 0;
+    while (ones < maxOnes) {
+      if (!get(1, bit)) return false;
+      if (bit == 0) return true;
+      ++ones;
+    }
+    return true;
+  }
+
+private:
+  const uint8_t* m_buf;
+  size_t         m_capBits;
+  size_t         m_bits;
+};
+
+/**
+ * @brief 時刻・値・フラグ系列の符号化器（1 ブロック分）
+ */
+class DeltaEncoder {
+public:
+  // 1 サンプルの最大ビット数（時刻 4+32 / 値 3+32 / フラグ 1+2）
+  static constexpr size_t MAX_SAMPLE_BITS = 36 + 35 + 3;
+
+  DeltaEncoder() : m_count(0), m_prevT(0), m_prevDelta(0), m_prevV(0), m_prevFlags(0) {}
+
+  /**
+   * @brief 書き込み先を設定して空にする（バッファはゼロクリアされる）
+   */
+  void reset(uint8_t* buf, size_t capBytes) {
+    m_w.reset(buf, capBytes);
+    m_count     = 0;
+    m_prevT     = 0;
+    m_prevDelta = 0;
+    m_prevV     = 0;
+    m_prevFlags = 0;
+  }
+
+  /**
+   * @brief サンプルを追加
+   * @param t     時刻 [ms]（単調増加。巻き戻りは 32bit の符号無し差分で扱う）
+   * @param v     量子化済みの値
+   * @param flags 下位 2bit のフラグ
+   * @return false: 満杯（このサンプルは書いていない）
+   */
+  bool add(uint32_t t, int32_t v, uint8_t flags) {
+    if (m_w.remaining() < MAX_SAMPLE_BITS) return false;
+    flags &= 0x03;
+    if (m_count == 0) {
+      m_w.put(t, 32);
+      m_w.put(zigzag(v), 32);
+      m_w.put(flags, 2);
+    } else {
+      const int32_t delta = static_cast<int32_t>(t - m_prevT);
+      putDod(zigzag(static_cast<int32_t>(static_cast<uint32_t>(delta) -
+                                         static_cast<uint32_t>(m_prevDelta))));
+      putValue(zigzag(static_cast<int32_t>(static_cast<uint32_t>(v) -
+                                           static_cast<uint32_t>(m_prevV))));
+      if (flags == m_prevFlags) {
+        m_w.put(0, 1);
+      } else {
+        m_w.put(1, 1);
+        m_w.put(flags, 2);
+      }
+      m_prevDelta = delta;
+    }
+    m_prevT     = t;
+    m_prevV     = v;
+    m_prevFlags = flags;
+    ++m_count;
+    return true;
+  }
+
+  uint16_t count() const { return m_count; }
+  size_t   bytes() const { return (m_w.bits() + 7) / 8; }
+
+  static uint32_t zigzag(int32_t n) {
+    return (static_cast<uint32_t>(n) << 1) ^ static_cast<uint32_t>(n >> 31);
+  }
+
+private:
+  void putDod(uint32_t zz) {
+    if (zz == 0)         { m_w.put(0x0, 1); }
+    else if (zz < 128)   { m_w.put(0x2, 2); m_w.put(zz, 7); }
+    else if (zz < 512)   { m_w.put(0x6, 3); m_w.put(zz, 9); }
+    else if (zz < 4096)  { m_w.put(0xE, 4); m_w.put(zz, 12); }
+    else                 { m_w.put(0xF, 4); m_w.put(zz, 32); }
+  }
+
+  void putValue(uint32_t zz) {
+    if (zz == 0)         { m_w.put(0x0, 1); }
+    else if (zz < 16)    { m_w.put(0x2, 2); m_w.put(zz, 4); }
+    else if (zz < 256)   { m_w.put(0x6, 3); m_w.put(zz, 8); }
+    else                 { m_w.put(0x7, 3); m_w.put(zz, 32); }
+  }
+
+  BitWriter m_w;
+  uint16_t  m_count;
+  uint32_t  m_prevT;
+  int32_t   m_prevDelta;
+  int32_t   m_prevV;
+  uint8_t   m_prevFlags;
+};
+
+/**
+ * @brief DeltaEncoder の出力の復号器（ホスト側・テスト）
+ */
+class DeltaDecoder {
+public:
+  DeltaDecoder() : m_left(0), m_first(true), m_prevT(0), m_prevDelta(0), m_prevV(0),
+                   m_prevFlags(0) {}
+
+  /**
+   * @param count 符号化されているサンプル数（ブロックヘッダの件数）
+   */
+  void reset(const uint8_t* buf, size_t lenBytes, uint16_t count) {
+    m_r.reset(buf, lenBytes);
+    m_left      = count;
+    m_first     = true;
+    m_prevT     = 0;
+    m_prevDelta = 0;
+    m_prevV     = 0;
+    m_prevFlags = 0;
+  }
+
+  /**
+   * @brief 次のサンプルを取り出す
+   * @return false: 終端（または途中で途切れた）
+   */
+  bool next(uint32_t& t, int32_t& v, uint8_t& flags) {
+    if (m_left == 0) return false;
+    uint32_t raw = 0;
+    if (m_first) {
+      uint32_t zv = 0, f = 0;
+      if (!m_r.get(32, raw) || !m_r.get(32, zv) || !m_r.get(2, f)) return false;
+      m_prevT     = raw;
+      m_prevV     = unzigzag(zv);
+      m_prevFlags = static_cast<uint8_t>(f);
+      m_first     = false;
+    } else {
+      uint8_t ones = 0;
+      uint32_t zz  = 0;
+      // 時刻
+      if (!m_r.prefix(4, ones)) return false;
+      static const uint8_t dodBits[5] = {0, 7, 9, 12, 32};
+      if (ones > 0 && !m_r.get(dodBits[ones], zz)) return false;
+      const int32_t delta = static_cast<int32_t>(static_cast<uint32_t>(m_prevDelta) +
+                                                 static_cast<uint32_t>(unzigzag(zz)));
+      m_prevT    += static_cast<uint32_t>(delta);
+      m_prevDelta = delta;
+      // 値
+      zz = 0;
+      if (!m_r.prefix(3, ones)) return false;
+      static const uint8_t valBits[4] = {0, 4, 8, 32};
+      if (ones > 0 && !m_r.get(valBits[ones], zz)) return false;
+      m_prevV = static_cast<int32_t>(static_cast<uint32_t>(m_prevV) +
+                                     static_cast<uint32_t>(unzigzag(zz)));
+      // フラグ
+      if (!m_r.get(1, raw)) return false;
+      if (raw != 0) {
+        if (!m_r.get(2, raw)) return false;
+        m_prevFlags = static_cast<uint8_t>(raw);
+      }
+    }
+    --m_left;
+    t     = m_prevT;
+    v     = m_prevV;
+    flags = m_prevFlags;
+    return true;
+  }
+
+  static int32_t unzigzag(uint32_t z) {
+    return static_cast<int32_t>((z >> 1) ^ (~(z & 1) + 1));
+  }
+
+private:
+  BitReader m_r;
+  uint16_t  m_left;
+  bool      m_first;
+  uint32_t  m_prevT;
+  int32_t   m_prevDelta;
+  int32_t   m_prevV;
+  uint8_t   m_prevFlags;
+};
+
+/**
+ * @brief 量子化値を温度の文字列に（量子化幅に応じた桁数、INT32_MIN は "NaN"）
+ * @return 書き込んだ末尾（終端 '\0' は書かない）
+ */
+inline char* putQuantized(char* p, int32_t q, uint16_t quantumMilliC) {
+  if (q == INT32_MIN) return FixedFormat::putStr(p, "NaN");
+  // 量子化幅の倍数なので、桁を落としても切り捨て誤差は出ない
+  const int32_t milli = static_cast<int32_t>(static_cast<int64_t>(q) * quantumMilliC);
+  if (quantumMilliC % 100 == 0) return FixedFormat::putFixed(p, milli / 100, 1);
+  if (quantumMilliC % 10 == 0)  return FixedFormat::putFixed(p, milli / 10, 2);
+  return FixedFormat::putFixed(p, milli, 3);
+}
+
+/**
+ * @brief DELTA 形式の 1 サンプルを CSV 1 行（CRLF 付き）に整形（ホスト側）
+ *
+ * @details
+ * 列は ElapsedMs,Temp_C,HI_ALARM,LO_ALARM。温度は量子化幅に応じた桁数
+ * （250m°C → 小数第 2 位）で出力し、INT32_MIN（NaN）は "NaN"。
+ *
+ * @param buf 64 バイト以上
+ * @return 書き込んだ文字数（終端 '\0' を除く）
+ */
+inline size_t formatDeltaRow(uint32_t t, int32_t q, uint8_t flags, uint16_t quantumMilliC,
+                             char* buf) {
+  char* p = FixedFormat::putUint(buf, t);
+  *p++ = ',';
+  p = putQuantized(p, q, quantumMilliC);
+  *p++ = ',';
+  p = FixedFormat::putBool(p, (flags & BinaryLog::FLAG_HI_ALARM) != 0);
+  *p++ = ',';
+  p = FixedFormat::putBool(p, (flags & BinaryLog::FLAG_LO_ALARM) != 0);
+  *p++ = '\r';
+  *p++ = '\n';
+  *p   = '\0';
+  return static_cast<size_t>(p - buf);
+}
+
+/**
+ * @brief 差分符号化ブロック（BinaryLog の BLOCK_DELTA、512B）の組み立てバッファ
+ *
+ * @details
+ * BinLogBlock と同じく 512B = 1 セクタ単位で書き出す。1 ブロックに数百〜
+ * 千サンプル以上入るため、満杯を待たずに途中の状態を snapshot() で
+ * 同じオフセットへ書き直し、電源断時の損失を同期間隔以内に抑える。
+ */
+class DeltaBlock {
+public:
+  DeltaBlock() { reset(0); }
+
+  DeltaBlock(const DeltaBlock&) = delete;
+  DeltaBlock& operator=(const DeltaBlock&) = delete;
+
+  void reset(uint32_t seq) {
+    m_seq = seq;
+    m_enc.reset(m_buf + BinaryLog::BLOCK_HEADER_SIZE, BinaryLog::PAYLOAD_SIZE);
+    memset(m_buf, 0, BinaryLog::BLOCK_HEADER_SIZE);
+  }
+
+  /**
+   * @brief サンプルを追加
+   * @return false: 満杯（seal() して書き出してから再度 add() すること）
+   */
+  bool add(uint32_t t, int32_t v, uint8_t flags) { return m_enc.add(t, v, flags); }
+
+  /**
+   * @brief 完成した 512B を返し、次のブロックへ進む（戻り値は次の add() まで有効）
+   */
+  const uint8_t* seal() {
+    snapshot();
+    reset(m_seq + 1);
+    return m_out;
+  }
+
+  /**
+   * @brief 途中までの内容を 512B のブロックとして返す（ブロックは進めない）
+   */
+  const uint8_t* snapshot() {
+    BinaryLog::sealBlock(m_buf, BinaryLog::BLOCK_DELTA, m_enc.count(), m_seq);
+    memcpy(m_out, m_buf, sizeof(m_out));
+    return m_out;
+  }
+
+  uint16_t count() const { return m_enc.count(); }
+  bool     empty() const { return m_enc.count() == 0; }
+  uint32_t seq() const { return m_seq; }
+
+private:
+  alignas(4) uint8_t m_buf[BinaryLog::BLOCK_SIZE];
+  alignas(4) uint8_t m_out[BinaryLog::BLOCK_SIZE];
+  DeltaEncoder m_enc;
+  uint32_t     m_seq;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "SdLatency.h"
+
+/**
+ * @file FaultyFile.h
+ * @brief 遅延・短い書き込み・失敗を注入する SD ファイルの代役（native 環境用）
+ *
+ * @details
+ * 現場で起きる SD の書き込み停止は机上のカードでは再現しない。本クラスは
+ * SectorWriter の Sink（seek / write / flush）と open / close を持つメモリ上の
+ * ファイルで、操作ごとに FaultPlan に従った時間を「模擬時計」に加算し、
+ * 確率的に遅延スパイク・短い書き込み（len 未満を返す）・失敗（0 を返す）を起こす。
+ * 実時間は待たないため、数時間分のログ経路を Linux 上で一瞬で回せる
+ * （tools/sdsim.cpp、test/test_faulty_file）。
+ *
+ * 各操作の模擬時間は SdLatency に記録でき、実機の SDManager::dumpLatency() と
+ * 同じ形で比較できる。乱数は seed から決まる xorshift32 で、同じ計画なら
+ * 同じ結果になる。
+ */
+
+/**
+ * @brief 注入する遅延と障害（確率は千分率、時間は µs）
+ */
+struct FaultPlan {
+  uint32_t openUs             = 3000;
+  uint32_t writeUsPerSector   = 250;    // 1 セクタ（512B）あたり。端数は切り上げ
+  uint32_t flushUs            = 2000;   // FAT / ディレクトリエントリ更新
+  uint32_t closeUs            = 2000;
+  uint32_t spikePermille      = 0;      // write / flush が止まる確率
+  uint32_t spikeUs            = 0;      // 止まる長さ（spikeUs / 2 〜 spikeUs）
+  uint32_t shortWritePermille = 0;      // write が len 未満を返す確率
+  uint32_t failPermille       = 0;      // write / flush が失敗する確率
+  uint32_t failAfterOps       = 0;      // この回数の操作後は全て失敗（カード抜け。0 = 無し）
+  uint32_t seed               = 1;
+  uint32_t stallUs            = 100000; // SdLatency の超過数の閾値（SD_STALL_THRESHOLD_US）
+};
+
+class FaultyFile {
+public:
+  /**
+   * @brief 注入結果の集計
+   */
+  struct Stats {
+    uint32_t ops;
+    uint32_t spikes;
+    uint32_t shortWrites;
+    uint32_t failures;
+  };
+
+  explicit FaultyFile(const FaultPlan& plan, SdLatency* latency = nullptr)
+      : m_plan(plan), m_latency(latency), m_rng(plan.seed ? plan.seed : 1), m_nowUs(0),
+        m_pos(0), m_open(false), m_stats() {}
+
+  bool open() {
+    if (!begin(SdOp::OPEN, m_plan.openUs, false)) return false;
+    m_open = true;
+    m_pos  = 0;
+    return true;
+  }
+
+  void close() {
+    begin(SdOp::CLOSE, m_plan.closeUs, false);
+    m_open = false;
+  }
+
+  bool seek(uint32_t offset) {
+    if (!m_open || offset > m_data.size()) return false;
+    m_pos = offset;
+    return true;
+  }
+
+  size_t write(const uint8_t* data, size_t len) {
+    const uint32_t sectors = static_cast<uint32_t>((len + 511) / 512);
+    if (!m_open || !begin(SdOp::WRITE, sectors * m_plan.writeUsPerSector, true)) return 0;
+    if (len > 1 && chance(m_plan.shortWritePermille)) {
+      m_stats.shortWrites++;
+      len /= 2;
+    }
+    if (m_data.size() < m_pos + len) m_data.resize(m_pos + len);
+    m_data.replace(m_pos, len, reinterpret_cast<const char*>(data), len);
+    m_pos += static_cast<uint32_t>(len);
+    return len;
+  }
+
+  void flush() {
+    if (m_open) begin(SdOp::FLUSH, m_plan.flushUs, true);
+  }
+
+  /**
+   * @brief 模擬時計を進める（操作の間の待ち時間）
+   */
+  void advanceTo(uint64_t us) {
+    if (us > m_nowUs) m_nowUs = us;
+  }
+
+  uint64_t nowUs() const { return m_nowUs; }
+  const std::string& data() const { return m_data; }
+  const Stats& stats() const { return m_stats; }
+
+private:
+  /**
+   * @brief 操作 1 回ぶんの時間を進めて記録する
+   * @param faultable スパイク・失敗を注入する操作か
+   * @return false : この操作を失敗させる
+   */
+  bool begin(SdOp op, uint32_t baseUs, bool faultable) {
+    m_stats.ops++;
+    uint32_t us = baseUs;
+    bool     ok = !(m_plan.failAfterOps != 0 && m_stats.ops > m_plan.failAfterOps);
+    if (faultable && ok && chance(m_plan.failPermille)) ok = false;
+    if (faultable && chance(m_plan.spikePermille)) {
+      m_stats.spikes++;
+      us += m_plan.spikeUs / 2 + next() % (m_plan.spikeUs / 2 + 1);
+    }
+    if (!ok) m_stats.failures++;
+    m_nowUs += us;
+    if (m_latency != nullptr) m_latency->record(op, us, m_plan.stallUs);
+    return ok;
+  }
+
+  bool chance(uint32_t permille) {
+    return permille != 0 && next() % 1000 < permille;
+  }
+
+  uint32_t next() {
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 17;
+    m_rng ^= m_rng << 5;
+    return m_rng;
+  }
+
+  FaultPlan   m_plan;
+  SdLatency*  m_latency;
+  uint32_t    m_rng;
+  uint64_t    m_nowUs;
+  std::string m_data;
+  uint32_t    m_pos;
+  bool        m_open;
+  Stats       m_stats;
+};
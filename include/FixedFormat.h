@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+
+/**
+ * @file FixedFormat.h
+ * @brief 確保無しの固定小数点数値整形（CSV 行・LCD・シリアル共通）
+ *
+ * @details
+ * %f 付きの snprintf / printf は ESP32 で最も重い呼び出しの一つで、CSV 行
+ * （%.1f × 5）・LCD の値表示（%6.1f）と、記録・表示の周期ごとに呼ばれていた。
+ * 本クラスは整数（ミリ度などの 10^-n 単位）または float を、呼び出し側の
+ * バッファへ直接 10 進文字列として書く。
+ *
+ * 【printf との互換】
+ * putFloat(p, v, n, w) は printf("%w.nf", v) と同じ文字列を出す（n ≤ 3）。
+ * float × 10^n（n ≤ 3）は double で誤差無く表せるため、rint（最近接偶数）で
+ * 丸めれば printf の正しい丸め（2 進値に対する 10 進丸め）と一致する。
+ * -0.0 や負の値が 0 に丸められた場合も printf と同じく "-0.0" になる。
+ * NaN / Inf と |v| × 10^n が int32 に収まらない場合は snprintf に任せる
+ * （通常の温度では通らない）。
+ *
+ * 【使い方】
+ * 各 put* は p から書き、書いた直後の位置を返す（終端 '\0' は付けない）。
+ * バッファ長は呼び出し側が最大長で確保する（putUint: 10 桁、putUint64: 20 桁、putFloat: 幅と
+ * 小数桁 + 12 文字）。
+ */
+class FixedFormat {
+public:
+  static constexpr uint8_t MAX_DECIMALS = 3;
+
+  /**
+   * @brief 符号無し整数（%u / %lu）
+   */
+  static char* putUint(char* p, uint32_t v) {
+    char tmp[10];
+    int  n = 0;
+    do {
+      tmp[n++] = static_cast<char>('0' + v % 10);
+      v /= 10;
+    } while (v != 0);
+    while (n > 0) *p++ = tmp[--n];
+    return p;
+  }
+
+  /**
+   * @brief 64 ビット符号無し整数（%llu、最大 20 桁。ソークの通算サンプル数・時刻用）
+   */
+  static char* putUint64(char* p, uint64_t v) {
+    if (v <= 0xFFFFFFFFull) return putUint(p, static_cast<uint32_t>(v));
+    char tmp[20];
+    int  n = 0;
+    do {
+      tmp[n++] = static_cast<char>('0' + v % 10);
+      v /= 10;
+    } while (v != 0);
+    while (n > 0) *p++ = tmp[--n];
+    return p;
+  }
+
+  /**
+   * @brief 符号付き整数（%d / %ld）
+   */
+  static char* putInt(char* p, int32_t v) {
+    if (v < 0) {
+      *p++ = '-';
+      return putUint(p, 0u - static_cast<uint32_t>(v));
+    }
+    return putUint(p, static_cast<uint32_t>(v));
+  }
+
+  /**
+   * @brief 幅指定の符号付き整数（%5ld: 空白で右寄せ / pad='0' で %05ld）
+   */
+  static char* putIntPad(char* p, int32_t v, uint8_t width, char pad = ' ') {
+    char  tmp[12];
+    char* e = putInt(tmp, v);
+    return padCopy(p, tmp, e, width, pad);
+  }
+
+  /**
+   * @brief 10^-decimals 単位の整数を小数表記（例: scaled=-1234, decimals=1 → "-123.4"）
+   * @param negative scaled が 0 でも '-' を付ける（"-0.0" の再現用）
+   */
+  static char* putFixed(char* p, int32_t scaled, uint8_t decimals, bool negative = false) {
+    uint32_t mag = (scaled < 0) ? 0u - static_cast<uint32_t>(scaled) : static_cast<uint32_t>(scaled);
+    if (scaled < 0 || negative) *p++ = '-';
+    if (decimals == 0) return putUint(p, mag);
+    const uint32_t div = scale10(decimals);
+    p = putUint(p, mag / div);
+    *p++ = '.';
+    uint32_t frac = mag % div;
+    for (uint32_t d = div / 10; d > 0; d /= 10) {
+      *p++ = static_cast<char>('0' + frac / d);
+      frac %= d;
+    }
+    return p;
+  }
+
+  /**
+   * @brief ミリ度（整数）を小数 decimals 桁で（0 から遠い方へ四捨五入）
+   */
+  static char* putMilli(char* p, int32_t milli, uint8_t decimals) {
+    if (decimals >= 3) return putFixed(p, milli, 3);
+    const int32_t div  = static_cast<int32_t>(scale10(static_cast<uint8_t>(3 - decimals)));
+    const int32_t half = div / 2;
+    const int32_t v    = (milli >= 0) ? (milli + half) / div : -((-milli + half) / div);
+    return putFixed(p, v, decimals);
+  }
+
+  /**
+   * @brief float を 10^-decimals 単位の整数へ（printf と同じ丸め）
+   * @return false : NaN / Inf、または int32 に収まらない
+   */
+  static bool toScaled(float v, uint8_t decimals, int32_t& out) {
+    if (decimals > MAX_DECIMALS || !std::isfinite(v)) return false;
+    const double s = std::rint(static_cast<double>(v) * scale10(decimals));
+    if (s > 2147483647.0 || s < -2147483647.0) return false;
+    out = static_cast<int32_t>(s);
+    return true;
+  }
+
+  /**
+   * @brief printf("%<width>.<decimals>f", v) と同じ文字列
+   */
+  static char* putFloat(char* p, float v, uint8_t decimals, uint8_t width = 0) {
+    char    tmp[48];
+    char*   e = tmp;
+    int32_t scaled;
+    if (toScaled(v, decimals, scaled)) {
+      e = putFixed(tmp, scaled, decimals, std::signbit(v) && scaled == 0);
+    } else {
+      const int n = snprintf(tmp, sizeof(tmp), "%.*f", static_cast<int>(decimals),
+                             static_cast<double>(v));
+      e = tmp + ((n <= 0) ? 0 : (static_cast<size_t>(n) < sizeof(tmp) ? n : sizeof(tmp) - 1));
+    }
+    return padCopy(p, tmp, e, width, ' ');
+  }
+
+  /**
+   * @brief "true" / "false"
+   */
+  static char* putBool(char* p, bool v) { return putStr(p, v ? "true" : "false"); }
+
+  /**
+   * @brief 文字列（終端 '\0' は含めない）
+   */
+  static char* putStr(char* p, const char* s) {
+    while (*s) *p++ = *s++;
+    return p;
+  }
+
+private:
+  static uint32_t scale10(uint8_t n) {
+    static const uint32_t table[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+    return table[n];
+  }
+
+  static char* padCopy(char* p, const char* s, const char* e, uint8_t width, char pad) {
+    const size_t len = static_cast<size_t>(e - s);
+    if (pad == '0' && len < width && s < e && *s == '-') {
+      *p++ = *s++;   // %05ld: 符号の後ろを 0 で埋める
+      --width;
+    }
+    for (size_t i = static_cast<size_t>(e - s); i < width; ++i) *p++ = pad;
+    while (s < e) *p++ = *s++;
+    return p;
+  }
+};
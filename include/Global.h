@@ -6,6 +6,14 @@
 #include <cmath>   // sqrt, isnan など数学関数用
 #include <cfloat>  // FLT_MAX, FLT_MIN など
 #include "EEPROMManager.h"  // EEPROM操作集約
+#include "LogFilter.h"      // RUN 中の記録判定
+#include "Rollup.h"         // 多段解像度の集約ログ
+#include "OutageBacklog.h"  // SD 切断中の退避
+#include "CardProfile.h"    // SD カードの自己ベンチマーク
+#include "RawCapture.h"     // 生データ記録
+#include "PreTrigger.h"     // トリガ前の直近サンプル
+#include "SoakLog.h"        // 長期連続試験の 64 ビット時刻・区間分割
+#include "SDConfig.h"       // SD ログ経路の定数・行データ（ホストツールと共有）
 
 
 // Phase 4: SD カード・ファイル操作
@@ -17,6 +25,15 @@
 // ハードウェアSPI (SCK=GPIO18, MISO=GPIO19) でLCDとバスを共有し、
 // センサー側は CS ピンを GPIO5 に割り当てる。
 constexpr uint8_t MAX31855_CS = 5;
+constexpr uint8_t LCD_CS_PIN  = 14;   // 内蔵 LCD（ILI9342C）の CS（M5Stack Basic / Gray）
+
+// ── 共有 SPI バスの調停（SpiBus.h）────────────────────────────────────────────
+constexpr uint32_t SPI_SENSOR_CLOCK_HZ = 1000000UL;    // Adafruit_MAX31855(cs) が使う値（ライブラリの既定）
+constexpr uint32_t SPI_LCD_CLOCK_HZ    = 40000000UL;   // M5Stack の LCD ドライバが使う値
+constexpr uint32_t SPI_SD_CLOCK_HZ     = 40000000UL;   // SD.begin() に渡す
+constexpr uint32_t SPI_SD_PROBE_HZ     = 400000UL;     // マウント前のカード有無確認（CMD0、初期化前の上限）
+constexpr int32_t  SPI_LCD_CHUNK_ROWS  = 24;           // 全消去を何行ずつ塗るか（40MHz で約 3ms / チャンク）
+constexpr uint32_t SPI_YIELD_SPIN_US   = 200UL;        // 明け渡し時にセンサーの獲得を待つ上限
 
 // ── タイマー周期 [ms] ─────────────────────────────────────────────────────────
 // millis() のオーバーフローは unsigned 演算の性質で自動吸収。
@@ -24,6 +41,32 @@ constexpr unsigned long IO_CYCLE_MS         =  10UL;  // IO層    : センサ読
 constexpr unsigned long LOGIC_CYCLE_MS      =  50UL;  // Logic層 : 状態遷移・演算
 constexpr unsigned long UI_CYCLE_MS         = 200UL;  // UI層    : 画面描画
 constexpr unsigned long TC_READ_INTERVAL_MS = 500UL;  // MAX31855 変換完了待ち間隔
+constexpr unsigned long TC_CAPTURE_INTERVAL_MS = 100UL;  // 生データ記録中の読取間隔（MAX31855 の最大変換時間）
+
+// ── FreeRTOS タスク配置（デュアルコア）─────────────────────────────────────────
+// IO コア   : センサ読取・ボタン入力・アラーム判定のみ（遅い処理を一切置かない）
+// 制御コア  : Logic / UI / SD 書き込み（LCD 全消去や SD flush で遅れてもよい側）
+// コア間のデータ受け渡しは SeqLock によるスナップショット公開（ミューテックス無し）
+constexpr int      IO_TASK_CORE             = 1;     // APP_CPU
+constexpr int      CONTROL_TASK_CORE        = 0;     // PRO_CPU
+constexpr uint32_t IO_TASK_STACK_BYTES      = 4096;
+constexpr uint32_t CONTROL_TASK_STACK_BYTES = 8192;
+constexpr unsigned IO_TASK_PRIORITY         = 3;     // 制御タスクより高優先
+constexpr unsigned CONTROL_TASK_PRIORITY    = 2;
+
+// ── タスク処理時間予算 [µs]（PerfMonitor の超過カウンタ判定用）────────────────
+// 目標値は docs/troubleshooting/PERFORMANCE.md「Ⅰ パフォーマンス目標設定」に準拠
+constexpr uint32_t PERF_BUDGET_IO_US      =   5000UL;  // IO_Task      < 5 ms
+constexpr uint32_t PERF_BUDGET_LOGIC_US   =  30000UL;  // Logic_Task   < 30 ms
+constexpr uint32_t PERF_BUDGET_UI_US      = 100000UL;  // UI_Task      < 100 ms
+constexpr uint32_t PERF_BUDGET_STORAGE_US =  10000UL;  // Storage_Task < IO_CYCLE_MS
+
+// ── 省電力ガバナー（PowerGovernor / PowerManager）─────────────────────────────
+// IDLE / RESULT で操作が無い間だけ 80MHz + ライトスリープ。RUN / ALARM_SETTING は常に 240MHz
+constexpr uint32_t POWER_ACTIVITY_HOLD_MS = 3000UL;  // 操作後にフルクロックを維持する時間
+constexpr uint32_t POWER_MIN_SLEEP_MS     =   10UL;  // これ未満の空きではスリープしない
+constexpr uint32_t POWER_MAX_SLEEP_MS     = 1000UL;  // 1 回のスリープ上限
+constexpr uint32_t POWER_WAKE_MARGIN_MS   =    2UL;  // 締め切り手前で起きる余裕（復帰時間）
 
 // ── フィルタ定数 ──────────────────────────────────────────────────────────────
 constexpr float FILTER_ALPHA = 0.1f;  // 1次遅れフィルタ係数 (0.0〜1.0)
@@ -104,11 +147,10 @@ constexpr float SETTING_STEP     =   5.0f;  // 設定時の調整幅 [°C]
 // シリアルボーレート (UART通信速度)
 constexpr uint32_t SERIAL_BAUD_RATE = 115200UL;
 
-// 初期化時の MAX31855 センサ安定化・リトライ設定
-constexpr unsigned long SETUP_SENSOR_DELAY_MS      = 200UL;   // パワーオン後の初期化待ち
-constexpr unsigned long SETUP_RETRY_INTERVAL_MS    = 500UL;   // リトライ間隔
-constexpr unsigned long SETUP_FINAL_DELAY_MS       = 1000UL;  // 最終確認後の待機時間
-constexpr int           MAX_SETUP_RETRIES          = 5;       // 最大リトライ回数
+// 起動時の MAX31855 プローブ設定（setup() では待たず、IO タスクが非同期に実施）
+constexpr unsigned long SETUP_SENSOR_DELAY_MS      = 200UL;   // パワーオン後の初回読取までの最短時間（リセット起点）
+constexpr unsigned long BOOT_PROBE_INTERVAL_MS     = 100UL;   // 初回有効サンプルまでの読取間隔
+constexpr unsigned long BOOT_SENSOR_TIMEOUT_MS     = 3000UL;  // これを過ぎたら「センサ未接続」と記録
 
 // ── アラーム音声設定（Speaker制御）────────────────────────────────────────────
 // HI/LO アラームは異なる周波数で区別可能
@@ -120,15 +162,20 @@ constexpr uint16_t ALARM_SOUND_DURATION_MS = 500U;  // アラーム音継続時
 // IO_Task 内での定期的なアラーム状態ログ出力
 constexpr unsigned long ALARM_DEBUG_LOG_INTERVAL_MS = 5000UL;  // 5秒ごとにデバッグ出力
 
-// ── Phase 4: SDカード定数 ──────────────────────────────────────────────────────
-constexpr const char* SD_MOUNT_POINT    = "/sd";         // microSD マウントポイント
-constexpr uint32_t    SD_BUFFER_SIZE    = 256;           // CSV行バッファサイズ [bytes]
-constexpr uint16_t    SD_WRITE_INTERVAL = 10;            // 書き込み間隔 [サンプル数]
-constexpr uint16_t    SD_MAX_FILENAME   = 32;            // ファイル名最大長
+// SD カード・ログ経路の定数、行データ（SDData）、ログ形式は SDConfig.h
 // EEPROM_SIZE は EEPROMManager.h で定義済み (4096 bytes)
 
 // ── Phase 4: RTC 定数 ───────────────────────────────────────────────────────────
 constexpr uint8_t     RTC_I2C_ADDR      = 0x68;          // DS3231 I²C アドレス
+constexpr int         RTC_I2C_SDA_PIN   = 21;            // M5Stack Grove / 内部 I²C
+constexpr int         RTC_I2C_SCL_PIN   = 22;
+constexpr uint32_t    RTC_I2C_CLOCK_HZ  = 400000UL;      // 7 バイト読み出しで約 0.3ms
+
+// 実時刻（RtcClock.h / WallClock.h）: RTC は補正の時だけ読み、行の時刻は RAM 上の時計から
+constexpr uint32_t RTC_DISCIPLINE_INTERVAL_MS = 600000UL;  // RTC に合わせ直す間隔（10 分）
+constexpr uint32_t RTC_RETRY_INTERVAL_MS      = 10000UL;   // 秒の変わり目を捕まえ損ねた時の再試行
+constexpr uint32_t RTC_EDGE_TIMEOUT_MS        = 1500UL;    // 秒の変わり目を待つ上限（1 秒 + 余裕）
+constexpr uint32_t RTC_EDGE_MAX_GAP_MS        = 60UL;      // 前後の読み出し間隔がこれ以下の変わり目だけ使う
 
 // ── LCD 座標定数（UI描画の高度な制御）─────────────────────────────────────────
 namespace UI {
@@ -148,21 +195,6 @@ namespace UI {
   }
 }
 
-// ── Phase 4: SDデータ構造体 ─────────────────────────────────────────────────────
-// CSV 1 行分のデータを保持（シングルチャネル専用）
-struct SDData {
-  uint32_t elapsedSeconds;   // RUN開始からの経過秒数
-  float    temperature;      // 現在の温度 [°C]
-  const char* state;         // 状態文字列（"RUN", "RESULT"等）
-  uint32_t sampleCount;      // 取得サンプル数
-  float    averageTemp;      // 平均温度 [°C]
-  float    stdDev;           // 標準偏差 [°C]
-  float    maxTemp;          // 最高温度 [°C]
-  float    minTemp;          // 最低温度 [°C]
-  bool     hiAlarm;          // 上限アラームフラグ
-  bool     loAlarm;          // 下限アラームフラグ
-};
-
 // ── 状態定義 ──────────────────────────────────────────────────────────────────
 // enum class により名前がグローバル名前空間に漏れない (State::IDLE のようにアクセス)
 enum class State : uint8_t {
@@ -180,8 +212,10 @@ struct GlobalData {
   // データレジスタ群
   float  D_RawPV;        // 生の温度測定値 [°C]
   float  D_FilteredPV;   // フィルタ後の温度値 [°C]
+  uint32_t D_SampleSeq;    // IO コアが新しいセンサ値を取り込んだ回数（IOSnapshot から反映）
+  uint32_t D_SampleTimeMs; // 最新センサ値の取得時刻 (millis)
   double D_Sum;          // 積算値 (平均計算用)
-  long   D_Count;        // サンプル数
+  int64_t D_Count;       // サンプル数（ソークでも桁あふれしない 64 ビット）
   float  D_Average;      // 平均温度 [°C]
 
   // Phase 2: 統計機能
@@ -210,13 +244,57 @@ struct GlobalData {
   // Phase 4: SDカード・ファイル操作
   bool     M_SDReady;              // SDカード検出フラグ
   bool     M_SDError;              // SDエラーフラグ
-  char     M_CurrentDataFile[32];  // 現在のファイル名 (YYYYMMDD_HHMMSS.csv)
+  bool     M_SDOutage;             // SD 切断中（RAM へ退避し再マウント待ち）
+  char     M_CurrentDataFile[32];  // 現在のファイル名 (DATA_xxxx.csv / .bin)
+  uint32_t M_NextRunId;            // 次の RUN 番号（起動時に目録から読む）
+  uint32_t M_RunId;                // 記録中の RUN 番号
+  uint16_t M_RunHiAlarms;          // RUN 中の HI アラーム発生回数（目録の要約用）
+  uint16_t M_RunLoAlarms;          // RUN 中の LO アラーム発生回数
+  LogFormat M_LogFormat;           // 次の RUN で使うログ形式
+  bool     M_LogDeadband;          // 次の RUN でデッドバンド記録を使うか
+  bool     M_RawCapture;           // 次の RUN で生データ（全読取値）も記録するか
+  LogFilter M_LogFilter;           // RUN 中の記録判定（Storage_Task が所有、CLOSE 時にフッタへ）
+  RollupCascade M_Rollup;          // 1 秒 / 1 分 / 1 時間の集約（Storage_Task が所有）
+  PreTriggerRing<SD_PRETRIGGER_DEPTH> M_PreTrigger;  // 直近のサンプル（Storage_Task が所有、状態に関係なく追加）
+  uint16_t M_RunAlarmSnapshots;    // RUN 中に作ったアラームスナップショット数
   SDData   M_SDBuffer;             // バッファ（1行分のCSVデータ）
-  uint16_t M_SDWriteCounter;       // 書き込みカウンタ（10サンプルごと）
+  uint16_t M_SDWriteCounter;       // 前回の行キュー投入からの IO 周期数（UI の書込表示用）
   uint32_t M_RunStartTime;         // RUN開始時刻 (millis)
+
+  // ソークモード（SoakLog.h）。区間の状態は Storage_Task が所有
+  bool     M_SoakMode;             // 次の RUN をソークモード（区間分割）で記録するか
+  WrapClock M_RunClock;            // millis() の 64 ビット化（Storage_Task が毎周期進める）
+  uint64_t M_RunStartTime64;       // RUN 開始時刻（M_RunClock の 64 ビット）
+  uint16_t M_SegmentIndex;         // 記録中の区間番号（0 = RUN の最初のファイル）
+  uint32_t M_SegmentStartTime;     // 区間開始時刻 (millis)。区間内の ElapsedMs の基準
+  char     M_SegmentFile[32];      // 記録中の区間のファイル名（非ソーク時は M_CurrentDataFile と同じ）
   
   // M_BtnA_Prev は IO_Task の実装詳細のため static ローカル変数へ移動
 };
+
+// ── コア間スナップショット ─────────────────────────────────────────────────────
+// IO コア → 制御コア: IO_Task が毎周期 publish し、制御コアは周期先頭で G に反映する。
+// ボタンは「押下回数カウンタ」で渡す（フラグのセット/クリアをコア間で共有しない）。
+struct IOSnapshot {
+  float    rawPV;          // 生の温度測定値 [°C]（G.D_RawPV 相当）
+  float    filteredPV;     // フィルタ後の温度値 [°C]（G.D_FilteredPV 相当）
+  uint32_t sampleSeq;      // 新しいセンサ値を取り込んだ回数
+  uint32_t sampleTimeMs;   // 最新サンプルの取得時刻 (millis)
+  bool     hiAlarm;        // 上限アラーム中フラグ
+  bool     loAlarm;        // 下限アラーム中フラグ
+  uint8_t  btnAEdges;      // BtnA 立ち上がりエッジ累計（mod 256）
+  uint8_t  btnBEdges;      // BtnB 立ち上がりエッジ累計（mod 256）
+  uint8_t  btnCEdges;      // BtnC 立ち上がりエッジ累計（mod 256）
+};
+
+// 制御コア → IO コア: Logic_Task 終了時に publish（アラーム判定用の閾値など）
+struct ControlSnapshot {
+  State    state;          // 現在の状態
+  float    hiThreshold;    // 上限アラーム閾値 [°C]
+  float    loThreshold;    // 下限アラーム閾値 [°C]
+  uint32_t alarmResetSeq;  // 変化したら IO 側がアラームフラグをクリア
+  bool     rawCapture;     // 生データ記録中（IO 側が TC_CAPTURE_INTERVAL_MS で読み、全読取値を渡す）
+};
 // ── 外部宣言 ──────────────────────────────────────────────────────────────────
 // 実体は Tasks.cpp で確保
 extern GlobalData        G;
@@ -227,6 +305,16 @@ void initGlobalData();  // グローバルデータ初期化 (Tasks.cpp)
 void IO_Task();
 void Logic_Task();
 void UI_Task();
+void Storage_Task();   // SD 記録レコードの生成・リング投入（制御コア、IO_CYCLE_MS 周期）
+void Boot_Task();      // 起動シーケンスの残り（初回サンプル待ち・SD マウント、制御コア / main.cpp）
+void Console_Task();   // シリアルコマンド処理（制御コア、IO_CYCLE_MS 周期）
+
+// コア間スナップショット操作（Tasks.cpp で実装）
+IOSnapshot readIOSnapshot();     // IO コアが最後に公開した値
+ControlSnapshot readControlSnapshot();  // 制御コアが最後に公開した値（IO コア側で参照）
+void syncFromIOSnapshot();       // IOSnapshot → G（制御コア周期の先頭で呼ぶ）
+void publishControlSnapshot();   // G → ControlSnapshot（閾値・状態を IO コアへ）
+void requestAlarmReset();        // IO コアにアラームフラグのクリアを依頼
 
 // EEPROM初期化ラッパー（Tasks.cpp で実装）
 // EEPROMManager を使用してEEPROMからGlobalDataに設定値を反映
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @file LatencyHistogram.h
+ * @brief 固定メモリ・O(1) 記録の対数バケット型レイテンシヒストグラム
+ *
+ * @details
+ * 2 のべき乗ごとに 4 分割したバケット（HDR ヒストグラムの簡易版）を使い、
+ * 相対誤差 25% 以内で p50/p99 を推定する。記録は clz 1 回 + 加算のみ。
+ *
+ * バケット配置（単位は呼び出し側の任意単位、通常は µs）:
+ * - index 0〜3   : 値 0〜3 をそのまま
+ * - index 4 以降 : 最上位ビット msb (>=2) と次の 2 ビット sub から
+ *                  index = (msb - 1) * 4 + sub
+ *
+ * 2^24 以上（µs なら約 16.7 秒以上）は最終バケットに丸める。
+ */
+class LatencyHistogram {
+public:
+  static constexpr uint8_t  MAX_BITS = 24;
+  static constexpr uint8_t  BUCKETS  = (MAX_BITS - 1) * 4;  // 92 バケット = 368 bytes
+  static constexpr uint32_t MAX_VALUE = (1UL << MAX_BITS) - 1;
+
+  LatencyHistogram() { reset(); }
+
+  /**
+   * @brief 全カウンタをクリア
+   */
+  void reset() {
+    memset(m_buckets, 0, sizeof(m_buckets));
+    m_count    = 0;
+    m_max      = 0;
+    m_overruns = 0;
+  }
+
+  /**
+   * @brief 1 サンプルを記録
+   * @param value  計測値（µs 等）
+   * @param budget 予算値。value がこれを超えたら超過カウンタを加算（0 で無効）
+   */
+  void record(uint32_t value, uint32_t budget = 0) {
+    m_buckets[bucketIndex(value)]++;
+    m_count++;
+    if (value > m_max) m_max = value;
+    if (budget != 0 && value > budget) m_overruns++;
+  }
+
+  uint32_t count() const { return m_count; }
+  uint32_t max() const { return m_max; }
+  uint32_t overruns() const { return m_overruns; }
+  uint32_t bucketCount(uint8_t index) const { return (index < BUCKETS) ? m_buckets[index] : 0; }
+
+  /**
+   * @brief パーセンタイル推定値（該当バケットの上限、ただし max を超えない）
+   * @param permille 千分率（p99 なら 990）
+   * @return 推定値。サンプル 0 件なら 0
+   */
+  uint32_t percentile(uint32_t permille) const {
+    if (m_count == 0) return 0;
+    if (permille > 1000) permille = 1000;
+    // 必要な順位 = ceil(count * permille / 1000)（最低 1）
+    uint64_t rank = (static_cast<uint64_t>(m_count) * permille + 999) / 1000;
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; ++i) {
+      seen += m_buckets[i];
+      if (seen >= rank) {
+        const uint32_t upper = bucketUpper(i);
+        return (upper < m_max) ? upper : m_max;
+      }
+    }
+    return m_max;
+  }
+
+  /**
+   * @brief 値 → バケット番号
+   */
+  static uint8_t bucketIndex(uint32_t value) {
+    if (value > MAX_VALUE) value = MAX_VALUE;
+    if (value < 4) return static_cast<uint8_t>(value);
+    const uint8_t msb = static_cast<uint8_t>(31 - __builtin_clz(value));
+    const uint8_t sub = static_cast<uint8_t>((value >> (msb - 2)) & 0x3U);
+    return static_cast<uint8_t>((msb - 1) * 4 + sub);
+  }
+
+  /**
+   * @brief バケットの下限値（含む）
+   */
+  static uint32_t bucketLower(uint8_t index) {
+    if (index < 4) return index;
+    const uint8_t msb = static_cast<uint8_t>(index / 4 + 1);
+    const uint8_t sub = static_cast<uint8_t>(index % 4);
+    return (4UL + sub) << (msb - 2);
+  }
+
+  /**
+   * @brief バケットの上限値（含む）
+   */
+  static uint32_t bucketUpper(uint8_t index) {
+    if (index + 1 >= BUCKETS) return MAX_VALUE;
+    return bucketLower(static_cast<uint8_t>(index + 1)) - 1;
+  }
+
+private:
+  uint32_t m_buckets[BUCKETS];
+  uint32_t m_count;
+  uint32_t m_max;
+  uint32_t m_overruns;
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+
+/**
+ * @file LogFilter.h
+ * @brief RUN 中の記録判定（新サンプル駆動 + デッドバンド）
+ *
+ * @details
+ * 熱電対の値は TC_READ_INTERVAL_MS（500ms）ごとにしか更新されないため、
+ * 従来の「IO 10 周期（100ms）ごとに 1 行」では 5 行中 4 行が直前の行の複製だった。
+ * Storage_Task は「新しいセンサ値」または「アラーム状態の変化」を 1 イベントとして
+ * offer() し、このクラスが記録するかを判定する。
+ *
+ * 【モード】
+ * - SAMPLE  : 全イベントを記録（新しいサンプルごとに 1 行、複製行は出ない）
+ * - DEADBAND: 前回記録値からの変化 |Δ| > epsilon、または前回記録から
+ *             maxIntervalMs 経過したときだけ記録（平坦な区間を間引く）
+ * どちらのモードでも RUN 最初のイベントとアラーム状態の変化は必ず記録する。
+ * NaN ⇔ 数値の変化も「変化」として記録する（断線の開始・復帰を落とさない）。
+ *
+ * 記録した行は取得時刻（経過 ms）を持つため、間引いた区間は
+ * 「次の記録行まで値は ±epsilon 以内で一定」として元の系列を再構成できる
+ * （最大 maxIntervalMs ごとに生存確認の行が入る）。
+ */
+class LogFilter {
+public:
+  /**
+   * @brief 記録理由（offer() の戻り値、NONE は記録しない）
+   */
+  enum Reason : uint8_t {
+    NONE,
+    FIRST,      // RUN 最初のイベント
+    SAMPLE,     // SAMPLE モードの通常記録
+    CHANGE,     // |Δ| > epsilon（NaN の出入りを含む）
+    INTERVAL,   // maxIntervalMs 経過
+    ALARM       // アラーム状態の変化
+  };
+
+  /**
+   * @brief RUN 中の判定統計（フッタ・シリアル表示用）
+   */
+  struct Stats {
+    uint32_t offered;     // 判定したイベント数
+    uint32_t written;     // 記録したイベント数
+    uint32_t byChange;
+    uint32_t byInterval;
+    uint32_t byAlarm;
+  };
+
+  LogFilter() : m_deadband(false), m_epsilon(0.0f), m_maxIntervalMs(0) { reset(); }
+
+  /**
+   * @brief モード設定（RUN 開始時に reset() と組で呼ぶ）
+   * @param deadband      false: SAMPLE / true: DEADBAND
+   * @param epsilon       デッドバンド幅 [°C]
+   * @param maxIntervalMs 記録間隔の上限 [ms]（0 = 上限なし）
+   */
+  void configure(bool deadband, float epsilon, uint32_t maxIntervalMs) {
+    m_deadband      = deadband;
+    m_epsilon       = epsilon;
+    m_maxIntervalMs = maxIntervalMs;
+  }
+
+  /**
+   * @brief 統計と前回記録値のクリア（次のイベントは FIRST で記録される）
+   */
+  void reset() {
+    m_stats      = Stats();
+    m_haveLast   = false;
+    m_lastValue  = NAN;
+    m_lastTimeMs = 0;
+    m_lastFlags  = 0;
+  }
+
+  /**
+   * @brief 前回記録値だけクリア（統計は続ける。次のイベントは FIRST で記録される）
+   * @details ソークの区間切り替えで、時刻の基準が変わった新しいファイルの先頭に必ず 1 行入れる
+   */
+  void restart() {
+    m_haveLast   = false;
+    m_lastTimeMs = 0;
+  }
+
+  /**
+   * @brief 1 イベントを判定
+   * @param timeMs RUN 開始からの経過時間 [ms]
+   * @param value  温度 [°C]（NaN 可）
+   * @param flags  アラーム状態（ビットの組み合わせは呼び出し側の定義）
+   * @return 記録理由（NONE なら記録しない）
+   */
+  Reason offer(uint32_t timeMs, float value, uint8_t flags) {
+    m_stats.offered++;
+    Reason reason = NONE;
+    if (!m_haveLast) {
+      reason = FIRST;
+    } else if (flags != m_lastFlags) {
+      reason = ALARM;
+      m_stats.byAlarm++;
+    } else if (!m_deadband) {
+      reason = SAMPLE;
+    } else if (changed(value)) {
+      reason = CHANGE;
+      m_stats.byChange++;
+    } else if (m_maxIntervalMs > 0 && timeMs - m_lastTimeMs >= m_maxIntervalMs) {
+      reason = INTERVAL;
+      m_stats.byInterval++;
+    }
+    if (reason == NONE) return NONE;
+
+    m_stats.written++;
+    m_haveLast   = true;
+    m_lastValue  = value;
+    m_lastTimeMs = timeMs;
+    m_lastFlags  = flags;
+    return reason;
+  }
+
+  bool         deadband() const { return m_deadband; }
+  const Stats& stats() const { return m_stats; }
+
+  /**
+   * @brief 判定統計のフッタ行（'# LOGF,...'）
+   * @return 書き込んだバイト数
+   */
+  size_t formatFooter(char* buf, size_t len) const {
+    const int n = snprintf(buf, len,
+                           "# LOGF,mode=%s,eps=%.2f,max_interval_ms=%lu,offered=%lu,written=%lu,"
+                           "change=%lu,interval=%lu,alarm=%lu\r\n",
+                           m_deadband ? "deadband" : "sample", static_cast<double>(m_epsilon),
+                           static_cast<unsigned long>(m_maxIntervalMs),
+                           static_cast<unsigned long>(m_stats.offered),
+                           static_cast<unsigned long>(m_stats.written),
+                           static_cast<unsigned long>(m_stats.byChange),
+                           static_cast<unsigned long>(m_stats.byInterval),
+                           static_cast<unsigned long>(m_stats.byAlarm));
+    if (n <= 0) return 0;
+    return (static_cast<size_t>(n) < len) ? static_cast<size_t>(n) : len - 1;
+  }
+
+private:
+  bool changed(float value) const {
+    const bool nanNow  = std::isnan(value);
+    const bool nanLast = std::isnan(m_lastValue);
+    if (nanNow || nanLast) return nanNow != nanLast;
+    return std::fabs(value - m_lastValue) > m_epsilon;
+  }
+
+  bool     m_deadband;
+  float    m_epsilon;
+  uint32_t m_maxIntervalMs;
+
+  Stats    m_stats;
+  bool     m_haveLast;
+  float    m_lastValue;
+  uint32_t m_lastTimeMs;
+  uint8_t  m_lastFlags;
+};
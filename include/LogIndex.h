@@ -0,0 +1,286 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "BinaryLog.h"
+#include "DeltaCodec.h"
+#include "LogRecovery.h"
+
+/**
+ * @file LogIndex.h
+ * @brief ログファイルの疎な時刻索引（経過時間 → バイトオフセット）
+ *
+ * @details
+ * 「経過 3:15:00 の位置」を探すのに先頭から全行を読むと、GB 級のログでは
+ * 実機でも転送先でも遅すぎる。SDManager は生ログと並べて索引ファイル
+ * （DATA_0003.idx）を作り、SD_INDEX_INTERVAL_RECORDS レコードごとに
+ * 「その位置から読み始めれば時刻順に読める点」を 1 エントリ記録する。
+ *
+ * 【読み始められる点（同期点）】
+ * - CSV           : データ行の先頭
+ * - BINARY / DELTA: データブロックの先頭（ブロック内は先頭から復号する）
+ *
+ * 【ファイル構成】（リトルエンディアン）
+ * - ヘッダ 32B: マジック "STLOGIDX" / u16 版数 / u16 エントリ長 / u32 間隔 /
+ *   u32 エントリ数 / u8 完了フラグ / u8 ログ形式 / 予約 / u32 CRC-32（先頭 28B）
+ * - エントリ 12B × n: u32 経過時間 [ms] / u32 オフセット / u32 レコード番号
+ * RUN 中はエントリ数 0・完了フラグ 0 のままで、読み出し側はファイルサイズから
+ * 件数を求める。closeFile() でエントリ数と完了フラグを書く。
+ * 電源断で閉じられなかった場合、起動時の復旧が有効長より先を指すエントリを
+ * 捨て、最後のエントリから有効長までを走査して不足分を足す（scanCsv / scanBlocks）。
+ *
+ * エントリは経過時間・オフセットとも単調増加のため、lookup() は
+ * 二分探索で O(log n) 回の読み出しで済む。
+ */
+
+/**
+ * @brief 索引 1 エントリ
+ */
+struct LogIndexEntry {
+  uint32_t elapsedMs;   // 同期点の最初のレコードの経過時間
+  uint32_t offset;      // 生ログ内のバイトオフセット
+  uint32_t recordSeq;   // 同期点の最初のレコードの番号（0 始まり）
+};
+
+/**
+ * @brief 索引ファイルのヘッダ
+ */
+struct LogIndexHeader {
+  uint32_t interval;    // エントリ間隔 [レコード]
+  uint32_t count;       // エントリ数（0 = 未確定、ファイルサイズから求める）
+  uint8_t  complete;    // 1 = closeFile() / 復旧で確定済み
+  uint8_t  logFormat;   // 0 = CSV / 1 = BINARY / 2 = DELTA（LogFormat の数値）
+};
+
+class LogIndex {
+public:
+  static constexpr uint16_t VERSION     = 1;
+  static constexpr size_t   HEADER_SIZE = 32;
+  static constexpr size_t   ENTRY_SIZE  = 12;
+
+  /**
+   * @brief 同期点ごとに呼び、エントリを書くかを決める
+   */
+  class Builder {
+  public:
+    explicit Builder(uint32_t interval) : m_interval(interval ? interval : 1) { reset(); }
+
+    void reset() {
+      m_have    = false;
+      m_lastSeq = 0;
+    }
+
+    /**
+     * @brief 既存の最後のエントリから続ける（復旧時）
+     */
+    void resumeAfter(const LogIndexEntry& last) {
+      m_have    = true;
+      m_lastSeq = last.recordSeq;
+    }
+
+    /**
+     * @return true : out を書く（最初の同期点、または前回から interval レコード以上）
+     */
+    bool offer(uint32_t recordSeq, uint32_t elapsedMs, uint32_t offset, LogIndexEntry& out) {
+      if (m_have && recordSeq - m_lastSeq < m_interval) return false;
+      m_have      = true;
+      m_lastSeq   = recordSeq;
+      out.elapsedMs = elapsedMs;
+      out.offset    = offset;
+      out.recordSeq = recordSeq;
+      return true;
+    }
+
+    uint32_t interval() const { return m_interval; }
+
+  private:
+    uint32_t m_interval;
+    bool     m_have;
+    uint32_t m_lastSeq;
+  };
+
+  // ── エンコード / デコード ────────────────────────────────────────────────
+
+  static void encodeHeader(const LogIndexHeader& h, uint8_t* out) {
+    memset(out, 0, HEADER_SIZE);
+    memcpy(out, magic(), 8);
+    BinaryLog::put16(out + 8, VERSION);
+    BinaryLog::put16(out + 10, static_cast<uint16_t>(ENTRY_SIZE));
+    BinaryLog::put32(out + 12, h.interval);
+    BinaryLog::put32(out + 16, h.count);
+    out[20] = h.complete;
+    out[21] = h.logFormat;
+    BinaryLog::put32(out + 28, BinaryLog::crc32(0, out, 28));
+  }
+
+  /**
+   * @return false : マジック・版数・エントリ長・CRC のいずれかが不正
+   */
+  static bool decodeHeader(const uint8_t* in, LogIndexHeader& h) {
+    if (memcmp(in, magic(), 8) != 0 || BinaryLog::get16(in + 8) != VERSION ||
+        BinaryLog::get16(in + 10) != ENTRY_SIZE ||
+        BinaryLog::get32(in + 28) != BinaryLog::crc32(0, in, 28)) {
+      return false;
+    }
+    h.interval  = BinaryLog::get32(in + 12);
+    h.count     = BinaryLog::get32(in + 16);
+    h.complete  = in[20];
+    h.logFormat = in[21];
+    return true;
+  }
+
+  static void encodeEntry(const LogIndexEntry& e, uint8_t* out) {
+    BinaryLog::put32(out + 0, e.elapsedMs);
+    BinaryLog::put32(out + 4, e.offset);
+    BinaryLog::put32(out + 8, e.recordSeq);
+  }
+
+  static void decodeEntry(const uint8_t* in, LogIndexEntry& e) {
+    e.elapsedMs = BinaryLog::get32(in + 0);
+    e.offset    = BinaryLog::get32(in + 4);
+    e.recordSeq = BinaryLog::get32(in + 8);
+  }
+
+  /**
+   * @brief 索引ファイルのエントリ数（確定済みならヘッダ、未確定ならファイルサイズから）
+   */
+  static uint32_t entryCount(const LogIndexHeader& h, uint32_t fileSize) {
+    const uint32_t bySize =
+        (fileSize > HEADER_SIZE) ? static_cast<uint32_t>((fileSize - HEADER_SIZE) / ENTRY_SIZE) : 0;
+    return (h.complete && h.count <= bySize) ? h.count : bySize;
+  }
+
+  static uint32_t entryOffset(uint32_t i) { return static_cast<uint32_t>(HEADER_SIZE + i * ENTRY_SIZE); }
+
+  // ── 探索 ──────────────────────────────────────────────────────────────────
+
+  /**
+   * @brief key(entry) <= target となる最後のエントリを二分探索（O(log n) 回の読み出し）
+   *
+   * @tparam Source size_t read(uint32_t offset, uint8_t* buf, size_t len) を持つ型（索引ファイル）
+   * @param byOffset false: 経過時間で探す / true: 生ログのオフセットで探す
+   * @param index [out] 見つかったエントリ番号
+   * @return false : エントリが無い、または target が最初のエントリより前
+   */
+  template <typename Source>
+  static bool lookup(Source& src, uint32_t count, uint32_t target, bool byOffset,
+                     LogIndexEntry& out, uint32_t& index) {
+    uint32_t lo = 0, hi = count;   // 答えは [lo, hi) の中の「最後の該当」
+    bool     found = false;
+    while (lo < hi) {
+      const uint32_t mid = lo + (hi - lo) / 2;
+      LogIndexEntry  e;
+      if (!readEntry(src, mid, e)) return false;
+      if ((byOffset ? e.offset : e.elapsedMs) <= target) {
+        out   = e;
+        index = mid;
+        found = true;
+        lo    = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return found;
+  }
+
+  template <typename Source>
+  static bool readEntry(Source& src, uint32_t i, LogIndexEntry& e) {
+    uint8_t buf[ENTRY_SIZE];
+    if (src.read(entryOffset(i), buf, sizeof(buf)) != sizeof(buf)) return false;
+    decodeEntry(buf, e);
+    return true;
+  }
+
+  // ── 再構築（生ログの走査）──────────────────────────────────────────────────
+
+  /**
+   * @brief CSV の [from, to) を走査し、同期点ごとに builder へ渡す
+   *
+   * @details
+   * from は行の先頭であること。'#' 行はレコードに数えない。不正な行で止まる。
+   * emit(const LogIndexEntry&) は書くと決まったエントリごとに呼ばれる。
+   *
+   * @param seq [in/out] from の行のレコード番号 → 走査後の次の番号
+   * @return 走査を終えたオフセット（最後の完全な行の直後）
+   */
+  template <typename Source, typename Emit>
+  static uint32_t scanCsv(Source& src, uint32_t from, uint32_t to, uint32_t& seq,
+                          Builder& builder, Emit& emit) {
+    char     line[LogRecovery::MAX_LINE];
+    size_t   lineLen   = 0;
+    uint32_t lineStart = from;
+    uint32_t pos       = from;
+    uint8_t  chunk[256];
+    while (pos < to) {
+      const size_t want = (to - pos < sizeof(chunk)) ? to - pos : sizeof(chunk);
+      const size_t got  = src.read(pos, chunk, want);
+      if (got == 0) break;
+      for (size_t i = 0; i < got; ++i) {
+        const char c = static_cast<char>(chunk[i]);
+        if (lineLen < sizeof(line)) line[lineLen] = c;
+        ++lineLen;
+        if (c != '\n') continue;
+        const uint32_t next = pos + static_cast<uint32_t>(i) + 1;
+        if (lineLen > sizeof(line) || lineLen < 2 || line[lineLen - 2] != '\r') return lineStart;
+        if (line[0] != '#') {
+          LogCheckpoint row;
+          if (!LogRecovery::parseCsvRow(line, lineLen - 2, row)) return lineStart;
+          LogIndexEntry e;
+          if (builder.offer(seq, row.elapsedMs, lineStart, e)) emit(e);
+          ++seq;
+        }
+        lineStart = next;
+        lineLen   = 0;
+      }
+      pos += static_cast<uint32_t>(got);
+    }
+    return lineStart;
+  }
+
+  /**
+   * @brief BINARY / DELTA の [from, to) をブロック単位で走査
+   *
+   * @details
+   * from はブロック境界であること。TEXT ブロックは数えない。
+   * 空（全ゼロ）・破損ブロックで止まる。
+   */
+  template <typename Source, typename Emit>
+  static uint32_t scanBlocks(Source& src, const BinLogHeader& h, uint32_t from, uint32_t to,
+                             uint32_t& seq, Builder& builder, Emit& emit) {
+    alignas(4) uint8_t block[BinaryLog::BLOCK_SIZE];
+    uint32_t pos = from;
+    while (pos + BinaryLog::BLOCK_SIZE <= to) {
+      if (src.read(pos, block, sizeof(block)) != sizeof(block)) break;
+      uint8_t  type = 0;
+      uint16_t count = 0;
+      uint32_t blockSeq = 0;
+      if (BinaryLog::checkBlock(block, type, count, blockSeq) != BinaryLog::BlockStatus::OK) break;
+      const uint8_t* payload = block + BinaryLog::BLOCK_HEADER_SIZE;
+      uint32_t firstMs = 0;
+      bool     data    = false;
+      if (type == BinaryLog::BLOCK_DATA && count > 0) {
+        BinLogRecord rec;
+        BinaryLog::decodeRecord(payload, rec, h.schemaVersion);
+        firstMs = rec.elapsedMs;
+        data    = true;
+      } else if (type == BinaryLog::BLOCK_DELTA && count > 0) {
+        DeltaDecoder dec;
+        dec.reset(payload, BinaryLog::PAYLOAD_SIZE, count);
+        int32_t v;
+        uint8_t f;
+        data = dec.next(firstMs, v, f);
+      }
+      if (data) {
+        LogIndexEntry e;
+        if (builder.offer(seq, firstMs, pos, e)) emit(e);
+        seq += count;
+      }
+      pos += static_cast<uint32_t>(BinaryLog::BLOCK_SIZE);
+    }
+    return pos;
+  }
+
+private:
+  static const char* magic() { return "STLOGIDX"; }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @file LogPrealloc.h
+ * @brief ログファイルの事前確保（サイズ計画）と有効長マーカー
+ *
+ * @details
+ * 空のファイルへ追記すると、クラスタ境界をまたぐたびに FAT の空き探索・
+ * チェーン更新が write() の中で起き、RUN 中の最悪レイテンシになる。
+ * SDManager はファイル作成時に想定 RUN 長ぶんを先に確保し、RUN 中は確保済み
+ * 領域の中だけを書く。確保済み領域の未書き込み部分は不定値（カードの旧データ）
+ * のため、実データの終端を「有効長マーカー」としてファイル先頭セクタに記録し、
+ * 同期のたびに更新する。closeFile() で有効長まで切り詰める。
+ * マーカーには「正常にクローズしたか」も記録し、起動時の復旧処理
+ * （LogRecovery.h）が電源断で閉じられなかったファイルを見分ける。
+ *
+ * 【有効長マーカーの位置】
+ * - BINARY / DELTA : BinLogHeader::validBytes / closed（ヘッダ 512B 内、CRC 付き）
+ * - CSV            : 列名行の次の '#' 行（先頭セクタを 512B ちょうどに埋める）
+ *     ElapsedSec,Temp_C,...\r\n
+ *     # LOG,valid_bytes=0000012345,closed=0<空白>\r\n
+ *   フッタ（'# PERF,...'）と同じコメント行の扱いで、表計算ソフトでは無視できる。
+ *
+ * 先頭セクタは常に 512B ちょうどのため、SectorWriter が以後そのセクタを
+ * 書き直すことはなく、マーカー更新は先頭セクタ 1 つの上書きで済む。
+ */
+class LogPrealloc {
+public:
+  static constexpr size_t SECTOR_SIZE = 512;
+
+  /**
+   * @brief 想定 RUN 長ぶんの確保サイズ（unitBytes の倍数に切り上げ）
+   * @param bytesPerSecond 形式ごとの書き込みレート見積り
+   * @param seconds        想定 RUN 長 [s]
+   * @param unitBytes      確保単位（クラスタサイズ相当）
+   */
+  static uint32_t planBytes(uint32_t bytesPerSecond, uint32_t seconds, uint32_t unitBytes) {
+    uint64_t bytes = static_cast<uint64_t>(bytesPerSecond) * seconds;
+    if (unitBytes == 0) unitBytes = SECTOR_SIZE;
+    if (bytes < unitBytes) bytes = unitBytes;
+    bytes = (bytes + unitBytes - 1) / unitBytes * unitBytes;
+    const uint64_t limit = 0xFFFFFFFFull / unitBytes * unitBytes;   // FAT32 のファイル上限
+    return static_cast<uint32_t>(bytes > limit ? limit : bytes);
+  }
+
+  /**
+   * @brief 確保済み領域の残りが marginBytes を下回ったか（追加確保が必要か）
+   */
+  static bool needsExtension(uint32_t usedBytes, uint32_t allocatedBytes, uint32_t marginBytes) {
+    return usedBytes + static_cast<uint64_t>(marginBytes) > allocatedBytes;
+  }
+
+  /**
+   * @brief CSV の先頭セクタ（列名行 + 有効長マーカー行）を 512B に整形
+   * @param columns 列名（改行無し）
+   * @param closed  正常にクローズ済みか
+   * @return false : 列名が長すぎて 1 セクタに収まらない
+   */
+  static bool formatCsvHeaderSector(const char* columns, uint32_t validBytes, bool closed,
+                                    uint8_t* out) {
+    const size_t colLen = strlen(columns);
+    char marker[48];
+    const int markerLen = snprintf(marker, sizeof(marker), "%s%010lu,closed=%c", markerPrefix(),
+                                   static_cast<unsigned long>(validBytes), closed ? '1' : '0');
+    if (markerLen <= 0 || colLen + 2 + static_cast<size_t>(markerLen) + 2 > SECTOR_SIZE) {
+      return false;
+    }
+    memset(out, ' ', SECTOR_SIZE);
+    memcpy(out, columns, colLen);
+    out[colLen]     = '\r';
+    out[colLen + 1] = '\n';
+    memcpy(out + colLen + 2, marker, static_cast<size_t>(markerLen));
+    out[SECTOR_SIZE - 2] = '\r';
+    out[SECTOR_SIZE - 1] = '\n';
+    return true;
+  }
+
+  /**
+   * @brief CSV の先頭セクタから有効長とクローズ済みフラグを読む
+   * @return false : マーカー行が無い（事前確保前のファイル等）
+   */
+  static bool parseCsvHeaderSector(const uint8_t* in, uint32_t& validBytes, bool& closed) {
+    const char* s = reinterpret_cast<const char*>(in);
+    size_t i = 0;
+    while (i + 1 < SECTOR_SIZE && !(s[i] == '\r' && s[i + 1] == '\n')) ++i;
+    i += 2;
+    const size_t prefixLen = strlen(markerPrefix());
+    if (i + prefixLen + 19 > SECTOR_SIZE || memcmp(s + i, markerPrefix(), prefixLen) != 0) {
+      return false;
+    }
+    uint32_t v = 0;
+    for (size_t k = i + prefixLen; k < i + prefixLen + 10; ++k) {
+      if (s[k] < '0' || s[k] > '9') return false;
+      v = v * 10 + static_cast<uint32_t>(s[k] - '0');
+    }
+    const char* c = s + i + prefixLen + 10;
+    if (memcmp(c, ",closed=", 8) != 0 || (c[8] != '0' && c[8] != '1')) return false;
+    validBytes = v;
+    closed     = (c[8] == '1');
+    return true;
+  }
+
+private:
+  // C++11 では constexpr 静的メンバ文字列を odr-use できないため関数で返す
+  static const char* markerPrefix() { return "# LOG,valid_bytes="; }
+};
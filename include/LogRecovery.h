@@ -0,0 +1,465 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include "BinaryLog.h"
+#include "DeltaCodec.h"
+
+/**
+ * @file LogRecovery.h
+ * @brief チェックポイント記録と、閉じられなかったログの復旧（末尾走査）
+ *
+ * @details
+ * RUN 中に電源が落ちると、ファイルは書きかけの行で終わり、RUN の統計も
+ * 残らない。SDManager は通常の書き込みの一部として一定間隔でチェックポイント
+ * （記録済みレコード数と、その時点の累積統計）を書く。
+ *   # CKPT,seq=1200,elapsed_ms=120000,samples=2400,avg=312.45,sd=1.234,max=320.50,min=25.00\r\n
+ * - CSV            : 上記のコメント行（SD_CHECKPOINT_INTERVAL_MS ごと）
+ * - BINARY / DELTA : 同じ行を TEXT ブロックで（データブロック SD_CHECKPOINT_BLOCKS 個ごと）
+ *
+ * 起動時、有効長マーカー（LogPrealloc.h）が closed=0 のファイルについて、
+ * 有効長の手前 windowBytes だけを先頭から読み直し（末尾のみ・セクタ単位）、
+ * - 最後の完全なレコードの終端（= 切り詰め位置）
+ * - 最後のチェックポイントと、それ以降のレコードから求めた RUN 要約
+ * を求める。読む量は windowBytes（+ バイナリの先読み）で頭打ちのため、
+ * ファイルがどれだけ大きくても時間・メモリは一定（バッファは 512B + 1 行分）。
+ * チェックポイント間隔は windowBytes に収まるよう選ぶ。
+ *
+ * 要約の統計は CSV / BINARY では最後のレコード（累積統計の列を持つ）から、
+ * DELTA と累積統計の列を持たない CSV（LeanLogLayout、LogSchema.h）では最後の
+ * チェックポイントから取り、最高・最低・経過時間・件数のみ以降のサンプルで更新する。
+ *
+ * @tparam Source 以下を持つ型（SD 上のファイル、テスト用メモリ等）
+ *   - size_t read(uint32_t offset, uint8_t* buf, size_t len)  読めたバイト数を返す
+ */
+
+/**
+ * @brief チェックポイント / 復旧要約の内容
+ */
+struct LogCheckpoint {
+  uint32_t seq;         // 記録済みレコード数（CSV 行 / BINARY レコード / DELTA サンプル）
+  uint32_t elapsedMs;   // 最後のレコードの経過時間 [ms]
+  uint32_t samples;     // 統計のサンプル数
+  float    average;     // 累積平均 [°C]
+  float    stdDev;      // 累積標準偏差 [°C]
+  float    maxTemp;     // 最高 [°C]
+  float    minTemp;     // 最低 [°C]
+};
+
+class LogRecovery {
+public:
+  static constexpr size_t SECTOR_SIZE   = 512;
+  static constexpr size_t MAX_LINE      = 160;   // CSV 行・チェックポイント行の上限
+
+  /**
+   * @brief 走査結果
+   */
+  struct Result {
+    uint32_t      validEnd;       // 最後の完全なレコードの終端（切り詰め位置）
+    uint32_t      nextBlockSeq;   // 次に書くブロック番号（BINARY / DELTA）
+    uint32_t      recordsAfter;   // 最後のチェックポイント以降のレコード数
+    uint32_t      corruptBlocks;  // 有効長内で CRC 不一致だったブロック数
+    bool          haveCheckpoint; // 走査範囲にチェックポイントがあった
+    LogCheckpoint summary;        // RUN 要約（seq = 記録済みレコード数）
+  };
+
+  // ── チェックポイント行 ────────────────────────────────────────────────────
+
+  /**
+   * @brief "# <tag>,seq=...,min=...\r\n" を整形（NaN は "NaN"）
+   * @return 書き込んだ文字数（終端 NUL を除く）
+   */
+  static size_t formatCheckpoint(const char* tag, const LogCheckpoint& c, char* buf, size_t len) {
+    char avg[16], sd[16], mx[16], mn[16];
+    formatFloat(c.average, 2, avg);
+    formatFloat(c.stdDev, 3, sd);
+    formatFloat(c.maxTemp, 2, mx);
+    formatFloat(c.minTemp, 2, mn);
+    const int n = snprintf(buf, len,
+                           "# %s,seq=%lu,elapsed_ms=%lu,samples=%lu,avg=%s,sd=%s,max=%s,min=%s\r\n",
+                           tag, static_cast<unsigned long>(c.seq),
+                           static_cast<unsigned long>(c.elapsedMs),
+                           static_cast<unsigned long>(c.samples), avg, sd, mx, mn);
+    if (n <= 0) return 0;
+    return (static_cast<size_t>(n) < len) ? static_cast<size_t>(n) : len - 1;
+  }
+
+  /**
+   * @brief "# CKPT,..." 行の解析（CRLF は含んでも含まなくてもよい）
+   * @return false : チェックポイント行ではない、または欠損
+   */
+  static bool parseCheckpoint(const char* line, size_t len, LogCheckpoint& c) {
+    char buf[MAX_LINE];
+    if (len >= sizeof(buf)) return false;
+    memcpy(buf, line, len);
+    buf[len] = '\0';
+    static const char prefix[] = "# CKPT,";
+    if (strncmp(buf, prefix, sizeof(prefix) - 1) != 0) return false;
+
+    static const char* const keys[] = {"seq=", "elapsed_ms=", "samples=",
+                                       "avg=", "sd=", "max=", "min="};
+    char* p = buf + sizeof(prefix) - 1;
+    LogCheckpoint out;
+    for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k) {
+      const size_t kl = strlen(keys[k]);
+      if (strncmp(p, keys[k], kl) != 0) return false;
+      p += kl;
+      char* end = nullptr;
+      if (k < 3) {
+        const unsigned long v = strtoul(p, &end, 10);
+        if (end == p) return false;
+        (k == 0 ? out.seq : k == 1 ? out.elapsedMs : out.samples) = static_cast<uint32_t>(v);
+      } else {
+        const float v = strtof(p, &end);
+        if (end == p) return false;
+        (k == 3 ? out.average : k == 4 ? out.stdDev : k == 5 ? out.maxTemp : out.minTemp) = v;
+      }
+      p = end;
+      if (k + 1 < sizeof(keys) / sizeof(keys[0])) {
+        if (*p != ',') return false;
+        ++p;
+      }
+    }
+    if (*p != '\0' && *p != '\r') return false;
+    c = out;
+    return true;
+  }
+
+  /**
+   * @brief CSV データ行（10 列、ElapsedMs 列付きは 11 列、WallTime 列付きは 12 列）を解析して
+   *        累積統計を取り出す（WallTime は空でもよく、中身は見ない）
+   *
+   * @details
+   * LeanLogLayout の行（ElapsedMs,Temp_C,HI_ALARM,LO_ALARM[,WallTime] の 4〜5 列）も受け付け、
+   * 経過時間と、最高・最低 = その行の温度を返す（samples = 0、平均・標準偏差は NaN）。
+   * @param cumulative 累積統計の列を持つ行だったか（nullptr 可）
+   * @return false : 列数・数値が不正（書きかけの行等）
+   */
+  static bool parseCsvRow(const char* line, size_t len, LogCheckpoint& c,
+                          bool* cumulative = nullptr) {
+    char buf[MAX_LINE];
+    if (len >= sizeof(buf) || len == 0) return false;
+    memcpy(buf, line, len);
+    buf[len] = '\0';
+    char* fields[12];
+    size_t n = 0;
+    char* p = buf;
+    fields[n++] = p;
+    for (; *p != '\0'; ++p) {
+      if (*p == ',') {
+        if (n == 12) return false;
+        *p = '\0';
+        fields[n++] = p + 1;
+      }
+    }
+    if (n == 4 || n == 5) {
+      uint32_t ms = 0;
+      float    t  = 0;
+      if (!parseU32(fields[0], ms) || !parseF(fields[1], t) || !parseBool(fields[2]) ||
+          !parseBool(fields[3]) || (n == 5 && !isWallTime(fields[4]))) {
+        return false;
+      }
+      clearStats(c);
+      c.elapsedMs = ms;
+      c.maxTemp   = t;
+      c.minTemp   = t;
+      if (cumulative != nullptr) *cumulative = false;
+      return true;
+    }
+    if (n < 10) return false;
+    uint32_t elapsedSec = 0, elapsedMs = 0, samples = 0;
+    float    temp = 0, avg = 0, sd = 0, mx = 0, mn = 0;
+    if (!parseU32(fields[0], elapsedSec) || !parseF(fields[1], temp) || fields[2][0] == '\0' ||
+        !parseU32(fields[3], samples) || !parseF(fields[4], avg) || !parseF(fields[5], sd) ||
+        !parseF(fields[6], mx) || !parseF(fields[7], mn) || !parseBool(fields[8]) ||
+        !parseBool(fields[9]) || (n >= 11 && !parseU32(fields[10], elapsedMs)) ||
+        (n == 12 && !isWallTime(fields[11]))) {
+      return false;
+    }
+    (void)temp;
+    c.elapsedMs = (n >= 11) ? elapsedMs : elapsedSec * 1000UL;
+    c.samples   = samples;
+    c.average   = avg;
+    c.stdDev    = sd;
+    c.maxTemp   = mx;
+    c.minTemp   = mn;
+    if (cumulative != nullptr) *cumulative = true;
+    return true;
+  }
+
+  // ── 末尾走査 ──────────────────────────────────────────────────────────────
+
+  /**
+   * @brief CSV ログの末尾走査
+   *
+   * @details
+   * [max(dataStart, validBytes - windowBytes), validBytes) を読み、CRLF で
+   * 終わる行のうち、チェックポイント行・その他の '#' 行・データ行（parseCsvRow）を
+   * 有効とする。最初の不正な行（書きかけ・破損）以降は捨てる。
+   * 走査開始が行の途中なら最初の CRLF まで読み飛ばす。
+   *
+   * @param dataStart 先頭セクタ（列名 + マーカー行）の直後
+   */
+  template <typename Source>
+  static void scanCsv(Source& src, uint32_t dataStart, uint32_t validBytes, uint32_t windowBytes,
+                      Result& r) {
+    memset(&r, 0, sizeof(r));
+    clearStats(r.summary);
+    if (validBytes < dataStart) validBytes = dataStart;
+    const uint32_t start =
+        (validBytes - dataStart > windowBytes) ? validBytes - windowBytes : dataStart;
+    bool          skipping = (start > dataStart);
+    uint32_t      lastGood = start;
+    LogCheckpoint row;
+    bool          haveRow = false;
+    Tail          tail;               // 累積統計の列を持たない行（LeanLogLayout）
+    LogCheckpoint lean;
+    bool          cumulative = false;
+
+    uint8_t sector[SECTOR_SIZE];
+    char    line[MAX_LINE];
+    size_t  lineLen = 0;
+    bool    stop = false;
+    for (uint32_t off = start; off < validBytes && !stop; off += SECTOR_SIZE) {
+      size_t want = validBytes - off;
+      if (want > SECTOR_SIZE) want = SECTOR_SIZE;
+      const size_t got = src.read(off, sector, want);
+      for (size_t i = 0; i < got && !stop; ++i) {
+        const char ch = static_cast<char>(sector[i]);
+        if (lineLen >= sizeof(line)) {
+          if (!skipping) stop = true;   // 長すぎる行 = 破損
+          lineLen = 0;
+          continue;
+        }
+        line[lineLen++] = ch;
+        if (ch != '\n') continue;
+
+        const uint32_t lineEnd = off + static_cast<uint32_t>(i) + 1;
+        if (skipping) {
+          skipping = false;
+        } else if (lineLen < 2 || line[lineLen - 2] != '\r') {
+          stop = true;
+        } else if (line[0] == '#') {
+          LogCheckpoint c;
+          if (parseCheckpoint(line, lineLen - 2, c)) {
+            r.summary        = c;
+            r.haveCheckpoint = true;
+            r.recordsAfter   = 0;
+            haveRow          = false;
+            tail.clear();
+          }
+        } else if (parseCsvRow(line, lineLen - 2, lean, &cumulative)) {
+          if (cumulative) {
+            row     = lean;
+            haveRow = true;
+          } else {
+            tail.add(lean.elapsedMs, lean.maxTemp);
+          }
+          r.recordsAfter++;
+        } else {
+          stop = true;
+        }
+        if (!stop) lastGood = lineEnd;
+        lineLen = 0;
+      }
+      if (got < want) break;
+    }
+
+    r.validEnd = lastGood;
+    tail.applyTo(r.summary);
+    finishSummary(r, haveRow ? &row : nullptr);
+  }
+
+  /**
+   * @brief BINARY / DELTA ログの末尾走査
+   *
+   * @details
+   * 有効長の手前 windowBytes からブロック単位で読む。有効長内の CRC 不一致
+   * ブロックは飛ばし（変換ツールと同じ扱い）、有効長より先は「番号が連続する
+   * 正常ブロック」だけを lookaheadBytes まで採用する（マーカー更新前に同期
+   * 済みだったデータを拾う）。旧データや未使用領域は番号が続かないため止まる。
+   *
+   * @param fileSize 実ファイルサイズ（事前確保で有効長より大きいことがある）
+   */
+  template <typename Source>
+  static void scanBinary(Source& src, const BinLogHeader& h, uint32_t fileSize,
+                         uint32_t windowBytes, uint32_t lookaheadBytes, Result& r) {
+    memset(&r, 0, sizeof(r));
+    clearStats(r.summary);
+    const uint32_t dataStart = BinaryLog::HEADER_SIZE;
+    uint32_t validBytes = h.validBytes;
+    if (validBytes < dataStart) validBytes = dataStart;
+    validBytes -= (validBytes - dataStart) % BinaryLog::BLOCK_SIZE;
+    uint32_t start = (validBytes - dataStart > windowBytes) ? validBytes - windowBytes : dataStart;
+    start -= (start - dataStart) % BinaryLog::BLOCK_SIZE;
+    uint64_t limit = static_cast<uint64_t>(validBytes) + lookaheadBytes;
+    if (limit > fileSize) limit = fileSize;
+
+    uint32_t      lastGood = start;
+    bool          haveSeq = false;
+    uint32_t      expected = 0;
+    LogCheckpoint row;
+    bool          haveRow = false;
+    Tail          tail;               // DELTA のサンプル
+
+    uint8_t block[BinaryLog::BLOCK_SIZE];
+    for (uint32_t off = start; off + BinaryLog::BLOCK_SIZE <= limit; off += BinaryLog::BLOCK_SIZE) {
+      const bool inside = (off < validBytes);
+      if (src.read(off, block, sizeof(block)) != sizeof(block)) break;
+      uint8_t  type = 0;
+      uint16_t count = 0;
+      uint32_t seq = 0;
+      const BinaryLog::BlockStatus st = BinaryLog::checkBlock(block, type, count, seq);
+      if (st != BinaryLog::BlockStatus::OK) {
+        if (!inside) break;
+        if (st == BinaryLog::BlockStatus::CORRUPT) r.corruptBlocks++;
+        continue;
+      }
+      if (!inside && (!haveSeq || seq != expected)) break;
+      haveSeq  = true;
+      expected = seq + 1;
+      lastGood = off + BinaryLog::BLOCK_SIZE;
+
+      const uint8_t* payload = block + BinaryLog::BLOCK_HEADER_SIZE;
+      if (type == BinaryLog::BLOCK_TEXT) {
+        LogCheckpoint c;
+        if (parseCheckpoint(reinterpret_cast<const char*>(payload), trimmedLen(payload, count), c)) {
+          r.summary        = c;
+          r.haveCheckpoint = true;
+          r.recordsAfter   = 0;
+          haveRow          = false;
+          tail.clear();
+        }
+      } else if (type == BinaryLog::BLOCK_DATA && count > 0) {
+        const uint16_t n = (count > BinaryLog::RECORDS_PER_BLOCK)
+                               ? static_cast<uint16_t>(BinaryLog::RECORDS_PER_BLOCK) : count;
+        BinLogRecord rec;
+        BinaryLog::decodeRecord(payload + (n - 1) * BinaryLog::RECORD_SIZE, rec,
+                                h.schemaVersion);
+        row.elapsedMs = rec.elapsedMs;
+        row.samples   = rec.sampleCount;
+        row.average   = fromDeci(rec.average);
+        row.stdDev    = fromDeci(rec.stdDev);
+        row.maxTemp   = fromDeci(rec.maxTemp);
+        row.minTemp   = fromDeci(rec.minTemp);
+        haveRow = true;
+        r.recordsAfter += n;
+      } else if (type == BinaryLog::BLOCK_DELTA) {
+        DeltaDecoder dec;
+        dec.reset(payload, BinaryLog::PAYLOAD_SIZE, count);
+        uint32_t t = 0;
+        int32_t  v = 0;
+        uint8_t  f = 0;
+        while (dec.next(t, v, f)) {
+          r.recordsAfter++;
+          tail.add(t, (v == INT32_MIN) ? NAN : static_cast<float>(v) * h.quantumMilliC / 1000.0f);
+        }
+      }
+    }
+
+    r.validEnd     = lastGood;
+    r.nextBlockSeq = haveSeq ? expected : 0;
+    if (h.encoding != BinaryLog::ENCODING_RECORDS) tail.applyTo(r.summary);
+    finishSummary(r, haveRow ? &row : nullptr);
+  }
+
+private:
+  /**
+   * @brief 最後のチェックポイント以降の、累積統計を持たないサンプル（DELTA / LeanLogLayout）
+   * @details 統計はチェックポイントの値のまま、範囲と経過時間だけ以降のサンプルで伸ばす
+   */
+  struct Tail {
+    bool     have;
+    uint32_t lastMs;
+    float    maxTemp;
+    float    minTemp;
+
+    Tail() { clear(); }
+
+    void clear() {
+      have    = false;
+      lastMs  = 0;
+      maxTemp = NAN;
+      minTemp = NAN;
+    }
+
+    void add(uint32_t ms, float temp) {
+      have   = true;
+      lastMs = ms;
+      if (std::isnan(temp)) return;
+      if (std::isnan(maxTemp) || temp > maxTemp) maxTemp = temp;
+      if (std::isnan(minTemp) || temp < minTemp) minTemp = temp;
+    }
+
+    void applyTo(LogCheckpoint& s) const {
+      if (!have) return;
+      s.elapsedMs = lastMs;
+      if (!std::isnan(maxTemp) && (std::isnan(s.maxTemp) || maxTemp > s.maxTemp)) s.maxTemp = maxTemp;
+      if (!std::isnan(minTemp) && (std::isnan(s.minTemp) || minTemp < s.minTemp)) s.minTemp = minTemp;
+    }
+  };
+
+  static void clearStats(LogCheckpoint& c) {
+    c.seq       = 0;
+    c.elapsedMs = 0;
+    c.samples   = 0;
+    c.average   = NAN;
+    c.stdDev    = NAN;
+    c.maxTemp   = NAN;
+    c.minTemp   = NAN;
+  }
+
+  /**
+   * @brief 要約の確定: 最後のレコードの累積統計があれば優先、件数を合算
+   */
+  static void finishSummary(Result& r, const LogCheckpoint* lastRow) {
+    const uint32_t base = r.summary.seq;
+    if (lastRow != nullptr) r.summary = *lastRow;
+    r.summary.seq = base + r.recordsAfter;
+  }
+
+  static float fromDeci(int16_t v) {
+    return (v == BinaryLog::NAN_DECI) ? NAN : static_cast<float>(v) / 10.0f;
+  }
+
+  static size_t trimmedLen(const uint8_t* p, uint16_t count) {
+    size_t n = (count > BinaryLog::PAYLOAD_SIZE) ? BinaryLog::PAYLOAD_SIZE : count;
+    while (n > 0 && (p[n - 1] == '\n' || p[n - 1] == '\r')) --n;
+    return n;
+  }
+
+  static void formatFloat(float v, int decimals, char* out) {
+    if (std::isnan(v)) {
+      strcpy(out, "NaN");
+    } else {
+      snprintf(out, 16, "%.*f", decimals, static_cast<double>(v));
+    }
+  }
+
+  static bool parseU32(const char* s, uint32_t& v) {
+    if (*s < '0' || *s > '9') return false;
+    char* end = nullptr;
+    v = static_cast<uint32_t>(strtoul(s, &end, 10));
+    return *end == '\0';
+  }
+
+  static bool parseF(const char* s, float& v) {
+    char* end = nullptr;
+    v = strtof(s, &end);
+    return end != s && *end == '\0';
+  }
+
+  static bool parseBool(const char* s) {
+    return strcmp(s, "true") == 0 || strcmp(s, "false") == 0;
+  }
+
+  // WallTime 列: 空（実時刻不明）か "2026-10-19T12:34:56.789"（WallClock::putIso）
+  static bool isWallTime(const char* s) {
+    return s[0] == '\0' || (strlen(s) == 23 && s[4] == '-' && s[10] == 'T' && s[19] == '.');
+  }
+};
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include "FixedFormat.h"
+#include "WallClock.h"
+
+/**
+ * @file LogSchema.h
+ * @brief ログの列構成（コンパイル時の列リスト）と、そこから生成する行・列名の整形
+ *
+ * @details
+ * CSV の 1 行は従来すべての列（累積の平均・標準偏差・最高・最低を含む）を
+ * 毎回整形していた。累積統計は生の温度列からホストで計算し直せるため、
+ * 配備ごとに列構成を選べるよう、列の並びを型（LogLayout<列...>）で 1 回だけ書き、
+ * 行の整形（formatRow）と列名（formatColumns）をそこからテンプレートで生成する。
+ * 行の整形は列ごとの put() をコンパイル時に並べたもので、列の判定・ループは残らない。
+ *
+ * - FullLogLayout : 従来どおりの 12 列（既定）
+ * - LeanLogLayout : ElapsedMs,Temp_C,HI_ALARM,LO_ALARM,WallTime の 5 列
+ *   （-DSD_LOG_LAYOUT_LEAN=1、platformio の m5stack-lean）
+ *
+ * 列名はファイル自体に残る（CSV はヘッダ行、BINARY はファイルヘッダの columns）。
+ * BINARY のレコードは 20B 固定のまま全列を持ち、tools/logconv はヘッダの列名に
+ * 従って出力する列を選ぶ。累積統計はどの構成でもチェックポイント行（# CKPT）に残る。
+ *
+ * 行の型 Row は SDData と同じ名前のメンバー（elapsedSeconds, elapsedMs, temperature,
+ * state, sampleCount, averageTemp, stdDev, maxTemp, minTemp, hiAlarm, loAlarm, wallMs）を持つこと。
+ */
+
+/**
+ * @brief 列の種類（数値は全列の行での位置 = BinaryLog::formatCsvRow の列順）
+ */
+enum class LogColumn : uint8_t {
+  ELAPSED_SEC,
+  TEMP,
+  STATE,
+  SAMPLES,
+  AVERAGE,
+  STDDEV,
+  MAX,
+  MIN,
+  HI_ALARM,
+  LO_ALARM,
+  ELAPSED_MS,
+  WALL_TIME,   // テキストのみ（BINARY のレコードには無い）
+  COUNT
+};
+
+class LogSchema {
+public:
+  static constexpr size_t MAX_COLUMNS = static_cast<size_t>(LogColumn::COUNT);
+  static constexpr size_t FLOAT_WIDTH = 42;   // putFloat(%.1f) の最長（-FLT_MAX）
+
+  static const char* columnName(LogColumn c) {
+    static const char* const names[MAX_COLUMNS] = {
+        "ElapsedSec", "Temp_C", "State", "Samples", "Average_C", "StdDev_C",
+        "Max_C", "Min_C", "HI_ALARM", "LO_ALARM", "ElapsedMs", "WallTime"};
+    return (c < LogColumn::COUNT) ? names[static_cast<size_t>(c)] : "?";
+  }
+
+  /**
+   * @brief BINARY のレコードに含まれる列か
+   */
+  static bool inBinaryRecord(LogColumn c) { return c != LogColumn::WALL_TIME; }
+
+  /**
+   * @brief ヘッダ行（"ElapsedMs,Temp_C,..."、CRLF 無し）を列の並びに
+   * @return 列数。知らない列名・多すぎる列があれば 0
+   */
+  static size_t parseColumns(const char* header, LogColumn* out, size_t max) {
+    size_t n = 0;
+    const char* p = header;
+    for (;;) {
+      const char* e = p;
+      while (*e != '\0' && *e != ',' && *e != '\r' && *e != '\n') ++e;
+      if (n == max || !findColumn(p, static_cast<size_t>(e - p), out[n])) return 0;
+      ++n;
+      if (*e != ',') return n;
+      p = e + 1;
+    }
+  }
+
+  /**
+   * @brief 統計列（温度が NaN なら "NaN"、温度が数値で統計が NaN なら 0.0）
+   */
+  static char* putStat(char* p, float v, float temperature) {
+    if (std::isnan(temperature)) return FixedFormat::putStr(p, "NaN");
+    return FixedFormat::putFloat(p, std::isnan(v) ? 0.0f : v, 1);
+  }
+
+private:
+  static bool findColumn(const char* name, size_t len, LogColumn& out) {
+    for (size_t i = 0; i < MAX_COLUMNS; ++i) {
+      const char* s = columnName(static_cast<LogColumn>(i));
+      if (strlen(s) == len && strncmp(s, name, len) == 0) {
+        out = static_cast<LogColumn>(i);
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// ── 列ごとの整形（WIDTH = 最長の文字数）──────────────────────────────────────
+
+template <LogColumn C> struct LogColumnTraits;
+
+template <> struct LogColumnTraits<LogColumn::ELAPSED_SEC> {
+  static constexpr size_t WIDTH = 10;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return FixedFormat::putUint(p, r.elapsedSeconds);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::TEMP> {
+  static constexpr size_t WIDTH = LogSchema::FLOAT_WIDTH;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    // NaN は 0.0 にすると正しい値に見えるため "NaN"
+    return std::isnan(r.temperature) ? FixedFormat::putStr(p, "NaN")
+                                     : FixedFormat::putFloat(p, r.temperature, 1);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::STATE> {
+  static constexpr size_t WIDTH = 16;   // 状態名（最長 "ALARM_SETTING"）
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return FixedFormat::putStr(p, r.state);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::SAMPLES> {
+  static constexpr size_t WIDTH = 20;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return FixedFormat::putUint64(p, r.sampleCount);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::AVERAGE> {
+  static constexpr size_t WIDTH = LogSchema::FLOAT_WIDTH;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return LogSchema::putStat(p, r.averageTemp, r.temperature);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::STDDEV> {
+  static constexpr size_t WIDTH = LogSchema::FLOAT_WIDTH;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return LogSchema::putStat(p, r.stdDev, r.temperature);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::MAX> {
+  static constexpr size_t WIDTH = LogSchema::FLOAT_WIDTH;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return LogSchema::putStat(p, r.maxTemp, r.temperature);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::MIN> {
+  static constexpr size_t WIDTH = LogSchema::FLOAT_WIDTH;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return LogSchema::putStat(p, r.minTemp, r.temperature);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::HI_ALARM> {
+  static constexpr size_t WIDTH = 5;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return FixedFormat::putBool(p, r.hiAlarm);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::LO_ALARM> {
+  static constexpr size_t WIDTH = 5;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return FixedFormat::putBool(p, r.loAlarm);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::ELAPSED_MS> {
+  static constexpr size_t WIDTH = 10;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return FixedFormat::putUint(p, r.elapsedMs);
+  }
+};
+
+template <> struct LogColumnTraits<LogColumn::WALL_TIME> {
+  static constexpr size_t WIDTH = WallClock::ISO_LEN;
+  template <typename Row> static char* put(char* p, const Row& r) {
+    return (r.wallMs >= 0) ? WallClock::putIso(p, r.wallMs) : p;   // 不明なら空
+  }
+};
+
+// ── 列構成 ────────────────────────────────────────────────────────────────────
+
+/**
+ * @brief 列の並び（コンパイル時）
+ * @details MAX_ROW は全列が最長の時の 1 行（CRLF・終端 '\0' を含む）。
+ *          行バッファの大きさは static_assert で確かめる
+ */
+template <LogColumn... Cs> struct LogLayout;
+
+template <> struct LogLayout<> {
+  static constexpr size_t COUNT   = 0;
+  static constexpr size_t MAX_ROW = 3;   // CRLF + '\0'
+
+  template <typename Row> static char* putFields(char* p, const Row&) { return p; }
+};
+
+template <LogColumn C, LogColumn... Rest> struct LogLayout<C, Rest...> {
+  typedef LogLayout<Rest...> Tail;
+  static constexpr size_t COUNT   = 1 + Tail::COUNT;
+  static constexpr size_t MAX_ROW = LogColumnTraits<C>::WIDTH + (Tail::COUNT > 0 ? 1 : 0) +
+                                    Tail::MAX_ROW;
+
+  /**
+   * @brief 1 行（"...\r\n"、終端 '\0' 付き）
+   * @param buf MAX_ROW バイト以上
+   * @return 書き込んだ文字数（終端 '\0' を除く）
+   */
+  template <typename Row> static size_t formatRow(const Row& r, char* buf) {
+    char* p = putFields(buf, r);
+    *p++ = '\r';
+    *p++ = '\n';
+    *p   = '\0';
+    return static_cast<size_t>(p - buf);
+  }
+
+  template <typename Row> static char* putFields(char* p, const Row& r) {
+    p = LogColumnTraits<C>::put(p, r);
+    if (Tail::COUNT > 0) *p++ = ',';
+    return Tail::putFields(p, r);
+  }
+
+  /**
+   * @brief 列名の行（"ElapsedMs,Temp_C,..."、CRLF 無し、終端 '\0' 付き）
+   * @param binary BINARY のファイルヘッダ用（レコードに無い列を除く）
+   * @return 書き込んだ文字数。len に収まらなければ 0
+   */
+  static size_t formatColumns(char* buf, size_t len, bool binary = false) {
+    size_t n = 0;
+    for (size_t i = 0; i < COUNT; ++i) {
+      const LogColumn c = columns()[i];
+      if (binary && !LogSchema::inBinaryRecord(c)) continue;
+      const char*  name = LogSchema::columnName(c);
+      const size_t nl   = strlen(name);
+      if (n + (n > 0 ? 1 : 0) + nl + 1 > len) return 0;
+      if (n > 0) buf[n++] = ',';
+      memcpy(buf + n, name, nl);
+      n += nl;
+    }
+    if (len > 0) buf[n] = '\0';
+    return n;
+  }
+
+  static const LogColumn* columns() {
+    static const LogColumn list[COUNT] = {C, Rest...};
+    return list;
+  }
+};
+
+typedef LogLayout<LogColumn::ELAPSED_SEC, LogColumn::TEMP, LogColumn::STATE, LogColumn::SAMPLES,
+                  LogColumn::AVERAGE, LogColumn::STDDEV, LogColumn::MAX, LogColumn::MIN,
+                  LogColumn::HI_ALARM, LogColumn::LO_ALARM, LogColumn::ELAPSED_MS,
+                  LogColumn::WALL_TIME>
+    FullLogLayout;
+
+typedef LogLayout<LogColumn::ELAPSED_MS, LogColumn::TEMP, LogColumn::HI_ALARM, LogColumn::LO_ALARM,
+                  LogColumn::WALL_TIME>
+    LeanLogLayout;
+
+#ifndef SD_LOG_LAYOUT_LEAN
+#define SD_LOG_LAYOUT_LEAN 0
+#endif
+
+#if SD_LOG_LAYOUT_LEAN
+typedef LeanLogLayout SdLogLayout;   // 配備時の列構成
+#else
+typedef FullLogLayout SdLogLayout;
+#endif
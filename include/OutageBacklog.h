@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @file OutageBacklog.h
+ * @brief SD 切断中のレコードを RAM に退避する有界バックログ
+ *
+ * @details
+ * カードの接触不良・抜けで書き込みに失敗しても RUN は続け、再マウントできた
+ * 時点で退避分を順にファイルへ書き戻す（SDWriter）。RAM は有限のため、
+ * 満杯時の方針を選ぶ:
+ *
+ * - DROP_OLDEST: 最も古いレコードを捨てる（切断直前〜復帰までの直近を全解像度で残す）
+ * - DECIMATE   : 退避済みを 1 つおきに間引き、以降も同じ間隔でだけ受け付ける
+ *                （満杯のたびに間隔が 2 倍になり、切断期間全体を粗く残す）
+ *
+ * 捨てたレコード数は dropped() で数え、ファイルの欠損記録（# OUTAGE 行）に使う。
+ * 生成・消費とも SD 書き込みタスクのみ（スレッド間の受け渡しには使わない）。
+ */
+enum class BacklogPolicy : uint8_t {
+  DROP_OLDEST,
+  DECIMATE,
+};
+
+/**
+ * @tparam T レコード型
+ * @tparam N 容量
+ */
+template <typename T, size_t N>
+class OutageBacklog {
+  static_assert(N >= 2, "OutageBacklog capacity must be at least 2");
+
+public:
+  explicit OutageBacklog(BacklogPolicy policy = BacklogPolicy::DECIMATE) : m_policy(policy) {
+    clear();
+  }
+
+  OutageBacklog(const OutageBacklog&) = delete;
+  OutageBacklog& operator=(const OutageBacklog&) = delete;
+
+  /**
+   * @brief 新しい切断の開始（中身・統計をクリア）
+   */
+  void clear() {
+    m_head    = 0;
+    m_size    = 0;
+    m_offered = 0;
+    m_dropped = 0;
+    m_stride  = 1;
+    m_phase   = 0;
+  }
+
+  void setPolicy(BacklogPolicy policy) { m_policy = policy; }
+  BacklogPolicy policy() const { return m_policy; }
+
+  /**
+   * @brief レコードを退避（満杯なら方針に従って捨てる）
+   * @return false: このレコード、または最も古いレコードを捨てた
+   */
+  bool push(const T& value) {
+    ++m_offered;
+    bool kept = true;
+    if (m_policy == BacklogPolicy::DECIMATE) {
+      // 間引き中は stride 個に 1 個だけ受け付ける
+      if (m_phase++ % m_stride != 0) {
+        ++m_dropped;
+        return false;
+      }
+      if (m_size == N) decimate();
+    } else if (m_size == N) {
+      m_head = (m_head + 1) % N;
+      --m_size;
+      ++m_dropped;
+      kept = false;
+    }
+    m_slots[(m_head + m_size) % N] = value;
+    ++m_size;
+    return kept;
+  }
+
+  /**
+   * @brief 最も古いレコード（空でないこと）
+   */
+  const T& front() const { return m_slots[m_head]; }
+
+  /**
+   * @brief 最も古いレコードを取り除く（書き戻し成功後に呼ぶ）
+   */
+  void pop() {
+    if (m_size == 0) return;
+    m_head = (m_head + 1) % N;
+    --m_size;
+  }
+
+  bool     empty() const { return m_size == 0; }
+  size_t   size() const { return m_size; }
+  static constexpr size_t capacity() { return N; }
+  uint32_t offered() const { return m_offered; }   // clear() 以降に渡されたレコード数
+  uint32_t dropped() const { return m_dropped; }   // 捨てたレコード数
+  uint32_t stride() const { return m_stride; }     // 現在の間引き間隔（1 = 全件）
+
+private:
+  /**
+   * @brief 退避済みを 1 つおきに詰め、間引き間隔を 2 倍に
+   */
+  void decimate() {
+    size_t kept = 0;
+    for (size_t i = 0; i < m_size; i += 2, ++kept) {
+      m_slots[(m_head + kept) % N] = m_slots[(m_head + i) % N];
+    }
+    m_dropped += static_cast<uint32_t>(m_size - kept);
+    m_size     = kept;
+    m_stride  *= 2;
+    m_phase    = 1;   // いま受け付けるレコードが新しい間隔の起点
+  }
+
+  BacklogPolicy m_policy;
+  T             m_slots[N];
+  size_t        m_head;
+  size_t        m_size;
+  uint32_t      m_offered;
+  uint32_t      m_dropped;
+  uint32_t      m_stride;
+  uint32_t      m_phase;    // DECIMATE: 受け付け判定用のカウンタ
+};
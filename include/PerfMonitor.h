@@ -0,0 +1,108 @@
+#pragma once
+
+#include <Arduino.h>
+#include "LatencyHistogram.h"
+
+/**
+ * @file PerfMonitor.h
+ * @brief タスクごとの処理時間ヒストグラムと予算超過カウンタ（常設計測）
+ *
+ * @details
+ * docs/troubleshooting/PERFORMANCE.md の「micros() を手で埋め込んでシリアルを
+ * 解析する」手順をファームウェアに常設したもの。各タスクの 1 回分の処理時間を
+ * LatencyHistogram に記録し、p50 / p99 / max と予算超過回数を保持する。
+ *
+ * - 記録: 各タスクのループで record() を呼ぶ（O(1)、固定メモリ）
+ * - 参照: シリアルコマンド 'p'（dump）、RUN 終了時の SD ログフッタ（summarize → formatFooter）
+ * - リセット: requestReset()。実際のクリアは各タスクが次の record() で行うため、
+ *   IO コアと制御コアの間でロックは不要
+ *
+ * 各ヒストグラムは所有タスクだけが書き込む。dump() は他コアから読むため、
+ * 値は数マイクロ秒単位でずれ得る（統計用途では問題にならない）。
+ */
+enum class PerfTask : uint8_t {
+  IO = 0,     // IO_Task     (IO コア)
+  LOGIC,      // Logic_Task  (制御コア)
+  UI,         // UI_Task     (制御コア)
+  STORAGE,    // Storage_Task(制御コア)
+  COUNT
+};
+
+class PerfMonitor {
+public:
+  /**
+   * @brief SD ログフッタに書く値（ある時点の写し）
+   *
+   * @details
+   * CLOSE は書き込みタスクが後で処理するため、その間に次の RUN の requestReset() が
+   * 入っても RUN の統計が残るよう、制御タスクが CLOSE を積む時に写しておく。
+   */
+  struct Summary {
+    struct Task {
+      uint32_t count;
+      uint32_t p50Us;
+      uint32_t p99Us;
+      uint32_t maxUs;
+      uint32_t overruns;
+    };
+    Task tasks[static_cast<uint8_t>(PerfTask::COUNT)];
+  };
+
+  /**
+   * @brief 1 回分の処理時間を記録
+   * @param task 計測対象タスク
+   * @param elapsedUs 処理時間 [µs]
+   */
+  static void record(PerfTask task, uint32_t elapsedUs);
+
+  /**
+   * @brief 全タスクの統計リセットを依頼（RUN 開始時など）
+   */
+  static void requestReset();
+
+  /**
+   * @brief 統計をシリアル等へ出力
+   * @param out 出力先（Serial 等）
+   * @param withBuckets true: 非ゼロのバケットも出力
+   */
+  static void dump(Print& out, bool withBuckets = false);
+
+  /**
+   * @brief 現在の統計を写す（RUN 終了時、制御タスクから）
+   */
+  static void summarize(Summary& out);
+
+  /**
+   * @brief SD ログフッタ用のコメント行を生成
+   *
+   * @details
+   * 1 タスク 1 行、CSV ビューアでデータ行と区別できるよう '#' で始める。
+   * 例: "# PERF,IO,count=1234,p50_us=410,p99_us=1023,max_us=1800,over=0,budget_us=5000\r\n"
+   *
+   * @param summary summarize() で写した値
+   * @return 書き込んだバイト数（終端 NUL を除く）
+   */
+  static size_t formatFooter(const Summary& summary, char* buf, size_t len);
+
+  /**
+   * @brief タスク名（"IO" 等）
+   */
+  static const char* taskName(PerfTask task);
+
+  /**
+   * @brief タスクの処理時間予算 [µs]
+   */
+  static uint32_t budgetUs(PerfTask task);
+
+  /**
+   * @brief 指定タスクのヒストグラム（参照専用）
+   */
+  static const LatencyHistogram& histogram(PerfTask task);
+
+private:
+  static constexpr uint8_t TASKS = static_cast<uint8_t>(PerfTask::COUNT);
+
+  static LatencyHistogram  s_hist[TASKS];
+  static volatile uint32_t s_resetGen;         // requestReset() で加算
+  static uint32_t          s_seenGen[TASKS];   // 各タスクが適用済みの世代
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @file PowerGovernor.h
+ * @brief 状態と次の締め切りから CPU クロック・ライトスリープを決める方針部
+ *
+ * @details
+ * IDLE / RESULT で実際に必要な処理は「500ms ごとのセンサ読取」と
+ * 「200ms ごとの UI 更新」程度だが、従来は常に 240MHz で周期ポーリングしていた。
+ * 本クラスは入力（状態・現在時刻・次の締め切り・最終操作時刻・制御コアの
+ * 待機状態）だけから判断を返す純粋関数で、ハードウェア操作は PowerManager が行う。
+ *
+ * 【方針】
+ * - RUN / ALARM_SETTING              : 240MHz、スリープ無し（計測・操作優先）
+ * - IDLE / RESULT で操作直後         : 240MHz、スリープ無し（画面遷移の描画バースト）
+ *   （最終操作から POWER_ACTIVITY_HOLD_MS 以内、またはボタン押下中）
+ * - IDLE / RESULT で操作無し         : 80MHz、次の締め切りまでライトスリープ
+ *   （制御コアが待機中で、残り時間が POWER_MIN_SLEEP_MS 以上、かつバックライト消灯時のみ）
+ * - 上記でバックライト点灯中         : 80MHz、スリープ無し（クロックだけ下げる）
+ *
+ * クロックは 80 / 240MHz のみ使う。80MHz 以上では APB クロックが 80MHz の
+ * まま変わらないため、SPI（LCD / SD / MAX31855）・UART のボーレートに影響しない。
+ *
+ * 【バックライトとライトスリープ】
+ * ライトスリープ中は APB クロックが止まり、LEDC の高速チャネル（M5Stack ライブラリの
+ * バックライト PWM）も止まるため、点灯中に眠ると画面がちらつく・固まる。
+ * 対策の候補は (a) バックライトの LEDC タイマを RTC8M へ移す、(b) スリープ中は
+ * gpio_hold_en でピンを保持する、(c) 点灯中はクロックだけ下げて眠らない、の 3 つ。
+ * (a) は M5.Lcd.setBrightness() の高速チャネル 7 を使えず自前の低速チャネルに
+ * 置き換える必要があり、(b) は保持した瞬間の PWM レベル（全点灯か消灯）で固まるため
+ * 輝度が変わって見える。本実装は (c) を採る（PowerInputs::backlightOn）。
+ * スピーカー（アラーム音）もスリープで止まるが、アラーム発生は noteActivity() で
+ * POWER_ACTIVITY_HOLD_MS（> ALARM_SOUND_DURATION_MS）の間フルクロック・スリープ無しになる。
+ *
+ */
+
+/**
+ * @brief ガバナーの入力
+ */
+struct PowerInputs {
+  uint8_t  state;               // State の数値（Global.h の enum class State）
+  uint32_t nowMs;               // 現在時刻 millis()
+  uint32_t nextDeadlineMs;      // 次に処理が必要な時刻（IO / 制御コアの早い方）
+  uint32_t lastActivityMs;      // 最後のボタン・コンソール操作時刻
+  bool     controlIdle;         // 制御コアが次の周期まで待機中か
+  bool     backlightOn;         // LCD バックライト点灯中か（点灯中は眠らない）
+};
+
+/**
+ * @brief ガバナーの判断結果
+ */
+struct PowerDecision {
+  uint16_t cpuMhz;    // 設定すべき CPU クロック
+  uint32_t sleepMs;   // ライトスリープ時間（0 = スリープしない）
+};
+
+/**
+ * @brief 省電力方針（状態を持たない純粋関数群）
+ */
+class PowerGovernor {
+public:
+  static constexpr uint16_t CPU_MHZ_FULL = 240;
+  static constexpr uint16_t CPU_MHZ_LOW  = 80;
+
+  // State の数値（Global.h の enum class State と一致させる）
+  static constexpr uint8_t STATE_IDLE          = 0;
+  static constexpr uint8_t STATE_RUN           = 1;
+  static constexpr uint8_t STATE_RESULT        = 2;
+  static constexpr uint8_t STATE_ALARM_SETTING = 3;
+
+  /**
+   * @brief 入力から CPU クロックとスリープ時間を決定
+   *
+   * @param in           入力
+   * @param activityHold 操作後にフルクロックを維持する時間 [ms]
+   * @param minSleep     これ未満の空き時間ではスリープしない [ms]（入出コスト対策）
+   * @param maxSleep     1 回のスリープ上限 [ms]
+   * @param wakeMargin   締め切りより手前で起きる余裕 [ms]
+   */
+  static PowerDecision decide(const PowerInputs& in, uint32_t activityHold,
+                              uint32_t minSleep, uint32_t maxSleep,
+                              uint32_t wakeMargin) {
+    PowerDecision d;
+    d.cpuMhz  = CPU_MHZ_FULL;
+    d.sleepMs = 0;
+
+    if (!isLowPowerState(in.state)) return d;
+    if (in.nowMs - in.lastActivityMs < activityHold) return d;  // 描画バースト中
+
+    d.cpuMhz = CPU_MHZ_LOW;
+    if (!in.controlIdle) return d;
+    if (in.backlightOn) return d;  // スリープ中は LEDC が止まり PWM が乱れる
+
+    // 締め切りまでの残り（過ぎていれば負 → スリープしない）
+    const int32_t remaining = static_cast<int32_t>(in.nextDeadlineMs - in.nowMs);
+    if (remaining <= static_cast<int32_t>(wakeMargin)) return d;
+
+    uint32_t sleep = static_cast<uint32_t>(remaining) - wakeMargin;
+    if (sleep < minSleep) return d;
+    if (sleep > maxSleep) sleep = maxSleep;
+    d.sleepMs = sleep;
+    return d;
+  }
+
+  /**
+   * @brief クロックを落としてよい状態か（IDLE / RESULT）
+   */
+  static bool isLowPowerState(uint8_t state) {
+    return state == STATE_IDLE || state == STATE_RESULT;
+  }
+
+  /**
+   * @brief 2 つの締め切りの早い方（millis() の巻き戻りを考慮）
+   */
+  static uint32_t earlier(uint32_t a, uint32_t b, uint32_t nowMs) {
+    return static_cast<int32_t>(a - nowMs) <= static_cast<int32_t>(b - nowMs) ? a : b;
+  }
+};
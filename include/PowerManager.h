@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "PowerGovernor.h"
+
+/**
+ * @file PowerManager.h
+ * @brief PowerGovernor の判断を ESP32 に適用（CPU クロック変更・ライトスリープ）
+ *
+ * @details
+ * 【役割分担】
+ * - 判断: PowerGovernor::decide()（純粋関数、native テスト済み）
+ * - 適用: 本クラス。IO タスクの周期末尾で govern() を呼ぶ（クロック変更と
+ *   スリープは IO タスクだけが行う = シングルオーナー）
+ *
+ * 【コア間の取り決め】
+ * - 制御タスクは待機に入る直前に setControlIdle(次の起床時刻) を、起きたら
+ *   setControlBusy() を呼ぶ。IO タスクは制御コアが待機中のときだけ眠る
+ * - ライトスリープ中は FreeRTOS の tick が進まない。このため制御タスクは
+ *   IDLE / RESULT では tick 遅延ではなくタスク通知で待ち、IO タスクが
+ *   スリープ明けに通知して起こす（main.cpp）
+ * - 起床要因: タイマー（次の締め切り）または BtnA/B/C の GPIO Low レベル
+ * - バックライト点灯中はライトスリープしない（PowerGovernor.h）。輝度は
+ *   M5.Lcd.setBrightness() を直接呼ばず setBacklight() で変える
+ *
+ * POWER_GOVERNOR_ENABLED=0 のビルド（m5stack-profile 等、CCOUNT で時間を
+ * 測るため固定クロックが必要な場合）では govern() は何もしない。
+ */
+
+#ifndef POWER_GOVERNOR_ENABLED
+#define POWER_GOVERNOR_ENABLED 1
+#endif
+
+class PowerManager {
+public:
+  /**
+   * @brief ボタンの GPIO 起床を設定（タスク起動前に 1 回）
+   */
+  static void init();
+
+  /**
+   * @brief ユーザ操作（ボタン・コンソール入力・アラーム発生）を記録
+   * @details どのコアからでも呼べる。POWER_ACTIVITY_HOLD_MS の間はフルクロック
+   */
+  static void noteActivity();
+
+  /**
+   * @brief 制御タスクが待機に入る（次の起床時刻 millis() を公開）
+   */
+  static void setControlIdle(uint32_t nextWakeMs);
+
+  /**
+   * @brief 制御タスクが処理を再開した
+   */
+  static void setControlBusy();
+
+  /**
+   * @brief LCD バックライトの輝度を設定（0 = 消灯）
+   * @details M5.Lcd.setBrightness() を呼び、点灯状態をガバナーへ伝える。
+   *          M5.begin() 直後は点灯しているものとして扱う
+   */
+  static void setBacklight(uint8_t brightness);
+
+  /**
+   * @brief IO タスク周期末尾の省電力判断と適用
+   * @param state 現在の状態（ControlSnapshot::state の数値）
+   * @param ioNextDeadlineMs IO タスク側の次の締め切り（次のセンサ読取など）
+   * @param storageIdle SD 書き込みタスクが待機中か（書き込み中は眠らない）
+   * @return true: ライトスリープした（呼び出し側は周期基準を取り直すこと）
+   */
+  static bool govern(uint8_t state, uint32_t ioNextDeadlineMs, bool storageIdle);
+
+  /**
+   * @brief 統計（現在クロック・スリープ回数・スリープ率）を出力
+   */
+  static void dump(Print& out);
+
+private:
+  static std::atomic<uint32_t> s_lastActivityMs;
+  static std::atomic<uint32_t> s_controlNextWakeMs;
+  static std::atomic<bool>     s_controlIdle;
+  static std::atomic<bool>     s_backlightOn;
+
+  // 以下は IO タスクのみが書く（dump() は統計用途の参照）
+  static uint16_t s_cpuMhz;
+  static uint32_t s_clockChanges;
+  static uint32_t s_sleepCount;
+  static uint64_t s_sleepUsTotal;
+  static uint32_t s_initMs;
+};
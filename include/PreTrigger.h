@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include "BinaryLog.h"
+#include "FixedFormat.h"
+
+/**
+ * @file PreTrigger.h
+ * @brief トリガ前の直近サンプルを常時保持するリング（オシロスコープのプリトリガ）
+ *
+ * @details
+ * BtnA で RUN を始めた時・アラームが変化した時には、見たい過渡はもう過ぎている。
+ * 状態に関係なく新しいセンサ値ごとに PreTriggerRing へ 1 件追加し（O(1)、満杯なら
+ * 最も古いものを上書き）、トリガ時に直近 windowMs 分を PreTriggerSnapshot に写す。
+ *
+ * - RUN 開始: 生ログの先頭（ヘッダ直後）に "# PRE,..." のコメント行として
+ * - アラーム変化（RUN 中）: 生ログと並べた DATA_xxxx_aNN.csv に CSV として
+ *
+ * 行の時刻はトリガからの相対値 OffsetMs（負 = トリガ前）で、RUN 開始のスナップショット
+ * では生ログの ElapsedMs と同じ軸になる。メモリは容量 N で固定（確保無し）。
+ * 追加・スナップショットとも同じタスク（Storage_Task）から行う前提。
+ */
+
+/**
+ * @brief 1 サンプル（新しいセンサ値ごと）
+ */
+struct PreTriggerSample {
+  uint32_t timeMs;       // 取得時刻 (millis)
+  float    rawPV;        // 生の温度 [°C]
+  float    filteredPV;   // フィルタ後の温度 [°C]
+  uint8_t  flags;        // BinaryLog::FLAG_HI_ALARM | FLAG_LO_ALARM
+};
+
+class PreTrigger {
+public:
+  /**
+   * @brief トリガの種類
+   */
+  enum Event : uint8_t {
+    RUN_START,
+    HI_SET,
+    HI_CLEAR,
+    LO_SET,
+    LO_CLEAR
+  };
+
+  static constexpr size_t      MAX_ROW = 64;   // formatRow() の最長（接頭辞 8 文字以内）
+  static constexpr const char* COLUMNS = "OffsetMs,Raw_C,Temp_C,HI_ALARM,LO_ALARM";
+
+  static const char* eventName(Event e) {
+    static const char* const names[] = {"RUN_START", "HI_SET", "HI_CLEAR", "LO_SET", "LO_CLEAR"};
+    return names[e];
+  }
+
+  /**
+   * @brief 1 サンプルを 1 行に（"-1500,540.25,539.87,false,false\r\n"、NaN は "NaN"）
+   * @param prefix 行頭に付ける文字列（生ログ内では "# PRE,"、スナップショットファイルでは ""）
+   * @param buf MAX_ROW バイト以上
+   * @return 書き込んだ文字数（終端 '\0' を除く）
+   */
+  static size_t formatRow(const PreTriggerSample& s, uint32_t triggerMs, const char* prefix,
+                          char* buf) {
+    char* p = FixedFormat::putStr(buf, prefix);
+    p = FixedFormat::putInt(p, static_cast<int32_t>(s.timeMs - triggerMs));
+    *p++ = ',';
+    p = std::isnan(s.rawPV) ? FixedFormat::putStr(p, "NaN") : FixedFormat::putFloat(p, s.rawPV, 2);
+    *p++ = ',';
+    p = std::isnan(s.filteredPV) ? FixedFormat::putStr(p, "NaN")
+                                 : FixedFormat::putFloat(p, s.filteredPV, 2);
+    *p++ = ',';
+    p = FixedFormat::putBool(p, (s.flags & BinaryLog::FLAG_HI_ALARM) != 0);
+    *p++ = ',';
+    p = FixedFormat::putBool(p, (s.flags & BinaryLog::FLAG_LO_ALARM) != 0);
+    *p++ = '\r';
+    *p++ = '\n';
+    *p   = '\0';
+    return static_cast<size_t>(p - buf);
+  }
+
+  /**
+   * @brief アラームフラグの変化をトリガの並びに（HI → LO の順、最大 2 件）
+   * @return events に書いた件数
+   */
+  static size_t eventsFor(uint8_t before, uint8_t after, Event* events) {
+    size_t n = 0;
+    const uint8_t changed = before ^ after;
+    if (changed & BinaryLog::FLAG_HI_ALARM) {
+      events[n++] = (after & BinaryLog::FLAG_HI_ALARM) ? HI_SET : HI_CLEAR;
+    }
+    if (changed & BinaryLog::FLAG_LO_ALARM) {
+      events[n++] = (after & BinaryLog::FLAG_LO_ALARM) ? LO_SET : LO_CLEAR;
+    }
+    return n;
+  }
+};
+
+/**
+ * @brief トリガ時点の窓（古い順）
+ */
+template <size_t N>
+struct PreTriggerSnapshot {
+  uint8_t          event;       // PreTrigger::Event
+  uint32_t         triggerMs;   // トリガ時刻 (millis)。行の OffsetMs の基準
+  uint32_t         windowMs;    // 要求した窓の長さ
+  uint32_t         count;
+  PreTriggerSample samples[N];
+
+  /**
+   * @brief 全行を buf へ（入りきらない行は書かない）
+   * @return 書き込んだ文字数
+   */
+  size_t formatRows(const char* prefix, char* buf, size_t len) const {
+    size_t used = 0;
+    for (uint32_t i = 0; i < count && used + PreTrigger::MAX_ROW <= len; ++i) {
+      used += PreTrigger::formatRow(samples[i], triggerMs, prefix, buf + used);
+    }
+    return used;
+  }
+};
+
+/**
+ * @tparam N 容量（保持するサンプル数）
+ */
+template <size_t N>
+class PreTriggerRing {
+  static_assert(N >= 2, "PreTriggerRing capacity must be at least 2");
+
+public:
+  PreTriggerRing() { clear(); }
+
+  void clear() {
+    m_next  = 0;
+    m_count = 0;
+  }
+
+  /**
+   * @brief 1 サンプル追加（O(1)、満杯なら最も古いものを上書き）
+   */
+  void add(const PreTriggerSample& s) {
+    m_buf[m_next] = s;
+    m_next = (m_next + 1) % N;
+    if (m_count < N) ++m_count;
+  }
+
+  size_t size() const { return m_count; }
+  static size_t capacity() { return N; }
+
+  /**
+   * @brief i 番目に古いサンプル（0 = 最も古い）
+   */
+  const PreTriggerSample& at(size_t i) const {
+    return m_buf[(m_next + N - m_count + i) % N];
+  }
+
+  /**
+   * @brief 取得時刻が triggerMs の windowMs 前以降のサンプルを古い順に写す
+   * @details triggerMs より後のサンプルも含める（トリガと同じ周期で届いた値）
+   */
+  void snapshot(uint8_t event, uint32_t triggerMs, uint32_t windowMs,
+                PreTriggerSnapshot<N>& out) const {
+    out.event     = event;
+    out.triggerMs = triggerMs;
+    out.windowMs  = windowMs;
+    out.count     = 0;
+    for (size_t i = 0; i < m_count; ++i) {
+      const PreTriggerSample& s = at(i);
+      const int32_t before = static_cast<int32_t>(triggerMs - s.timeMs);
+      if (before > static_cast<int32_t>(windowMs)) continue;
+      out.samples[out.count++] = s;
+    }
+  }
+
+private:
+  PreTriggerSample m_buf[N];
+  size_t           m_next;
+  size_t           m_count;
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @file ProfileZone.h
+ * @brief サイクルカウンタによる RAII プロファイリングゾーン（リングバッファ記録）
+ *
+ * @details
+ * タスク単位の合計時間（PerfMonitor）では分からない「UI 時間の内訳は
+ * clearLine() か renderLabelValueLine() か SPI 待ちか」を調べるための計測。
+ *
+ * 使い方:
+ * @code
+ *   void clearLine(uint16_t y0, uint16_t y1) {
+ *     PROFILE_ZONE("clearLine");
+ *     ...
+ *   }
+ * @endcode
+ *
+ * - PROFILE_ZONES_ENABLED=0（既定）では PROFILE_ZONE() は何も生成しない
+ * - 有効時はスコープ終了時に {名前, 開始, 長さ} をコアごとの固定長リングへ記録
+ *   （同じコアの複数タスク、例えば制御タスクと SDWriter タスクが書くため、
+ *   枠は head.fetch_add で予約し、書き終えた印に予約番号 seq を置く。ロック無し）
+ * - 時刻源: ESP32 は CCOUNT（CPU サイクル、xthal_get_ccount()）、
+ *   native 環境は std::chrono::steady_clock（µs）
+ * - dump() の出力を scripts/profile_to_trace.py で Chrome / Perfetto の
+ *   トレース JSON に変換してフレームチャートを表示する
+ *
+ * 出力形式（1 行 1 イベント、古い順）:
+ *   # PROFILE clock_hz=240000000 cores=2
+ *   Z,<core>,<start_ticks>,<duration_ticks>,<name>
+ *   # PROFILE end events=<n> dropped=<n>
+ *
+ * @note CCOUNT はコアごとのレジスタで 32bit（240MHz で約 17.9 秒で一周）。
+ *       変換ツールはコアごとに記録順で巻き戻りを補正する。CPU クロックを
+ *       途中で変えると時間換算がずれるため、計測中は固定クロックで使うこと。
+ */
+
+#ifndef PROFILE_ZONES_ENABLED
+#define PROFILE_ZONES_ENABLED 0
+#endif
+
+#ifndef PROFILE_RING_SIZE
+#define PROFILE_RING_SIZE 512   // コアあたりのイベント数（1 イベント 16 bytes）
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <xtensa/hal.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * @brief 記録 1 件分
+ */
+struct ProfileEvent {
+  const char*           name;      // 文字列リテラル（ゾーン名）
+  uint32_t              start;     // 開始ティック
+  uint32_t              duration;  // 長さ [ティック]
+  std::atomic<uint32_t> seq;       // 書き終えた予約番号 + 1（0 = 未記録、BUSY = 書き込み中）
+};
+
+/**
+ * @brief コアごとのリングバッファ群（ヘッダオンリー、静的領域）
+ */
+class ProfileRecorder {
+public:
+  static constexpr uint8_t  CORES = 2;
+  static constexpr uint32_t SIZE  = PROFILE_RING_SIZE;
+  static constexpr uint32_t BUSY  = 0xFFFFFFFFUL;   // ProfileEvent::seq: 書き込み中
+
+  /**
+   * @brief 現在のティック値
+   */
+  static uint32_t now() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return xthal_get_ccount();
+#else
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  /**
+   * @brief 1 ティックあたりの周波数 [Hz]
+   */
+  static uint32_t clockHz() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return getCpuFrequencyMhz() * 1000000UL;
+#else
+    return 1000000UL;
+#endif
+  }
+
+  /**
+   * @brief 実行中のコア番号
+   */
+  static uint8_t currentCore() {
+#if defined(ARDUINO_ARCH_ESP32)
+    return static_cast<uint8_t>(xPortGetCoreID());
+#else
+    return 0;
+#endif
+  }
+
+  /**
+   * @brief ゾーン 1 件を記録（自コアのリングへ）
+   *
+   * @details
+   * 同じコアの優先度の高いタスクが途中で割り込んでも同じ枠を書かないよう、
+   * 枠は fetch_add で予約する。割り込んだ側がリングを一周して同じ枠に来た場合に
+   * 備え、枠の seq を BUSY に取ってから書く（書き込み中・より新しい記録済みの枠なら
+   * このイベントを捨てて dropped に数える）。dump() は seq が予約番号と合う枠だけを読む。
+   */
+  static void record(const char* name, uint32_t start, uint32_t end) {
+    Ring& r = ring(currentCore());
+    if (state().paused.load(std::memory_order_relaxed)) {
+      state().dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const uint32_t h = r.head.fetch_add(1, std::memory_order_relaxed);
+    ProfileEvent& e = r.events[h % SIZE];
+    uint32_t prev = e.seq.load(std::memory_order_relaxed);
+    do {
+      if (prev == BUSY || static_cast<int32_t>(prev - (h + 1)) > 0) {
+        state().dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    } while (!e.seq.compare_exchange_weak(prev, BUSY, std::memory_order_acquire,
+                                          std::memory_order_relaxed));
+    e.name     = name;
+    e.start    = start;
+    e.duration = end - start;   // 32bit の巻き戻りは符号無し減算で吸収
+    e.seq.store(h + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief 記録済みイベント数（リング上書き前の累計）
+   */
+  static uint32_t recorded(uint8_t core) {
+    return (core < CORES) ? ring(core).head.load(std::memory_order_acquire) : 0;
+  }
+
+  /**
+   * @brief 全リングを 1 行ずつ出力
+   *
+   * @details
+   * 出力中は記録を一時停止（その間のゾーンは dropped に計上）するため、
+   * 途中で上書きされたイベントが混ざらない。
+   *
+   * @param writeLine 1 行（改行付き）を受け取るコールバック
+   * @param ctx コールバックへそのまま渡す値
+   */
+  static void dump(void (*writeLine)(const char* line, void* ctx), void* ctx) {
+    char line[96];
+    state().paused.store(true, std::memory_order_seq_cst);
+
+    snprintf(line, sizeof(line), "# PROFILE clock_hz=%lu cores=%u\n",
+             (unsigned long)clockHz(), (unsigned)CORES);
+    writeLine(line, ctx);
+
+    uint32_t total = 0;
+    for (uint8_t c = 0; c < CORES; ++c) {
+      Ring& r = ring(c);
+      const uint32_t head  = r.head.load(std::memory_order_acquire);
+      uint32_t count = head;
+      if (count > SIZE) count = SIZE;   // 古いものは上書き済み
+      for (uint32_t i = head - count; i != head; ++i) {
+        const ProfileEvent& e = r.events[i % SIZE];
+        if (e.seq.load(std::memory_order_acquire) != i + 1) {
+          state().dropped.fetch_add(1, std::memory_order_relaxed);   // 書きかけ・上書き済み
+          continue;
+        }
+        const char*    name     = e.name;
+        const uint32_t start    = e.start;
+        const uint32_t duration = e.duration;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != i + 1) {   // 読む間に書き換わった
+          state().dropped.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        snprintf(line, sizeof(line), "Z,%u,%lu,%lu,%s\n",
+                 (unsigned)c, (unsigned long)start, (unsigned long)duration,
+                 name ? name : "?");
+        writeLine(line, ctx);
+        ++total;
+      }
+    }
+
+    snprintf(line, sizeof(line), "# PROFILE end events=%lu dropped=%lu\n",
+             (unsigned long)total,
+             (unsigned long)state().dropped.load(std::memory_order_relaxed));
+    writeLine(line, ctx);
+
+    state().paused.store(false, std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief 全リングを空にする
+   */
+  static void clear() {
+    for (uint8_t c = 0; c < CORES; ++c) {
+      Ring& r = ring(c);
+      for (uint32_t i = 0; i < SIZE; ++i) r.events[i].seq.store(0, std::memory_order_relaxed);
+      r.head.store(0, std::memory_order_release);
+    }
+    state().dropped.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  struct Ring {
+    ProfileEvent          events[SIZE];
+    std::atomic<uint32_t> head;
+  };
+
+  struct State {
+    std::atomic<bool>     paused;
+    std::atomic<uint32_t> dropped;
+  };
+
+  static Ring& ring(uint8_t core) {
+    static Ring rings[CORES];   // ゼロ初期化（静的記憶域）
+    return rings[(core < CORES) ? core : 0];
+  }
+
+  static State& state() {
+    static State s;
+    return s;
+  }
+};
+
+/**
+ * @brief スコープの開始〜終了を 1 イベントとして記録する RAII オブジェクト
+ */
+class ProfileZone {
+public:
+  explicit ProfileZone(const char* name) : m_name(name), m_start(ProfileRecorder::now()) {}
+  ~ProfileZone() { ProfileRecorder::record(m_name, m_start, ProfileRecorder::now()); }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+  const char* m_name;
+  uint32_t    m_start;
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+
+#if PROFILE_ZONES_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profileZone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
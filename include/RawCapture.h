@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <climits>
+#include <cmath>
+#include "BinaryLog.h"
+#include "DeltaCodec.h"
+#include "FixedFormat.h"
+
+/**
+ * @file RawCapture.h
+ * @brief 熱電対の生データ記録（全変換結果・取得時刻・故障ビット）の形式
+ *
+ * @details
+ * 要約ログ（CSV / BINARY / DELTA）はフィルタ後の値（G.D_FilteredPV）を
+ * TC_READ_INTERVAL_MS ごとに記録するため、MAX31855 の読取値そのものは残らず、
+ * ノイズ解析やフィルタのかけ直しができない。生データ記録を有効にした RUN では、
+ * IO タスクが TC_CAPTURE_INTERVAL_MS（MAX31855 の最大変換時間）ごとに読み、
+ * 1 回の読取ごとに RawSample を SD 書き込みタスクへ渡す。要約ログ・フィルタは
+ * 従来どおり TC_READ_INTERVAL_MS 間隔のまま。
+ *
+ * 【ファイル】生ログと並べた DATA_xxxx_raw.bin
+ * - 先頭セクタ: BinLogHeader（encoding = ENCODING_RAW、quantumMilliC = 250、
+ *   columns = "ElapsedMs,Raw_C,Fault"）
+ * - 以降: DELTA ブロック（DeltaCodec.h）。フラグ 2 ビットに故障コード（FAULT_*）を入れる
+ * 経過時間は要約ログと同じく RUN 開始からの ms のため、両者をそのまま突き合わせられる。
+ * MAX31855 の分解能は 0.25°C なので、250m°C への量子化は可逆。
+ * ホストでは tools/logconv がそのまま CSV に変換する。
+ *
+ * 【SD 帯域】worstBytesPerSec() は全サンプルが最長符号（MAX_SAMPLE_BITS）に
+ * なった場合の書き込み量に、同期間隔ごとの途中ブロック書き直し（512B）を足した上限。
+ * SDManager.cpp がこれを SD_RAW_BUDGET_BYTES_PER_S 以下であることを静的に検査する。
+ */
+
+/**
+ * @brief 読取 1 回分（IO タスク → SD 書き込みタスク）
+ */
+struct RawSample {
+  uint32_t timeMs;   // 読取時刻 (millis)
+  int32_t  q;        // 温度 [QUANTUM_MILLIC m°C]、故障時は INT32_MIN
+  uint8_t  fault;    // RawCapture::FAULT_*
+};
+
+class RawCapture {
+public:
+  static constexpr uint16_t QUANTUM_MILLIC  = 250;   // MAX31855 の分解能
+  static constexpr uint32_t CONVERSION_MS   = 100;   // MAX31855 の変換時間（最大値）
+  static constexpr uint8_t  FAULT_NONE      = 0;
+  static constexpr uint8_t  FAULT_OPEN      = 1;     // 熱電対の断線（OC）
+  static constexpr uint8_t  FAULT_SHORT_GND = 2;     // GND への短絡（SCG）
+  static constexpr uint8_t  FAULT_SHORT_VCC = 3;     // VCC への短絡（SCV）
+  static constexpr const char* COLUMNS = "ElapsedMs,Raw_C,Fault";
+
+  // 1 ブロックに必ず入るサンプル数（全サンプルが最長符号の場合）
+  static constexpr uint32_t MIN_SAMPLES_PER_BLOCK =
+      BinaryLog::PAYLOAD_SIZE * 8 / DeltaEncoder::MAX_SAMPLE_BITS;
+
+  /**
+   * @brief MAX31855 の故障ビット（readError(): bit0 = OC, bit1 = SCG, bit2 = SCV）を故障コードに
+   * @details 複数立っている場合は断線を優先（断線中は短絡ビットも不定になるため）
+   */
+  static uint8_t faultFromError(uint8_t errorBits) {
+    if (errorBits & 0x01) return FAULT_OPEN;
+    if (errorBits & 0x02) return FAULT_SHORT_GND;
+    if (errorBits & 0x04) return FAULT_SHORT_VCC;
+    return FAULT_NONE;
+  }
+
+  static const char* faultName(uint8_t fault) {
+    static const char* const names[] = {"", "OC", "SCG", "SCV"};
+    return names[fault & 0x03];
+  }
+
+  /**
+   * @brief 読取結果から 1 サンプルを作る
+   * @param celsius readCelsius() の値（故障時は NaN）
+   * @param errorBits NaN のときの readError() の値
+   */
+  static RawSample sample(uint32_t timeMs, float celsius, uint8_t errorBits) {
+    RawSample s;
+    s.timeMs = timeMs;
+    if (std::isnan(celsius)) {
+      s.q     = INT32_MIN;
+      s.fault = faultFromError(errorBits);
+    } else {
+      s.q     = static_cast<int32_t>(lroundf(celsius * 1000.0f / QUANTUM_MILLIC));
+      s.fault = FAULT_NONE;
+    }
+    return s;
+  }
+
+  /**
+   * @brief 生データ記録の SD 書き込み量の上限 [bytes/s]
+   * @param intervalMs 読取間隔
+   * @param tailSyncMs 途中ブロックを書き直す間隔（生ログの同期間隔）
+   */
+  static constexpr uint32_t worstBytesPerSec(uint32_t intervalMs, uint32_t tailSyncMs) {
+    return (1000 + intervalMs - 1) / intervalMs * BinaryLog::BLOCK_SIZE / MIN_SAMPLES_PER_BLOCK +
+           BinaryLog::BLOCK_SIZE * 1000 / tailSyncMs;
+  }
+
+  /**
+   * @brief 1 サンプルを CSV 1 行（"12345,540.25,\r\n" / "12445,NaN,OC\r\n"）に整形（ホスト側）
+   * @param buf 64 バイト以上
+   * @return 書き込んだ文字数（終端 '\0' を除く）
+   */
+  static size_t formatRow(uint32_t t, int32_t q, uint8_t fault, uint16_t quantumMilliC, char* buf) {
+    char* p = FixedFormat::putUint(buf, t);
+    *p++ = ',';
+    p = putQuantized(p, q, quantumMilliC);
+    *p++ = ',';
+    p = FixedFormat::putStr(p, faultName(fault));
+    *p++ = '\r';
+    *p++ = '\n';
+    *p   = '\0';
+    return static_cast<size_t>(p - buf);
+  }
+};
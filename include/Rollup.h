@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include "FixedFormat.h"
+
+/**
+ * @file Rollup.h
+ * @brief 多段解像度の集約（1 秒 / 1 分 / 1 時間）を RUN 中に逐次計算
+ *
+ * @details
+ * 週単位の RUN では生ログが数百万行になり、全体の傾向を見るために毎回
+ * 全行を読むのは現実的でない。RollupCascade は新しいセンサ値ごとに
+ * 最下段（1 秒）の集計器へ加え、区間が閉じたら 1 行（開始時刻・件数・
+ * 平均・最小・最大・標準偏差）を出力して 1 つ上の段へ併合する。
+ *
+ * - 1 サンプルあたりの処理は O(1)（段の繰り上がりは区間ごとに 1 回の併合）
+ * - 平均・分散は Welford 法、段間の併合は Chan らの並列公式（再計算不要）
+ * - 区間は RUN 開始からの経過時間で揃える（1 分の区間 = 1 秒の区間 60 個）
+ * - NaN（断線）は集計に含めない。有効値が 1 つも無い区間は行を出さない
+ *
+ * 出力先（SD のファイル、グラフ表示等）は Emit 関数オブジェクトで受け取る。
+ */
+
+/**
+ * @brief 1 区間の集計値
+ */
+struct RollupStats {
+  uint32_t count;
+  double   mean;
+  double   m2;      // 偏差平方和（分散 = m2 / count）
+  float    minV;
+  float    maxV;
+
+  void clear() {
+    count = 0;
+    mean  = 0.0;
+    m2    = 0.0;
+    minV  = NAN;
+    maxV  = NAN;
+  }
+
+  void add(float v) {
+    ++count;
+    const double d = v - mean;
+    mean += d / count;
+    m2   += d * (v - mean);
+    if (count == 1 || v < minV) minV = v;
+    if (count == 1 || v > maxV) maxV = v;
+  }
+
+  /**
+   * @brief 別区間の集計を併合（Chan et al. の並列分散公式）
+   */
+  void merge(const RollupStats& o) {
+    if (o.count == 0) return;
+    if (count == 0) {
+      *this = o;
+      return;
+    }
+    const double n = static_cast<double>(count) + o.count;
+    const double d = o.mean - mean;
+    mean += d * o.count / n;
+    m2   += o.m2 + d * d * (static_cast<double>(count) * o.count / n);
+    count += o.count;
+    if (o.minV < minV) minV = o.minV;
+    if (o.maxV > maxV) maxV = o.maxV;
+  }
+
+  float stdDev() const {
+    return (count > 0) ? static_cast<float>(std::sqrt(m2 / count)) : NAN;
+  }
+};
+
+/**
+ * @brief 出力する 1 行
+ */
+struct RollupRow {
+  uint8_t  level;      // 0 = 最下段
+  uint32_t startMs;    // 区間の開始（RUN 開始からの経過 ms）
+  uint32_t count;
+  float    mean;
+  float    minV;
+  float    maxV;
+  float    stdDev;
+};
+
+class RollupCascade {
+public:
+  static constexpr size_t LEVELS = 3;
+
+  /**
+   * @brief 既定の段構成（1 秒 / 1 分 / 1 時間）
+   */
+  RollupCascade() {
+    for (size_t i = 0; i < LEVELS; ++i) m_period[i] = defaultPeriodMs(i);
+    reset();
+  }
+
+  /**
+   * @param periodsMs 各段の区間長（下の段の整数倍であること）
+   */
+  explicit RollupCascade(const uint32_t (&periodsMs)[LEVELS]) {
+    for (size_t i = 0; i < LEVELS; ++i) m_period[i] = periodsMs[i];
+    reset();
+  }
+
+  /**
+   * @brief RUN 開始時に全段をクリア
+   */
+  void reset() {
+    for (size_t i = 0; i < LEVELS; ++i) {
+      m_acc[i].clear();
+      m_bucket[i] = 0;
+    }
+  }
+
+  uint32_t periodMs(size_t level) const { return m_period[level]; }
+
+  static uint32_t defaultPeriodMs(size_t level) {
+    static const uint32_t periods[LEVELS] = {1000UL, 60000UL, 3600000UL};
+    return periods[level];
+  }
+
+  /**
+   * @brief 区間長の名前（"1s" / "1m" / "1h" 等、ファイル名の接尾辞に使う）
+   */
+  static void periodName(uint32_t p, char* buf, size_t len) {
+    if (p % 3600000UL == 0) {
+      snprintf(buf, len, "%luh", static_cast<unsigned long>(p / 3600000UL));
+    } else if (p % 60000UL == 0) {
+      snprintf(buf, len, "%lum", static_cast<unsigned long>(p / 60000UL));
+    } else if (p % 1000UL == 0) {
+      snprintf(buf, len, "%lus", static_cast<unsigned long>(p / 1000UL));
+    } else {
+      snprintf(buf, len, "%lums", static_cast<unsigned long>(p));
+    }
+  }
+
+  /**
+   * @brief 新しいセンサ値を加える（閉じた区間があれば emit(const RollupRow&) を呼ぶ）
+   * @param tMs RUN 開始からの経過時間 [ms]（単調増加）
+   */
+  template <typename Emit>
+  void add(uint32_t tMs, float value, Emit& emit) {
+    if (std::isnan(value)) return;
+    const uint32_t bucket = tMs / m_period[0];
+    if (m_acc[0].count > 0 && bucket != m_bucket[0]) close(0, emit);
+    m_bucket[0] = bucket;
+    m_acc[0].add(value);
+  }
+
+  /**
+   * @brief 途中の区間をすべて出力（RUN 終了時）
+   */
+  template <typename Emit>
+  void finish(Emit& emit) {
+    for (size_t level = 0; level < LEVELS; ++level) {
+      if (m_acc[level].count > 0) close(level, emit);
+    }
+  }
+
+  /**
+   * @brief 1 行を CSV に整形（列: StartMs,Count,Mean_C,Min_C,Max_C,StdDev_C）
+   * @return 書き込んだバイト数
+   */
+  static size_t formatCsv(const RollupRow& r, char* buf, size_t len) {
+    // "%lu,%lu,%.2f,%.2f,%.2f,%.3f\r\n" と同じ文字列（FixedFormat、最大でも数値 4 個 × 48 文字）
+    char  tmp[224];
+    char* p = FixedFormat::putUint(tmp, r.startMs);
+    *p++ = ',';
+    p = FixedFormat::putUint(p, r.count);
+    *p++ = ',';
+    p = FixedFormat::putFloat(p, r.mean, 2);
+    *p++ = ',';
+    p = FixedFormat::putFloat(p, r.minV, 2);
+    *p++ = ',';
+    p = FixedFormat::putFloat(p, r.maxV, 2);
+    *p++ = ',';
+    p = FixedFormat::putFloat(p, r.stdDev, 3);
+    *p++ = '\r';
+    *p++ = '\n';
+    if (len == 0) return 0;
+    size_t n = static_cast<size_t>(p - tmp);
+    if (n > len - 1) n = len - 1;
+    memcpy(buf, tmp, n);
+    buf[n] = '\0';
+    return n;
+  }
+
+  static const char* csvColumns() { return "StartMs,Count,Mean_C,Min_C,Max_C,StdDev_C"; }
+
+private:
+  /**
+   * @brief level の区間を出力し、上の段へ併合（上の段も区間が変わるなら先に閉じる）
+   */
+  template <typename Emit>
+  void close(size_t level, Emit& emit) {
+    RollupStats&   acc   = m_acc[level];
+    const uint32_t start = m_bucket[level] * m_period[level];
+    RollupRow row;
+    row.level   = static_cast<uint8_t>(level);
+    row.startMs = start;
+    row.count   = acc.count;
+    row.mean    = static_cast<float>(acc.mean);
+    row.minV    = acc.minV;
+    row.maxV    = acc.maxV;
+    row.stdDev  = acc.stdDev();
+    emit(row);
+
+    const size_t up = level + 1;
+    if (up < LEVELS) {
+      const uint32_t bucket = start / m_period[up];
+      if (m_acc[up].count > 0 && bucket != m_bucket[up]) close(up, emit);
+      m_bucket[up] = bucket;
+      m_acc[up].merge(acc);
+    }
+    acc.clear();
+  }
+
+  uint32_t    m_period[LEVELS];
+  uint32_t    m_bucket[LEVELS];   // 集計中の区間番号（経過時間 / 区間長）
+  RollupStats m_acc[LEVELS];
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+#include "WallClock.h"
+
+/**
+ * @file RtcClock.h
+ * @brief DS3231 RTC の読み書きと、RAM 上の実時刻（WallClock）の補正
+ *
+ * @details
+ * 【読む頻度】RTC を I²C で読むのは補正の時だけ（RTC_DISCIPLINE_INTERVAL_MS ごと）。
+ * 行の時刻は wallMsAt(millis) が WallClock のモデルから整数演算だけで求めるため、
+ * 記録周期に I²C の待ちは入らない。
+ *
+ * 【秒の変わり目】DS3231 の時刻は秒単位のため、補正の時は制御周期ごとに 1 回ずつ
+ * 秒レジスタを読み、値が変わった読み出しとその前の読み出しの中点を「RTC が
+ * その秒になった millis()」とみなす（誤差は読み出し間隔の半分）。1 周期に 1 回の
+ * 読み出しだけなので、変わり目を待つ間も制御周期を止めない。
+ *
+ * 【所有】制御タスクのみが呼ぶ（G と同じ。IO コアは I²C を使わない）。
+ * 発振停止フラグ（OSF）が立っている RTC は時刻が無効のため、set() で設定し直すまで
+ * valid() は false のまま（ログの実時刻列は空）。
+ */
+class RtcClock {
+public:
+  /**
+   * @brief I²C の初期化と RTC の検出（setup() で 1 回）
+   * @return false : RTC が応答しない（以降の呼び出しは何もしない）
+   */
+  static bool init();
+
+  /**
+   * @brief 補正の進行（制御タスクの毎周期）
+   * @details 補正の時刻になれば秒の変わり目を待ち、捕まえたら WallClock を補正する。
+   *          それ以外の周期では I²C を使わない
+   */
+  static void service(uint32_t nowMs);
+
+  /**
+   * @brief 実時刻が使えるか（RTC があり、時刻が設定済みで、1 回以上補正した）
+   */
+  static bool valid() { return s_clock.valid(); }
+
+  /**
+   * @brief millis() の時刻 localMs の実時刻 [ms]（RAM 上の計算のみ）
+   * @return valid() でなければ -1
+   */
+  static int64_t wallMsAt(uint32_t localMs) { return s_clock.nowMs(localMs); }
+
+  static int32_t driftPpb() { return s_clock.driftPpb(); }
+
+  /**
+   * @brief RTC を設定（OSF を消し、すぐに補正し直す）
+   * @return false : RTC が無い・書き込みに失敗
+   */
+  static bool set(const CivilTime& t);
+
+  /**
+   * @brief 状態（現在時刻・進み・最後の誤差・補正回数）を出力
+   */
+  static void dump(Print& out);
+
+private:
+  static bool readTime(CivilTime& t);
+  static bool readRegs(uint8_t reg, uint8_t* buf, size_t len);
+  static bool writeRegs(uint8_t reg, const uint8_t* buf, size_t len);
+  static void finishHunt(uint32_t nowMs, bool ok);
+
+  static WallClock s_clock;
+  static bool      s_present;       // RTC が応答した
+  static bool      s_stopped;       // OSF（発振停止）: 時刻が無効
+  static bool      s_hunting;       // 秒の変わり目を待っている
+  static uint32_t  s_nextMs;        // 次に補正する時刻 (millis)
+  static uint32_t  s_huntStartMs;
+  static uint32_t  s_prevPollMs;    // 直前の読み出し時刻 (millis)
+  static int64_t   s_prevSec;       // 直前の読み出し値（-1 = 未読）
+  static uint32_t  s_missed;        // 変わり目を捕まえ損ねた回数
+  static uint32_t  s_i2cErrors;
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include "BinaryLog.h"
+
+/**
+ * @file RunCatalog.h
+ * @brief RUN の目録（SD 上の追記専用ファイル RUNS.CAT）
+ *
+ * @details
+ * ファイル番号を起動ごとの static カウンタで振ると、再起動のたびに
+ * DATA_0000 から上書きしてしまう。ディレクトリを走査して空き番号を探すと
+ * ファイル数に比例して起動が遅くなるため、RUN ごとに固定長レコードを
+ * 目録ファイルへ追記し、起動時は末尾の 1 レコードだけ読んで次の RUN 番号を得る。
+ *
+ * 【レコード】（64B、リトルエンディアン）
+ * - [0..3]   マジック "RCAT"
+ * - [4]      版数 / [5] 種別（START / END）/ [6] ログ形式 / [7] フラグ
+ * - [8..11]  RUN 番号
+ * - [12..15] 開始時刻（起動からの ms）
+ * - [16..19] RUN の長さ [ms]（END のみ）
+ * - [20..23] サンプル数
+ * - [24..39] 平均 / 標準偏差 / 最小 / 最大（float）
+ * - [40..43] HI / LO アラームの発生回数（u16 × 2）
+ * - [44..59] ログファイル名（NUL 終端）
+ * - [60..63] CRC-32（先頭 60B）
+ *
+ * RUN 開始時に START、終了時に統計入りの END を書く。END の無い START は
+ * 電源断などで終了できなかった RUN（ログは起動時の復旧で閉じられる）。
+ * 書きかけで電源が落ちた末尾は CRC で検出し、次の追記で上書きする。
+ * 一覧表示も末尾から必要な件数だけ読む（ディレクトリは走査しない）。
+ */
+
+/**
+ * @brief 目録 1 レコード
+ */
+struct RunCatalogEntry {
+  uint32_t runId;
+  uint8_t  kind;            // RunCatalog::START / END
+  uint8_t  logFormat;       // 0 = CSV / 1 = BINARY / 2 = DELTA（LogFormat の数値）
+  uint8_t  flags;           // RunCatalog::FLAG_*
+  uint32_t startUptimeMs;   // RUN 開始時の millis()
+  uint32_t durationMs;      // END のみ
+  uint32_t samples;         // END のみ
+  float    average;         // END のみ（以下同じ）
+  float    stdDev;
+  float    minimum;
+  float    maximum;
+  uint16_t hiAlarms;        // HI アラームの発生回数（立ち上がり）
+  uint16_t loAlarms;
+  char     fileName[16];
+};
+
+class RunCatalog {
+public:
+  static constexpr uint8_t VERSION     = 1;
+  static constexpr size_t  RECORD_SIZE = 64;
+
+  static constexpr uint8_t START = 1;
+  static constexpr uint8_t END   = 2;
+
+  static constexpr uint8_t FLAG_SD_ERROR = 0x01;   // RUN 中に SD エラー（ログが不完全）
+
+  /**
+   * @brief RUN 番号からログファイル名（/DATA_0003.csv / .bin）
+   * @details 番号は 5 桁で一巡する（fileName[16] に収まるように。1 時間 1 RUN で約 11 年）
+   */
+  static void fileNameFor(uint32_t runId, bool csv, char* out, size_t len) {
+    snprintf(out, len, "/DATA_%04lu.%s", static_cast<unsigned long>(runId % 100000),
+             csv ? "csv" : "bin");
+  }
+
+  // ── エンコード / デコード ────────────────────────────────────────────────
+
+  static void encode(const RunCatalogEntry& e, uint8_t* out) {
+    memset(out, 0, RECORD_SIZE);
+    memcpy(out, magic(), 4);
+    out[4] = VERSION;
+    out[5] = e.kind;
+    out[6] = e.logFormat;
+    out[7] = e.flags;
+    BinaryLog::put32(out + 8, e.runId);
+    BinaryLog::put32(out + 12, e.startUptimeMs);
+    BinaryLog::put32(out + 16, e.durationMs);
+    BinaryLog::put32(out + 20, e.samples);
+    putFloat(out + 24, e.average);
+    putFloat(out + 28, e.stdDev);
+    putFloat(out + 32, e.minimum);
+    putFloat(out + 36, e.maximum);
+    BinaryLog::put16(out + 40, e.hiAlarms);
+    BinaryLog::put16(out + 42, e.loAlarms);
+    for (size_t i = 0; i + 1 < sizeof(e.fileName) && e.fileName[i] != '\0'; ++i) {
+      out[44 + i] = static_cast<uint8_t>(e.fileName[i]);
+    }
+    BinaryLog::put32(out + 60, BinaryLog::crc32(0, out, 60));
+  }
+
+  /**
+   * @return false : マジック・版数・CRC のいずれかが不正（書きかけ・破損）
+   */
+  static bool decode(const uint8_t* in, RunCatalogEntry& e) {
+    if (memcmp(in, magic(), 4) != 0 || in[4] != VERSION ||
+        BinaryLog::get32(in + 60) != BinaryLog::crc32(0, in, 60)) {
+      return false;
+    }
+    e.kind          = in[5];
+    e.logFormat     = in[6];
+    e.flags         = in[7];
+    e.runId         = BinaryLog::get32(in + 8);
+    e.startUptimeMs = BinaryLog::get32(in + 12);
+    e.durationMs    = BinaryLog::get32(in + 16);
+    e.samples       = BinaryLog::get32(in + 20);
+    e.average       = getFloat(in + 24);
+    e.stdDev        = getFloat(in + 28);
+    e.minimum       = getFloat(in + 32);
+    e.maximum       = getFloat(in + 36);
+    e.hiAlarms      = BinaryLog::get16(in + 40);
+    e.loAlarms      = BinaryLog::get16(in + 42);
+    memcpy(e.fileName, in + 44, sizeof(e.fileName));
+    e.fileName[sizeof(e.fileName) - 1] = '\0';
+    return true;
+  }
+
+  // ── 追記位置・末尾の読み出し ──────────────────────────────────────────────
+
+  /**
+   * @brief 次のレコードを書くオフセット（書きかけの末尾は上書きする）
+   */
+  static uint32_t appendOffset(uint32_t fileSize) {
+    return fileSize - fileSize % RECORD_SIZE;
+  }
+
+  /**
+   * @brief 末尾から遡って最初の正しいレコードを読む
+   *
+   * @tparam Source size_t read(uint32_t offset, uint8_t* buf, size_t len) を持つ型
+   * @param maxBack 遡る最大レコード数（破損が続く場合の打ち切り）
+   * @param offset  見つかったレコードのオフセット（省略可）
+   * @return false : 正しいレコードが無い（空・全て破損）
+   */
+  template <typename Source>
+  static bool findLast(Source& src, uint32_t fileSize, RunCatalogEntry& out,
+                       uint32_t maxBack = 8, uint32_t* offset = nullptr) {
+    uint8_t  buf[RECORD_SIZE];
+    uint32_t pos = appendOffset(fileSize);
+    for (uint32_t i = 0; i < maxBack && pos >= RECORD_SIZE; ++i) {
+      pos -= RECORD_SIZE;
+      if (src.read(pos, buf, RECORD_SIZE) == RECORD_SIZE && decode(buf, out)) {
+        if (offset != nullptr) *offset = pos;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief 目録の末尾から次の RUN 番号を求める
+   * @return 最後のレコードの RUN 番号 + 1（正しいレコードが無ければ fallback）
+   */
+  template <typename Source>
+  static uint32_t nextRunId(Source& src, uint32_t fileSize, uint32_t fallback = 0) {
+    RunCatalogEntry last;
+    if (!findLast(src, fileSize, last)) return fallback;
+    return (last.runId + 1 > fallback) ? last.runId + 1 : fallback;
+  }
+
+  /**
+   * @brief 一覧表示用の 1 行（"#0003 END  DATA_0003.csv 3600s n=7200 avg=..."）
+   */
+  static int formatLine(const RunCatalogEntry& e, char* out, size_t len) {
+    if (e.kind != END) {
+      return snprintf(out, len, "#%04lu START %s at %lus\n", static_cast<unsigned long>(e.runId),
+                      e.fileName, static_cast<unsigned long>(e.startUptimeMs / 1000));
+    }
+    return snprintf(out, len,
+                    "#%04lu END   %s %lus n=%lu avg=%.2f sd=%.3f min=%.2f max=%.2f hi=%u lo=%u%s\n",
+                    static_cast<unsigned long>(e.runId), e.fileName,
+                    static_cast<unsigned long>(e.durationMs / 1000),
+                    static_cast<unsigned long>(e.samples), e.average, e.stdDev, e.minimum,
+                    e.maximum, static_cast<unsigned>(e.hiAlarms),
+                    static_cast<unsigned>(e.loAlarms),
+                    (e.flags & FLAG_SD_ERROR) ? " sd_error" : "");
+  }
+
+private:
+  static const uint8_t* magic() {
+    static const uint8_t m[4] = {'R', 'C', 'A', 'T'};
+    return m;
+  }
+
+  static void putFloat(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    BinaryLog::put32(p, bits);
+  }
+  static float getFloat(const uint8_t* p) {
+    const uint32_t bits = BinaryLog::get32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Global.h"
+#include "LatencyHistogram.h"
+#include "CardProfile.h"
+
+/**
+ * @file SDBenchmark.h
+ * @brief SD 書き込み方式の実機ベンチマーク（行あたりレイテンシ・行/秒）
+ *
+ * @details
+ * 同じ CSV 行を 2 方式で書き込み、1 行あたりの処理時間分布と行/秒を比較する。
+ * - legacy : 旧 SDManager::writeData() 相当（write → flush → SPI.end/begin を毎行）
+ * - sector : 現行の SectorWriter（512B 整列ダブルバッファ + 時間/バイト数で同期）
+ *
+ * シリアルコマンド 'b' から SD 書き込みタスクへ依頼して実行（IDLE / RESULT 中のみ、
+ * SDWriter::benchmark()）。他の SD 操作とはリングの順で直列になり、実行中も
+ * 制御タスクの UI・記録判定、IO コアのサンプリングは止まらない
+ * （SPI バスは 1 行ごとに SpiBusGuard で獲得・解放）。ベンチ用ファイル
+ * （/BENCH_L.csv, /BENCH_S.csv）は終了後に削除する。
+ *
+ * profileCard() はマウント時のカード計測（CardProfile.h）。SDManager::profileCard() から呼ぶ。
+ */
+class SDBenchmark {
+public:
+  /**
+   * @brief 両方式のベンチマークを実行して結果を出力（SD 書き込みタスクから）
+   * @param out 出力先（Serial 等）
+   * @param rows 1 方式あたりの書き込み行数
+   */
+  static void run(Print& out, uint16_t rows = SD_BENCH_ROWS);
+
+  /**
+   * @brief ブロック長ごとの書き込み・読み出し速度と書き込みレイテンシを計測
+   *
+   * @details
+   * 一時ファイル（SD_PROFILE_SCRATCH_FILE）を SD_PROFILE_BYTES_PER_SIZE まで
+   * 確保してから、ブロック長ごとに先頭から「write() + flush()」で上書きする
+   * （ログも確保済み領域への上書きのため、クラスタ確保の時間は含めない）。
+   * 結果は profile.results / count に入れる（同期方針の選択は呼び出し側）。
+   *
+   * @return false : 一時ファイルを作れない・書き込みに失敗した
+   */
+  static bool profileCard(Print& out, CardProfile& profile);
+
+private:
+  static void report(Print& out, const char* mode, uint16_t rows,
+                     uint32_t totalUs, const LatencyHistogram& hist);
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "OutageBacklog.h"  // SD 切断中の退避（BacklogPolicy）
+#include "CardProfile.h"    // SD カードの自己ベンチマーク（CardProfileMode）
+
+/**
+ * @file SDConfig.h
+ * @brief SD ログ経路の定数・1 行分のデータ（SDData）・ログ形式
+ *
+ * @details
+ * Global.h から分けたもの。M5Stack / Arduino に依存しないため、ホストツール
+ * （tools/sdsim.cpp 等）が実機と同じリング深さ・同期方針・行の形で見積もれる。
+ * ファームウェアは Global.h 経由で読み込む。
+ */
+
+// ── Phase 4: SDカード定数 ──────────────────────────────────────────────────────
+constexpr const char* SD_MOUNT_POINT    = "/sd";         // microSD マウントポイント
+constexpr uint32_t    SD_BUFFER_SIZE    = 256;           // CSV行バッファサイズ [bytes]
+constexpr uint16_t    SD_MAX_FILENAME   = 32;            // ファイル名最大長
+constexpr uint32_t    SD_SYNC_INTERVAL_MS = 2000UL;      // 最長この間隔でカードへ同期（電源断時の損失上限）
+constexpr uint32_t    SD_SYNC_BYTES       = 4096UL;      // 未同期がこのバイト数に達したら同期
+constexpr uint16_t    SD_BENCH_ROWS       = 300;         // SDBenchmark の 1 方式あたり行数
+constexpr uint32_t    SD_STALL_THRESHOLD_US = 100000UL;  // ファイル操作がこれを超えたら停止として数える（'p' の over=）
+
+// マウント時のカード自己ベンチマーク（CardProfile.h）: 上の同期方針をカードに合わせて選び直す
+constexpr CardProfileMode SD_PROFILE_MODE            = CardProfileMode::CACHED;
+constexpr const char*     SD_PROFILE_FILE            = "/CARD.PRF";    // 最後の計測結果（同じカードなら再利用）
+constexpr const char*     SD_PROFILE_LOG_FILE        = "/CARDS.LOG";   // 計測ごとに 1 行追記（カード履歴）
+constexpr const char*     SD_PROFILE_SCRATCH_FILE    = "/CARD.TMP";    // 計測用（終了後に削除）
+constexpr uint32_t        SD_PROFILE_BYTES_PER_SIZE  = 65536UL;  // ブロック長ごとの書き込み量（計 320KB、約 1～3 秒）
+constexpr uint32_t        SD_SYNC_BYTES_MIN          = 2048UL;   // 選択する同期バイト数の範囲
+constexpr uint32_t        SD_SYNC_BYTES_MAX          = 8192UL;
+constexpr uint32_t        SD_SYNC_INTERVAL_MIN_MS    = 1000UL;   // 選択する同期間隔の範囲（上限 = 電源断時の損失上限）
+constexpr uint32_t        SD_SYNC_INTERVAL_MAX_MS    = 5000UL;
+constexpr uint32_t        SD_PROFILE_THROUGHPUT_PCT  = 80;       // 最速の何 % 出れば小さいブロックを選ぶか
+constexpr uint32_t        SD_PROFILE_SYNC_DUTY_DIV   = 50;       // 同期に費やす時間を 1/50 以下に
+constexpr uint32_t        SD_PROFILE_BAD_LATENCY_US  = 250000UL; // これより長く止まるカードは BAD
+constexpr uint32_t        SD_PROFILE_MIN_WRITE_KBPS  = 100;      // 最速でもこれ未満なら BAD
+constexpr const char* FIRMWARE_VERSION    = "1.0.0";     // バイナリログのヘッダに記録
+constexpr uint32_t    SD_PREALLOC_SECONDS      = 3600UL;   // ファイル作成時に確保する想定 RUN 長 [s]
+constexpr uint32_t    SD_PREALLOC_UNIT_BYTES   = 32768UL;  // 確保単位（SDHC の標準クラスタサイズ）
+constexpr uint32_t    SD_PREALLOC_MARGIN_BYTES = 65536UL;  // 残りがこれを切ったら次の想定 RUN 長ぶんを追加確保
+constexpr uint32_t    SD_PREALLOC_STEP_BYTES   = 2 * SD_PREALLOC_UNIT_BYTES;  // 1 回に伸ばす量（この間はバスを譲れない）
+constexpr uint32_t    SD_CHECKPOINT_INTERVAL_MS   = 30000UL;  // CSV のチェックポイント行の間隔（全サンプル記録で約 5KB）
+constexpr uint32_t    SD_CHECKPOINT_BLOCKS        = 8;        // BINARY / DELTA: データブロック何個ごとに 1 個
+constexpr uint32_t    SD_RECOVERY_WINDOW_BYTES    = 65536UL;  // 起動時の復旧で末尾から読む量（間隔より広く）
+constexpr uint32_t    SD_RECOVERY_LOOKAHEAD_BYTES = SD_SYNC_BYTES_MAX + 1024UL;  // 有効長より先を探す量
+constexpr uint32_t    SD_INDEX_INTERVAL_RECORDS   = 120;      // 時刻索引のエントリ間隔（全サンプル記録で 1 分）
+constexpr const char*   SD_CATALOG_FILE         = "/RUNS.CAT";  // RUN の目録（追記専用、RunCatalog.h）
+constexpr uint32_t      SD_CATALOG_MAX_RUN_ID   = 65536UL;   // 目録が無いときに既存ログを探す上限
+constexpr uint32_t      SD_CATALOG_LIST_RUNS    = 20;        // シリアル 'l' で表示する件数
+constexpr size_t        SD_OUTAGE_BACKLOG_DEPTH = 512;       // 切断中に RAM へ退避する行数（約 22KB、全サンプル記録で約 4 分）
+constexpr uint32_t      SD_REMOUNT_INTERVAL_MS  = 2000UL;    // 切断中の再マウント試行間隔（初回、失敗ごとに倍）
+constexpr uint32_t      SD_REMOUNT_INTERVAL_MAX_MS = 30000UL; // 同上の上限
+constexpr uint32_t      SD_MOUNT_RETRY_MS       = 5000UL;    // 未マウントの間（IDLE）のマウント再試行間隔（初回、失敗ごとに倍）
+constexpr uint32_t      SD_MOUNT_RETRY_MAX_MS   = 60000UL;   // 同上の上限
+constexpr BacklogPolicy SD_OUTAGE_POLICY        = BacklogPolicy::DECIMATE;  // 退避が満杯のとき（DROP_OLDEST: 古い順に捨てる）
+
+// SD 書き込みタスク（SDWriter）: 制御タスクより低優先で、制御タスクの空き時間に書く
+constexpr size_t        SD_RING_DEPTH              = 64;     // レコード数（2 行/秒で約 30 秒分）
+constexpr unsigned long SD_CONTROL_RECORD_WAIT_MS  = 200UL;  // OPEN / CLOSE 依頼時の空き待ち上限
+constexpr size_t        SD_CONTROL_SLOTS           = 4;      // 処理待ちにできる OPEN / SEGMENT / CLOSE の数
+constexpr int           SD_WRITER_TASK_CORE        = 0;      // 制御コアと同じ（IO コアは空けておく）
+constexpr uint32_t      SD_WRITER_TASK_STACK_BYTES = 6144;   // フッタ整形 512B を含む
+constexpr unsigned      SD_WRITER_TASK_PRIORITY    = 1;      // 制御タスク(2)より低優先
+
+// 生データ記録（RawCapture.h）: RUN 中、全読取値を DATA_xxxx_raw.bin へ（要約ログはそのまま）
+constexpr bool     SD_RAW_CAPTURE_DEFAULT    = false;   // 起動時のモード（シリアル 'c' で切替）
+constexpr size_t   SD_RAW_RING_DEPTH         = 256;     // IO → 書き込みタスク（10 サンプル/秒で約 25 秒分）
+constexpr uint32_t SD_RAW_BUDGET_BYTES_PER_S = 1024UL;  // 生データ記録に割く SD 帯域（カード下限 100KB/s の 1%）
+
+// プリトリガ（PreTrigger.h）: RUN 開始・アラーム変化の直前 SD_PRETRIGGER_WINDOW_MS を残す
+constexpr uint32_t SD_PRETRIGGER_WINDOW_MS      = 30000UL;  // 残す長さ
+constexpr size_t   SD_PRETRIGGER_DEPTH          = 64;       // 保持するサンプル数（500ms 周期で 32 秒分）
+constexpr size_t   SD_PRETRIGGER_SLOTS          = 2;        // 書き込み待ちにできるスナップショット数
+constexpr uint16_t SD_ALARM_SNAPSHOTS_PER_RUN   = 16;       // 1 RUN で作るアラームスナップショットの上限
+
+// ソークモード（SoakLog.h）: 数週間の RUN でログを区間に分け、時刻・サンプル数を 64 ビットで数える
+constexpr bool     SD_SOAK_DEFAULT      = false;               // 起動時のモード（シリアル 's' で切替）
+constexpr uint32_t SD_SEGMENT_MAX_BYTES = 256UL * 1024 * 1024; // 区間のファイルサイズ上限（FAT32 上限 4GB より十分小さく）
+constexpr uint32_t SD_SEGMENT_MAX_MS    = 86400000UL;          // 区間の長さ上限（24 時間）
+
+// ── Phase 4: SDデータ構造体 ─────────────────────────────────────────────────────
+// CSV 1 行分のデータを保持（シングルチャネル専用）
+struct SDData {
+  uint32_t elapsedSeconds;   // RUN開始からの経過秒数
+  uint32_t elapsedMs;        // RUN開始からの経過時間 [ms]（DELTA: サンプル取得時刻）
+  float    temperature;      // 現在の温度 [°C]
+  const char* state;         // 状態文字列（"RUN", "RESULT"等）
+  uint64_t sampleCount;      // 取得サンプル数（BINARY / DELTA の記録は 32 ビットで飽和）
+  float    averageTemp;      // 平均温度 [°C]
+  float    stdDev;           // 標準偏差 [°C]
+  float    maxTemp;          // 最高温度 [°C]
+  float    minTemp;          // 最低温度 [°C]
+  bool     hiAlarm;          // 上限アラームフラグ
+  bool     loAlarm;          // 下限アラームフラグ
+  int64_t  wallMs;           // サンプル取得時の実時刻 [ms]（RtcClock、-1 = 不明。CSV のみ記録）
+};
+
+// ── ログ形式 ──────────────────────────────────────────────────────────────────
+// CSV: 従来どおりの 1 行テキスト / BINARY: 20B 固定長レコード（BinaryLog.h、tools/logconv で CSV 化）
+// DELTA: 新しいセンサ値ごとに時刻・温度・アラームのみを差分符号化（DeltaCodec.h、長時間向け）
+enum class LogFormat : uint8_t {
+  CSV,
+  BINARY,
+  DELTA
+};
+constexpr LogFormat SD_LOG_FORMAT_DEFAULT = LogFormat::CSV;  // 起動時の形式（シリアル 'f' で切替）
+constexpr uint16_t  SD_DELTA_QUANTUM_MILLIC = 250;            // DELTA の温度量子化幅（MAX31855 の分解能）
+
+// 記録判定（LogFilter.h）: 新しいセンサ値ごとに 1 行。デッドバンドは変化・間隔・アラーム変化時のみ
+constexpr bool     SD_DEADBAND_DEFAULT         = false;    // 起動時のモード（シリアル 'd' で切替）
+constexpr float    SD_DEADBAND_C               = 0.5f;     // デッドバンド幅 [°C]（MAX31855 分解能の 2 倍）
+constexpr uint32_t SD_DEADBAND_MAX_INTERVAL_MS = 10000UL;  // デッドバンド中も最低この間隔で 1 行
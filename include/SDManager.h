@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Global.h"
+#include "BinaryLog.h"
+#include "Rollup.h"
+#include "LogIndex.h"
+#include "RunCatalog.h"
+#include "CardProfile.h"
 
 /**
  * @file SDManager.h
@@ -8,12 +13,38 @@
  * 
  * @details
  * ESP32 のハードウェア SPI を使用して microSD カードに CSV形式でデータを記録します。
+ * ファイル作成時に LogFormat::BINARY を指定すると、同じ内容を 20B 固定長の
+ * レコードとして記録します（形式は BinaryLog.h、CSV への変換は tools/logconv.cpp）。
+ * LogFormat::DELTA では時刻・温度（0.25°C 量子化）・アラームのみを差分符号化
+ * します（DeltaCodec.h）。
  * EEPROMManager と同パターンで、すべてのSD操作を静的メソッドで提供します。
  * 
  * ファイルライフサイクル：
  * 1. RUN開始 → createNewFile() でファイル作成
- * 2. RUN中 → writeData() で逐次データ記録（バッファ蓄積）
+ * 2. RUN中 → writeData() で逐次データ記録（バッファ蓄積）、writeRollup() で集約ログ
  * 3. RESULT遷移 → flush() + closeFile() でファイルクローズ
+ *
+ * 書き込みは SectorWriter（512 バイト整列のダブルバッファ）経由。
+ * 行は RAM に溜め、満杯のセクタを 1 回の write() で書き出す。カードへの
+ * 同期は SD_SYNC_INTERVAL_MS / SD_SYNC_BYTES の早い方（電源断時の損失上限）。
+ * 起動時に profileCard() がカードを計測し、この 2 つをカードに合わせて選び直す
+ * （CardProfile.h）。
+ *
+ * ファイルは作成時に想定 RUN 長（SD_PREALLOC_SECONDS）ぶんを事前確保し、
+ * 実データ長は先頭セクタの有効長マーカーに同期ごとに記録する（LogPrealloc.h）。
+ * closeFile() で有効長まで切り詰める。
+ *
+ * RUN 中は一定間隔でチェックポイント（記録済みレコード数・累積統計）を書き、
+ * 電源断で閉じられなかったファイルは起動時に recoverUnclosed() が
+ * 最後の完全なレコードで切り詰め、復旧要約を追記する（LogRecovery.h）。
+ *
+ * 生ログと並べて疎な時刻索引（DATA_xxxx.idx、LogIndex.h）を作り、
+ * seekIndex() で経過時間から読み始めるオフセットを O(log n) で引ける。
+ * 生データ記録を有効にした RUN では、全読取値を DATA_xxxx_raw.bin に残す
+ * （openRaw() / writeRaw() / closeRaw()、RawCapture.h）。
+ *
+ * RUN ごとの開始・終了は目録ファイル（SD_CATALOG_FILE、RunCatalog.h）に追記し、
+ * 起動時は loadCatalog() が末尾だけ読んで次の RUN 番号を決める。
  * 
  * エラーハンドリング：
  * - SD未検出時：M_SDReady=false を GlobalData に設定
@@ -51,60 +82,163 @@ public:
    * @brief 新規 CSV ファイルの作成・オープン
    * 
    * @details
-   * ファイル名は YYYYMMDD_HHMMSS.csv 形式で、
-   * Logic_Task から RTC の現在時刻を基に生成されたファイル名が渡されます。
+   * ファイル名は RUN の目録（RUNS.CAT）の RUN 番号から作った DATA_xxxx.csv 形式で、
+   * handleButtonA から渡されます（RUN の実時刻はヘッダ直後の "# WALLCLOCK" 行と
+   * CSV の WallTime 列に記録）。
    * 
    * 既にファイルが開いている場合は closeFile() してから呼び出してください。
    * 
-   * @param filename ファイル名（例："20260226_143025.csv"）
+   * 形式ごとの書き込みレートから想定 RUN 長ぶんのサイズを事前確保します
+   * （確保に失敗しても作成は成功扱い、従来どおり書き込み時に伸ばす）。
+   * 
+   * @param filename ファイル名（例："/DATA_0003.csv"）
+   * @param format ログ形式（既定は CSV）
    * @return true : ファイル作成・オープン成功
    * @return false : ファイル操作失敗
    */
-  static bool createNewFile(const char* filename);
+  static bool createNewFile(const char* filename, LogFormat format = LogFormat::CSV);
 
   /**
-   * @brief CSV ヘッダ行の書き込み
+   * @brief ヘッダの書き込み
    * 
    * @details
    * createNewFile() の直後に呼び出す想定です。
-   * ヘッダ行フォーマット：
-   * ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,HI_ALARM,LO_ALARM
+   * CSV のヘッダ行フォーマット：
+   * ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,HI_ALARM,LO_ALARM,ElapsedMs,WallTime
+   * （FullLogLayout の場合。列構成は LogSchema.h の SdLogLayout から生成）
+   * 続く '# LOG,valid_bytes=...' 行（空白埋め）で先頭セクタを 512B にします。
+   * 
+   * バイナリ形式では 512B の自己記述ヘッダ（スキーマ版数・サンプル周期・
+   * 閾値・ファームウェア版数・上記の列名（WallTime を除く））を書きます。
    * 
-   * @return true : ヘッダ行書き込み成功
+   * @param hiThreshold 上限アラーム閾値 [°C]（バイナリ形式のみ記録）
+   * @param loThreshold 下限アラーム閾値 [°C]（バイナリ形式のみ記録）
+   * @return true : ヘッダ書き込み成功
    * @return false : 書き込み失敗
    */
-  static bool writeHeader();
+  static bool writeHeader(float hiThreshold = NAN, float loThreshold = NAN);
 
   /**
    * @brief CSV データ行の書き込み
    * 
    * @details
    * SDData 構造体（Global.h で定義）を CSV フォーマットに変換して書き込みます。
-   * 実装としては内部バッファに蓄積し、flushBuffer() で物理的に SD へ書き出します。
+   * 行はセクタバッファに追記し、満杯のセクタと同期方針（時間・バイト数）に
+   * 該当する分だけを物理的に SD へ書き出します。行ごとの flush は行いません。
+   * 
+   * バイナリ形式ではレコードを 512B ブロックに詰め、満杯のブロックだけを
+   * セクタバッファへ渡します（途中のブロックは flush() / フッタ書き込み時）。
    * 
    * @param data CSV に記録するデータ（SDData 構造体参照）
    * @return true : バッファに蓄積成功
-   * @return false : バッファ溢れか書き込み失敗
+   * @return false : セクタ書き出しまたは同期に失敗
    */
   static bool writeData(const SDData& data);
 
+  /**
+   * @brief 集約ログ（1 秒 / 1 分 / 1 時間）の 1 行を書き込み
+   *
+   * @details
+   * createNewFile() は生ログと並べて段ごとの CSV（例: DATA_0003_1s.csv、
+   * 列は StartMs,Count,Mean_C,Min_C,Max_C,StdDev_C）を作成します。
+   * 行は Storage_Task の RollupCascade（Rollup.h）が区間を閉じるたびに届きます。
+   * 書き込みに失敗した段は以後記録しません（生ログの記録は続ける）。
+   *
+   * @return false : その段のファイルが無い、または書き込み失敗
+   */
+  static bool writeRollup(const RollupRow& row);
+
+  /**
+   * @brief 生データ記録（DATA_xxxx_raw.bin）の作成
+   *
+   * @details
+   * 生ログ（filename）と並べて作成し、ENCODING_RAW のヘッダを書きます（RawCapture.h）。
+   * 同期方針は生ログと同じ（profileCard() 後はカードに合わせた値）。
+   * 生データ側の失敗は生ログの記録を止めません（以後の生データを捨てるだけ）。
+   *
+   * @param filename 生ログのファイル名（例："/DATA_0003.bin"）
+   * @param hiThreshold RUN 開始時の上限閾値（ヘッダに記録）
+   * @param loThreshold RUN 開始時の下限閾値（ヘッダに記録）
+   * @return false : 作成またはヘッダ書き込みに失敗
+   */
+  static bool openRaw(const char* filename, float hiThreshold, float loThreshold);
+
+  /**
+   * @brief 生データ 1 サンプルを差分符号化ブロックへ追加
+   * @param elapsedMs RUN 開始からの経過時間（要約ログの ElapsedMs と同じ基準）
+   * @return false : 開いていない、または書き込み失敗（以後は記録しない）
+   */
+  static bool writeRaw(uint32_t elapsedMs, const RawSample& sample);
+
+  /**
+   * @brief 生データ記録を同期してクローズ（有効長・closed=1 を記録）
+   * @return false : 開いていなかった、または書き込み失敗
+   */
+  static bool closeRaw();
+
+  /**
+   * @brief アラームスナップショット（PreTrigger.h）を独立した CSV として書き込み
+   *
+   * @details
+   * 作成 → 書き込み → クローズを 1 回で行います（生ログとは別のファイル。開いたままにしない）。
+   * 書き込みはセクタ単位に分け、その都度センサー読取へバスを譲ります。
+   *
+   * @param path ファイル名（例："/DATA_0003_a01.csv"）
+   * @param text CSV 全体（ヘッダ行を含む）
+   * @param len text の長さ
+   * @return false : 作成または書き込みに失敗
+   */
+  static bool writeSnapshot(const char* path, const char* text, size_t len);
+
+  /**
+   * @brief 開いているログに書いたバイト数（ヘッダを含む。ソークの区間切り替え判定用）
+   */
+  static uint32_t logBytes();
+
+  /**
+   * @brief フッタ（コメント行）の書き込み
+   *
+   * @details
+   * closeFile() の直前に呼び出す想定です。'#' で始まる行をそのまま追記します
+   * （例: PerfMonitor::formatFooter() のタスク処理時間統計）。
+   * バイナリ形式では TEXT ブロックとして格納します（変換時にそのまま出力）。
+   *
+   * @param text 追記するテキスト（CRLF 終端済みの行の並び）
+   * @return true : 書き込み成功
+   * @return false : 書き込み失敗
+   */
+  static bool writeFooter(const char* text);
+
   /**
    * @brief 内部バッファを SD カードへフラッシュ
    * 
    * @details
-   * IO_Task で 10 サンプルごとに call される想定です。
-   * バッファの内容を物理的に microSD へ書き込み、バッファをクリアします。
+   * RUN 終了時（closeFile() 内を含む）に呼び出します。書き出し待ちセクタと
+   * 途中までのセクタを書き込み、ファイルサイズを確定させます。
    * 
    * @return true : フラッシュ成功
    * @return false : 書き込み失敗
    */
   static bool flush();
 
+  /**
+   * @brief 書き出し待ちセクタの書き出しと時間条件の同期
+   *
+   * @details
+   * 行が途切れても SD_SYNC_INTERVAL_MS ごとの同期を守るため、SD 書き込み
+   * タスクが定期的に呼び出します。ファイルが開いていなければ何もしません。
+   *
+   * @return true : 成功（または何もする必要が無い）
+   * @return false : 書き込み失敗
+   */
+  static bool poll();
+
   /**
    * @brief 開いているファイルをクローズ
    * 
    * @details
-   * 最後に flush() してからクローズします。
+   * 最後に flush() してからクローズし、事前確保した未使用領域を
+   * 有効長まで切り詰めます（truncate() 失敗時も有効長マーカーは残る）。
    * RESULT 遷移時に Logic_Task から call される想定です。
    * 
    * @return true : クローズ成功
@@ -112,6 +246,23 @@ public:
    */
   static bool closeFile();
 
+  /**
+   * @brief 閉じられなかったログの復旧（起動時）
+   *
+   * @details
+   * 目録（RUNS.CAT）の末尾が END の無い START なら、その RUN の生ログ・ソークの区間・
+   * 生データのうち有効長マーカーが closed=0 のファイルについて、末尾
+   * SD_RECOVERY_WINDOW_BYTES だけを読み、最後の完全なレコードの直後へ
+   * "# RECOVERED,..." の要約を書いてクローズ済みにし、切り詰めます。
+   * ディレクトリは走査せず、開くのはその RUN のファイルだけ（RUN の数に依存しない）。
+   * 1 ファイルあたりの読み出し量は一定（ファイルサイズに依存しない）。
+   * SPI バスは I/O 1 回ごとに保持します（IO コアの読取を長く止めない）。
+   * ファイルを開いている間は何もしません。SD 書き込みタスクから呼び出します。
+   *
+   * @return 復旧したファイル数
+   */
+  static int recoverUnclosed();
+
   /**
    * @brief ファイルをクローズして終了
    * 
@@ -148,13 +299,94 @@ public:
    */
   static const char* getLastError();
 
+  /**
+   * @brief SD 切断後の再マウントと、記録中ファイルへの追記再開
+   *
+   * @details
+   * 書き込み失敗で無効になったハンドルを捨て、SD.end() → begin() で再マウントする。
+   * 記録中のファイルは起動時と同じ復旧（recoverFile()）で最後の完全なレコードまで
+   * 切り詰めて "# RECOVERED" 要約を追記し、その直後から追記を再開する
+   * （時刻索引・集約ログも開き直す）。最後の同期より後に RAM にあったレコードは
+   * 失われ、その数を lostRecords に返す。SD 書き込みタスクから呼ぶ。
+   * 生データ記録はその RUN では再開しない（ファイルは次回起動時の復旧で閉じられる）。
+   *
+   * @param lostRecords [out] 最後の同期以降に失われたレコード数
+   * @return false : 再マウント・再開に失敗（ファイルは開いたまま扱い、再試行できる）
+   */
+  static bool remount(uint32_t& lostRecords);
+
+  /**
+   * @brief 時刻索引から、経過時間 elapsedMs 以前で最も近い同期点を引く
+   *
+   * @details
+   * 索引ファイルを二分探索する（読み出しは O(log n) 回）。生ログは
+   * out.offset から読み始め、経過時間が elapsedMs に達するまで読み飛ばす。
+   * 記録中のファイルにも使える（未確定の索引はファイルサイズから件数を求める）。
+   *
+   * @param logPath 生ログのパス（例："/DATA_0003.csv"）
+   * @return false : 索引が無い・壊れている、または elapsedMs が最初の同期点より前
+   */
+  static bool seekIndex(const char* logPath, uint32_t elapsedMs, LogIndexEntry& out);
+
+  /**
+   * @brief 目録の末尾を読み、次の RUN 番号を返す（マウント成功ごと、SD 書き込みタスクから）
+   *
+   * @details
+   * 読むのは末尾の 1 レコード（破損時は数レコード遡る）のみ。目録が無い場合
+   * （初回・旧ファームウェアからの更新）は DATA_xxxx の有無を倍々 → 二分探索で
+   * 調べ、既存ファイルの次の番号から始める（O(log n) 回の存在確認）。
+   */
+  static uint32_t loadCatalog();
+
+  /**
+   * @brief 目録へ 1 レコード追記（SD 書き込みタスクから呼ぶ）
+   * @details 書きかけで残った末尾（64B に満たない端数）は上書きする
+   * @return false : 目録を開けない・書き込み失敗
+   */
+  static bool appendCatalog(const RunCatalogEntry& entry);
+
+  /**
+   * @brief 目録の末尾 count 件を古い順に出力（ディレクトリは走査しない）
+   */
+  static void listRuns(Print& out, uint32_t count);
+
+  /**
+   * @brief カードの性能プロファイルを得て、ログの同期方針に反映（マウント成功ごと）
+   *
+   * @details
+   * SD_PROFILE_MODE が CACHED なら、SD_PROFILE_FILE が同じカード（種別・容量）の
+   * ものであれば再利用する。無ければ SDBenchmark::profileCard() で計測し、
+   * 保存したうえで SD_PROFILE_LOG_FILE に 1 行追記する。結果と判定は out へも出力。
+   * 再マウント（remount()）では呼ばない（選んだ方針は RUN をまたいで保持）。
+   * 同期方針は書き込み器の状態のため、SD 書き込みタスクから呼び出します
+   * （SDWriter::profileCard()）。
+   */
+  static void profileCard(Print& out);
+
+  /**
+   * @brief 生ログの同期間隔 [ms]（profileCard() 後はカードに合わせた値）
+   */
+  static uint32_t syncIntervalMs();
+
+  /**
+   * @brief ログ経路のファイル操作（open / write / flush / close）ごとのレイテンシを出力
+   * @details SD_STALL_THRESHOLD_US を超えた回数も併せて出す（SdLatency.h）
+   */
+  static void dumpLatency(Print& out);
+
+  /**
+   * @brief レイテンシ統計のリセットを依頼（次の記録時に SD 書き込みタスクが行う）
+   */
+  static void requestLatencyReset();
+
 private:
   // ── 内部状態管理 ──
   static bool       s_sdReady;              // SD 初期化完了フラグ
   static bool       s_fileOpen;             // ファイルオープン状態
+  static LogFormat  s_format;               // 開いているファイルの形式
   static File       s_currentFile;          // 現在のファイルハンドル
   static char       s_lastError[64];        // 最後のエラーメッセージ
-  static char       s_lineBuffer[256];      // CSV 行バッファ
+  static char       s_lineBuffer[320];      // CSV 行バッファ（float 5 列が最長でも収まる）
 
   /**
    * @brief エラーメッセージの設定（内部用）
@@ -168,4 +400,132 @@ private:
    * @return 生成された CSV 行（s_lineBuffer）
    */
   static const char* formatCSVLine(const SDData& data);
+
+  /**
+   * @brief SDData からバイナリレコードを生成
+   * @param data SDData 構造体
+   * @param rec  [out] 0.1°C に量子化したレコード
+   */
+  static void toBinaryRecord(const SDData& data, BinLogRecord& rec);
+
+  /**
+   * @brief 途中までの DATA ブロックを書き出す（バイナリ形式のみ）
+   * @return false : 書き込み失敗
+   */
+  static bool flushBinaryBlock();
+
+  /**
+   * @brief 次の TEXT ブロックの番号を払い出す（バイナリ / DELTA 形式）
+   */
+  static uint32_t nextBlockSeq();
+
+  /**
+   * @brief DELTA 形式: 1 サンプルを差分符号化ブロックへ追加
+   * @return false : 満杯ブロックの書き出しに失敗
+   */
+  static bool appendDeltaSample(const SDData& data);
+
+  /**
+   * @brief DELTA 形式: 途中のブロックを同期間隔ごとに書き直す
+   * @return false : 書き込み失敗
+   */
+  static bool syncDeltaTail(uint32_t nowMs);
+
+  /**
+   * @brief 形式ごとの書き込みレート見積り [bytes/s]（事前確保サイズの計画用）
+   */
+  static uint32_t preallocRate(LogFormat format);
+
+  /**
+   * @brief ファイルを bytes まで伸ばしてクラスタを確保する
+   * @return false : 確保失敗（カード容量不足等）
+   */
+  static bool preallocate(uint32_t bytes);
+
+  /**
+   * @brief 同期済みのデータ長を先頭セクタの有効長マーカーへ反映（必要なら追加確保）
+   * @return false : ヘッダの書き直しに失敗
+   */
+  static bool updateValidLength();
+
+  /**
+   * @brief 先頭セクタ（有効長マーカー・クローズ済みフラグ）を書き直して flush
+   * @return false : 書き込み失敗
+   */
+  static bool writeHeaderSector(uint32_t validBytes, bool closed);
+
+  /**
+   * @brief チェックポイント行を整形（seq = 記録済みレコード数、統計は data の累積値）
+   * @return 行の長さ
+   */
+  static size_t formatCheckpoint(const SDData& data, char* buf, size_t len);
+
+  /**
+   * @brief BINARY / DELTA: データブロック追記直後の処理（一定個数ごとにチェックポイント）
+   * @param last ファイルに入っている最後のレコードの元データ
+   * @return false : 書き込み失敗
+   */
+  static bool afterDataBlock(const SDData& last);
+
+  /**
+   * @brief 生ログのファイル名から集約ログのファイルを作成（失敗した段は記録しない）
+   */
+  static void openRollups(const char* filename);
+
+  /**
+   * @brief 集約ログの書き出し待ちセクタを書き出す（force: 途中セクタも同期）
+   */
+  static void serviceRollups(bool force);
+
+  /**
+   * @brief 集約ログを同期してクローズ
+   */
+  static void closeRollups();
+
+  /**
+   * @brief 生ログのファイル名から時刻索引を作成（失敗しても生ログは記録する）
+   */
+  static void openIndex(const char* filename);
+
+  /**
+   * @brief 同期点（CSV の行頭・BINARY / DELTA のブロック先頭）を索引へ渡す
+   */
+  static void indexRecord(uint32_t recordSeq, uint32_t elapsedMs, uint32_t offset);
+
+  /**
+   * @brief 時刻索引を同期してクローズ（complete: エントリ数と完了フラグを確定）
+   */
+  static void closeIndex(bool complete);
+
+  /**
+   * @brief 生データ: 途中のブロックを同期間隔ごとに書き直し、完成ブロックを書き出す
+   * @details 失敗したら生データ記録だけを止める（生ログの poll() は失敗にしない）
+   */
+  static void serviceRaw();
+
+  /**
+   * @brief 復旧したログの時刻索引を有効長 validEnd に合わせる
+   * @param header バイナリ形式のヘッダ（CSV は nullptr）
+   */
+  static void recoverIndex(const char* path, const BinLogHeader* header, uint32_t validEnd);
+
+  /**
+   * @brief 再マウント後、時刻索引の追記を再開（失敗したら索引なしで続ける）
+   */
+  static void resumeIndex(const char* filename);
+
+  /**
+   * @brief 再マウント後、集約ログの追記を再開（失敗した段は記録しない）
+   */
+  static void resumeRollups(const char* filename);
+
+  /**
+   * @brief 1 ファイルの復旧（closed=0 のもののみ）
+   * @param path ファイルパス（例："/DATA_0003.csv"）
+   * @param result [out] 走査結果（nullptr 可。再マウント後の再開に使う）
+   * @param newEnd [out] 復旧要約を追記した後のファイル長（nullptr 可）
+   * @return true : 復旧した
+   */
+  static bool recoverFile(const char* path, LogRecovery::Result* result = nullptr,
+                          uint32_t* newEnd = nullptr);
 };
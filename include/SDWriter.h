@@ -0,0 +1,239 @@
+#pragma once
+
+#include "Global.h"
+#include "RunCatalog.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/**
+ * @file SDWriter.h
+ * @brief SD 書き込み専用タスク（SPSC リング経由でレコードを受け取る）
+ *
+ * @details
+ * 安価なカードでは FAT 割り当てやウェアレベリングで 1 回の書き込みが
+ * 100ms 以上止まることがある。これを計測・UI の周期から切り離すため、
+ * SDManager の呼び出しはすべてこのタスク（制御コア、制御タスクより低優先）
+ * が行う。制御タスクは固定長レコードを SpscRing に積んで即座に戻る。
+ *
+ * 【レコード種別】（FIFO 順に処理）
+ * - OPEN : ファイル作成 + ヘッダ書き込み（CSV / バイナリ）+ 目録へ START
+ * - DATA : 1 行分（SDData）
+ * - ROLLUP: 集約ログ 1 行分（RollupRow、1 秒 / 1 分 / 1 時間の各段）
+ * - CLOSE: フッタ（PerfMonitor・リング統計・記録判定統計・生データ件数）→ flush → クローズ + 目録へ END
+ *   （PerfMonitor・記録判定の統計は closeFile() の時点で制御タスクが写してレコードに載せる）
+ * - MOUNT : SD カードのマウント + 目録から次の RUN 番号（SDManager::begin() / loadCatalog()）。
+ *   結果は takeMount() で制御タスクへ返す（起動時と、未マウント・エラーの間の再試行）
+ * - RECOVER: 起動時、電源断で閉じられなかったログの復旧（SDManager::recoverUnclosed()）
+ * - PROFILE: 起動時、カードの計測と同期方針の選択（SDManager::profileCard()）
+ * - BENCH: シリアル 'b' の書き込み方式ベンチマーク（SDBenchmark::run()）
+ * - LIST: シリアル 'l' の RUN 目録の一覧（SDManager::listRuns()）
+ * - SEGMENT: ソークの区間切り替え（前の区間に "# SEGMENT_END,..." → クローズ → 次の区間を作成し
+ *   "# SEGMENT,..." 行）。目録には書かない（START / END は RUN 単位）
+ * - SNAPSHOT: プリトリガの窓（PreTrigger.h）。RUN 開始分は生ログ先頭へ、アラーム分は別ファイルへ
+ *
+ * 【生データ記録】（RawCapture.h）
+ * OPEN で生データ記録を指定した RUN では、IO タスクが読取ごとに pushRaw() で
+ * 別の SpscRing（SD_RAW_RING_DEPTH）へ積む。書き込みタスクは起床ごとに
+ * （起こされなくても同期間隔ごとに起きる）まとめて SDManager::writeRaw() へ渡す。
+ * 満杯・切断中の読取値は捨てて数え、CLOSE 時に "# RAW,..." 行として生ログに残す。
+ *
+ * 【プリトリガ】（PreTrigger.h）
+ * 窓（最大 SD_PRETRIGGER_DEPTH サンプル）はレコードに載せず、SD_PRETRIGGER_SLOTS 個の
+ * 静的スロットに写して添字だけを積む。スロット・リングが空かなければ捨てて数える
+ * （制御周期を止めない）。
+ *
+ * 【制約】
+ * - 生成側は制御タスクのみ（シングルプロデューサ。生データのリングは IO タスクのみ）
+ * - DATA / ROLLUP はリング満杯なら破棄して dropped に計上（計測周期を止めない）
+ * - OPEN / CLOSE は取りこぼすとファイルが壊れるため、空きができるまで
+ *   最大 SD_CONTROL_RECORD_WAIT_MS 待つ
+ * - リングのレコードは DATA（種別 + SDData）の大きさに保つ。OPEN / SEGMENT / CLOSE の
+ *   大きな内容（ファイル名・目録・区間・記録判定・処理時間の統計）は SD_CONTROL_SLOTS 個の
+ *   静的スロットに置き、添字だけを積む（プリトリガの窓と同じ）
+ * - 書き込み失敗は takeError() で制御タスクへ通知（G.M_SDError に反映）
+ *
+ * 【SD 切断時】
+ * 記録中の DATA 書き込み（または定期同期）に失敗したら切断状態に入り、以降の DATA は
+ * RAM のバックログ（OutageBacklog、SD_OUTAGE_BACKLOG_DEPTH 件、満杯時は
+ * SD_OUTAGE_POLICY に従い古い順に捨てる / 間引く）へ退避する。
+ * SD_REMOUNT_INTERVAL_MS（失敗ごとに倍、SD_REMOUNT_INTERVAL_MAX_MS まで）の間隔で
+ * SDManager::remount() を試み（カードが応答しなければ SD.begin() まで進まない）、成功したら
+ * "# OUTAGE,..." 行（退避した範囲・失われた件数）に続けて退避分を順に書き戻す。
+ * RUN 終了までに復帰しなければ退避分を捨て、エラーとして通知する
+ * （ファイルは次回起動時の復旧で閉じられる）。
+ */
+struct SDRecord;   // SDWriter.cpp で定義（リングで受け渡す固定長レコード）
+struct SDControl;  // SDWriter.cpp で定義（OPEN / SEGMENT / CLOSE の内容）
+
+class SDWriter {
+public:
+  /**
+   * @brief 書き込みタスクを起動（SpiBus::init() 後、1 回）
+   */
+  static void start();
+
+  /**
+   * @brief 新規ファイル作成を依頼
+   * @param format ログ形式（CSV / BINARY）
+   * @param hiThreshold RUN 開始時の上限閾値（バイナリヘッダに記録）
+   * @param loThreshold RUN 開始時の下限閾値（バイナリヘッダに記録）
+   * @param runId 目録（RUNS.CAT）に記録する RUN 番号
+   * @param rawCapture 生データ（DATA_xxxx_raw.bin）も記録する
+   * @param wallStartMs RUN 開始の実時刻（RtcClock、-1 = 不明）。"# WALLCLOCK" 行に記録
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool openFile(const char* filename, LogFormat format,
+                       float hiThreshold, float loThreshold, uint32_t runId,
+                       bool rawCapture = false, int64_t wallStartMs = -1);
+
+  /**
+   * @brief ソークの次の区間への切り替えを依頼（SoakLog.h）
+   * @param filename 次の区間のファイル名（SoakLog::segmentName()）
+   * @param startMs 区間開始時刻 (millis)。生データの経過時間の基準
+   * @param segment "# SEGMENT,..." 行の内容（index は 1 以上）
+   * @param wallStartMs 区間開始の実時刻（-1 = 不明）
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool openSegment(const char* filename, LogFormat format, float hiThreshold,
+                          float loThreshold, bool rawCapture, uint32_t startMs,
+                          const SegmentInfo& segment, int64_t wallStartMs = -1);
+
+  /**
+   * @brief 区間 index に書いたバイト数（書き込みタスクがまだその区間を開いていなければ false）
+   */
+  static bool segmentBytes(uint16_t index, uint32_t& bytes);
+
+  /**
+   * @brief CSV 1 行を依頼（待ち無し）
+   * @return false: リング満杯で破棄した
+   */
+  static bool pushData(const SDData& data);
+
+  /**
+   * @brief 生データ 1 サンプルを依頼（IO タスクから。待ち無し、書き込みタスクは起こさない）
+   * @return false: リング満杯で破棄した
+   */
+  static bool pushRaw(const RawSample& sample);
+
+  /**
+   * @brief 集約ログ 1 行を依頼（待ち無し）
+   * @return false: リング満杯で破棄した
+   */
+  static bool pushRollup(const RollupRow& row);
+
+  /**
+   * @brief プリトリガの窓の書き込みを依頼（待ち無し。制御タスクから）
+   * @param ring 直近サンプル（G.M_PreTrigger）。triggerMs の SD_PRETRIGGER_WINDOW_MS 前以降を写す
+   * @param event RUN_START: 生ログの先頭へ / それ以外: filename の CSV へ
+   * @param triggerMs トリガ時刻 (millis)
+   * @param elapsedMs トリガの RUN 開始からの経過時間（アラームスナップショットのヘッダ用）
+   * @param filename アラームスナップショットのファイル名（RUN_START では nullptr）
+   * @return false: 空きスロット・リングが無く破棄した
+   */
+  static bool pushSnapshot(const PreTriggerRing<SD_PRETRIGGER_DEPTH>& ring,
+                           PreTrigger::Event event, uint32_t triggerMs, uint32_t elapsedMs,
+                           const char* filename);
+
+  /**
+   * @brief フッタ書き込み・クローズを依頼
+   * @param summary 目録に記録する RUN の要約（kind = END）。ファイルを閉じられ
+   *                なかった場合は FLAG_SD_ERROR を付けて記録する
+   * @param filter RUN の記録判定（G.M_LogFilter）。統計は処理時間統計と同じく
+   *               ここで写してレコードに載せる（フッタは写しから書く）
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool closeFile(const RunCatalogEntry& summary, const LogFilter& filter);
+
+  /**
+   * @brief SD カードのマウントと目録の読み込みを依頼
+   * @details カードが無いと SD.begin() は検出の再試行で長引くため、制御タスクでは行わない。
+   *          結果は takeMount() で受け取る（1 回の依頼に 1 回）
+   * @param remount マウント済みでも外してからマウントし直す（書き込みエラー後。
+   *                開いたままのファイルは閉じる）
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool mount(bool remount = false);
+
+  /**
+   * @brief 前回呼び出し以降に届いたマウントの結果（制御タスクが周期的に呼ぶ）
+   * @param ok マウントできたか
+   * @param nextRunId 目録から求めた次の RUN 番号（ok のときのみ有効）
+   * @return false: 結果はまだ届いていない
+   */
+  static bool takeMount(bool& ok, uint32_t& nextRunId);
+
+  /**
+   * @brief 閉じられなかったログの復旧を依頼（SD マウント成功後に 1 回）
+   * @details 最初の OPEN より前に積むこと（FIFO のため新しいファイルより先に処理される）
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool recover();
+
+  /**
+   * @brief カードの計測・同期方針の選択を依頼（SD マウント成功後に 1 回）
+   * @details 未計測のカードでは数秒かかるため制御タスクでは行わない。
+   *          最初の OPEN より前に積むこと（OPEN のファイルから選んだ方針で同期する）
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool profileCard();
+
+  /**
+   * @brief 書き込み方式ベンチマーク（SDBenchmark::run()）を依頼
+   * @details 数秒かかるため制御タスクでは行わない。結果は Serial へ出力
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool benchmark(uint16_t rows = SD_BENCH_ROWS);
+
+  /**
+   * @brief RUN 目録の末尾 count 件の出力（SDManager::listRuns()）を依頼
+   * @details 目録の読み出しを開いているファイルの書き込みと直列にするため。結果は Serial へ出力
+   * @return false: リングが空かず依頼できなかった
+   */
+  static bool listRuns(uint32_t count = SD_CATALOG_LIST_RUNS);
+
+  /**
+   * @brief 前回呼び出し以降に書き込み失敗があったか（制御タスクが周期的に呼ぶ）
+   */
+  static bool takeError();
+
+  /**
+   * @brief SD 切断中（バックログへ退避し、再マウント待ち）か
+   */
+  static bool inOutage();
+
+  /**
+   * @brief 未処理レコードが無く、書き込み中でもないか
+   * @details 省電力ガバナーのスリープ可否・ベンチマーク実行可否の判定に使う
+   */
+  static bool idle();
+
+  /**
+   * @brief リング統計（滞留数・最大滞留数・破棄数）を出力
+   */
+  static void dump(Print& out);
+
+  /**
+   * @brief リング統計をフッタ行に整形（CLOSE 時に書き込む）
+   * @return 書き込んだバイト数
+   */
+  static size_t formatFooter(char* buf, size_t len);
+
+private:
+  static void taskEntry(void*);
+  static void handle(const SDRecord& rec);
+  static bool pushControl(const SDRecord& rec);
+  static bool openLog(const SDControl& rec);
+  static bool closeLog(const SDControl& rec, bool segment);
+  static void appendCatalog(const RunCatalogEntry& entry);
+  static void drainRaw();
+  static void writeSnapshot(const SDRecord& rec);
+  static void enterOutage();
+  static void backlog(const SDData& data);
+  static bool tryResume();
+
+  static TaskHandle_t      s_task;
+  static std::atomic<bool> s_busy;
+  static std::atomic<bool> s_error;
+  static std::atomic<bool> s_outage;
+};
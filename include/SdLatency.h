@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include "LatencyHistogram.h"
+
+/**
+ * @file SdLatency.h
+ * @brief SD ファイル操作（open / write / flush / close）ごとのレイテンシ分布
+ *
+ * @details
+ * 現場で起きる「数百 ms の書き込み停止」が、どの操作で・どのくらいの頻度で
+ * 起きているかを実行中に確認するための計測。操作ごとに LatencyHistogram
+ * （固定メモリ・O(1) 記録）を 1 個持つ。
+ *
+ * 実機では SDManager がログ経路のファイル操作（生ログ・集約ログ・索引・目録）を
+ * 計測し、シリアル 'p' で表示する。native 環境では FaultyFile（FaultyFile.h）が
+ * 注入した遅延を同じ形で記録し、tools/sdsim.cpp・テストから読む。
+ * 記録は 1 タスク（SD 書き込みタスク）から行う前提。
+ */
+enum class SdOp : uint8_t {
+  OPEN,
+  WRITE,
+  FLUSH,
+  CLOSE,
+  COUNT
+};
+
+class SdLatency {
+public:
+  static constexpr size_t OPS = static_cast<size_t>(SdOp::COUNT);
+
+  static const char* name(SdOp op) {
+    static const char* const names[] = {"open", "write", "flush", "close"};
+    return names[static_cast<size_t>(op)];
+  }
+
+  /**
+   * @brief 1 回の操作時間を記録
+   * @param budgetUs これを超えた回数を超過数として数える（0 = 数えない）
+   */
+  void record(SdOp op, uint32_t us, uint32_t budgetUs = 0) {
+    m_hist[static_cast<size_t>(op)].record(us, budgetUs);
+  }
+
+  const LatencyHistogram& histogram(SdOp op) const {
+    return m_hist[static_cast<size_t>(op)];
+  }
+
+  void reset() {
+    for (size_t i = 0; i < OPS; ++i) m_hist[i].reset();
+  }
+
+  /**
+   * @brief 1 操作ぶんの 1 行（"write n=1200 p50_us=850 p99_us=4095 max_us=212000 over=3"）
+   */
+  int formatLine(SdOp op, char* out, size_t len) const {
+    const LatencyHistogram& h = histogram(op);
+    return snprintf(out, len, "%-5s n=%lu p50_us=%lu p99_us=%lu max_us=%lu over=%lu", name(op),
+                    static_cast<unsigned long>(h.count()),
+                    static_cast<unsigned long>(h.percentile(500)),
+                    static_cast<unsigned long>(h.percentile(990)),
+                    static_cast<unsigned long>(h.max()),
+                    static_cast<unsigned long>(h.overruns()));
+  }
+
+private:
+  LatencyHistogram m_hist[OPS];
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @file SectorWriter.h
+ * @brief 512 バイトセクタ整列のダブルバッファ付きログ書き込み
+ *
+ * @details
+ * 行単位の write() + flush() は、SD カード上では毎回「セクタ読み出し →
+ * 部分更新 → 書き戻し」と FAT / ディレクトリエントリ更新を伴う。
+ * 本クラスは行を RAM 上のセクタバッファへ追記し、512 バイト揃いの
+ * オフセットへ 1 セクタ単位でまとめて書き出す。
+ *
+ * 【バッファ構成】
+ * - active  : 追記中のセクタ
+ * - pending : 満杯になり書き出し待ちのセクタ（append() は I/O を行わず、
+ *             service() で書き出す。pending が残ったまま active も満杯に
+ *             なった場合のみ append() 内で同期的に書き出す）
+ *
+ * 【耐久性（同期）方針】
+ * 未同期バイトが syncBytes 以上、または最後の同期から syncIntervalMs 経過で
+ * sync() する。sync() は書き出し待ちセクタに加え、途中までの active を
+ * 「そのセクタの先頭オフセット」へ書き、Sink::flush()（FAT のサイズ更新）を行う。
+ * active が後で満杯になると同じオフセットへ 1 セクタ丸ごと書き直すため、
+ * ファイル上の書き込みは常にセクタ境界から始まる。
+ *
+ * @tparam Sink 以下を持つ型（Arduino File のラッパー、テスト用メモリ等）
+ *   - bool   seek(uint32_t offset)
+ *   - size_t write(const uint8_t* data, size_t len)
+ *   - void   flush()
+ */
+template <typename Sink>
+class SectorWriter {
+public:
+  static constexpr size_t SECTOR_SIZE = 512;
+
+  /**
+   * @brief 書き込み統計
+   */
+  struct Stats {
+    uint32_t sectorWrites;   // 1 セクタ丸ごとの書き出し回数
+    uint32_t tailWrites;     // sync() 時の途中セクタ書き出し回数
+    uint32_t syncs;          // Sink::flush() 回数
+    uint32_t stalls;         // append() 内で同期書き出しが必要になった回数
+    uint32_t bytesAppended;  // 追記バイト数累計
+  };
+
+  SectorWriter(Sink& sink, uint32_t syncIntervalMs, uint32_t syncBytes)
+      : m_sink(sink), m_syncIntervalMs(syncIntervalMs), m_syncBytes(syncBytes) {
+    reset(0);
+  }
+
+  SectorWriter(const SectorWriter&) = delete;
+  SectorWriter& operator=(const SectorWriter&) = delete;
+
+  /**
+   * @brief 新しいファイル（オフセット 0）の書き込みを開始
+   */
+  void reset(uint32_t nowMs) {
+    m_active     = 0;
+    m_fill       = 0;
+    m_pending    = false;
+    m_baseOffset = 0;
+    m_unsynced   = 0;
+    m_lastSyncMs = nowMs;
+    memset(&m_stats, 0, sizeof(m_stats));
+  }
+
+  /**
+   * @brief 同期方針を変更（カードの計測結果に合わせる。次の service() から有効）
+   */
+  void setSyncPolicy(uint32_t syncIntervalMs, uint32_t syncBytes) {
+    m_syncIntervalMs = syncIntervalMs;
+    m_syncBytes      = syncBytes;
+  }
+
+  uint32_t syncIntervalMs() const { return m_syncIntervalMs; }
+  uint32_t syncBytes() const { return m_syncBytes; }
+
+  /**
+   * @brief 既存ファイルの offset から追記を再開（SD の再マウント後）
+   *
+   * @details
+   * offset を含むセクタの先頭から offset までの内容を active に読み込んだ状態に
+   * する。次の書き出しはそのセクタの先頭から行うため、既存の内容は書き直しても変わらない。
+   *
+   * @param tail ファイルの [offset - offset % SECTOR_SIZE, offset) の内容
+   */
+  void resume(uint32_t offset, const uint8_t* tail, uint32_t nowMs) {
+    reset(nowMs);
+    m_fill       = offset % SECTOR_SIZE;
+    m_baseOffset = offset - static_cast<uint32_t>(m_fill);
+    if (m_fill > 0) memcpy(m_buf[m_active], tail, m_fill);
+  }
+
+  /**
+   * @brief データを追記（通常は RAM コピーのみ）
+   * @return false: 同期書き出しが必要になり、それに失敗した
+   */
+  bool append(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    m_stats.bytesAppended += len;
+    m_unsynced            += len;
+    while (len > 0) {
+      size_t n = SECTOR_SIZE - m_fill;
+      if (n > len) n = len;
+      memcpy(m_buf[m_active] + m_fill, p, n);
+      m_fill += n;
+      p      += n;
+      len    -= n;
+
+      if (m_fill == SECTOR_SIZE) {
+        if (m_pending) {
+          // 書き出しが追いついていない: ここで 1 セクタ書き出して空ける
+          m_stats.stalls++;
+          if (!writePending()) return false;
+        }
+        m_pending = true;
+        m_active ^= 1;
+        m_fill    = 0;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief 書き出し待ちセクタの書き出しと、同期方針の適用
+   * @return false: 書き込み失敗
+   */
+  bool service(uint32_t nowMs) {
+    if (m_pending && !writePending()) return false;
+    if (m_unsynced == 0) return true;
+    if (m_unsynced >= m_syncBytes || nowMs - m_lastSyncMs >= m_syncIntervalMs) {
+      return sync(nowMs);
+    }
+    return true;
+  }
+
+  /**
+   * @brief 追記済みの全データをカードへ書き、Sink::flush() する
+   * @return false: 書き込み失敗
+   */
+  bool sync(uint32_t nowMs) {
+    if (m_pending && !writePending()) return false;
+    if (m_fill > 0) {
+      if (!m_sink.seek(m_baseOffset)) return false;
+      if (m_sink.write(m_buf[m_active], m_fill) != m_fill) return false;
+      m_stats.tailWrites++;
+    }
+    m_sink.flush();
+    m_stats.syncs++;
+    m_unsynced   = 0;
+    m_lastSyncMs = nowMs;
+    return true;
+  }
+
+  /**
+   * @brief 最後の sync() 以降に追記され、電源断で失われ得るバイト数
+   */
+  uint32_t unsyncedBytes() const { return m_unsynced; }
+
+  /**
+   * @brief 追記済みデータの論理サイズ（= 全て書き出した後のファイルサイズ）
+   */
+  uint32_t size() const {
+    return m_baseOffset + (m_pending ? SECTOR_SIZE : 0) + m_fill;
+  }
+
+  const Stats& stats() const { return m_stats; }
+
+private:
+  bool writePending() {
+    if (!m_sink.seek(m_baseOffset)) return false;
+    if (m_sink.write(m_buf[m_active ^ 1], SECTOR_SIZE) != SECTOR_SIZE) return false;
+    m_baseOffset += SECTOR_SIZE;
+    m_pending     = false;
+    m_stats.sectorWrites++;
+    return true;
+  }
+
+  Sink&    m_sink;
+  uint32_t m_syncIntervalMs;
+  uint32_t m_syncBytes;
+
+  // 4 バイト整列: ESP32 の SD(SPI) ドライバが中間コピー無しで DMA 転送できる
+  alignas(4) uint8_t m_buf[2][SECTOR_SIZE];
+  uint8_t  m_active;       // 追記中のバッファ番号（pending は m_active ^ 1）
+  size_t   m_fill;         // active の使用バイト数
+  bool     m_pending;      // m_active ^ 1 が書き出し待ちか
+  uint32_t m_baseOffset;   // 最も古い未書き出しセクタのファイル先頭オフセット
+  uint32_t m_unsynced;
+  uint32_t m_lastSyncMs;
+  Stats    m_stats;
+};
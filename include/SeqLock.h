@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @file SeqLock.h
+ * @brief シングルライター / マルチリーダーのロックフリー・スナップショット公開
+ *
+ * @details
+ * IO コアが書き込み、Logic/UI/SD コアが読み出す GlobalData の部分集合を
+ * ミューテックス無しで受け渡すためのシーケンスロック実装です。
+ *
+ * 【プロトコル】
+ * - 書き込み側: seq を奇数にする → データ更新 → seq を偶数に戻す
+ * - 読み出し側: seq(偶数) を読む → データコピー → seq が変わっていなければ採用
+ *
+ * 書き込み側は決して待たない（サンプリング経路をブロックしない）。
+ * 読み出し側は書き込みと衝突した場合のみ再試行する。
+ *
+ * データ本体は 32bit のアトミック語として保持するため、C++ メモリモデル上の
+ * データ競合が無く、Linux 上の std::thread テストでもそのまま検証できます。
+ * ESP32 (Xtensa) では relaxed な 32bit ロード/ストアは通常の命令になります。
+ *
+ * @tparam T 公開するスナップショット型（trivially copyable であること）
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock<T> requires a trivially copyable snapshot type");
+
+public:
+  SeqLock() : m_seq(0) {
+    for (auto& w : m_words) w.store(0, std::memory_order_relaxed);
+  }
+
+  explicit SeqLock(const T& initial) : SeqLock() { publish(initial); }
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  /**
+   * @brief スナップショットを公開（単一ライター専用、待ち無し）
+   */
+  void publish(const T& value) {
+    uint32_t buf[WORDS] = {0};
+    memcpy(buf, &value, sizeof(T));
+
+    const uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(seq + 1, std::memory_order_relaxed);      // 奇数 = 書き込み中
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; ++i) {
+      m_words[i].store(buf[i], std::memory_order_relaxed);
+    }
+    m_seq.store(seq + 2, std::memory_order_release);      // 偶数 = 確定
+  }
+
+  /**
+   * @brief 一貫したスナップショットの読み出しを試みる
+   * @param[out] out 読み出し先
+   * @param maxRetries 書き込みと衝突した場合の再試行上限
+   * @return true: 一貫したコピーを取得, false: 再試行上限に到達
+   */
+  bool tryRead(T& out, uint32_t maxRetries = 64) const {
+    uint32_t buf[WORDS];
+    for (uint32_t attempt = 0; attempt <= maxRetries; ++attempt) {
+      const uint32_t before = m_seq.load(std::memory_order_acquire);
+      if (before & 1U) continue;  // 書き込み中
+      for (size_t i = 0; i < WORDS; ++i) {
+        buf[i] = m_words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (m_seq.load(std::memory_order_relaxed) == before) {
+        memcpy(&out, buf, sizeof(T));
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief 一貫したスナップショットを取得するまで読み出す
+   */
+  T read() const {
+    T out;
+    while (!tryRead(out)) {
+      // ライターは 1 回の publish が数十命令で終わるため、ここで長く回ることは無い
+    }
+    return out;
+  }
+
+  /**
+   * @brief 公開回数（publish ごとに +2、偶数なら確定状態）
+   */
+  uint32_t sequence() const { return m_seq.load(std::memory_order_acquire); }
+
+private:
+  static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  std::atomic<uint32_t> m_seq;
+  std::atomic<uint32_t> m_words[WORDS];
+};
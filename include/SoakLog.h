@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include "FixedFormat.h"
+
+/**
+ * @file SoakLog.h
+ * @brief 長期連続試験（ソーク）用の 64 ビット時刻とログの区間分割
+ *
+ * @details
+ * 数週間の RUN では隠れた上限に当たる。millis() の差は 49.7 日で一周し
+ * （Storage_Task の int32 の経過時間は 24.8 日で負になる）、1 本のログは際限なく
+ * 大きくなり（FAT32 は 4GB まで、起動時の復旧走査も長さに比例）、
+ * サンプル数 D_Count も 32 ビットだった。ソークモードの RUN では:
+ *
+ * - WrapClock で millis() を 64 ビットに伸ばし、RUN 全体の経過時間・サンプル数を 64 ビットで数える
+ * - ログをサイズ（SD_SEGMENT_MAX_BYTES）か時間（SD_SEGMENT_MAX_MS）で区切り、
+ *   DATA_0003.csv → DATA_0003_s001.csv → DATA_0003_s002.csv ... と続ける
+ * - 各区間の ElapsedMs は区間の開始から（32 ビットに収まる）。区間の先頭（ヘッダ直後）の
+ *   "# SEGMENT,..." 行に RUN 番号・区間番号・前の区間・RUN 開始からの区間開始時刻・
+ *   それまでのサンプル数を記録し、ホストで RUN 全体に繋げられる
+ * - 統計（平均・標準偏差・最小・最大・サンプル数）は区間をまたいで続ける
+ *
+ * 1 区間のサイズ・時間が有界なので、区間を閉じて開く処理・復旧の走査・事前確保は
+ * RUN の長さに依らず一定になる。
+ */
+
+/**
+ * @brief 32 ビットの millis() を 64 ビットに伸ばす
+ * @details extend() を 49.7 日より短い間隔で（単調に進む現在時刻で）呼び続けること。
+ *          それより前の時刻（サンプル取得時刻など）は widen() で伸ばす
+ */
+class WrapClock {
+public:
+  WrapClock() : m_last(0), m_high(0) {}
+
+  void reset(uint32_t nowMs) {
+    m_last = nowMs;
+    m_high = 0;
+  }
+
+  /**
+   * @brief 現在時刻を 64 ビットに（前回より小さければ一周したとみなす）
+   */
+  uint64_t extend(uint32_t nowMs) {
+    if (nowMs < m_last) m_high += 0x100000000ull;
+    m_last = nowMs;
+    return m_high + nowMs;
+  }
+
+  /**
+   * @brief 前回の extend() 以前の時刻 t を 64 ビットに（差が 49.7 日未満であること）
+   */
+  uint64_t widen(uint32_t t) const {
+    return m_high + m_last - static_cast<uint32_t>(m_last - t);
+  }
+
+private:
+  uint32_t m_last;
+  uint64_t m_high;
+};
+
+/**
+ * @brief 区間を切り替える時に書き込みタスクへ渡す情報（"# SEGMENT,..." 行）
+ */
+struct SegmentInfo {
+  uint32_t runId;
+  uint16_t index;           // 0 = RUN の最初のファイル
+  uint64_t runOffsetMs;     // RUN 開始から区間開始まで
+  uint64_t samplesBefore;   // 区間開始までのサンプル数（D_Count）
+};
+
+class SoakLog {
+public:
+  static constexpr uint16_t MAX_SEGMENTS   = 999;          // ファイル名の区間番号 3 桁
+  static constexpr uint32_t MAX_SEGMENT_MS = 0x7FFFFFFFUL; // 区間内の経過時間は int32 で扱う
+  static constexpr size_t   MAX_LINE       = 160;          // formatSegmentLine() の最長
+
+  /**
+   * @brief 区間を切り替える時か
+   * @param fileBytes 現在の区間に書いたバイト数
+   * @param segmentMs 区間開始からの経過時間
+   * @param maxBytes / maxMs 上限（0 = その条件を使わない）
+   */
+  static bool segmentDue(uint32_t fileBytes, uint32_t segmentMs, uint32_t maxBytes,
+                         uint32_t maxMs) {
+    return (maxBytes > 0 && fileBytes >= maxBytes) || (maxMs > 0 && segmentMs >= maxMs);
+  }
+
+  /**
+   * @brief 区間のファイル名（"/DATA_0003.csv", 2 → "/DATA_0003_s002.csv"、0 はそのまま）
+   */
+  static void segmentName(const char* runFile, uint16_t index, char* out, size_t len) {
+    if (index == 0) {
+      snprintf(out, len, "%s", runFile);
+      return;
+    }
+    const char* dot  = strrchr(runFile, '.');
+    const int   stem = dot ? static_cast<int>(dot - runFile) : static_cast<int>(strlen(runFile));
+    snprintf(out, len, "%.*s_s%03u%s", stem, runFile, static_cast<unsigned>(index),
+             dot ? dot : "");
+  }
+
+  /**
+   * @brief 区間先頭の行（"# SEGMENT,run=3,index=2,prev=DATA_0003_s001.csv,run_offset_ms=...,
+   *        samples_before=...\r\n"）
+   * @param prevFile 前の区間のファイル名（先頭の '/' は省く）
+   * @param buf MAX_LINE バイト以上
+   * @return 書き込んだ文字数（終端 '\0' を除く）
+   */
+  static size_t formatSegmentLine(const SegmentInfo& seg, const char* prevFile, char* buf) {
+    if (prevFile[0] == '/') ++prevFile;
+    char* p = FixedFormat::putStr(buf, "# SEGMENT,run=");
+    p = FixedFormat::putUint(p, seg.runId);
+    p = FixedFormat::putStr(p, ",index=");
+    p = FixedFormat::putUint(p, seg.index);
+    p = FixedFormat::putStr(p, ",prev=");
+    p = putClipped(p, prevFile, 40);
+    p = FixedFormat::putStr(p, ",run_offset_ms=");
+    p = FixedFormat::putUint64(p, seg.runOffsetMs);
+    p = FixedFormat::putStr(p, ",samples_before=");
+    p = FixedFormat::putUint64(p, seg.samplesBefore);
+    *p++ = '\r';
+    *p++ = '\n';
+    *p   = '\0';
+    return static_cast<size_t>(p - buf);
+  }
+
+private:
+  static char* putClipped(char* p, const char* s, size_t max) {
+    for (size_t i = 0; i < max && s[i] != '\0'; ++i) *p++ = s[i];
+    return p;
+  }
+};
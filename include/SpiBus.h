@@ -0,0 +1,130 @@
+#pragma once
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+/**
+ * @file SpiBus.h
+ * @brief 共有ハードウェア SPI バス（MAX31855 / LCD / microSD）の調停
+ *
+ * @details
+ * デュアルコア化により、IO コア（MAX31855 読取）と Logic/UI/SD コア
+ * （LCD 描画・SD 書き込み）が同じ VSPI バスを同時に触り得るようになった。
+ * データの受け渡しは SeqLock でロックフリーに行うが、物理バスだけは
+ * 1 トランザクション単位で排他する必要がある。
+ *
+ * 【デバイスごとの設定】
+ * CS ピン・クロック・SPI モードは config() の表が持つ。表は各ドライバが実際に
+ * 使う値を写したもので、調停側からは適用しない（SD のクロックだけは SD.begin() に
+ * 渡して表の値で動かす）。MAX31855（Adafruit_MAX31855(cs) の既定 1MHz）と
+ * LCD（M5Stack の ILI9342C ドライバ、40MHz）はドライバ自身が beginTransaction() を
+ * 呼ぶため、lock() でも呼ぶと SPIClass の設定ロック（再帰しない）を同じタスクで
+ * 二重に取って止まる。表は dump() の表示と SD.begin() の引数に使う。
+ *
+ * 【優先度】
+ * センサー読取（SpiDevice::SENSOR）を最優先とする。
+ * - センサーが待っている間、LCD / SD は新たにバスを獲得しない
+ * - LCD / SD は処理全体ではなくチャンクごとにバスを保持する。LCD は描画の
+ *   部品（1 行・SPI_LCD_CHUNK_ROWS 行の塗り）ごとに取り直し、SD は呼び出し
+ *   ごとに取ったうえで 1 セクタの書き込み・ファイル 1 つの作成・事前確保 1 段
+ *   （SD_PREALLOC_STEP_BYTES）の境目で yield() を呼ぶ。
+ *   センサーが待っていればそこでバスを明け渡す
+ * これによりセンサーの待ち時間は「実行中のチャンク 1 個」で抑えられる
+ * （カード内部のビジー・SD.begin() など分割できない操作は除く）。
+ *
+ * 【統計】
+ * デバイスごとに獲得回数・保持時間の累計（利用率）・最大待ち時間・明け渡し回数を
+ * 数え、dump() で出力する（シリアル 'p'）。
+ *
+ * setup() 中（タスク起動前）は init() 前でも lock()/unlock() は何もしない。
+ */
+enum class SpiDevice : uint8_t {
+  SENSOR,   // MAX31855（IO コア、最優先）
+  LCD,
+  SD,
+  COUNT
+};
+
+/**
+ * @brief デバイスごとのトランザクション設定
+ */
+struct SpiDeviceConfig {
+  const char* name;
+  uint8_t     csPin;
+  uint32_t    clockHz;
+  uint8_t     mode;       // SPI_MODE0 など
+};
+
+class SpiBus {
+public:
+  /**
+   * @brief デバイスごとの統計（保持時間は最も外側の lock() 〜 unlock()）
+   */
+  struct Stats {
+    uint32_t grants;       // 獲得回数
+    uint64_t busyUs;       // 保持時間の累計 [µs]
+    uint32_t waitMaxUs;    // 獲得までの最大待ち時間 [µs]
+    uint32_t yields;       // センサーへの明け渡し回数（LCD / SD）
+  };
+
+  /**
+   * @brief バス排他用の再帰ミューテックスを生成（タスク起動前に 1 回）
+   */
+  static void init();
+
+  /**
+   * @brief バスを獲得（獲得できるまで待つ）
+   * @details 同じタスクの入れ子は即座に獲得する（統計は最も外側のデバイスに計上）
+   */
+  static void lock(SpiDevice dev);
+
+  /**
+   * @brief バスを解放
+   */
+  static void unlock();
+
+  /**
+   * @brief チャンクの境目: センサーが待っていればバスを一時的に明け渡す
+   * @details 入れ子の深さごと解放し、センサーの獲得を見届けてから取り直す
+   */
+  static void yield();
+
+  /**
+   * @brief デバイスのトランザクション設定
+   */
+  static const SpiDeviceConfig& config(SpiDevice dev);
+
+  /**
+   * @brief デバイスごとの利用率・待ち時間を出力し、区間をリセット
+   */
+  static void dump(Print& out);
+
+private:
+  static void account();
+
+  static SemaphoreHandle_t     s_mutex;
+  static std::atomic<uint32_t> s_sensorWaiting;   // バス待ちのセンサー読取数
+  // 以下はバス保持中の所有タスクのみが更新する
+  static TaskHandle_t          s_owner;
+  static uint32_t              s_depth;
+  static SpiDevice             s_holder;
+  static uint32_t              s_holdStartUs;
+  static Stats                 s_stats[static_cast<size_t>(SpiDevice::COUNT)];
+  static uint32_t              s_windowStartUs;   // 利用率の区間の開始
+};
+
+/**
+ * @brief スコープ内で SPI バスを保持する RAII ガード
+ */
+class SpiBusGuard {
+public:
+  explicit SpiBusGuard(SpiDevice dev) { SpiBus::lock(dev); }
+  ~SpiBusGuard() { SpiBus::unlock(); }
+
+  SpiBusGuard(const SpiBusGuard&) = delete;
+  SpiBusGuard& operator=(const SpiBusGuard&) = delete;
+};
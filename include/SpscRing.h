@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @file SpscRing.h
+ * @brief シングルプロデューサ / シングルコンシューマのロックフリー・リングバッファ
+ *
+ * @details
+ * 制御タスク（計測レコードの生成側）と SD 書き込みタスク（消費側）の間で
+ * 固定長レコードを受け渡す。生成側は決して待たない: 満杯なら push() は
+ * 即座に false を返し、破棄数（dropped）を加算する。
+ *
+ * 【インデックス】
+ * head（消費側のみ書く）と tail（生成側のみ書く）は単調増加する 32bit 値で、
+ * 要素数 = tail - head。N を 2 のべき乗に限定し、位置は & (N - 1) で求める。
+ * スロットの中身は tail の release ストア / acquire ロードで受け渡すため、
+ * C++ メモリモデル上のデータ競合は無い（Linux の std::thread テストで検証）。
+ *
+ * 【統計】
+ * - highWater: push 直後の要素数の最大値（容量見積もり用）
+ * - dropped  : 満杯で破棄したレコード数
+ *
+ * @tparam T レコード型（trivially copyable であること）
+ * @tparam N 容量（2 のべき乗）
+ */
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SpscRing<T> requires a trivially copyable record type");
+
+public:
+  SpscRing() : m_head(0), m_tail(0), m_highWater(0), m_dropped(0) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  /**
+   * @brief レコードを追加（生成側専用、待ち無し）
+   * @return false: 満杯のため破棄した
+   */
+  bool push(const T& value) {
+    const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    const uint32_t head = m_head.load(std::memory_order_acquire);
+    if (tail - head >= N) {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    m_slots[tail & (N - 1)] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    const uint32_t used = tail + 1 - head;
+    if (used > m_highWater.load(std::memory_order_relaxed)) {
+      m_highWater.store(used, std::memory_order_relaxed);  // 書くのは生成側のみ
+    }
+    return true;
+  }
+
+  /**
+   * @brief 最も古いレコードを取り出す（消費側専用）
+   * @return false: 空
+   */
+  bool pop(T& out) {
+    const uint32_t head = m_head.load(std::memory_order_relaxed);
+    const uint32_t tail = m_tail.load(std::memory_order_acquire);
+    if (head == tail) return false;
+    out = m_slots[head & (N - 1)];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief 現在の要素数（他方のスレッドから見ると近似値）
+   */
+  size_t size() const {
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+  static size_t capacity() { return N; }
+
+  uint32_t highWater() const { return m_highWater.load(std::memory_order_relaxed); }
+  uint32_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 統計のリセット（生成側から呼ぶこと）
+   */
+  void resetStats() {
+    m_highWater.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<uint32_t> m_head;       // 消費側のみ書く
+  std::atomic<uint32_t> m_tail;       // 生成側のみ書く
+  std::atomic<uint32_t> m_highWater;  // 生成側のみ書く
+  std::atomic<uint32_t> m_dropped;    // 生成側のみ書く
+  T                     m_slots[N];
+};
@@ -1,9 +1,29 @@
 #ifndef TASKS_H
 #define TASKS_H
 
-// ========== IO Layer (10ms周期) =================================================
+// ========== IO Layer (10ms周期 / IO コア) =========================================
 void IO_Task();
 
+// ========== Storage Layer (10ms周期 / 制御コア) ==================================
+void Storage_Task();
+
+// ========== 起動シーケンス (10ms周期 / 制御コア、完了まで) =========================
+/**
+ * @brief setup() 後に残った起動段階を非ブロッキングで進める（main.cpp）
+ * @details 初回有効サンプルの到着待ち（BOOT_SENSOR_TIMEOUT_MS で打ち切り）と
+ *          SD マウントを行い、全段階完了時に [BOOT] 行で所要時間の内訳を出力
+ */
+void Boot_Task();
+
+// ========== シリアルコンソール (10ms周期 / 制御コア) ==============================
+/**
+ * @brief シリアルから 1 文字コマンドを読み取り実行
+ * @details 'p': 処理時間統計, 'P': 統計＋ヒストグラム, 'r': 統計リセット,
+ *          'z'/'Z': プロファイリングゾーンのダンプ/クリア, 'w': 省電力統計,
+ *          'b': SD 書き込みベンチマーク, 'h': ヘルプ
+ */
+void Console_Task();
+
 // ========== Logic Layer (50ms周期) =================================================
 void Logic_Task();
 void handleButtonA();
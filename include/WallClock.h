@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "FixedFormat.h"
+
+/**
+ * @file WallClock.h
+ * @brief RTC（DS3231）に合わせ続ける RAM 上の時計（時刻モデル・暦計算・レジスタ形式）
+ *
+ * @details
+ * 行ごとの時刻のために毎回 I²C で RTC を読むと、記録周期に I²C の待ちが入る。
+ * RtcClock は RTC を RTC_DISCIPLINE_INTERVAL_MS ごとにだけ読み（秒の変わり目を
+ * 捕まえて ms 単位の観測にする）、その観測で本クラスのモデルを補正する。
+ * 行の時刻は nowMs(millis()) の整数演算だけで求まる。
+ *
+ * 【モデル】anchor（RTC 時刻, millis）からの経過 dt に対し
+ *   時刻 = anchorMs + dt + dt × drift + min(dt, SLEW_MS) / SLEW_MS × slew
+ * - drift: millis() の進み・遅れ（ppb）。最後に一度に合わせた時点からの RTC と millis() の
+ *          進みの比。基線が長いほど観測の揺れ（秒の変わり目を捕まえる周期ぶん）が効かない
+ * - slew : 観測時の位相誤差。SLEW_MS かけて滑らかに詰める（時刻が跳ばず、逆行しない）
+ * - 誤差が STEP_MS を超えたら（初回・RTC の再設定）その時刻へ一度に合わせ、drift を捨てる
+ * millis() の一周（49.7 日）は dt を 32 ビットの差で求めるため影響しない
+ * （観測の間隔がそれより短いこと）。
+ *
+ * 時刻は RTC の暦（タイムゾーン無し）を 1970-01-01 00:00:00 起点の ms で表す。
+ */
+
+/**
+ * @brief 暦の日時（DS3231 のレジスタ・シリアルでの設定用）
+ */
+struct CivilTime {
+  uint16_t year;     // 2000〜2099（DS3231 の範囲）
+  uint8_t  month;    // 1〜12
+  uint8_t  day;      // 1〜31
+  uint8_t  hour;     // 0〜23
+  uint8_t  minute;
+  uint8_t  second;
+};
+
+class WallClock {
+public:
+  static constexpr uint32_t SLEW_MS       = 60000UL;    // 位相誤差を詰める時間
+  static constexpr int32_t  STEP_MS       = 1000;       // これを超える誤差は一度に合わせる
+  static constexpr int32_t  MAX_DRIFT_PPB = 500000;     // 補正する進み・遅れの上限（±500ppm）
+  static constexpr uint32_t MIN_RATE_INTERVAL_MS = 10000UL;  // 基線がこれより短い間は位相だけ
+  static constexpr size_t   ISO_LEN       = 23;         // "2026-10-19T12:34:56.789"
+
+  WallClock() { reset(); }
+
+  void reset() {
+    m_valid       = false;
+    m_anchorMs    = 0;
+    m_anchorLocal = 0;
+    m_driftPpb    = 0;
+    m_slewMs      = 0;
+    m_baseMs      = 0;
+    m_spanMs      = 0;
+    m_lastErrorMs = 0;
+    m_steps       = 0;
+    m_samples     = 0;
+  }
+
+  bool     valid() const { return m_valid; }
+  int32_t  driftPpb() const { return m_driftPpb; }
+  int32_t  lastErrorMs() const { return m_lastErrorMs; }
+  uint32_t steps() const { return m_steps; }
+  uint32_t samples() const { return m_samples; }
+
+  /**
+   * @brief RTC の観測で補正
+   * @param rtcMs 観測した RTC 時刻（秒の変わり目なら ms まで正確）
+   * @param localMs その時の millis()
+   */
+  void discipline(int64_t rtcMs, uint32_t localMs) {
+    m_samples++;
+    if (!m_valid) {
+      step(rtcMs, localMs);
+      m_valid = true;
+      return;
+    }
+    const int64_t predicted = nowMs(localMs);
+    const int64_t error     = rtcMs - predicted;
+    m_lastErrorMs = static_cast<int32_t>(error > INT32_MAX ? INT32_MAX
+                                         : error < INT32_MIN ? INT32_MIN : error);
+    if (error > STEP_MS || error < -STEP_MS) {
+      step(rtcMs, localMs);
+      m_driftPpb = 0;
+      m_steps++;
+      return;
+    }
+    m_spanMs += sinceAnchor(localMs);
+    if (m_spanMs >= static_cast<int64_t>(MIN_RATE_INTERVAL_MS)) {
+      int64_t drift = (rtcMs - m_baseMs - m_spanMs) * 1000000000LL / m_spanMs;
+      if (drift > MAX_DRIFT_PPB) drift = MAX_DRIFT_PPB;
+      if (drift < -MAX_DRIFT_PPB) drift = -MAX_DRIFT_PPB;
+      m_driftPpb = static_cast<int32_t>(drift);
+    }
+    m_anchorMs    = predicted;
+    m_anchorLocal = localMs;
+    m_slewMs      = static_cast<int32_t>(error);
+  }
+
+  /**
+   * @brief localMs（millis()）時点の時刻 [ms]（RAM 上の計算のみ）
+   * @return valid() でなければ -1
+   */
+  int64_t nowMs(uint32_t localMs) const {
+    if (!m_valid) return -1;
+    const int64_t dt = sinceAnchor(localMs);
+    if (dt < 0) return m_anchorMs + dt;
+    const int64_t s  = (dt < SLEW_MS) ? dt : SLEW_MS;
+    return m_anchorMs + dt + dt * m_driftPpb / 1000000000LL +
+           static_cast<int64_t>(m_slewMs) * s / static_cast<int64_t>(SLEW_MS);
+  }
+
+  // ── 暦計算（グレゴリオ暦、1970-01-01 = 0 日）────────────────────────────
+
+  static int64_t toEpochSec(const CivilTime& t) {
+    return daysFromCivil(t.year, t.month, t.day) * 86400LL + t.hour * 3600L + t.minute * 60L +
+           t.second;
+  }
+
+  static void fromEpochSec(int64_t sec, CivilTime& t) {
+    int64_t days = sec / 86400;
+    int64_t rem  = sec % 86400;
+    if (rem < 0) {
+      rem += 86400;
+      days -= 1;
+    }
+    // H. Hinnant の civil_from_days
+    days += 719468;
+    const int64_t  era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t doe = static_cast<uint32_t>(days - era * 146097);
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp  = (5 * doy + 2) / 153;
+    const uint32_t d   = doy - (153 * mp + 2) / 5 + 1;
+    const uint32_t m   = mp < 10 ? mp + 3 : mp - 9;
+    t.year   = static_cast<uint16_t>(yoe + era * 400 + (m <= 2 ? 1 : 0));
+    t.month  = static_cast<uint8_t>(m);
+    t.day    = static_cast<uint8_t>(d);
+    t.hour   = static_cast<uint8_t>(rem / 3600);
+    t.minute = static_cast<uint8_t>(rem / 60 % 60);
+    t.second = static_cast<uint8_t>(rem % 60);
+  }
+
+  /**
+   * @brief 暦として正しいか（2000〜2099 年、うるう年を考慮）
+   */
+  static bool validCivil(const CivilTime& t) {
+    static const uint8_t mdays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (t.year < 2000 || t.year > 2099 || t.month < 1 || t.month > 12 || t.day < 1) return false;
+    const bool leap = (t.year % 4 == 0 && t.year % 100 != 0) || t.year % 400 == 0;
+    const uint8_t last = (t.month == 2 && leap) ? 29 : mdays[t.month - 1];
+    return t.day <= last && t.hour < 24 && t.minute < 60 && t.second < 60;
+  }
+
+  /**
+   * @brief ISO 8601（"2026-10-19T12:34:56.789"、ISO_LEN 文字、終端 '\0' は付けない）
+   */
+  static char* putIso(char* p, int64_t epochMs) {
+    int64_t sec = epochMs / 1000;
+    int32_t ms  = static_cast<int32_t>(epochMs % 1000);
+    if (ms < 0) {
+      ms += 1000;
+      sec -= 1;
+    }
+    CivilTime t;
+    fromEpochSec(sec, t);
+    p = FixedFormat::putIntPad(p, t.year, 4, '0');
+    *p++ = '-';
+    p = FixedFormat::putIntPad(p, t.month, 2, '0');
+    *p++ = '-';
+    p = FixedFormat::putIntPad(p, t.day, 2, '0');
+    *p++ = 'T';
+    p = FixedFormat::putIntPad(p, t.hour, 2, '0');
+    *p++ = ':';
+    p = FixedFormat::putIntPad(p, t.minute, 2, '0');
+    *p++ = ':';
+    p = FixedFormat::putIntPad(p, t.second, 2, '0');
+    *p++ = '.';
+    return FixedFormat::putIntPad(p, ms, 3, '0');
+  }
+
+  /**
+   * @brief "YYYYMMDDhhmmss"（シリアルでの設定）を解析
+   */
+  static bool parseCompact(const char* s, CivilTime& t) {
+    uint32_t v[6];
+    static const uint8_t widths[] = {4, 2, 2, 2, 2, 2};
+    for (int f = 0; f < 6; ++f) {
+      v[f] = 0;
+      for (int i = 0; i < widths[f]; ++i, ++s) {
+        if (*s < '0' || *s > '9') return false;
+        v[f] = v[f] * 10 + static_cast<uint32_t>(*s - '0');
+      }
+    }
+    if (*s != '\0') return false;
+    t.year   = static_cast<uint16_t>(v[0]);
+    t.month  = static_cast<uint8_t>(v[1]);
+    t.day    = static_cast<uint8_t>(v[2]);
+    t.hour   = static_cast<uint8_t>(v[3]);
+    t.minute = static_cast<uint8_t>(v[4]);
+    t.second = static_cast<uint8_t>(v[5]);
+    return validCivil(t);
+  }
+
+  // ── DS3231 の時刻レジスタ（0x00〜0x06、BCD、24 時間制で書く）──────────────
+
+  static constexpr uint8_t DS3231_REG_TIME   = 0x00;
+  static constexpr uint8_t DS3231_REG_STATUS = 0x0F;
+  static constexpr uint8_t DS3231_OSF        = 0x80;   // 発振停止フラグ（時刻は無効）
+  static constexpr size_t  DS3231_TIME_BYTES = 7;
+
+  /**
+   * @brief 時刻レジスタ 7 バイトを暦に（12 時間制の読み出しにも対応）
+   * @return false : 範囲外（未設定・読み出し異常）
+   */
+  static bool decodeDs3231(const uint8_t* r, CivilTime& t) {
+    t.second = bcd(r[0] & 0x7F);
+    t.minute = bcd(r[1] & 0x7F);
+    if (r[2] & 0x40) {
+      // 12 時間制: bit5 = PM
+      const uint8_t h12 = bcd(r[2] & 0x1F);
+      t.hour = static_cast<uint8_t>((h12 % 12) + ((r[2] & 0x20) ? 12 : 0));
+    } else {
+      t.hour = bcd(r[2] & 0x3F);
+    }
+    t.day   = bcd(r[4] & 0x3F);
+    t.month = bcd(r[5] & 0x1F);
+    t.year  = static_cast<uint16_t>(2000 + bcd(r[6]));
+    return validCivil(t);
+  }
+
+  static void encodeDs3231(const CivilTime& t, uint8_t* r) {
+    const int64_t days = daysFromCivil(t.year, t.month, t.day);
+    r[0] = toBcd(t.second);
+    r[1] = toBcd(t.minute);
+    r[2] = toBcd(t.hour);
+    r[3] = static_cast<uint8_t>((days + 3) % 7 + 1);   // 曜日 1〜7（月曜 = 1、1970-01-01 は木曜）
+    r[4] = toBcd(t.day);
+    r[5] = toBcd(t.month);
+    r[6] = toBcd(static_cast<uint8_t>(t.year % 100));
+  }
+
+private:
+  static int64_t daysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+    y -= (m <= 2) ? 1 : 0;
+    const int32_t  era = (y >= 0 ? y : y - 399) / 400;
+    const uint32_t yoe = static_cast<uint32_t>(y - era * 400);
+    const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<int64_t>(era) * 146097 + doe - 719468;
+  }
+
+  static uint8_t bcd(uint8_t v) { return static_cast<uint8_t>((v >> 4) * 10 + (v & 0x0F)); }
+  static uint8_t toBcd(uint8_t v) { return static_cast<uint8_t>(((v / 10) << 4) | (v % 10)); }
+
+  void step(int64_t rtcMs, uint32_t localMs) {
+    m_anchorMs    = rtcMs;
+    m_anchorLocal = localMs;
+    m_slewMs      = 0;
+    m_baseMs      = rtcMs;
+    m_spanMs      = 0;
+  }
+
+  /**
+   * @brief 補正時点からの millis() の経過
+   * @details 観測（秒の変わり目の推定）は呼び出し時より少し前になるため、
+   *          補正時点より SLEW_MS 以内の前は一周ではなく負の経過として扱う
+   */
+  int64_t sinceAnchor(uint32_t localMs) const {
+    const uint32_t dt = localMs - m_anchorLocal;
+    return (dt > 0xFFFFFFFFUL - SLEW_MS) ? -static_cast<int64_t>(~dt) - 1 : dt;
+  }
+
+  bool     m_valid;
+  int64_t  m_anchorMs;      // 補正時点の時刻
+  uint32_t m_anchorLocal;   // 補正時点の millis()
+  int32_t  m_driftPpb;
+  int32_t  m_slewMs;        // 補正時点の位相誤差（SLEW_MS かけて加える）
+  int64_t  m_baseMs;        // 基線の始点（最後に一度に合わせた時の RTC 時刻）
+  int64_t  m_spanMs;        // 基線の始点からの millis() の経過（一周をまたいで数える）
+  int32_t  m_lastErrorMs;
+  uint32_t m_steps;         // 一度に合わせた回数（初回を除く）
+  uint32_t m_samples;       // 観測回数
+};
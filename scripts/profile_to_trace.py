@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+プロファイリングゾーンのダンプ → Chrome / Perfetto トレース JSON 変換
+
+使用方法:
+    python scripts/profile_to_trace.py serial_log.txt -o trace.json
+
+入力はシリアルモニタのキャプチャ（'z' コマンドの出力）。他のログ行が
+混ざっていてもよい。出力を chrome://tracing または https://ui.perfetto.dev
+で開くと、コアごとのトラックにフレームチャートが表示される。
+
+入力形式（include/ProfileZone.h 参照）:
+    # PROFILE clock_hz=240000000 cores=2
+    Z,<core>,<start_ticks>,<duration_ticks>,<name>
+    # PROFILE end events=<n> dropped=<n>
+"""
+
+import argparse
+import json
+import re
+import sys
+
+HEADER_RE = re.compile(r"# PROFILE clock_hz=(\d+)")
+EVENT_RE = re.compile(r"^Z,(\d+),(\d+),(\d+),(.+)$")
+WRAP = 1 << 32
+
+
+def parse(lines):
+    """最後の PROFILE ブロックを (clock_hz, {core: [(end, dur, name)]}) で返す"""
+    clock_hz = None
+    events = {}
+    for raw in lines:
+        line = raw.strip()
+        m = HEADER_RE.search(line)
+        if m:
+            # 新しいダンプが始まったら前のものは捨てる
+            clock_hz = int(m.group(1))
+            events = {}
+            continue
+        m = EVENT_RE.match(line)
+        if m and clock_hz is not None:
+            core, start, dur, name = int(m.group(1)), int(m.group(2)), int(m.group(3)), m.group(4)
+            events.setdefault(core, []).append(((start + dur) % WRAP, dur, name))
+    return clock_hz, events
+
+
+def unwrap(core_events):
+    """
+    32bit ティックの巻き戻りを補正する。
+
+    イベントはゾーン終了時に記録されるため、リング内では終了時刻が単調増加。
+    終了時刻が前より小さくなったら 1 周したとみなして 2^32 を加える。
+    """
+    offset = 0
+    prev_end = None
+    out = []
+    for end, dur, name in core_events:
+        if prev_end is not None and end + offset < prev_end:
+            offset += WRAP
+        abs_end = end + offset
+        prev_end = abs_end
+        out.append((abs_end - dur, dur, name))
+    return out
+
+
+def to_trace(clock_hz, events):
+    trace = []
+    base = None
+    per_core = {core: unwrap(evts) for core, evts in events.items()}
+    for evts in per_core.values():
+        for start, _, _ in evts:
+            base = start if base is None else min(base, start)
+    base = base or 0
+    us_per_tick = 1e6 / clock_hz
+
+    for core, evts in sorted(per_core.items()):
+        trace.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core,
+                      "args": {"name": "core%d" % core}})
+        for start, dur, name in evts:
+            trace.append({
+                "name": name,
+                "ph": "X",
+                "pid": 0,
+                "tid": core,
+                "ts": (start - base) * us_per_tick,
+                "dur": dur * us_per_tick,
+            })
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert profile zone dump to Chrome trace JSON")
+    parser.add_argument("logfile", help="シリアルキャプチャ（'-' で標準入力）")
+    parser.add_argument("-o", "--output", default="trace.json", help="出力 JSON ファイル")
+    args = parser.parse_args()
+
+    if args.logfile == "-":
+        lines = sys.stdin.readlines()
+    else:
+        with open(args.logfile, "r", encoding="utf-8", errors="replace") as f:
+            lines = f.readlines()
+
+    clock_hz, events = parse(lines)
+    if clock_hz is None:
+        print("ERROR: '# PROFILE' ヘッダが見つかりません（'z' コマンドの出力を含めてください）")
+        return 1
+
+    trace = to_trace(clock_hz, events)
+    with open(args.output, "w", encoding="utf-8") as f:
+        json.dump(trace, f)
+
+    total = sum(len(e) for e in events.values())
+    print("OK: %d events (%d cores, %.1f MHz) -> %s"
+          % (total, len(events), clock_hz / 1e6, args.output))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,142 @@
+#include "PerfMonitor.h"
+#include "Global.h"
+
+// ── 静的メンバー変数の実装 ─────────────────────────────────────────────────────
+LatencyHistogram  PerfMonitor::s_hist[PerfMonitor::TASKS];
+volatile uint32_t PerfMonitor::s_resetGen = 0;
+uint32_t          PerfMonitor::s_seenGen[PerfMonitor::TASKS] = {0};
+
+// ================================ 実装部分 ====================================
+
+/**
+ * @brief 1 回分の処理時間を記録
+ */
+void PerfMonitor::record(PerfTask task, uint32_t elapsedUs) {
+  const uint8_t i = static_cast<uint8_t>(task);
+  if (i >= TASKS) return;
+
+  // リセット要求は所有タスク自身が適用する（他コアから配列を消さない）
+  const uint32_t gen = s_resetGen;
+  if (s_seenGen[i] != gen) {
+    s_seenGen[i] = gen;
+    s_hist[i].reset();
+  }
+  s_hist[i].record(elapsedUs, budgetUs(task));
+}
+
+/**
+ * @brief 全タスクの統計リセットを依頼
+ */
+void PerfMonitor::requestReset() {
+  s_resetGen = s_resetGen + 1;
+}
+
+/**
+ * @brief 統計をシリアル等へ出力
+ */
+void PerfMonitor::dump(Print& out, bool withBuckets) {
+  out.printf("[PERF] %-8s %8s %8s %8s %8s %6s %9s\n",
+             "task", "count", "p50_us", "p99_us", "max_us", "over", "budget_us");
+  for (uint8_t i = 0; i < TASKS; ++i) {
+    const PerfTask task = static_cast<PerfTask>(i);
+    const LatencyHistogram& h = s_hist[i];
+    out.printf("[PERF] %-8s %8lu %8lu %8lu %8lu %6lu %9lu\n",
+               taskName(task),
+               (unsigned long)h.count(),
+               (unsigned long)h.percentile(500),
+               (unsigned long)h.percentile(990),
+               (unsigned long)h.max(),
+               (unsigned long)h.overruns(),
+               (unsigned long)budgetUs(task));
+
+    if (withBuckets) {
+      // 非ゼロのバケットのみ "下限-上限:件数" で列挙
+      out.printf("[PERF] %-8s hist", taskName(task));
+      for (uint8_t b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+        const uint32_t n = h.bucketCount(b);
+        if (n == 0) continue;
+        out.printf(" %lu-%lu:%lu",
+                   (unsigned long)LatencyHistogram::bucketLower(b),
+                   (unsigned long)LatencyHistogram::bucketUpper(b),
+                   (unsigned long)n);
+      }
+      out.printf("\n");
+    }
+  }
+}
+
+/**
+ * @brief 現在の統計を写す
+ */
+void PerfMonitor::summarize(Summary& out) {
+  for (uint8_t i = 0; i < TASKS; ++i) {
+    const LatencyHistogram& h = s_hist[i];
+    out.tasks[i].count    = h.count();
+    out.tasks[i].p50Us    = h.percentile(500);
+    out.tasks[i].p99Us    = h.percentile(990);
+    out.tasks[i].maxUs    = h.max();
+    out.tasks[i].overruns = h.overruns();
+  }
+}
+
+/**
+ * @brief SD ログフッタ用のコメント行を生成
+ */
+size_t PerfMonitor::formatFooter(const Summary& summary, char* buf, size_t len) {
+  if (buf == nullptr || len == 0) return 0;
+  size_t used = 0;
+  buf[0] = '\0';
+  for (uint8_t i = 0; i < TASKS; ++i) {
+    const PerfTask task = static_cast<PerfTask>(i);
+    const Summary::Task& t = summary.tasks[i];
+    const int n = snprintf(buf + used, len - used,
+                           "# PERF,%s,count=%lu,p50_us=%lu,p99_us=%lu,max_us=%lu,over=%lu,budget_us=%lu\r\n",
+                           taskName(task),
+                           (unsigned long)t.count,
+                           (unsigned long)t.p50Us,
+                           (unsigned long)t.p99Us,
+                           (unsigned long)t.maxUs,
+                           (unsigned long)t.overruns,
+                           (unsigned long)budgetUs(task));
+    if (n < 0 || static_cast<size_t>(n) >= len - used) {
+      buf[used] = '\0';  // 途中の行は書かない
+      break;
+    }
+    used += static_cast<size_t>(n);
+  }
+  return used;
+}
+
+/**
+ * @brief タスク名
+ */
+const char* PerfMonitor::taskName(PerfTask task) {
+  switch (task) {
+    case PerfTask::IO:      return "IO";
+    case PerfTask::LOGIC:   return "Logic";
+    case PerfTask::UI:      return "UI";
+    case PerfTask::STORAGE: return "Storage";
+    default:                return "?";
+  }
+}
+
+/**
+ * @brief タスクの処理時間予算 [µs]（PERFORMANCE.md の目標値）
+ */
+uint32_t PerfMonitor::budgetUs(PerfTask task) {
+  switch (task) {
+    case PerfTask::IO:      return PERF_BUDGET_IO_US;
+    case PerfTask::LOGIC:   return PERF_BUDGET_LOGIC_US;
+    case PerfTask::UI:      return PERF_BUDGET_UI_US;
+    case PerfTask::STORAGE: return PERF_BUDGET_STORAGE_US;
+    default:                return 0;
+  }
+}
+
+/**
+ * @brief 指定タスクのヒストグラム
+ */
+const LatencyHistogram& PerfMonitor::histogram(PerfTask task) {
+  const uint8_t i = static_cast<uint8_t>(task);
+  return s_hist[(i < TASKS) ? i : 0];
+}
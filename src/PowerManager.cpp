@@ -0,0 +1,138 @@
+#include "PowerManager.h"
+#include "Global.h"
+#include <M5Stack.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <driver/uart.h>
+
+static_assert(static_cast<uint8_t>(State::IDLE)   == PowerGovernor::STATE_IDLE &&
+              static_cast<uint8_t>(State::RUN)    == PowerGovernor::STATE_RUN &&
+              static_cast<uint8_t>(State::RESULT) == PowerGovernor::STATE_RESULT &&
+              static_cast<uint8_t>(State::ALARM_SETTING) == PowerGovernor::STATE_ALARM_SETTING,
+              "PowerGovernor state numbering must match enum class State");
+
+// ── 静的メンバー変数の実装 ─────────────────────────────────────────────────────
+std::atomic<uint32_t> PowerManager::s_lastActivityMs(0);
+std::atomic<uint32_t> PowerManager::s_controlNextWakeMs(0);
+std::atomic<bool>     PowerManager::s_controlIdle(false);
+std::atomic<bool>     PowerManager::s_backlightOn(true);   // M5.begin() が点灯させる
+uint16_t              PowerManager::s_cpuMhz        = PowerGovernor::CPU_MHZ_FULL;
+uint32_t              PowerManager::s_clockChanges  = 0;
+uint32_t              PowerManager::s_sleepCount    = 0;
+uint64_t              PowerManager::s_sleepUsTotal  = 0;
+uint32_t              PowerManager::s_initMs        = 0;
+
+// ================================ 実装部分 ====================================
+
+/**
+ * @brief ボタンの GPIO 起床を設定
+ *
+ * @details
+ * M5Stack のボタンは外付けプルアップ・押下で Low。ライトスリープ中に
+ * 押されたら即座に起きるよう Low レベル起床を有効にする。
+ * UART0 も起床要因にし、以降 POWER_ACTIVITY_HOLD_MS はコンソール入力を取りこぼさない。
+ */
+void PowerManager::init() {
+  s_initMs = millis();
+  s_lastActivityMs.store(s_initMs, std::memory_order_relaxed);  // 起動直後はフルクロック
+  s_cpuMhz = static_cast<uint16_t>(getCpuFrequencyMhz());
+#if POWER_GOVERNOR_ENABLED
+  gpio_wakeup_enable(static_cast<gpio_num_t>(BUTTON_A_PIN), GPIO_INTR_LOW_LEVEL);
+  gpio_wakeup_enable(static_cast<gpio_num_t>(BUTTON_B_PIN), GPIO_INTR_LOW_LEVEL);
+  gpio_wakeup_enable(static_cast<gpio_num_t>(BUTTON_C_PIN), GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  // シリアルコンソール: 受信でも起きる（起床に使われた最初の 1 文字は失われる）
+  uart_set_wakeup_threshold(UART_NUM_0, 3);
+  esp_sleep_enable_uart_wakeup(UART_NUM_0);
+#endif
+}
+
+/**
+ * @brief ユーザ操作を記録
+ */
+void PowerManager::noteActivity() {
+  s_lastActivityMs.store(millis(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief バックライトの輝度設定
+ */
+void PowerManager::setBacklight(uint8_t brightness) {
+  M5.Lcd.setBrightness(brightness);
+  s_backlightOn.store(brightness > 0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 制御タスクの待機開始
+ */
+void PowerManager::setControlIdle(uint32_t nextWakeMs) {
+  s_controlNextWakeMs.store(nextWakeMs, std::memory_order_relaxed);
+  s_controlIdle.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief 制御タスクの処理再開
+ */
+void PowerManager::setControlBusy() {
+  s_controlIdle.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief 省電力判断と適用（IO タスク専用）
+ */
+bool PowerManager::govern(uint8_t state, uint32_t ioNextDeadlineMs, bool storageIdle) {
+#if POWER_GOVERNOR_ENABLED
+  const uint32_t now = millis();
+  // 制御コア上のタスク（制御・SD 書き込み）が両方とも待機中のときだけ眠れる
+  const bool controlIdle = s_controlIdle.load(std::memory_order_acquire) && storageIdle;
+
+  PowerInputs in;
+  in.state          = state;
+  in.nowMs          = now;
+  in.nextDeadlineMs = controlIdle
+                    ? PowerGovernor::earlier(ioNextDeadlineMs,
+                                             s_controlNextWakeMs.load(std::memory_order_relaxed), now)
+                    : now;
+  in.lastActivityMs = s_lastActivityMs.load(std::memory_order_relaxed);
+  in.controlIdle    = controlIdle;
+  in.backlightOn    = s_backlightOn.load(std::memory_order_relaxed);
+
+  const PowerDecision d = PowerGovernor::decide(in, POWER_ACTIVITY_HOLD_MS, POWER_MIN_SLEEP_MS,
+                                                POWER_MAX_SLEEP_MS, POWER_WAKE_MARGIN_MS);
+
+  if (d.cpuMhz != s_cpuMhz) {
+    setCpuFrequencyMhz(d.cpuMhz);  // 80MHz 以上は APB=80MHz 固定（SPI / UART 不変）
+    s_cpuMhz = d.cpuMhz;
+    s_clockChanges++;
+  }
+
+  if (d.sleepMs == 0) return false;
+
+  const int64_t t0 = esp_timer_get_time();
+  esp_sleep_enable_timer_wakeup(static_cast<uint64_t>(d.sleepMs) * 1000ULL);
+  esp_light_sleep_start();  // 両コアとも停止。ボタン押下かタイマーで復帰
+  s_sleepUsTotal += static_cast<uint64_t>(esp_timer_get_time() - t0);
+  s_sleepCount++;
+  return true;
+#else
+  (void)state;
+  (void)ioNextDeadlineMs;
+  (void)storageIdle;
+  return false;
+#endif
+}
+
+/**
+ * @brief 統計を出力
+ */
+void PowerManager::dump(Print& out) {
+  const uint32_t upMs    = millis() - s_initMs;
+  const uint32_t sleepMs = static_cast<uint32_t>(s_sleepUsTotal / 1000ULL);
+  out.printf("[POWER] governor=%s cpu_mhz=%u backlight=%s clock_changes=%lu sleeps=%lu sleep_ms=%lu (%.1f%% of %lums)\n",
+             POWER_GOVERNOR_ENABLED ? "on" : "off", (unsigned)s_cpuMhz,
+             s_backlightOn.load(std::memory_order_relaxed) ? "on" : "off",
+             (unsigned long)s_clockChanges, (unsigned long)s_sleepCount,
+             (unsigned long)sleepMs, upMs ? (100.0f * sleepMs / upMs) : 0.0f,
+             (unsigned long)upMs);
+}
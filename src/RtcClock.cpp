@@ -0,0 +1,154 @@
+#include "RtcClock.h"
+#include "Global.h"
+#include <Wire.h>
+
+// ── 静的メンバー変数の実装 ─────────────────────────────────────────────────────
+WallClock RtcClock::s_clock;
+bool      RtcClock::s_present    = false;
+bool      RtcClock::s_stopped    = false;
+bool      RtcClock::s_hunting    = false;
+uint32_t  RtcClock::s_nextMs     = 0;
+uint32_t  RtcClock::s_huntStartMs = 0;
+uint32_t  RtcClock::s_prevPollMs = 0;
+int64_t   RtcClock::s_prevSec    = -1;
+uint32_t  RtcClock::s_missed     = 0;
+uint32_t  RtcClock::s_i2cErrors  = 0;
+
+// ================================ 実装部分 ====================================
+
+/**
+ * @brief I²C の初期化と RTC の検出
+ *
+ * @details
+ * M5.begin() は I²C を有効にしないため、ここで Wire を開始する。
+ * 状態レジスタの OSF が立っていれば（電池切れ・未設定）時刻は使わない。
+ */
+bool RtcClock::init() {
+  Wire.begin(RTC_I2C_SDA_PIN, RTC_I2C_SCL_PIN, RTC_I2C_CLOCK_HZ);
+  uint8_t status = 0;
+  s_present = readRegs(WallClock::DS3231_REG_STATUS, &status, 1);
+  if (!s_present) {
+    Serial.println("[RTC] DS3231 not found, wall-clock column disabled");
+    return false;
+  }
+  s_stopped = (status & WallClock::DS3231_OSF) != 0;
+  if (s_stopped) Serial.println("[RTC] oscillator stopped, set the time with 'T'");
+  s_nextMs = millis();   // 最初の補正はすぐに
+  return true;
+}
+
+/**
+ * @brief 補正の進行
+ */
+void RtcClock::service(uint32_t nowMs) {
+  if (!s_present || s_stopped) return;
+  if (!s_hunting) {
+    if (static_cast<int32_t>(nowMs - s_nextMs) < 0) return;
+    s_hunting     = true;
+    s_huntStartMs = nowMs;
+    s_prevSec     = -1;
+  }
+
+  CivilTime t;
+  const uint32_t pollMs = millis();
+  if (!readTime(t)) {
+    s_i2cErrors++;
+    finishHunt(nowMs, false);
+    return;
+  }
+  const int64_t sec = WallClock::toEpochSec(t);
+  if (s_prevSec >= 0 && sec != s_prevSec) {
+    // 変わり目は直前の読み出しとこの読み出しの間。間隔が長ければ（省電力で周期が
+    // 伸びている等）誤差が大きいため、次の変わり目を待つ
+    const uint32_t gap = pollMs - s_prevPollMs;
+    if (gap <= RTC_EDGE_MAX_GAP_MS) {
+      s_clock.discipline(sec * 1000, s_prevPollMs + gap / 2);
+      finishHunt(nowMs, true);
+      return;
+    }
+  }
+  s_prevSec    = sec;
+  s_prevPollMs = pollMs;
+  if (nowMs - s_huntStartMs >= RTC_EDGE_TIMEOUT_MS) finishHunt(nowMs, false);
+}
+
+/**
+ * @brief RTC を設定
+ *
+ * @details
+ * 書き込むと DS3231 の秒以下のカウンタがリセットされるため、書いた瞬間が
+ * その秒の変わり目になる。WallClock は次の補正で一度に合わせ直す（誤差 > STEP_MS
+ * なら step、それ以下なら slew）。
+ */
+bool RtcClock::set(const CivilTime& t) {
+  if (!s_present || !WallClock::validCivil(t)) return false;
+  uint8_t regs[WallClock::DS3231_TIME_BYTES];
+  WallClock::encodeDs3231(t, regs);
+  uint8_t status = 0;
+  if (!writeRegs(WallClock::DS3231_REG_TIME, regs, sizeof(regs)) ||
+      !readRegs(WallClock::DS3231_REG_STATUS, &status, 1)) {
+    s_i2cErrors++;
+    return false;
+  }
+  status &= static_cast<uint8_t>(~WallClock::DS3231_OSF);
+  if (!writeRegs(WallClock::DS3231_REG_STATUS, &status, 1)) {
+    s_i2cErrors++;
+    return false;
+  }
+  s_stopped = false;
+  s_hunting = false;
+  s_nextMs  = millis();
+  return true;
+}
+
+/**
+ * @brief 状態を出力
+ */
+void RtcClock::dump(Print& out) {
+  if (!s_present) {
+    out.println("[RTC] not present");
+    return;
+  }
+  char iso[WallClock::ISO_LEN + 1] = "-";
+  const int64_t wall = wallMsAt(millis());
+  if (wall >= 0) *WallClock::putIso(iso, wall) = '\0';
+  out.printf("[RTC] now=%s osf=%d drift_ppb=%ld last_error_ms=%ld samples=%lu steps=%lu "
+             "missed=%lu i2c_errors=%lu\n",
+             iso, s_stopped ? 1 : 0, (long)s_clock.driftPpb(), (long)s_clock.lastErrorMs(),
+             (unsigned long)s_clock.samples(), (unsigned long)s_clock.steps(),
+             (unsigned long)s_missed, (unsigned long)s_i2cErrors);
+}
+
+/**
+ * @brief 時刻レジスタ 7 バイトを読んで暦に
+ */
+bool RtcClock::readTime(CivilTime& t) {
+  uint8_t regs[WallClock::DS3231_TIME_BYTES];
+  return readRegs(WallClock::DS3231_REG_TIME, regs, sizeof(regs)) &&
+         WallClock::decodeDs3231(regs, t);
+}
+
+bool RtcClock::readRegs(uint8_t reg, uint8_t* buf, size_t len) {
+  Wire.beginTransmission(RTC_I2C_ADDR);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0) return false;
+  if (Wire.requestFrom(RTC_I2C_ADDR, static_cast<uint8_t>(len)) != len) return false;
+  for (size_t i = 0; i < len; ++i) buf[i] = static_cast<uint8_t>(Wire.read());
+  return true;
+}
+
+bool RtcClock::writeRegs(uint8_t reg, const uint8_t* buf, size_t len) {
+  Wire.beginTransmission(RTC_I2C_ADDR);
+  Wire.write(reg);
+  Wire.write(buf, len);
+  return Wire.endTransmission() == 0;
+}
+
+/**
+ * @brief 変わり目の待ちを終える（捕まえ損ねたら短い間隔で再試行）
+ */
+void RtcClock::finishHunt(uint32_t nowMs, bool ok) {
+  s_hunting = false;
+  if (!ok) s_missed++;
+  s_nextMs = nowMs + (ok ? RTC_DISCIPLINE_INTERVAL_MS : RTC_RETRY_INTERVAL_MS);
+}
@@ -0,0 +1,208 @@
+#include "SDBenchmark.h"
+#include "SectorWriter.h"
+#include "SpiBus.h"
+#include "SDManager.h"
+#include <SD.h>
+#include <SPI.h>
+
+namespace {
+  const char* BENCH_LEGACY_FILE = "/BENCH_L.csv";
+  const char* BENCH_SECTOR_FILE = "/BENCH_S.csv";
+
+  // RUN 中の代表的な 1 行（約 60 バイト）
+  const char* BENCH_ROW = "1234,540.2,RUN,12340,538.7,1.3,545.0,531.9,false,false\r\n";
+
+  struct BenchSink {
+    File*  file;
+    bool   seek(uint32_t offset) { return file->seek(offset); }
+    size_t write(const uint8_t* data, size_t len) { return file->write(data, len); }
+    void   flush() { file->flush(); }
+  };
+
+  // カード計測の 1 ブロック（最大 8KB。DMA 転送できるよう 4 バイト整列）
+  alignas(4) uint8_t s_profileBlock[512UL << (CardProfile::MAX_RESULTS - 1)];
+}
+
+// ================================ 実装部分 ====================================
+
+/**
+ * @brief 両方式のベンチマークを実行
+ */
+void SDBenchmark::run(Print& out, uint16_t rows) {
+  if (!SDManager::isReady()) {
+    out.println("[SDBENCH] SD not ready");
+    return;
+  }
+
+  const size_t rowLen = strlen(BENCH_ROW);
+  out.printf("[SDBENCH] rows=%u row_bytes=%u\n", (unsigned)rows, (unsigned)rowLen);
+
+  // ── legacy: 毎行 write → flush → SPI 再初期化（旧 writeData()）──
+  {
+    LatencyHistogram hist;
+    File f;
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      f = SD.open(BENCH_LEGACY_FILE, FILE_WRITE);
+    }
+    if (!f) {
+      out.println("[SDBENCH] cannot create legacy file");
+      return;
+    }
+    const uint32_t start = micros();
+    for (uint16_t i = 0; i < rows; ++i) {
+      SpiBusGuard bus(SpiDevice::SD);
+      const uint32_t t0 = micros();
+      f.write(reinterpret_cast<const uint8_t*>(BENCH_ROW), rowLen);
+      f.flush();
+      SPI.end();
+      SPI.begin();
+      hist.record(micros() - t0);
+    }
+    const uint32_t totalUs = micros() - start;
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      f.close();
+      SD.remove(BENCH_LEGACY_FILE);
+    }
+    report(out, "legacy", rows, totalUs, hist);
+  }
+
+  // ── sector: SectorWriter（SDManager と同じ同期方針）──
+  {
+    LatencyHistogram hist;
+    File f;
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      f = SD.open(BENCH_SECTOR_FILE, FILE_WRITE);
+    }
+    if (!f) {
+      out.println("[SDBENCH] cannot create sector file");
+      return;
+    }
+    BenchSink sink = {&f};
+    SectorWriter<BenchSink> writer(sink, SD_SYNC_INTERVAL_MS, SD_SYNC_BYTES);
+    writer.reset(millis());
+
+    const uint32_t start = micros();
+    for (uint16_t i = 0; i < rows; ++i) {
+      SpiBusGuard bus(SpiDevice::SD);
+      const uint32_t t0 = micros();
+      writer.append(BENCH_ROW, rowLen);
+      writer.service(millis());
+      hist.record(micros() - t0);
+    }
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      writer.sync(millis());
+    }
+    const uint32_t totalUs = micros() - start;
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      f.close();
+      SD.remove(BENCH_SECTOR_FILE);
+    }
+    report(out, "sector", rows, totalUs, hist);
+    out.printf("[SDBENCH] sector: sectors=%lu tails=%lu syncs=%lu stalls=%lu\n",
+               (unsigned long)writer.stats().sectorWrites,
+               (unsigned long)writer.stats().tailWrites,
+               (unsigned long)writer.stats().syncs,
+               (unsigned long)writer.stats().stalls);
+  }
+}
+
+/**
+ * @brief ブロック長ごとの速度・レイテンシを計測
+ */
+bool SDBenchmark::profileCard(Print& out, CardProfile& profile) {
+  for (size_t i = 0; i < sizeof(s_profileBlock); ++i) {
+    s_profileBlock[i] = static_cast<uint8_t>('0' + i % 10);
+  }
+
+  File f;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    SD.remove(SD_PROFILE_SCRATCH_FILE);
+    f = SD.open(SD_PROFILE_SCRATCH_FILE, FILE_WRITE);
+  }
+  if (!f) {
+    out.println("[SDPROFILE] cannot create scratch file");
+    return false;
+  }
+
+  // 計測範囲を先に確保（計測しない）
+  bool ok = true;
+  for (uint32_t done = 0; ok && done < SD_PROFILE_BYTES_PER_SIZE; done += sizeof(s_profileBlock)) {
+    SpiBusGuard bus(SpiDevice::SD);
+    ok = f.write(s_profileBlock, sizeof(s_profileBlock)) == sizeof(s_profileBlock);
+  }
+  if (ok) {
+    SpiBusGuard bus(SpiDevice::SD);
+    f.flush();
+  }
+
+  profile.count = 0;
+  for (uint8_t i = 0; ok && i < CardProfile::MAX_RESULTS; ++i) {
+    const uint32_t   block = CardProfile::blockSize(i);
+    const uint32_t   n     = SD_PROFILE_BYTES_PER_SIZE / block;
+    LatencyHistogram hist;
+
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      ok = f.seek(0);
+    }
+    const uint32_t writeStart = micros();
+    for (uint32_t k = 0; ok && k < n; ++k) {
+      SpiBusGuard bus(SpiDevice::SD);
+      const uint32_t t0 = micros();
+      ok = f.write(s_profileBlock, block) == block;
+      f.flush();
+      hist.record(micros() - t0);
+    }
+    const uint32_t writeUs = micros() - writeStart;
+
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      ok = ok && f.seek(0);
+    }
+    const uint32_t readStart = micros();
+    for (uint32_t k = 0; ok && k < n; ++k) {
+      SpiBusGuard bus(SpiDevice::SD);
+      ok = f.read(s_profileBlock, block) == block;
+    }
+    const uint32_t readUs = micros() - readStart;
+    if (!ok) break;
+
+    // bytes / µs × 1e6 / 1024 = kB/s
+    const uint64_t bytes = static_cast<uint64_t>(block) * n;
+    CardBlockResult& r   = profile.results[profile.count++];
+    r.blockBytes = block;
+    r.writeKBps  = writeUs ? static_cast<uint32_t>(bytes * 1000000ULL / 1024ULL / writeUs) : 0;
+    r.readKBps   = readUs ? static_cast<uint32_t>(bytes * 1000000ULL / 1024ULL / readUs) : 0;
+    r.writeP50Us = hist.percentile(500);
+    r.writeP99Us = hist.percentile(990);
+    r.writeMaxUs = hist.max();
+  }
+
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    f.close();
+    SD.remove(SD_PROFILE_SCRATCH_FILE);
+  }
+  if (!ok) out.println("[SDPROFILE] scratch file I/O failed");
+  return ok;
+}
+
+/**
+ * @brief 1 方式分の結果を 1 行で出力
+ */
+void SDBenchmark::report(Print& out, const char* mode, uint16_t rows,
+                         uint32_t totalUs, const LatencyHistogram& hist) {
+  const float rowsPerSec = totalUs ? (rows * 1000000.0f / totalUs) : 0.0f;
+  out.printf("[SDBENCH] %-6s rows_per_s=%.1f p50_us=%lu p99_us=%lu max_us=%lu total_ms=%lu\n",
+             mode, rowsPerSec,
+             (unsigned long)hist.percentile(500),
+             (unsigned long)hist.percentile(990),
+             (unsigned long)hist.max(),
+             (unsigned long)(totalUs / 1000UL));
+}
@@ -1,11 +1,278 @@
 #include "SDManager.h"
+#include "ProfileZone.h"
+#include "SectorWriter.h"
+#include "DeltaCodec.h"
+#include "LogPrealloc.h"
+#include "LogRecovery.h"
+#include "SpiBus.h"
+#include "FixedFormat.h"
+#include "SDBenchmark.h"
+#include "SdLatency.h"
+#include "RawCapture.h"
+#include "LogSchema.h"
+#include <atomic>
+#include <unistd.h>   // truncate()
+
+// 生データ記録の SD 書き込み量は、最短の同期間隔・最長符号でも予算内（RawCapture.h）
+static_assert(RawCapture::worstBytesPerSec(TC_CAPTURE_INTERVAL_MS, SD_SYNC_INTERVAL_MIN_MS) <=
+                  SD_RAW_BUDGET_BYTES_PER_S,
+              "raw capture exceeds SD_RAW_BUDGET_BYTES_PER_S at the shortest sync interval");
+static_assert(TC_CAPTURE_INTERVAL_MS >= RawCapture::CONVERSION_MS,
+              "TC_CAPTURE_INTERVAL_MS is shorter than the MAX31855 conversion time");
 
 // ── 静的メンバー変数の実装 ─────────────────────────────────────────────────────
 bool   SDManager::s_sdReady       = false;
 bool   SDManager::s_fileOpen      = false;
+LogFormat SDManager::s_format     = LogFormat::CSV;
 File   SDManager::s_currentFile;
 char   SDManager::s_lastError[64] = {0};
-char   SDManager::s_lineBuffer[256] = {0};
+char   SDManager::s_lineBuffer[320] = {0};
+
+// ── セクタ整列ライター ─────────────────────────────────────────────────────────
+namespace {
+  // ログ経路のファイル操作ごとのレイテンシ（SdLatency.h）。記録は SD 書き込みタスクのみ
+  SdLatency         s_latency;
+  std::atomic<bool> s_latencyResetRequested(false);   // シリアル 'r'（制御タスク）からの依頼
+
+  /**
+   * @brief 32 ビットの記録欄へ（BINARY / DELTA / チェックポイントのサンプル数。超えたら飽和）
+   */
+  uint32_t saturate32(uint64_t v) {
+    return (v > 0xFFFFFFFFull) ? 0xFFFFFFFFUL : static_cast<uint32_t>(v);
+  }
+
+  void recordOp(SdOp op, uint32_t startUs) {
+    const uint32_t us = micros() - startUs;
+    if (s_latencyResetRequested.exchange(false, std::memory_order_acq_rel)) s_latency.reset();
+    s_latency.record(op, us, SD_STALL_THRESHOLD_US);
+  }
+
+  File timedOpen(const char* path, const char* mode) {
+    const uint32_t t0 = micros();
+    File f = SD.open(path, mode);
+    recordOp(SdOp::OPEN, t0);
+    return f;
+  }
+
+  void timedFlush(File& f) {
+    const uint32_t t0 = micros();
+    f.flush();
+    recordOp(SdOp::FLUSH, t0);
+  }
+
+  void timedClose(File& f) {
+    const uint32_t t0 = micros();
+    f.close();
+    recordOp(SdOp::CLOSE, t0);
+  }
+
+  /**
+   * @brief SectorWriter の書き込み先（開いている s_currentFile）
+   * @details 1 回の write() は 1 セクタ以下。書くたびにセンサー読取へバスを譲る機会を作る
+   */
+  struct FileSink {
+    File*  file;
+    bool   seek(uint32_t offset) { return file->seek(offset); }
+    size_t write(const uint8_t* data, size_t len) {
+      const uint32_t t0 = micros();
+      const size_t   n  = file->write(data, len);
+      recordOp(SdOp::WRITE, t0);
+      SpiBus::yield();
+      return n;
+    }
+    void   flush() { timedFlush(*file); }
+  };
+
+  FileSink                s_sink   = {nullptr};  // createNewFile() で設定
+  SectorWriter<FileSink>  s_writer(s_sink, SD_SYNC_INTERVAL_MS, SD_SYNC_BYTES);
+
+  BinLogBlock             s_block;                 // バイナリ形式の組み立て中ブロック
+  DeltaBlock              s_delta;                 // DELTA 形式の組み立て中ブロック
+  uint32_t                s_deltaSyncMs = 0;       // 途中ブロックを最後に書き直した時刻
+  bool                    s_deltaTailOnDisk = false;  // 途中ブロックを末尾に書いてある
+
+  // 事前確保と有効長マーカー（LogPrealloc.h）
+  char                    s_path[SD_MAX_FILENAME + 8] = {0};  // truncate() 用の VFS パス
+  uint32_t                s_allocated   = 0;       // 確保済みのファイルサイズ
+  uint32_t                s_allocChunk  = 0;       // 追加確保の単位（0 = 確保しない）
+  uint32_t                s_validBytes  = 0;       // 先頭セクタに記録済みの有効長
+  BinLogHeader            s_binHeader;             // バイナリ形式のヘッダ（validBytes を書き換えて再出力）
+  alignas(4) uint8_t      s_headerSector[LogPrealloc::SECTOR_SIZE];
+
+  // チェックポイント（LogRecovery.h）
+  uint32_t                s_recordSeq     = 0;     // 記録済みレコード数
+  uint32_t                s_lastCkptMs    = 0;     // CSV: 最後のチェックポイントの経過時間
+  uint32_t                s_blocksSinceCkpt = 0;   // BINARY / DELTA: 以降のデータブロック数
+  SDData                  s_lastData;              // DELTA: ファイルに入っている最後のサンプル
+
+  /**
+   * @brief 集約ログ 1 段分（Rollup.h）。生ログと同じセクタ整列・同期方針で書く
+   */
+  struct RollupFile {
+    File                   file;
+    FileSink               sink;
+    SectorWriter<FileSink> writer;
+    bool                   open;
+
+    RollupFile() : sink{&file}, writer(sink, SD_SYNC_INTERVAL_MS, SD_SYNC_BYTES), open(false) {}
+  };
+  RollupFile              s_rollups[RollupCascade::LEVELS];
+
+  // 時刻索引（LogIndex.h）: 生ログと並べた DATA_xxxx.idx
+  File                    s_indexFile;
+  FileSink                s_indexSink = {&s_indexFile};
+  SectorWriter<FileSink>  s_indexWriter(s_indexSink, SD_SYNC_INTERVAL_MS, SD_SYNC_BYTES);
+  bool                    s_indexOpen  = false;
+  uint32_t                s_indexCount = 0;        // 書いたエントリ数
+  LogIndex::Builder       s_indexBuilder(SD_INDEX_INTERVAL_RECORDS);
+
+  // 生データ記録（RawCapture.h）: 生ログと並べた DATA_xxxx_raw.bin
+  File                    s_rawFile;
+  FileSink                s_rawSink = {&s_rawFile};
+  SectorWriter<FileSink>  s_rawWriter(s_rawSink, SD_SYNC_INTERVAL_MS, SD_SYNC_BYTES);
+  bool                    s_rawOpen   = false;
+  DeltaBlock              s_rawBlock;              // 組み立て中のブロック
+  uint32_t                s_rawSyncMs = 0;         // 途中ブロックを最後に書き直した時刻
+  BinLogHeader            s_rawHeader;             // クローズ時に有効長・closed を書き換えて再出力
+
+  /**
+   * @brief 生データ記録を止める（生ログの記録は続ける）
+   */
+  void stopRaw(const char* what) {
+    Serial.printf("[SDManager] Raw capture %s failed, capture stopped\n", what);
+    timedClose(s_rawFile);
+    s_rawOpen = false;
+  }
+
+  /**
+   * @brief 生ログのファイル名から生データのファイル名（DATA_0003.bin → DATA_0003_raw.bin）
+   */
+  void rawPathFor(const char* filename, char* out, size_t len) {
+    const char* dot  = strrchr(filename, '.');
+    const int   stem = (dot != nullptr) ? static_cast<int>(dot - filename)
+                                        : static_cast<int>(strlen(filename));
+    snprintf(out, len, "%.*s_raw.bin", stem, filename);
+  }
+
+  /**
+   * @brief 生ログのファイル名から索引ファイル名（拡張子を .idx に）
+   */
+  void indexPathFor(const char* filename, char* out, size_t len) {
+    const char* dot  = strrchr(filename, '.');
+    const int   stem = (dot != nullptr) ? static_cast<int>(dot - filename)
+                                        : static_cast<int>(strlen(filename));
+    snprintf(out, len, "%.*s.idx", stem, filename);
+  }
+
+  /**
+   * @brief 生ログのファイル名から集約ログのファイル名（DATA_0003.csv → DATA_0003_1m.csv）
+   */
+  void rollupPathFor(const char* filename, size_t level, char* out, size_t len) {
+    const char* dot  = strrchr(filename, '.');
+    const int   stem = (dot != nullptr) ? static_cast<int>(dot - filename)
+                                        : static_cast<int>(strlen(filename));
+    char suffix[8];
+    RollupCascade::periodName(RollupCascade::defaultPeriodMs(level), suffix, sizeof(suffix));
+    snprintf(out, len, "%.*s_%s.csv", stem, filename, suffix);
+  }
+
+  /**
+   * @brief 開き直した既存ファイルの end から追記を再開（SD の再マウント後）
+   */
+  bool resumeWriter(File& file, SectorWriter<FileSink>& writer, uint32_t end) {
+    alignas(4) uint8_t tail[LogPrealloc::SECTOR_SIZE];
+    const uint32_t base = end - end % LogPrealloc::SECTOR_SIZE;
+    const size_t   n    = end - base;
+    if (n > 0 && (!file.seek(base) || file.read(tail, n) != n)) return false;
+    writer.resume(end, tail, millis());
+    return true;
+  }
+
+  /**
+   * @brief 起動時の復旧で読む SD 上のファイル（I/O 1 回ごとにバスを保持）
+   */
+  struct RecoverySource {
+    File*  file;
+    size_t read(uint32_t offset, uint8_t* buf, size_t len) {
+      SpiBusGuard bus(SpiDevice::SD);
+      if (!file->seek(offset)) return 0;
+      return file->read(buf, len);
+    }
+  };
+
+  /**
+   * @brief 目録の末尾の有効なレコード（読むのは末尾の数レコードのみ）
+   * @return false : 目録が無い、または全て破損
+   */
+  bool lastCatalogEntry(RunCatalogEntry& last) {
+    File     cat;
+    uint32_t size = 0;
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      cat = SD.open(SD_CATALOG_FILE, FILE_READ);
+      if (cat) size = cat.size();
+    }
+    if (!cat) return false;
+    RecoverySource src = {&cat};
+    const bool found = RunCatalog::findLast(src, size, last);
+    SpiBusGuard bus(SpiDevice::SD);
+    cat.close();
+    return found;
+  }
+
+  /**
+   * @brief 旧ファームウェアの命名（/DATA_xxxx.csv / .bin）で n 番のログがあるか
+   */
+  bool legacyRunExists(uint32_t n) {
+    char name[SD_MAX_FILENAME];
+    RunCatalog::fileNameFor(n, true, name, sizeof(name));
+    if (SD.exists(name)) return true;
+    RunCatalog::fileNameFor(n, false, name, sizeof(name));
+    return SD.exists(name);
+  }
+
+  /**
+   * @brief カードが挿さっていて応答するか（SD.begin() の前の安価な確認）
+   *
+   * @details
+   * M5Stack にはカード検出ピンが無いため、CMD0（GO_IDLE_STATE）を 1 回だけ送り、
+   * アイドル応答（R1 = 0x01）が返るかを見る。カードが無ければ MISO はプルアップで
+   * 0xFF のままで、1ms 未満で終わる（SD.begin() は初期化の待ちで数百 ms かかる）。
+   * 呼び出し側が SpiBusGuard を保持していること。
+   */
+  bool cardResponds(uint8_t csPin) {
+    SPI.beginTransaction(SPISettings(SPI_SD_PROBE_HZ, MSBFIRST, SPI_MODE0));
+    pinMode(csPin, OUTPUT);
+    digitalWrite(csPin, HIGH);
+    for (int i = 0; i < 10; ++i) SPI.transfer(0xFF);   // 74 クロック以上の空送り
+    digitalWrite(csPin, LOW);
+    static const uint8_t CMD0[6] = {0x40, 0x00, 0x00, 0x00, 0x00, 0x95};
+    for (uint8_t b : CMD0) SPI.transfer(b);
+    uint8_t r1 = 0xFF;
+    for (int i = 0; i < 8 && r1 == 0xFF; ++i) r1 = SPI.transfer(0xFF);   // NCR は最大 8 バイト
+    digitalWrite(csPin, HIGH);
+    SPI.transfer(0xFF);
+    SPI.endTransaction();
+    return r1 == 0x01;
+  }
+
+  // DELTA 形式の列名（tools/logconv の出力ヘッダ行）
+  const char* const DELTA_COLUMNS = "ElapsedMs,Temp_C,HI_ALARM,LO_ALARM";
+
+  // 配備時の列構成（SdLogLayout）の列名。CSV のヘッダ行と、バイナリ形式のファイルヘッダ
+  // （tools/logconv の出力ヘッダ行）。実時刻はテキストにだけ記録する（バイナリのレコードは
+  // 20B 固定のまま、RUN 開始の実時刻を "# WALLCLOCK" 行から足せば求まる）
+  char s_textColumns[LogPrealloc::SECTOR_SIZE / 2] = {0};
+  char s_binaryColumns[sizeof(BinLogHeader::columns)] = {0};
+
+  const char* layoutColumns(bool binary) {
+    if (s_textColumns[0] == '\0') {
+      SdLogLayout::formatColumns(s_textColumns, sizeof(s_textColumns));
+      SdLogLayout::formatColumns(s_binaryColumns, sizeof(s_binaryColumns), true);
+    }
+    return binary ? s_binaryColumns : s_textColumns;
+  }
+}
 
 // ================================ 実装部分 ====================================
 
@@ -17,8 +284,15 @@ bool SDManager::init() {
   // ⚠️ 重要: M5Stack の SD カード CS は GPIO 4 (TFCARD_CS_PIN)。
   // SD.begin() を引数なしで呼ぶと ESP32 デフォルトの SS=GPIO5 が使われ、
   // MAX31855_CS(GPIO5) と衝突して温度読み取りが破損する。
-  // M5.begin() と同じ設定 (TFCARD_CS_PIN, SPI, 40MHz) を明示的に指定する。
-  if (!SD.begin(TFCARD_CS_PIN, SPI, 40000000)) {
+  // M5.begin() と同じ設定 (TFCARD_CS_PIN, SPI, 40MHz) を SpiBus の設定表から指定する。
+  const SpiDeviceConfig& bus = SpiBus::config(SpiDevice::SD);
+  // 抜かれている間の再試行で SD.begin() の待ちにバスを占有させない
+  if (!cardResponds(bus.csPin)) {
+    setError("No SD card");
+    s_sdReady = false;
+    return false;
+  }
+  if (!SD.begin(bus.csPin, SPI, bus.clockHz)) {
     setError("SD initialization failed");
     s_sdReady = false;
     Serial.printf("[SDManager] SD initialization failed\n");
@@ -51,7 +325,7 @@ bool SDManager::begin() {
 /**
  * @brief 新規 CSV ファイルの作成・オープン
  */
-bool SDManager::createNewFile(const char* filename) {
+bool SDManager::createNewFile(const char* filename, LogFormat format) {
   // SD 未初期化なら失敗
   if (!s_sdReady) {
     setError("SD not ready");
@@ -64,47 +338,94 @@ bool SDManager::createNewFile(const char* filename) {
   }
 
   // ファイルを書き込みモードで作成
-  s_currentFile = SD.open(filename, FILE_WRITE);
+  s_currentFile = timedOpen(filename, FILE_WRITE);
   
   if (!s_currentFile) {
     Serial.printf("[SDManager] Failed to create file: %s\n", filename);
     setError("Cannot create file");
     return false;
   }
+  SpiBus::yield();   // 以降もファイル 1 つの作成・確保 1 段ごとにセンサー読取を先に通す
 
   s_fileOpen = true;
-  Serial.printf("[SDManager] File created: %s\n", filename);
+  s_format   = format;
+  s_sink.file = &s_currentFile;
+  s_writer.reset(millis());
+  s_block.reset(0);
+  s_delta.reset(0);
+  s_deltaSyncMs     = millis();
+  s_deltaTailOnDisk = false;
+  s_recordSeq       = 0;
+  s_lastCkptMs      = 0;
+  s_blocksSinceCkpt = 0;
+  snprintf(s_path, sizeof(s_path), "%s%s", SD_MOUNT_POINT, filename);
+
+  // 想定 RUN 長ぶんを先に確保し、RUN 中の write() で FAT の割り当てを起こさない。
+  // 失敗しても記録は続ける（従来どおり書き込み時に割り当て）
+  s_allocated  = 0;
+  s_validBytes = 0;
+  s_allocChunk = LogPrealloc::planBytes(preallocRate(format), SD_PREALLOC_SECONDS,
+                                        SD_PREALLOC_UNIT_BYTES);
+  if (!preallocate(s_allocChunk)) {
+    Serial.printf("[SDManager] Preallocation failed, growing on demand\n");
+    s_allocChunk = 0;
+  }
+  static const char* const names[] = {"csv", "binary", "delta"};
+  Serial.printf("[SDManager] File created: %s (%s)\n", filename,
+                names[static_cast<uint8_t>(format)]);
 
+  openRollups(filename);
+  openIndex(filename);
+  SpiBus::yield();
   return true;
 }
 
 /**
- * @brief CSV ヘッダ行の書き込み
+ * @brief ヘッダの書き込み
  */
-bool SDManager::writeHeader() {
+bool SDManager::writeHeader(float hiThreshold, float loThreshold) {
   if (!s_fileOpen) {
     setError("File not open");
     return false;
   }
 
-  // ヘッダ行フォーマット
-  const char* header = "ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,HI_ALARM,LO_ALARM\r\n";
-  
-  // ファイルへ書き込み
-  size_t written = s_currentFile.write((uint8_t*)header, strlen(header));
-  
-  if (written != strlen(header)) {
-    Serial.printf("[SDManager] Header write failed: wrote %d of %d bytes\n", 
-                  written, strlen(header));
+  bool   ok;
+  size_t len;
+  if (s_format != LogFormat::CSV) {
+    // 自己記述ヘッダ（512B = 1 セクタ、CRC 付き）
+    const bool delta = (s_format == LogFormat::DELTA);
+    BinLogHeader h;
+    memset(&h, 0, sizeof(h));
+    h.schemaVersion   = BinaryLog::SCHEMA_VERSION;
+    h.samplePeriodMs  = TC_READ_INTERVAL_MS;   // 行は新しいセンサ値ごと（デッドバンド時は間引き）
+    h.hiThresholdDeci = BinaryLog::toDeci(hiThreshold);
+    h.loThresholdDeci = BinaryLog::toDeci(loThreshold);
+    snprintf(h.firmware, sizeof(h.firmware), "%s %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
+    strncpy(h.columns, delta ? DELTA_COLUMNS : layoutColumns(true), sizeof(h.columns) - 1);
+    h.encoding        = delta ? BinaryLog::ENCODING_DELTA : BinaryLog::ENCODING_RECORDS;
+    h.quantumMilliC   = delta ? SD_DELTA_QUANTUM_MILLIC : 100;
+    h.validBytes      = BinaryLog::HEADER_SIZE;
+
+    s_binHeader = h;
+    BinaryLog::encodeHeader(h, s_headerSector);
+    ok = true;
+  } else {
+    // ヘッダ行 + 有効長マーカー行で先頭セクタを 512B ちょうどに埋める
+    ok = LogPrealloc::formatCsvHeaderSector(layoutColumns(false), LogPrealloc::SECTOR_SIZE, false,
+                                            s_headerSector);
+  }
+  // ヘッダは即時同期して確実に保存（ファイル先頭 = セクタ境界から書く）
+  len = sizeof(s_headerSector);
+  ok  = ok && s_writer.append(s_headerSector, len) && s_writer.sync(millis());
+  s_validBytes = ok ? static_cast<uint32_t>(len) : 0;
+
+  if (!ok) {
+    Serial.printf("[SDManager] Header write failed\n");
     setError("Header write failed");
     return false;
   }
 
-  Serial.printf("[SDManager] Header written (%d bytes)\n", written);
-
-  // ヘッダは即時フラッシュして確実に保存
-  s_currentFile.flush();
-  Serial.printf("[SDManager] Header flushed to card\n");
+  Serial.printf("[SDManager] Header written (%d bytes)\n", (int)len);
 
   return true;
 }
@@ -113,30 +434,117 @@ bool SDManager::writeHeader() {
  * @brief CSV データ行の書き込み
  */
 bool SDManager::writeData(const SDData& data) {
+  PROFILE_ZONE("SD.writeData");
   if (!s_fileOpen) {
     setError("File not open");
     return false;
   }
 
-  // CSV フォーマット生成
+  if (s_format == LogFormat::DELTA) {
+    bool ok;
+    {
+      PROFILE_ZONE("SD.write");
+      ok = appendDeltaSample(data);
+      if (ok) {
+        // ブロックの最初のサンプル = 同期点（ブロックは次に書く位置に置かれる）
+        if (s_delta.count() == 1) indexRecord(s_recordSeq, data.elapsedMs, s_writer.size());
+        s_recordSeq++;
+        s_lastData = data;
+      }
+      ok = ok && s_writer.service(millis()) && syncDeltaTail(millis()) && updateValidLength();
+    }
+    if (!ok) {
+      Serial.printf("[SDManager] Data write failed (delta block %lu)\n",
+                    (unsigned long)s_delta.seq());
+      setError("Data write failed");
+      return false;
+    }
+    return true;
+  }
+
+  if (s_format == LogFormat::BINARY) {
+    // 固定長レコード → ブロックへ詰め、満杯のブロック（= 1 セクタ）だけを追記
+    BinLogRecord rec;
+    toBinaryRecord(data, rec);
+    bool ok;
+    {
+      PROFILE_ZONE("SD.write");
+      if (s_block.count() == 0) indexRecord(s_recordSeq, data.elapsedMs, s_writer.size());
+      const bool full = s_block.add(rec);
+      s_recordSeq++;
+      ok = (!full ||
+            (s_writer.append(s_block.seal(), BinaryLog::BLOCK_SIZE) && afterDataBlock(data))) &&
+           s_writer.service(millis()) && updateValidLength();
+    }
+    if (!ok) {
+      Serial.printf("[SDManager] Data write failed (binary block %lu)\n",
+                    (unsigned long)s_block.seq());
+      setError("Data write failed");
+      return false;
+    }
+    return true;
+  }
+
+  // CSV フォーマット生成 → セクタバッファへ追記（通常は RAM コピーのみ）
   const char* csvLine = formatCSVLine(data);
-  
-  // ファイルへ書き込み
-  size_t written = s_currentFile.write((uint8_t*)csvLine, strlen(csvLine));
-  
-  if (written != strlen(csvLine)) {
-    Serial.printf("[SDManager] Data write failed: wrote %d of %d bytes\n", 
-                  written, strlen(csvLine));
+  bool ok;
+  {
+    PROFILE_ZONE("SD.write");
+    const uint32_t rowOffset = s_writer.size();
+    ok = s_writer.append(csvLine, strlen(csvLine));
+    if (ok) indexRecord(s_recordSeq++, data.elapsedMs, rowOffset);
+    // 一定間隔でチェックポイント行（通常の行と同じくセクタバッファへ）
+    if (ok && data.elapsedMs - s_lastCkptMs >= SD_CHECKPOINT_INTERVAL_MS) {
+      char line[LogRecovery::MAX_LINE];
+      ok = s_writer.append(line, formatCheckpoint(data, line, sizeof(line)));
+      s_lastCkptMs = data.elapsedMs;
+    }
+    ok = ok && s_writer.service(millis()) && updateValidLength();
+  }
+
+  if (!ok) {
+    Serial.printf("[SDManager] Data write failed: %s", csvLine);
     setError("Data write failed");
     return false;
   }
+  return true;
+}
 
-  // 成功時は即時フラッシュしてログ出力
-  s_currentFile.flush();
-    // SD書き込み後にSPIバスをリセット
-    SPI.end();
-    SPI.begin();
-  Serial.printf("[SDManager] Data written (%d bytes): %s", written, csvLine);
+/**
+ * @brief フッタ（コメント行）の書き込み
+ */
+bool SDManager::writeFooter(const char* text) {
+  if (!s_fileOpen) {
+    setError("File not open");
+    return false;
+  }
+  if (text == nullptr) {
+    return true;
+  }
+
+  const size_t len = strlen(text);
+  bool ok;
+  if (s_format != LogFormat::CSV) {
+    // 途中の DATA / DELTA ブロックを先に出して順序を保ち、テキストは TEXT ブロックへ分割
+    ok = flushBinaryBlock();
+    alignas(4) uint8_t block[BinaryLog::BLOCK_SIZE];
+    for (size_t off = 0; ok && off < len; off += BinaryLog::PAYLOAD_SIZE) {
+      size_t n = len - off;
+      if (n > BinaryLog::PAYLOAD_SIZE) n = BinaryLog::PAYLOAD_SIZE;
+      const uint32_t seq = nextBlockSeq();
+      BinaryLog::encodeTextBlock(text + off, n, seq, block);
+      ok = s_writer.append(block, sizeof(block));
+    }
+  } else {
+    ok = s_writer.append(text, len);
+  }
+  if (!ok) {
+    Serial.printf("[SDManager] Footer write failed (%d bytes)\n", (int)len);
+    setError("Footer write failed");
+    return false;
+  }
+
+  Serial.printf("[SDManager] Footer written (%d bytes)\n", (int)len);
   return true;
 }
 
@@ -144,34 +552,71 @@ bool SDManager::writeData(const SDData& data) {
  * @brief 内部バッファを SD カードへフラッシュ
  */
 bool SDManager::flush() {
+  PROFILE_ZONE("SD.flush");
   if (!s_fileOpen) {
     // ファイルが開いていなければ OK（何もしない）
     return true;
   }
 
-  // SD カードバッファをフラッシュ
-  s_currentFile.flush();
+  // セクタバッファの残りを書き出してカードへ同期
+  if (!flushBinaryBlock() || !s_writer.sync(millis()) || !updateValidLength()) {
+    setError("Flush failed");
+    return false;
+  }
+  serviceRollups(true);
+  if (s_indexOpen && !s_indexWriter.sync(millis())) closeIndex(false);
 
-  Serial.printf("[SDManager] Buffer flushed\n");
+  const SectorWriter<FileSink>::Stats& st = s_writer.stats();
+  Serial.printf("[SDManager] Buffer flushed (%lu bytes, sectors=%lu tails=%lu syncs=%lu stalls=%lu)\n",
+                (unsigned long)s_writer.size(), (unsigned long)st.sectorWrites,
+                (unsigned long)st.tailWrites, (unsigned long)st.syncs,
+                (unsigned long)st.stalls);
 
   return true;
 }
 
+/**
+ * @brief 書き出し待ちセクタの書き出しと時間条件の同期
+ */
+bool SDManager::poll() {
+  if (!s_fileOpen) return true;
+  if (!s_writer.service(millis()) || !syncDeltaTail(millis()) || !updateValidLength()) {
+    setError("Sync failed");
+    return false;
+  }
+  serviceRollups(false);
+  if (s_indexOpen && !s_indexWriter.service(millis())) closeIndex(false);
+  serviceRaw();
+  return true;
+}
+
 /**
  * @brief 開いているファイルをクローズ
  */
 bool SDManager::closeFile() {
+  PROFILE_ZONE("SD.closeFile");
   if (!s_fileOpen) {
     // ファイルが開いていなければ OK
     return true;
   }
 
-  // flush() してからクローズ
-  flush();
-  s_currentFile.close();
+  // flush() → クローズ済みを記録 → クローズ → 事前確保した未使用領域を切り詰め
+  const bool flushed = flush() && writeHeaderSector(s_validBytes, true);
+  timedClose(s_currentFile);
   s_fileOpen = false;
+  closeRollups();
+  closeIndex(flushed);
 
-  Serial.printf("[SDManager] File closed\n");
+  if (flushed && s_allocated > s_validBytes) {
+    if (truncate(s_path, s_validBytes) != 0) {
+      // 有効長マーカーは記録済みのため、読み出し側は終端を判別できる
+      Serial.printf("[SDManager] Truncate failed: %s (%lu bytes valid)\n", s_path,
+                    (unsigned long)s_validBytes);
+    }
+  }
+  s_allocated = 0;
+
+  Serial.printf("[SDManager] File closed (%lu bytes)\n", (unsigned long)s_validBytes);
 
   return true;
 }
@@ -211,6 +656,208 @@ const char* SDManager::getLastError() {
   return s_lastError;
 }
 
+/**
+ * @brief 時刻索引から経過時間に対応する同期点を引く
+ */
+bool SDManager::seekIndex(const char* logPath, uint32_t elapsedMs, LogIndexEntry& out) {
+  char idxPath[SD_MAX_FILENAME];
+  indexPathFor(logPath, idxPath, sizeof(idxPath));
+  File     idx;
+  uint32_t idxSize = 0;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    idx = SD.open(idxPath, FILE_READ);
+    if (idx) idxSize = idx.size();
+  }
+  if (!idx) return false;
+
+  RecoverySource src = {&idx};
+  uint8_t        head[LogIndex::HEADER_SIZE];
+  LogIndexHeader h;
+  uint32_t       index = 0;
+  const bool found = src.read(0, head, sizeof(head)) == sizeof(head) &&
+                     LogIndex::decodeHeader(head, h) &&
+                     LogIndex::lookup(src, LogIndex::entryCount(h, idxSize), elapsedMs, false,
+                                      out, index);
+  SpiBusGuard bus(SpiDevice::SD);
+  idx.close();
+  return found;
+}
+
+/**
+ * @brief 目録の末尾から次の RUN 番号を求める
+ */
+uint32_t SDManager::loadCatalog() {
+  RunCatalogEntry last;
+  if (lastCatalogEntry(last)) return last.runId + 1;
+
+  // 目録が無い（または全て破損）: 既存ログの続き番号を O(log n) 回の存在確認で探す
+  SpiBusGuard bus(SpiDevice::SD);
+  if (!legacyRunExists(0)) return 0;
+  uint32_t lo = 0;   // 存在する
+  uint32_t hi = 1;   // 存在しない番号まで倍々に広げる
+  while (hi < SD_CATALOG_MAX_RUN_ID && legacyRunExists(hi)) {
+    lo = hi;
+    hi *= 2;
+  }
+  while (hi - lo > 1) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (legacyRunExists(mid)) lo = mid;
+    else                      hi = mid;
+  }
+  Serial.printf("[SDManager] no run catalog, continuing after existing run %lu\n",
+                (unsigned long)lo);
+  return lo + 1;
+}
+
+/**
+ * @brief カードの性能プロファイルを得て同期方針に反映
+ */
+void SDManager::profileCard(Print& out) {
+  if (!s_sdReady || SD_PROFILE_MODE == CardProfileMode::OFF) return;
+
+  CardProfile profile;
+  uint8_t     rec[CardProfile::RECORD_SIZE];
+  uint8_t     type;
+  uint32_t    sectors;
+  bool        cached = false;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    type    = static_cast<uint8_t>(SD.cardType());
+    sectors = static_cast<uint32_t>(SD.cardSize() / 512ULL);
+    if (SD_PROFILE_MODE == CardProfileMode::CACHED) {
+      File f = SD.open(SD_PROFILE_FILE, FILE_READ);
+      if (f) {
+        cached = f.read(rec, sizeof(rec)) == sizeof(rec) && profile.decode(rec) &&
+                 profile.matches(type, sectors);
+        f.close();
+      }
+    }
+  }
+
+  if (!cached) {
+    out.println("[SDManager] measuring card (first mount of this card)...");
+    if (!SDBenchmark::profileCard(out, profile)) return;   // 既定の方針のまま
+    profile.cardType = type;
+    profile.sectors  = sectors;
+    const CardProfile::Limits limits = {
+        SD_SYNC_BYTES_MIN,       SD_SYNC_BYTES_MAX,        SD_SYNC_INTERVAL_MIN_MS,
+        SD_SYNC_INTERVAL_MAX_MS, SD_SYNC_INTERVAL_MS,      SD_PROFILE_THROUGHPUT_PCT,
+        SD_PROFILE_SYNC_DUTY_DIV, SD_PROFILE_BAD_LATENCY_US, SD_PROFILE_MIN_WRITE_KBPS};
+    profile.tune(limits);
+
+    char line[192];
+    profile.encode(rec);
+    profile.formatLogLine(millis(), line, sizeof(line));
+    SpiBusGuard bus(SpiDevice::SD);
+    File f = SD.open(SD_PROFILE_FILE, FILE_WRITE);
+    if (!f || f.write(rec, sizeof(rec)) != sizeof(rec)) {
+      Serial.printf("[SDManager] cannot save %s\n", SD_PROFILE_FILE);
+    }
+    if (f) f.close();
+    File log = SD.open(SD_PROFILE_LOG_FILE, FILE_APPEND);
+    if (log) {
+      log.print(line);
+      log.close();
+    }
+  }
+
+  s_writer.setSyncPolicy(profile.syncIntervalMs, profile.syncBytes);
+
+  out.printf("[SDManager] card type=%u sectors=%lu grade=%s (%s) sync=%luB/%lums\n",
+             (unsigned)type, (unsigned long)sectors, CardProfile::gradeName(profile.grade),
+             cached ? "cached" : "measured", (unsigned long)profile.syncBytes,
+             (unsigned long)profile.syncIntervalMs);
+  char line[128];
+  for (uint8_t i = 0; i < profile.count; ++i) {
+    CardProfile::formatResult(profile.results[i], line, sizeof(line));
+    out.printf("[SDManager]   %s\n", line);
+  }
+  if (profile.grade == CardProfile::GRADE_BAD) {
+    out.println("[SDManager] WARNING: this card stalls or is too slow for logging, replace it");
+  }
+}
+
+/**
+ * @brief 生ログの同期間隔
+ */
+uint32_t SDManager::syncIntervalMs() {
+  return s_writer.syncIntervalMs();
+}
+
+/**
+ * @brief ファイル操作ごとのレイテンシを出力
+ *
+ * @details 書き込みタスクが記録中でも読む（診断用の近似値）
+ */
+void SDManager::dumpLatency(Print& out) {
+  char line[112];
+  for (size_t i = 0; i < SdLatency::OPS; ++i) {
+    s_latency.formatLine(static_cast<SdOp>(i), line, sizeof(line));
+    out.printf("[SDLAT] %s\n", line);
+  }
+}
+
+/**
+ * @brief レイテンシ統計のリセットを依頼
+ */
+void SDManager::requestLatencyReset() {
+  s_latencyResetRequested.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief 目録へ 1 レコード追記
+ */
+bool SDManager::appendCatalog(const RunCatalogEntry& entry) {
+  SpiBusGuard bus(SpiDevice::SD);
+  if (!s_sdReady) return false;
+  File cat = SD.exists(SD_CATALOG_FILE) ? timedOpen(SD_CATALOG_FILE, "r+")
+                                        : timedOpen(SD_CATALOG_FILE, FILE_WRITE);
+  if (!cat) return false;
+  uint8_t rec[RunCatalog::RECORD_SIZE];
+  RunCatalog::encode(entry, rec);
+  const bool ok = cat.seek(RunCatalog::appendOffset(cat.size())) &&
+                  cat.write(rec, sizeof(rec)) == sizeof(rec);
+  timedClose(cat);
+  return ok;
+}
+
+/**
+ * @brief 目録の末尾 count 件を出力
+ */
+void SDManager::listRuns(Print& out, uint32_t count) {
+  File     cat;
+  uint32_t size = 0;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    cat = SD.open(SD_CATALOG_FILE, FILE_READ);
+    if (cat) size = cat.size();
+  }
+  if (!cat) {
+    out.println("[RUNS] no catalog");
+    return;
+  }
+  RecoverySource src = {&cat};
+  const uint32_t total = RunCatalog::appendOffset(size) / RunCatalog::RECORD_SIZE;
+  const uint32_t first = (total > count) ? total - count : 0;
+  out.printf("[RUNS] %lu records, showing %lu\n", (unsigned long)total,
+             (unsigned long)(total - first));
+  for (uint32_t i = first; i < total; ++i) {
+    uint8_t         rec[RunCatalog::RECORD_SIZE];
+    RunCatalogEntry e;
+    char            line[160];
+    if (src.read(i * RunCatalog::RECORD_SIZE, rec, sizeof(rec)) != sizeof(rec) ||
+        !RunCatalog::decode(rec, e)) {
+      out.printf("[RUNS] record %lu corrupt\n", (unsigned long)i);
+      continue;
+    }
+    RunCatalog::formatLine(e, line, sizeof(line));
+    out.print(line);
+  }
+  SpiBusGuard bus(SpiDevice::SD);
+  cat.close();
+}
+
 // ================================ 内部メソッド ====================================
 
 /**
@@ -233,54 +880,869 @@ void SDManager::setError(const char* message) {
  * @brief 内部バッファから CSV 行フォーマットを生成
  * 
  * @details
- * SDData 構造体を CSV フォーマットに変換します。
+ * SDData 構造体を、配備時の列構成（SdLogLayout、LogSchema.h）の CSV 行に変換します。
  * 浮動小数点数は小数第1位（%.1f）で出力します。
  * 
- * フォーマット例：
- * 0,540.2,RUN,1,540.2,0.0,540.2,540.2,false,false\r\n
+ * フォーマット例（FullLogLayout）：
+ * 0,540.2,RUN,1,540.2,0.0,540.2,540.2,false,false,0,2026-10-19T12:34:56.789\r\n
+ * 実時刻が不明（RTC 無し・未設定）なら WallTime 列は空。
  */
 const char* SDManager::formatCSVLine(const SDData& data) {
-  // アラーム状態を文字列に変換
-  const char* hiAlarmStr = data.hiAlarm ? "true" : "false";
-  const char* loAlarmStr = data.loAlarm ? "true" : "false";
-
-  // CSV 行を生成
-  // NaN 値は 0.0 としてしまうと不正なデータに見えるため、
-  // テキスト 'NaN' を出力して後処理で判別しやすくする。
-  const char* tempStr = isnan(data.temperature) ? "NaN" : nullptr;
-  const char* avgStr  = isnan(data.averageTemp) ? "NaN" : nullptr;
-  const char* sdStr   = isnan(data.stdDev) ? "NaN" : nullptr;
-  const char* maxStr  = isnan(data.maxTemp) ? "NaN" : nullptr;
-  const char* minStr  = isnan(data.minTemp) ? "NaN" : nullptr;
-
-  if (tempStr) {
-    snprintf(s_lineBuffer, sizeof(s_lineBuffer),
-             "%u,%s,%s,%u,%s,%s,%s,%s,%s,%s\r\n",
-             data.elapsedSeconds,
-             tempStr,
-             data.state,
-             data.sampleCount,
-             avgStr ? avgStr : "NaN",
-             sdStr  ? sdStr  : "NaN",
-             maxStr ? maxStr : "NaN",
-             minStr ? minStr : "NaN",
-             hiAlarmStr,
-             loAlarmStr);
+  PROFILE_ZONE("SD.formatCSVLine");
+  // 列ごとの FixedFormat 呼び出しをコンパイル時に並べたもの（%f の printf は 1 行あたりの
+  // 処理時間の大半を占めていた）。NaN の扱いは LogColumnTraits を参照
+  static_assert(SdLogLayout::MAX_ROW <= sizeof(s_lineBuffer),
+                "s_lineBuffer cannot hold the longest SdLogLayout row");
+  SdLogLayout::formatRow(data, s_lineBuffer);
+  return s_lineBuffer;
+}
+
+/**
+ * @brief SDData からバイナリレコードを生成
+ *
+ * @details
+ * 温度は 0.1°C 整数（formatCSVLine() の %.1f と同じ丸め）、状態は
+ * enum class State の数値、アラームはビットフラグに詰めます。
+ * NaN の扱い（温度 NaN なら全統計列 NaN 等）は変換側で CSV と同じ規則を再現します。
+ */
+void SDManager::toBinaryRecord(const SDData& data, BinLogRecord& rec) {
+  PROFILE_ZONE("SD.toBinaryRecord");
+  rec.elapsedMs      = data.elapsedMs;
+  rec.sampleCount    = saturate32(data.sampleCount);
+  rec.temperature    = BinaryLog::toDeci(data.temperature);
+  rec.average        = BinaryLog::toDeci(data.averageTemp);
+  rec.stdDev         = BinaryLog::toDeci(data.stdDev);
+  rec.maxTemp        = BinaryLog::toDeci(data.maxTemp);
+  rec.minTemp        = BinaryLog::toDeci(data.minTemp);
+  rec.state          = BinaryLog::stateCode(data.state);
+  rec.flags          = (data.hiAlarm ? BinaryLog::FLAG_HI_ALARM : 0) |
+                       (data.loAlarm ? BinaryLog::FLAG_LO_ALARM : 0);
+}
+
+/**
+ * @brief 途中までの DATA ブロックを書き出す（バイナリ形式のみ）
+ */
+bool SDManager::flushBinaryBlock() {
+  if (s_format == LogFormat::DELTA) {
+    if (s_delta.empty()) return true;
+    s_deltaTailOnDisk = false;   // 同じ位置へ完成ブロックとして書かれる
+    return s_writer.append(s_delta.seal(), BinaryLog::BLOCK_SIZE);
+  }
+  if (s_format != LogFormat::BINARY || s_block.empty()) return true;
+  return s_writer.append(s_block.seal(), BinaryLog::BLOCK_SIZE);
+}
+
+/**
+ * @brief 次の TEXT ブロックの番号を払い出す（組み立て中ブロックは空であること）
+ */
+uint32_t SDManager::nextBlockSeq() {
+  const uint32_t seq = (s_format == LogFormat::DELTA) ? s_delta.seq() : s_block.seq();
+  s_block.reset(seq + 1);
+  s_delta.reset(seq + 1);
+  return seq;
+}
+
+/**
+ * @brief DELTA 形式: 1 サンプルを差分符号化ブロックへ追加
+ *
+ * @details
+ * 値は SD_DELTA_QUANTUM_MILLIC 単位に量子化（NaN は INT32_MIN）、フラグは
+ * bit0 = HI_ALARM / bit1 = LO_ALARM。ブロックが満杯なら書き出して次のブロックへ。
+ */
+bool SDManager::appendDeltaSample(const SDData& data) {
+  const int32_t q = isnan(data.temperature)
+      ? INT32_MIN
+      : static_cast<int32_t>(lroundf(data.temperature * 1000.0f / SD_DELTA_QUANTUM_MILLIC));
+  const uint8_t flags = (data.hiAlarm ? BinaryLog::FLAG_HI_ALARM : 0) |
+                        (data.loAlarm ? BinaryLog::FLAG_LO_ALARM : 0);
+  if (s_delta.add(data.elapsedMs, q, flags)) return true;
+
+  // 満杯: 完成したブロックを追記し、新しいブロックの先頭に入れ直す
+  if (!s_writer.append(s_delta.seal(), BinaryLog::BLOCK_SIZE)) return false;
+  s_deltaSyncMs     = millis();
+  s_deltaTailOnDisk = false;
+  // チェックポイントはファイルに入っている最後のサンプル（= 前回の data）の統計
+  if (!afterDataBlock(s_lastData)) return false;
+  return s_delta.add(data.elapsedMs, q, flags);
+}
+
+/**
+ * @brief DELTA 形式: 途中のブロックを同期間隔ごとに同じオフセットへ書き直す
+ *
+ * @details
+ * 1 ブロックに数百サンプル以上入るため、満杯まで RAM に置くと電源断で
+ * 長時間分を失う。同期間隔（syncIntervalMs()）ごとに途中の内容を CRC 付きの完全な
+ * ブロックとして「次に書くブロックの位置」（= セクタ境界）へ書き、flush する。
+ * 満杯になったブロックは同じ位置へ上書きされる。
+ */
+bool SDManager::syncDeltaTail(uint32_t nowMs) {
+  if (s_format != LogFormat::DELTA || s_delta.empty()) return true;
+  if (nowMs - s_deltaSyncMs < s_writer.syncIntervalMs()) return true;
+  if (!s_writer.sync(nowMs)) return false;   // 書き出し待ちの完成ブロックを先に
+  if (!s_currentFile.seek(s_writer.size())) return false;
+  if (s_currentFile.write(s_delta.snapshot(), BinaryLog::BLOCK_SIZE) != BinaryLog::BLOCK_SIZE) {
+    return false;
+  }
+  timedFlush(s_currentFile);
+  s_deltaSyncMs     = nowMs;
+  s_deltaTailOnDisk = true;
+  return true;
+}
+
+/**
+ * @brief 形式ごとの書き込みレート見積り [bytes/s]（事前確保サイズの計画用）
+ *
+ * @details
+ * CSV は 1 行 80B（ElapsedMs 列込み）、BINARY は 1 レコード 20B + ブロックヘッダ分（512 / 25）、
+ * DELTA は 1 サンプル 4B（実測 1.2B 程度に対して余裕を持たせる）。
+ */
+uint32_t SDManager::preallocRate(LogFormat format) {
+  // 行もサンプルも新しいセンサ値ごと（デッドバンド時はこれより少ない）
+  const uint32_t rowsPerSec    = 1000UL / TC_READ_INTERVAL_MS;
+  const uint32_t samplesPerSec = rowsPerSec;
+  switch (format) {
+    case LogFormat::BINARY:
+      return rowsPerSec * (BinaryLog::BLOCK_SIZE + BinaryLog::RECORDS_PER_BLOCK - 1) /
+             BinaryLog::RECORDS_PER_BLOCK;
+    case LogFormat::DELTA:
+      return samplesPerSec * 4;
+    case LogFormat::CSV:
+    default:
+      return rowsPerSec * 80;
+  }
+}
+
+/**
+ * @brief ファイルを bytes まで伸ばしてクラスタを確保する
+ *
+ * @details
+ * Arduino の File / ESP-IDF の VFS からは FatFs の f_expand()（連続領域の
+ * 一括確保）を呼べないため、書き込みモードで末尾を越えて seek し 1 バイト
+ * 書くことで、FatFs にクラスタチェーンをまとめて伸ばさせる。FatFs は前回
+ * 割り当て位置から空きを順に探すため、空きが連続していれば連続領域になる。
+ * 伸ばした領域の内容は不定（有効長マーカーで区別する）。
+ *
+ * 1 回の seek で伸ばすと FAT の連鎖（想定 RUN 長ぶん、数百 KB）を書き終えるまで
+ * バスを譲れないため、SD_PREALLOC_STEP_BYTES ずつ伸ばし、段の境目で
+ * SpiBus::yield() する。途中で失敗したら伸ばせた所までを確保済みとする。
+ */
+bool SDManager::preallocate(uint32_t bytes) {
+  PROFILE_ZONE("SD.preallocate");
+  if (bytes <= s_allocated) return true;
+  const uint8_t zero = 0;
+  while (s_allocated < bytes) {
+    const uint32_t next = (bytes - s_allocated > SD_PREALLOC_STEP_BYTES)
+                        ? s_allocated + SD_PREALLOC_STEP_BYTES : bytes;
+    if (!s_currentFile.seek(next - 1) || s_currentFile.write(&zero, 1) != 1) {
+      return false;
+    }
+    s_allocated = next;
+    SpiBus::yield();
+  }
+  timedFlush(s_currentFile);
+  Serial.printf("[SDManager] Preallocated %lu bytes\n", (unsigned long)bytes);
+  return true;
+}
+
+/**
+ * @brief 同期済みのデータ長を先頭セクタの有効長マーカーへ反映
+ *
+ * @details
+ * 未同期のデータが残っている間は据え置く（マーカーが実データより先に
+ * 進むことは無い）。データの flush の後にヘッダを書き直して flush する。
+ * 確保済み領域の残りが SD_PREALLOC_MARGIN_BYTES を切ったら、想定より長い RUN
+ * として次の想定 RUN 長ぶんを追加確保する（割り当てはこの 1 回に集約される）。
+ */
+bool SDManager::updateValidLength() {
+  if (s_validBytes == 0 || s_writer.unsyncedBytes() != 0) return true;
+  const uint32_t valid =
+      s_writer.size() + (s_deltaTailOnDisk ? static_cast<uint32_t>(BinaryLog::BLOCK_SIZE) : 0);
+  if (valid == s_validBytes) return true;
+  if (!writeHeaderSector(valid, false)) return false;
+
+  if (s_allocChunk > 0 &&
+      LogPrealloc::needsExtension(valid, s_allocated, SD_PREALLOC_MARGIN_BYTES) &&
+      !preallocate(s_allocated + s_allocChunk)) {
+    Serial.printf("[SDManager] Preallocation extend failed, growing on demand\n");
+    s_allocChunk = 0;
+  }
+  return true;
+}
+
+/**
+ * @brief 先頭セクタ（有効長マーカー・クローズ済みフラグ）を書き直して flush
+ */
+bool SDManager::writeHeaderSector(uint32_t validBytes, bool closed) {
+  if (s_validBytes == 0) return true;   // ヘッダ未書き込み
+  if (s_format == LogFormat::CSV) {
+    LogPrealloc::formatCsvHeaderSector(layoutColumns(false), validBytes, closed, s_headerSector);
   } else {
-    // 温度が数値なら他も数値フォーマットで出力（小数第1位）
-    snprintf(s_lineBuffer, sizeof(s_lineBuffer),
-             "%u,%.1f,%s,%u,%.1f,%.1f,%.1f,%.1f,%s,%s\r\n",
-             data.elapsedSeconds,
-             data.temperature,
-             data.state,
-             data.sampleCount,
-             isnan(data.averageTemp) ? 0.0f : data.averageTemp,
-             isnan(data.stdDev) ? 0.0f : data.stdDev,
-             isnan(data.maxTemp) ? 0.0f : data.maxTemp,
-             isnan(data.minTemp) ? 0.0f : data.minTemp,
-             hiAlarmStr,
-             loAlarmStr);
+    s_binHeader.validBytes = validBytes;
+    s_binHeader.closed     = closed ? 1 : 0;
+    BinaryLog::encodeHeader(s_binHeader, s_headerSector);
   }
+  if (!s_currentFile.seek(0) ||
+      s_currentFile.write(s_headerSector, sizeof(s_headerSector)) != sizeof(s_headerSector)) {
+    return false;
+  }
+  timedFlush(s_currentFile);
+  s_validBytes = validBytes;
+  return true;
+}
 
-  return s_lineBuffer;
+/**
+ * @brief チェックポイント行を整形（seq = 記録済みレコード数、統計は data の累積値）
+ */
+size_t SDManager::formatCheckpoint(const SDData& data, char* buf, size_t len) {
+  LogCheckpoint c;
+  c.seq       = s_recordSeq;
+  c.elapsedMs = data.elapsedMs;
+  c.samples   = saturate32(data.sampleCount);
+  c.average   = data.averageTemp;
+  c.stdDev    = data.stdDev;
+  c.maxTemp   = data.maxTemp;
+  c.minTemp   = data.minTemp;
+  return LogRecovery::formatCheckpoint("CKPT", c, buf, len);
+}
+
+/**
+ * @brief BINARY / DELTA: データブロックを追記した直後の処理
+ *
+ * @details
+ * SD_CHECKPOINT_BLOCKS 個ごとにチェックポイントを TEXT ブロックで追記する。
+ * 組み立て中のブロックが空（封をした直後）のときだけ呼ぶこと。
+ *
+ * @param last ファイルに入っている最後のレコードの元データ
+ */
+bool SDManager::afterDataBlock(const SDData& last) {
+  if (++s_blocksSinceCkpt < SD_CHECKPOINT_BLOCKS) return true;
+  s_blocksSinceCkpt = 0;
+  char line[LogRecovery::MAX_LINE];
+  const size_t n = formatCheckpoint(last, line, sizeof(line));
+  alignas(4) uint8_t block[BinaryLog::BLOCK_SIZE];
+  BinaryLog::encodeTextBlock(line, n, nextBlockSeq(), block);
+  return s_writer.append(block, sizeof(block));
+}
+
+/**
+ * @brief 閉じられなかったログの復旧（起動時）
+ */
+int SDManager::recoverUnclosed() {
+  if (!s_sdReady || s_fileOpen) return 0;
+
+  // 終了できなかった RUN は目録の末尾の END の無い START だけ（それより前の RUN は
+  // 次の RUN を開始する前に閉じている）。ディレクトリは走査しない
+  RunCatalogEntry last;
+  if (!lastCatalogEntry(last) || last.kind != RunCatalog::START) return 0;
+  last.fileName[sizeof(last.fileName) - 1] = '\0';
+
+  // ソークでは区間（DATA_xxxx_s001.csv ...）が連番で続き、生データは区間ごとに並ぶ。
+  // 集約ログ・索引・アラームスナップショットは有効長マーカーを持たないため対象外
+  int recovered = 0;
+  for (uint16_t index = 0; index <= SoakLog::MAX_SEGMENTS; ++index) {
+    char log[SD_MAX_FILENAME];
+    char raw[SD_MAX_FILENAME];
+    SoakLog::segmentName(last.fileName, index, log, sizeof(log));
+    bool exists;
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      exists = SD.exists(log);
+    }
+    if (!exists) break;
+    if (recoverFile(log)) ++recovered;
+    // 生データ（DATA_xxxx_raw.bin）は DELTA と同じ形式のため生ログと同様に復旧する
+    rawPathFor(log, raw, sizeof(raw));
+    bool hasRaw;
+    {
+      SpiBusGuard bus(SpiDevice::SD);
+      hasRaw = SD.exists(raw);
+    }
+    if (hasRaw && recoverFile(raw)) ++recovered;
+  }
+  return recovered;
+}
+
+/**
+ * @brief 1 ファイルの復旧
+ *
+ * @details
+ * 先頭セクタが closed=0 のファイルだけを対象に、LogRecovery で末尾
+ * SD_RECOVERY_WINDOW_BYTES を走査し、最後の完全なレコードの直後へ
+ * "# RECOVERED,..." 要約（バイナリは TEXT ブロック）を書き、
+ * 有効長・closed=1 を記録してから切り詰める。
+ * 有効長マーカーの無いファイル（事前確保前の形式）は対象外。
+ */
+bool SDManager::recoverFile(const char* path, LogRecovery::Result* result, uint32_t* newEnd) {
+  File f;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    f = SD.open(path, "r+");
+  }
+  if (!f) return false;
+
+  RecoverySource src = {&f};
+  alignas(4) uint8_t head[LogPrealloc::SECTOR_SIZE];
+  BinLogHeader h;
+  uint32_t     valid  = 0;
+  bool         closed = true;
+  const bool   binary = (src.read(0, head, sizeof(head)) == sizeof(head)) &&
+                        BinaryLog::decodeHeader(head, h);
+  if (binary) {
+    valid  = h.validBytes;
+    closed = (h.closed != 0) || valid == 0;
+  } else if (!LogPrealloc::parseCsvHeaderSector(head, valid, closed)) {
+    closed = true;
+  }
+  if (closed) {
+    SpiBusGuard bus(SpiDevice::SD);
+    f.close();
+    return false;
+  }
+
+  uint32_t fileSize;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    fileSize = f.size();
+  }
+  LogRecovery::Result r;
+  if (binary) {
+    LogRecovery::scanBinary(src, h, fileSize, SD_RECOVERY_WINDOW_BYTES,
+                            SD_RECOVERY_LOOKAHEAD_BYTES, r);
+  } else {
+    LogRecovery::scanCsv(src, LogPrealloc::SECTOR_SIZE, (valid < fileSize) ? valid : fileSize,
+                         SD_RECOVERY_WINDOW_BYTES, r);
+  }
+
+  char line[LogRecovery::MAX_LINE];
+  const size_t n = LogRecovery::formatCheckpoint("RECOVERED", r.summary, line, sizeof(line));
+  uint32_t end;
+  bool     ok;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    ok = f.seek(r.validEnd);
+    if (binary) {
+      alignas(4) uint8_t block[BinaryLog::BLOCK_SIZE];
+      BinaryLog::encodeTextBlock(line, n, r.nextBlockSeq, block);
+      ok  = ok && f.write(block, sizeof(block)) == sizeof(block);
+      end = r.validEnd + BinaryLog::BLOCK_SIZE;
+      h.validBytes = end;
+      h.closed     = 1;
+      BinaryLog::encodeHeader(h, head);
+    } else {
+      ok  = ok && f.write(reinterpret_cast<const uint8_t*>(line), n) == n;
+      end = r.validEnd + n;
+      // 列名行はそのまま、マーカー行だけを更新
+      char columns[LogPrealloc::SECTOR_SIZE];
+      size_t k = 0;
+      while (k + 1 < sizeof(head) && !(head[k] == '\r' && head[k + 1] == '\n')) {
+        columns[k] = static_cast<char>(head[k]);
+        ++k;
+      }
+      columns[k] = '\0';
+      ok = ok && LogPrealloc::formatCsvHeaderSector(columns, end, true, head);
+    }
+    ok = ok && f.seek(0) && f.write(head, sizeof(head)) == sizeof(head);
+    f.flush();
+    f.close();
+  }
+
+  char full[SD_MAX_FILENAME + 8];
+  snprintf(full, sizeof(full), "%s%s", SD_MOUNT_POINT, path);
+  if (ok && fileSize > end && truncate(full, end) != 0) {
+    Serial.printf("[SDManager] Recovery truncate failed: %s\n", full);
+  }
+  if (ok) recoverIndex(path, binary ? &h : nullptr, r.validEnd);
+  if (result != nullptr) *result = r;
+  if (newEnd != nullptr) *newEnd = end;
+  Serial.printf("[SDManager] Recovered %s: %lu records, %lu -> %lu bytes%s%s\n", path,
+                (unsigned long)r.summary.seq, (unsigned long)valid, (unsigned long)end,
+                r.haveCheckpoint ? "" : " (no checkpoint in window)",
+                ok ? "" : " [write failed]");
+  return ok;
+}
+
+/**
+ * @brief 集約ログ 1 行の書き込み
+ */
+bool SDManager::writeRollup(const RollupRow& row) {
+  PROFILE_ZONE("SD.writeRollup");
+  if (row.level >= RollupCascade::LEVELS) return false;
+  RollupFile& rf = s_rollups[row.level];
+  if (!rf.open) return false;
+  char line[96];
+  const size_t len = RollupCascade::formatCsv(row, line, sizeof(line));
+  if (!rf.writer.append(line, len) || !rf.writer.service(millis())) {
+    Serial.printf("[SDManager] Rollup write failed (level %u), level disabled\n",
+                  (unsigned)row.level);
+    timedClose(rf.file);
+    rf.open = false;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 生ログと並べて集約ログ（DATA_xxxx_1s.csv 等）を作成
+ *
+ * @details
+ * 作成に失敗した段は記録しない（生ログの記録は続ける）。
+ */
+void SDManager::openRollups(const char* filename) {
+  for (size_t i = 0; i < RollupCascade::LEVELS; ++i) {
+    RollupFile& rf = s_rollups[i];
+    char path[SD_MAX_FILENAME];
+    rollupPathFor(filename, i, path, sizeof(path));
+    rf.file = timedOpen(path, FILE_WRITE);
+    rf.open = static_cast<bool>(rf.file);
+    if (!rf.open) {
+      Serial.printf("[SDManager] Cannot create rollup file: %s\n", path);
+      continue;
+    }
+    rf.writer.reset(millis());
+    rf.writer.append(RollupCascade::csvColumns(), strlen(RollupCascade::csvColumns()));
+    rf.writer.append("\r\n", 2);
+    SpiBus::yield();
+  }
+}
+
+/**
+ * @brief 集約ログの書き出し（force = true で途中セクタも同期）
+ */
+void SDManager::serviceRollups(bool force) {
+  for (size_t i = 0; i < RollupCascade::LEVELS; ++i) {
+    RollupFile& rf = s_rollups[i];
+    if (!rf.open) continue;
+    const bool ok = force ? rf.writer.sync(millis()) : rf.writer.service(millis());
+    if (!ok) {
+      Serial.printf("[SDManager] Rollup sync failed (level %u), level disabled\n", (unsigned)i);
+      timedClose(rf.file);
+      rf.open = false;
+    }
+  }
+}
+
+/**
+ * @brief 集約ログを同期してクローズ
+ */
+void SDManager::closeRollups() {
+  serviceRollups(true);
+  for (size_t i = 0; i < RollupCascade::LEVELS; ++i) {
+    if (!s_rollups[i].open) continue;
+    timedClose(s_rollups[i].file);
+    s_rollups[i].open = false;
+  }
+}
+
+/**
+ * @brief 生データ記録（DATA_xxxx_raw.bin）の作成
+ *
+ * @details
+ * 事前確保はしない（最大でも SD_RAW_BUDGET_BYTES_PER_S 程度の伸びのため）。
+ * ヘッダの有効長は作成時の 512B のまま、closeRaw() で確定する。
+ */
+bool SDManager::openRaw(const char* filename, float hiThreshold, float loThreshold) {
+  char path[SD_MAX_FILENAME];
+  rawPathFor(filename, path, sizeof(path));
+  s_rawFile = timedOpen(path, FILE_WRITE);
+  if (!s_rawFile) {
+    Serial.printf("[SDManager] Cannot create raw capture file: %s\n", path);
+    return false;
+  }
+
+  BinLogHeader& h = s_rawHeader;
+  memset(&h, 0, sizeof(h));
+  h.schemaVersion   = BinaryLog::SCHEMA_VERSION;
+  h.samplePeriodMs  = TC_CAPTURE_INTERVAL_MS;
+  h.hiThresholdDeci = BinaryLog::toDeci(hiThreshold);
+  h.loThresholdDeci = BinaryLog::toDeci(loThreshold);
+  snprintf(h.firmware, sizeof(h.firmware), "%s %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
+  strncpy(h.columns, RawCapture::COLUMNS, sizeof(h.columns) - 1);
+  h.encoding        = BinaryLog::ENCODING_RAW;
+  h.quantumMilliC   = RawCapture::QUANTUM_MILLIC;
+  h.validBytes      = BinaryLog::HEADER_SIZE;
+  alignas(4) uint8_t head[BinaryLog::HEADER_SIZE];
+  BinaryLog::encodeHeader(h, head);
+
+  // 同期方針は生ログに合わせる（途中ブロックの書き直し間隔 = 帯域見積りの前提）
+  s_rawWriter.setSyncPolicy(s_writer.syncIntervalMs(), s_writer.syncBytes());
+  s_rawWriter.reset(millis());
+  s_rawBlock.reset(0);
+  s_rawSyncMs = millis();
+  s_rawOpen   = true;
+  if (!s_rawWriter.append(head, sizeof(head)) || !s_rawWriter.sync(millis())) {
+    stopRaw("header write");
+    return false;
+  }
+  Serial.printf("[SDManager] Raw capture file created: %s\n", path);
+  return true;
+}
+
+/**
+ * @brief 生データ 1 サンプルの追加（通常は RAM 上の符号化のみ）
+ */
+bool SDManager::writeRaw(uint32_t elapsedMs, const RawSample& sample) {
+  if (!s_rawOpen) return false;
+  if (s_rawBlock.add(elapsedMs, sample.q, sample.fault)) return true;
+
+  // 満杯: 完成したブロックを追記し、新しいブロックの先頭に入れ直す
+  if (!s_rawWriter.append(s_rawBlock.seal(), BinaryLog::BLOCK_SIZE) ||
+      !s_rawWriter.service(millis())) {
+    stopRaw("block write");
+    return false;
+  }
+  s_rawSyncMs = millis();
+  return s_rawBlock.add(elapsedMs, sample.q, sample.fault);
+}
+
+/**
+ * @brief 生データの書き出しと途中ブロックの書き直し（syncDeltaTail() と同じ方式）
+ */
+void SDManager::serviceRaw() {
+  if (!s_rawOpen) return;
+  const uint32_t now = millis();
+  bool ok = s_rawWriter.service(now);
+  if (ok && !s_rawBlock.empty() && now - s_rawSyncMs >= s_rawWriter.syncIntervalMs()) {
+    ok = s_rawWriter.sync(now) && s_rawFile.seek(s_rawWriter.size()) &&
+         s_rawSink.write(s_rawBlock.snapshot(), BinaryLog::BLOCK_SIZE) == BinaryLog::BLOCK_SIZE;
+    if (ok) timedFlush(s_rawFile);
+    s_rawSyncMs = now;
+  }
+  if (!ok) stopRaw("sync");
+}
+
+/**
+ * @brief 生データ記録を同期してクローズ
+ */
+bool SDManager::closeRaw() {
+  if (!s_rawOpen) return false;
+  s_rawOpen = false;
+  bool ok = (s_rawBlock.empty() ||
+             s_rawWriter.append(s_rawBlock.seal(), BinaryLog::BLOCK_SIZE)) &&
+            s_rawWriter.sync(millis());
+  if (ok) {
+    s_rawHeader.validBytes = s_rawWriter.size();
+    s_rawHeader.closed     = 1;
+    alignas(4) uint8_t head[BinaryLog::HEADER_SIZE];
+    BinaryLog::encodeHeader(s_rawHeader, head);
+    ok = s_rawFile.seek(0) && s_rawSink.write(head, sizeof(head)) == sizeof(head);
+    timedFlush(s_rawFile);
+  }
+  if (!ok) Serial.println("[SDManager] Raw capture close failed, left for recovery");
+  timedClose(s_rawFile);
+  Serial.printf("[SDManager] Raw capture closed (%lu bytes)\n",
+                (unsigned long)s_rawWriter.size());
+  return ok;
+}
+
+/**
+ * @brief 開いているログに書いたバイト数
+ */
+uint32_t SDManager::logBytes() {
+  return s_fileOpen ? s_writer.size() : 0;
+}
+
+/**
+ * @brief アラームスナップショットを独立した CSV として書き込み
+ */
+bool SDManager::writeSnapshot(const char* path, const char* text, size_t len) {
+  if (!s_sdReady) return false;
+  File f = timedOpen(path, FILE_WRITE);
+  if (!f) {
+    Serial.printf("[SDManager] Snapshot create failed: %s\n", path);
+    return false;
+  }
+  FileSink sink = {&f};
+  bool ok = true;
+  for (size_t off = 0; ok && off < len; off += LogPrealloc::SECTOR_SIZE) {
+    size_t n = len - off;
+    if (n > LogPrealloc::SECTOR_SIZE) n = LogPrealloc::SECTOR_SIZE;
+    ok = sink.write(reinterpret_cast<const uint8_t*>(text + off), n) == n;
+  }
+  timedClose(f);
+  if (!ok) Serial.printf("[SDManager] Snapshot write failed: %s\n", path);
+  return ok;
+}
+
+/**
+ * @brief 生ログと並べて時刻索引（DATA_xxxx.idx）を作成
+ *
+ * @details
+ * 作成に失敗しても生ログの記録は続ける（索引はホストで再構築できる）。
+ */
+void SDManager::openIndex(const char* filename) {
+  char path[SD_MAX_FILENAME];
+  indexPathFor(filename, path, sizeof(path));
+  s_indexFile = timedOpen(path, FILE_WRITE);
+  s_indexOpen = static_cast<bool>(s_indexFile);
+  if (!s_indexOpen) {
+    Serial.printf("[SDManager] Cannot create index file: %s\n", path);
+    return;
+  }
+  s_indexCount = 0;
+  s_indexBuilder.reset();
+  s_indexWriter.reset(millis());
+  LogIndexHeader h = {SD_INDEX_INTERVAL_RECORDS, 0, 0, static_cast<uint8_t>(s_format)};
+  uint8_t head[LogIndex::HEADER_SIZE];
+  LogIndex::encodeHeader(h, head);
+  s_indexWriter.append(head, sizeof(head));
+}
+
+/**
+ * @brief 同期点を索引へ（間隔に達したものだけエントリになる）
+ */
+void SDManager::indexRecord(uint32_t recordSeq, uint32_t elapsedMs, uint32_t offset) {
+  LogIndexEntry e;
+  if (!s_indexOpen || !s_indexBuilder.offer(recordSeq, elapsedMs, offset, e)) return;
+  uint8_t buf[LogIndex::ENTRY_SIZE];
+  LogIndex::encodeEntry(e, buf);
+  if (!s_indexWriter.append(buf, sizeof(buf))) {
+    closeIndex(false);
+    return;
+  }
+  s_indexCount++;
+}
+
+/**
+ * @brief 索引を同期してクローズ（complete: エントリ数と完了フラグを書く）
+ *
+ * @details
+ * ヘッダは最後に先頭へ直接書く（SectorWriter はこれ以降そのセクタを書かない）。
+ * 書き込みに失敗した索引は未確定のまま閉じる（起動時の復旧・ホストで再構築）。
+ */
+void SDManager::closeIndex(bool complete) {
+  if (!s_indexOpen) return;
+  bool ok = s_indexWriter.sync(millis());
+  if (ok && complete) {
+    LogIndexHeader h = {SD_INDEX_INTERVAL_RECORDS, s_indexCount, 1,
+                        static_cast<uint8_t>(s_format)};
+    uint8_t head[LogIndex::HEADER_SIZE];
+    LogIndex::encodeHeader(h, head);
+    ok = s_indexFile.seek(0) && s_indexFile.write(head, sizeof(head)) == sizeof(head);
+    timedFlush(s_indexFile);
+  }
+  if (!ok) Serial.println("[SDManager] Index write failed, left incomplete");
+  timedClose(s_indexFile);
+  s_indexOpen = false;
+}
+
+/**
+ * @brief 復旧したログの索引を有効長に合わせる（起動時）
+ *
+ * @details
+ * 有効長より先を指すエントリを二分探索で見つけて捨て、最後のエントリから
+ * 有効長までを走査して不足分を足す。走査量が SD_RECOVERY_WINDOW_BYTES を
+ * 超える場合（索引の同期が大きく遅れていた等）は残せる分だけで未確定のまま
+ * にする（ホストの tools/logseek --rebuild で作り直せる）。
+ *
+ * @param header バイナリ形式のヘッダ（CSV は nullptr）
+ */
+void SDManager::recoverIndex(const char* path, const BinLogHeader* header, uint32_t validEnd) {
+  char idxPath[SD_MAX_FILENAME];
+  indexPathFor(path, idxPath, sizeof(idxPath));
+  File     idx;
+  File     log;
+  uint32_t idxSize = 0;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    if (!SD.exists(idxPath)) return;
+    idx = SD.open(idxPath, "r+");
+    log = SD.open(path, FILE_READ);
+    if (idx) idxSize = idx.size();
+  }
+  RecoverySource idxSrc = {&idx};
+  RecoverySource logSrc = {&log};
+  uint8_t        head[LogIndex::HEADER_SIZE];
+  LogIndexHeader h;
+  if (!idx || !log || idxSrc.read(0, head, sizeof(head)) != sizeof(head) ||
+      !LogIndex::decodeHeader(head, h)) {
+    SpiBusGuard bus(SpiDevice::SD);
+    if (idx) idx.close();
+    if (log) log.close();
+    return;
+  }
+
+  // 有効長より手前のエントリだけを残す
+  uint32_t      keep = 0;
+  LogIndexEntry last = {0, 0, 0};
+  uint32_t      lastIndex = 0;
+  const uint32_t n = LogIndex::entryCount(h, idxSize);
+  if (validEnd > 0 && LogIndex::lookup(idxSrc, n, validEnd - 1, true, last, lastIndex)) {
+    keep = lastIndex + 1;
+  }
+
+  // 最後のエントリ（無ければデータ先頭）から有効長までを走査して足す
+  const uint32_t from = (keep > 0) ? last.offset : static_cast<uint32_t>(LogPrealloc::SECTOR_SIZE);
+  bool complete = false;
+  struct Appender {
+    File*           file;
+    uint32_t        count;
+    bool            ok;
+    void operator()(const LogIndexEntry& e) {
+      uint8_t buf[LogIndex::ENTRY_SIZE];
+      LogIndex::encodeEntry(e, buf);
+      SpiBusGuard bus(SpiDevice::SD);
+      ok = ok && file->seek(LogIndex::entryOffset(count)) && file->write(buf, sizeof(buf)) == sizeof(buf);
+      ++count;
+    }
+  } append = {&idx, keep, true};
+  if (validEnd >= from && validEnd - from <= SD_RECOVERY_WINDOW_BYTES) {
+    LogIndex::Builder builder(h.interval);
+    uint32_t seq = 0;
+    if (keep > 0) {
+      builder.resumeAfter(last);
+      seq = last.recordSeq;
+    }
+    if (header != nullptr) {
+      LogIndex::scanBlocks(logSrc, *header, from, validEnd, seq, builder, append);
+    } else {
+      LogIndex::scanCsv(logSrc, from, validEnd, seq, builder, append);
+    }
+    complete = append.ok;
+  }
+
+  h.count    = append.count;
+  h.complete = complete ? 1 : 0;
+  LogIndex::encodeHeader(h, head);
+  bool ok;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    ok = append.ok && idx.seek(0) && idx.write(head, sizeof(head)) == sizeof(head);
+    idx.flush();
+    idx.close();
+    log.close();
+  }
+  const uint32_t end = LogIndex::entryOffset(append.count);
+  char full[SD_MAX_FILENAME + 8];
+  snprintf(full, sizeof(full), "%s%s", SD_MOUNT_POINT, idxPath);
+  if (ok && idxSize > end && truncate(full, end) != 0) {
+    Serial.printf("[SDManager] Index truncate failed: %s\n", full);
+  }
+  Serial.printf("[SDManager] Index %s: %lu entries%s\n", idxPath, (unsigned long)append.count,
+                complete ? "" : " (incomplete, rebuild on host)");
+}
+
+/**
+ * @brief SD の再マウントと、記録中ファイルへの追記再開
+ *
+ * @details
+ * 再開位置は起動時の復旧と同じ手順（recoverFile()）で決める。書き込みに失敗した
+ * 時点の RAM 上のセクタ・組み立て中ブロックは内容が保証できないため捨て、
+ * 記録済みレコード数・ブロック番号はファイル側（復旧要約）に合わせる。
+ */
+bool SDManager::remount(uint32_t& lostRecords) {
+  lostRecords = 0;
+  if (!s_fileOpen) return false;
+  char name[SD_MAX_FILENAME];
+  snprintf(name, sizeof(name), "%s", s_path + strlen(SD_MOUNT_POINT));
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    // 無効になったハンドルは書き込まずに捨てる
+    s_currentFile.close();
+    s_indexFile.close();
+    s_indexOpen = false;
+    for (size_t i = 0; i < RollupCascade::LEVELS; ++i) {
+      s_rollups[i].file.close();
+      s_rollups[i].open = false;
+    }
+    // 生データはこの RUN では再開しない（closed=0 のまま、次回起動時の復旧で閉じる）
+    s_rawFile.close();
+    s_rawOpen = false;
+    SD.end();
+    s_sdReady = false;
+    if (!begin()) return false;
+  }
+
+  LogRecovery::Result r;
+  uint32_t end = 0;
+  if (!recoverFile(name, &r, &end)) {
+    setError("Resume failed");
+    return false;
+  }
+  lostRecords = (s_recordSeq > r.summary.seq) ? s_recordSeq - r.summary.seq : 0;
+  s_recordSeq = r.summary.seq;
+
+  SpiBusGuard bus(SpiDevice::SD);
+  s_currentFile = timedOpen(name, "r+");
+  if (!s_currentFile || !resumeWriter(s_currentFile, s_writer, end)) {
+    setError("Resume failed");
+    return false;
+  }
+  s_allocated       = end;   // 復旧で切り詰め済み
+  s_validBytes      = end;
+  s_block.reset(r.nextBlockSeq + 1);   // BINARY / DELTA: 復旧要約の TEXT ブロックの次
+  s_delta.reset(r.nextBlockSeq + 1);
+  s_deltaSyncMs     = millis();
+  s_deltaTailOnDisk = false;
+  s_blocksSinceCkpt = 0;
+  s_lastCkptMs      = r.summary.elapsedMs;
+
+  // 記録中（closed=0）に戻し、想定 RUN 長ぶんを確保し直す
+  const bool ok = writeHeaderSector(end, false);
+  if (ok && s_allocChunk > 0 && !preallocate(end + s_allocChunk)) {
+    Serial.printf("[SDManager] Preallocation failed, growing on demand\n");
+    s_allocChunk = 0;
+  }
+  resumeIndex(name);
+  resumeRollups(name);
+  Serial.printf("[SDManager] Resumed %s at %lu bytes (%lu records, %lu lost)\n", name,
+                (unsigned long)end, (unsigned long)s_recordSeq, (unsigned long)lostRecords);
+  return ok;
+}
+
+/**
+ * @brief 時刻索引の追記を再開（recoverFile() で有効長に合わせた後）
+ *
+ * @details
+ * ヘッダを記録中（エントリ数 0・未確定）に戻してから末尾のセクタを読み込む
+ * （索引が 1 セクタに収まる間はヘッダも SectorWriter が書き直すため）。
+ */
+void SDManager::resumeIndex(const char* filename) {
+  char path[SD_MAX_FILENAME];
+  indexPathFor(filename, path, sizeof(path));
+  s_indexFile = timedOpen(path, "r+");
+  if (!s_indexFile) return;
+
+  RecoverySource src = {&s_indexFile};
+  uint8_t        head[LogIndex::HEADER_SIZE];
+  LogIndexHeader h;
+  LogIndexEntry  last = {0, 0, 0};
+  uint32_t       count = 0;
+  bool ok = src.read(0, head, sizeof(head)) == sizeof(head) && LogIndex::decodeHeader(head, h);
+  if (ok) {
+    count = LogIndex::entryCount(h, s_indexFile.size());
+    ok    = (count == 0 || LogIndex::readEntry(src, count - 1, last));
+  }
+  if (ok) {
+    h.count    = 0;
+    h.complete = 0;
+    LogIndex::encodeHeader(h, head);
+    ok = s_indexFile.seek(0) && s_indexFile.write(head, sizeof(head)) == sizeof(head) &&
+         resumeWriter(s_indexFile, s_indexWriter, LogIndex::entryOffset(count));
+  }
+  if (!ok) {
+    Serial.printf("[SDManager] Index not resumed: %s\n", path);
+    timedClose(s_indexFile);
+    return;
+  }
+  s_indexBuilder.reset();
+  if (count > 0) s_indexBuilder.resumeAfter(last);
+  s_indexCount = count;
+  s_indexOpen  = true;
+}
+
+/**
+ * @brief 集約ログの追記を再開（同期済みの末尾から。未同期だった行は失われる）
+ */
+void SDManager::resumeRollups(const char* filename) {
+  for (size_t i = 0; i < RollupCascade::LEVELS; ++i) {
+    RollupFile& rf = s_rollups[i];
+    char path[SD_MAX_FILENAME];
+    rollupPathFor(filename, i, path, sizeof(path));
+    rf.file = timedOpen(path, "r+");
+    rf.open = rf.file && resumeWriter(rf.file, rf.writer, static_cast<uint32_t>(rf.file.size()));
+    if (!rf.open) {
+      Serial.printf("[SDManager] Rollup not resumed: %s\n", path);
+      if (rf.file) timedClose(rf.file);
+    }
+  }
 }
@@ -0,0 +1,897 @@
+#include "SDWriter.h"
+#include "SDManager.h"
+#include "SpiBus.h"
+#include "SpscRing.h"
+#include "PerfMonitor.h"
+#include "OutageBacklog.h"
+#include "WallClock.h"
+#include "SDBenchmark.h"
+
+/**
+ * @brief OPEN / SEGMENT / CLOSE の内容（リングには載せず、s_controls のスロットで受け渡す）
+ */
+struct SDControl {
+  char      filename[SD_MAX_FILENAME];   // OPEN / SEGMENT（次の区間）
+  LogFormat format;                      // OPEN / SEGMENT
+  bool      rawCapture;                  // OPEN / SEGMENT（生データ記録も行う）
+  float     hiThreshold;                 // OPEN / SEGMENT（バイナリヘッダ用）
+  float     loThreshold;                 // OPEN / SEGMENT（バイナリヘッダ用）
+  RunCatalogEntry run;                   // OPEN / CLOSE（目録の START / END）。SEGMENT は startUptimeMs のみ
+  SegmentInfo segment;                   // SEGMENT（"# SEGMENT,..." 行）
+  int64_t   wallMs;                      // OPEN / SEGMENT（開始の実時刻、-1 = 不明）
+  LogFilter logFilter;                   // CLOSE（積んだ時点の記録判定の設定・統計）
+  PerfMonitor::Summary perf;             // CLOSE（積んだ時点のタスク処理時間統計）
+};
+
+/**
+ * @brief リングで受け渡す固定長レコード
+ *
+ * @details
+ * 毎行積む DATA に合わせて種別 + SDData の大きさに保つ。まれな制御レコードの大きな内容は
+ * スロット（s_controls / s_snapshots）に置き、添字だけを載せる。
+ */
+struct SDRecord {
+  enum Type : uint8_t { DATA, OPEN, CLOSE, MOUNT, RECOVER, PROFILE, BENCH, LIST, ROLLUP, SNAPSHOT, SEGMENT };
+  Type    type;
+  uint8_t slot;                // OPEN / SEGMENT / CLOSE: s_controls、SNAPSHOT: s_snapshots の添字
+  bool    remount;             // MOUNT（マウント済みでも一度外してから）
+  union {
+    SDData    data;            // DATA
+    RollupRow rollup;          // ROLLUP
+    uint32_t  elapsedMs;       // SNAPSHOT（トリガの RUN 開始からの経過時間）
+    uint16_t  rows;            // BENCH（1 方式あたりの行数）
+    uint32_t  count;           // LIST（出力する件数）
+  };
+};
+
+// IO タスクは書き込みタスクを起こさない（同期間隔ごとの起床でまとめて処理する）ため、
+// 最も長い起床間隔のあいだの読取値がリングに収まること
+static_assert(SD_RAW_RING_DEPTH * TC_CAPTURE_INTERVAL_MS >= 2 * SD_SYNC_INTERVAL_MAX_MS,
+              "SD_RAW_RING_DEPTH cannot hold the samples of one writer wake-up interval");
+
+// プリトリガのリングが窓の長さを覆うこと（要約周期で追加されるため）
+static_assert(SD_PRETRIGGER_DEPTH * TC_READ_INTERVAL_MS >= SD_PRETRIGGER_WINDOW_MS,
+              "SD_PRETRIGGER_DEPTH cannot cover SD_PRETRIGGER_WINDOW_MS");
+
+// ── 静的メンバー変数の実装 ─────────────────────────────────────────────────────
+TaskHandle_t      SDWriter::s_task = nullptr;
+std::atomic<bool> SDWriter::s_busy(false);
+std::atomic<bool> SDWriter::s_error(false);
+std::atomic<bool> SDWriter::s_outage(false);
+
+namespace {
+  SpscRing<SDRecord, SD_RING_DEPTH> s_ring;   // 生成: 制御タスク / 消費: 書き込みタスク
+
+  // OPEN / SEGMENT / CLOSE の内容。制御タスクが空きスロットへ書き、書き込みタスクが処理後に解放する
+  SDControl         s_controls[SD_CONTROL_SLOTS];
+  std::atomic<bool> s_controlBusy[SD_CONTROL_SLOTS];
+  bool s_fileOpen = false;                     // 書き込みタスクのみが参照
+
+  // SD 切断中の退避（書き込みタスクのみが参照）
+  OutageBacklog<SDData, SD_OUTAGE_BACKLOG_DEPTH> s_backlog(SD_OUTAGE_POLICY);
+  uint32_t s_backlogFromMs  = 0;     // 退避した最初のレコードの経過時間
+  uint32_t s_backlogToMs    = 0;     // 退避した最後のレコードの経過時間
+  uint32_t s_lastRemountMs  = 0;     // 最後に再マウントを試みた時刻 (millis)
+  uint32_t s_remountEveryMs = SD_REMOUNT_INTERVAL_MS;  // 次の試行までの間隔（失敗ごとに倍）
+  std::atomic<uint32_t> s_backlogDepth(0);   // 退避中の件数（dump() 用）
+
+  // RUN 単位の累計（CLOSE 時にフッタへ）
+  uint32_t s_outageCount  = 0;
+  uint32_t s_outageFilled = 0;       // 書き戻したレコード数
+  uint32_t s_outageLost   = 0;       // 間引き・未同期で失われたレコード数
+
+  // 生データ記録（RawCapture.h）。リング以外は書き込みタスクのみが参照
+  SpscRing<RawSample, SD_RAW_RING_DEPTH> s_rawRing;   // 生成: IO タスク / 消費: 書き込みタスク
+  bool     s_rawOpen        = false;
+  uint32_t s_rawStartMs     = 0;     // RUN 開始時刻 (millis)。経過時間の基準
+  uint32_t s_rawSamples     = 0;     // 書いたサンプル数
+  uint32_t s_rawFaults      = 0;     // うち故障（NaN）のサンプル数
+  uint32_t s_rawDiscarded   = 0;     // 切断中・記録停止後に捨てたサンプル数
+  uint32_t s_rawDroppedBase = 0;     // OPEN 時点のリング破棄数（リング統計は生成側しか戻せない）
+
+  // プリトリガのスナップショット（PreTrigger.h）。制御タスクが空きスロットへ写し、
+  // 書き込みタスクが書き終えて解放する（レコードには添字だけを載せ、リングを大きくしない）
+  PreTriggerSnapshot<SD_PRETRIGGER_DEPTH> s_snapshots[SD_PRETRIGGER_SLOTS];
+  std::atomic<bool>     s_snapshotBusy[SD_PRETRIGGER_SLOTS];
+  std::atomic<uint32_t> s_snapshotDropped(0);   // スロット・リングが空かず捨てた数
+  char s_snapshotFiles[SD_PRETRIGGER_SLOTS][SD_MAX_FILENAME];   // アラームスナップショットの書き先
+  char s_snapshotText[256 + SD_PRETRIGGER_DEPTH * PreTrigger::MAX_ROW];   // 書き込みタスクのみ
+
+  // ソークの区間分割（SoakLog.h）。書き込みタスクが開いている区間とその書き込み量を公開し、
+  // 制御タスクが切り替えを判定する（区間番号が一致する時だけバイト数を信用する）
+  std::atomic<uint32_t> s_segmentBytes(0);
+  std::atomic<uint32_t> s_segmentIndex(0);
+  char s_fileName[SD_MAX_FILENAME] = {0};   // 開いているファイル（書き込みタスクのみ）
+
+  // マウントの結果（書き込みタスクが書き、制御タスクが takeMount() で受け取る）
+  enum MountResult : uint8_t { MOUNT_NONE, MOUNT_OK, MOUNT_FAILED };
+  std::atomic<uint8_t>  s_mountResult(MOUNT_NONE);
+  std::atomic<uint32_t> s_mountNextRunId(0);
+}
+
+namespace {
+  /**
+   * @brief 内容を制御スロット（s_controls）に置くレコードか
+   */
+  bool usesControlSlot(const SDRecord& rec) {
+    return rec.type == SDRecord::OPEN || rec.type == SDRecord::SEGMENT ||
+           rec.type == SDRecord::CLOSE;
+  }
+
+  /**
+   * @brief 空いている制御スロットを取る（制御タスクから。空くまで最大 SD_CONTROL_RECORD_WAIT_MS 待つ）
+   * @return SD_CONTROL_SLOTS : 空かなかった
+   */
+  size_t acquireControl() {
+    const uint32_t start = millis();
+    for (;;) {
+      for (size_t i = 0; i < SD_CONTROL_SLOTS; ++i) {
+        if (!s_controlBusy[i].exchange(true, std::memory_order_acquire)) return i;
+      }
+      if (millis() - start >= SD_CONTROL_RECORD_WAIT_MS) {
+        Serial.println("[SDWriter] no free control slot, control record not queued");
+        return SD_CONTROL_SLOTS;
+      }
+      vTaskDelay(pdMS_TO_TICKS(1));
+    }
+  }
+}
+
+// ================================ 実装部分 ====================================
+
+/**
+ * @brief 書き込みタスクを起動
+ */
+void SDWriter::start() {
+  if (s_task != nullptr) return;
+  xTaskCreatePinnedToCore(taskEntry, "SDWriter", SD_WRITER_TASK_STACK_BYTES, nullptr,
+                          SD_WRITER_TASK_PRIORITY, &s_task, SD_WRITER_TASK_CORE);
+  xTaskNotifyGive(s_task);  // 起動前に積まれた依頼（復旧等）があれば処理させる
+}
+
+/**
+ * @brief 新規ファイル作成を依頼
+ */
+bool SDWriter::openFile(const char* filename, LogFormat format,
+                        float hiThreshold, float loThreshold, uint32_t runId, bool rawCapture,
+                        int64_t wallStartMs) {
+  s_ring.resetStats();  // 最大滞留数・破棄数はファイル（RUN）単位で取り直す
+  const size_t slot = acquireControl();
+  if (slot == SD_CONTROL_SLOTS) return false;
+  SDControl& c = s_controls[slot];
+  strncpy(c.filename, filename, sizeof(c.filename) - 1);
+  c.filename[sizeof(c.filename) - 1] = '\0';
+  c.format      = format;
+  c.rawCapture  = rawCapture;
+  c.hiThreshold = hiThreshold;
+  c.loThreshold = loThreshold;
+  memset(&c.run, 0, sizeof(c.run));
+  c.run.runId         = runId;
+  c.run.kind          = RunCatalog::START;
+  c.run.logFormat     = static_cast<uint8_t>(format);
+  c.run.startUptimeMs = millis();
+  strncpy(c.run.fileName, filename, sizeof(c.run.fileName) - 1);
+  memset(&c.segment, 0, sizeof(c.segment));
+  c.segment.runId = runId;
+  c.wallMs        = wallStartMs;
+
+  SDRecord rec;
+  rec.type = SDRecord::OPEN;
+  rec.slot = static_cast<uint8_t>(slot);
+  return pushControl(rec);
+}
+
+/**
+ * @brief 次の区間への切り替えを依頼（ソーク）
+ */
+bool SDWriter::openSegment(const char* filename, LogFormat format, float hiThreshold,
+                           float loThreshold, bool rawCapture, uint32_t startMs,
+                           const SegmentInfo& segment, int64_t wallStartMs) {
+  const size_t slot = acquireControl();
+  if (slot == SD_CONTROL_SLOTS) return false;
+  SDControl& c = s_controls[slot];
+  strncpy(c.filename, filename, sizeof(c.filename) - 1);
+  c.filename[sizeof(c.filename) - 1] = '\0';
+  c.format      = format;
+  c.rawCapture  = rawCapture;
+  c.hiThreshold = hiThreshold;
+  c.loThreshold = loThreshold;
+  memset(&c.run, 0, sizeof(c.run));
+  c.run.startUptimeMs = startMs;
+  c.segment     = segment;
+  c.wallMs      = wallStartMs;
+
+  SDRecord rec;
+  rec.type = SDRecord::SEGMENT;
+  rec.slot = static_cast<uint8_t>(slot);
+  return pushControl(rec);
+}
+
+/**
+ * @brief 区間 index に書いたバイト数
+ */
+bool SDWriter::segmentBytes(uint16_t index, uint32_t& bytes) {
+  if (s_segmentIndex.load(std::memory_order_acquire) != index) return false;
+  bytes = s_segmentBytes.load(std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief CSV 1 行を依頼（待ち無し）
+ */
+bool SDWriter::pushData(const SDData& data) {
+  SDRecord rec;
+  rec.type = SDRecord::DATA;
+  rec.data = data;
+  if (!s_ring.push(rec)) return false;
+  if (s_task != nullptr) xTaskNotifyGive(s_task);
+  return true;
+}
+
+/**
+ * @brief 生データ 1 サンプルを依頼（IO タスクから、待ち無し・起床通知無し）
+ */
+bool SDWriter::pushRaw(const RawSample& sample) {
+  return s_rawRing.push(sample);
+}
+
+/**
+ * @brief 集約ログ 1 行を依頼（待ち無し）
+ */
+bool SDWriter::pushRollup(const RollupRow& row) {
+  SDRecord rec;
+  rec.type   = SDRecord::ROLLUP;
+  rec.rollup = row;
+  if (!s_ring.push(rec)) return false;
+  if (s_task != nullptr) xTaskNotifyGive(s_task);
+  return true;
+}
+
+/**
+ * @brief プリトリガの窓の書き込みを依頼（待ち無し）
+ */
+bool SDWriter::pushSnapshot(const PreTriggerRing<SD_PRETRIGGER_DEPTH>& ring,
+                            PreTrigger::Event event, uint32_t triggerMs, uint32_t elapsedMs,
+                            const char* filename) {
+  size_t slot = 0;
+  while (slot < SD_PRETRIGGER_SLOTS &&
+         s_snapshotBusy[slot].exchange(true, std::memory_order_acquire)) {
+    ++slot;
+  }
+  if (slot == SD_PRETRIGGER_SLOTS) {
+    s_snapshotDropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  ring.snapshot(event, triggerMs, SD_PRETRIGGER_WINDOW_MS, s_snapshots[slot]);
+
+  SDRecord rec;
+  rec.type      = SDRecord::SNAPSHOT;
+  rec.slot      = static_cast<uint8_t>(slot);
+  rec.elapsedMs = elapsedMs;
+  char* const file = s_snapshotFiles[slot];
+  file[0] = '\0';
+  if (filename != nullptr) {
+    strncpy(file, filename, SD_MAX_FILENAME - 1);
+    file[SD_MAX_FILENAME - 1] = '\0';
+  }
+  if (!s_ring.push(rec)) {
+    s_snapshotBusy[slot].store(false, std::memory_order_release);
+    s_snapshotDropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (s_task != nullptr) xTaskNotifyGive(s_task);
+  return true;
+}
+
+/**
+ * @brief フッタ書き込み・クローズを依頼
+ */
+bool SDWriter::closeFile(const RunCatalogEntry& summary, const LogFilter& filter) {
+  const size_t slot = acquireControl();
+  if (slot == SD_CONTROL_SLOTS) return false;
+  SDControl& c = s_controls[slot];
+  c.run       = summary;
+  c.logFilter = filter;
+  PerfMonitor::summarize(c.perf);
+
+  SDRecord rec;
+  rec.type = SDRecord::CLOSE;
+  rec.slot = static_cast<uint8_t>(slot);
+  return pushControl(rec);
+}
+
+/**
+ * @brief SD カードのマウントと目録の読み込みを依頼
+ */
+bool SDWriter::mount(bool remount) {
+  SDRecord rec;
+  rec.type    = SDRecord::MOUNT;
+  rec.remount = remount;
+  return pushControl(rec);
+}
+
+/**
+ * @brief マウントの結果を取得してクリア
+ */
+bool SDWriter::takeMount(bool& ok, uint32_t& nextRunId) {
+  const uint8_t result = s_mountResult.exchange(MOUNT_NONE, std::memory_order_acq_rel);
+  if (result == MOUNT_NONE) return false;
+  ok        = (result == MOUNT_OK);
+  nextRunId = s_mountNextRunId.load(std::memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief 閉じられなかったログの復旧を依頼
+ */
+bool SDWriter::recover() {
+  SDRecord rec;
+  rec.type = SDRecord::RECOVER;
+  return pushControl(rec);
+}
+
+/**
+ * @brief カードの計測・同期方針の選択を依頼
+ */
+bool SDWriter::profileCard() {
+  SDRecord rec;
+  rec.type = SDRecord::PROFILE;
+  return pushControl(rec);
+}
+
+/**
+ * @brief 書き込み方式ベンチマークを依頼
+ */
+bool SDWriter::benchmark(uint16_t rows) {
+  SDRecord rec;
+  rec.type = SDRecord::BENCH;
+  rec.rows = rows;
+  return pushControl(rec);
+}
+
+/**
+ * @brief RUN 目録の一覧出力を依頼
+ */
+bool SDWriter::listRuns(uint32_t count) {
+  SDRecord rec;
+  rec.type = SDRecord::LIST;
+  rec.count = count;
+  return pushControl(rec);
+}
+
+/**
+ * @brief 書き込み失敗の有無を取得してクリア
+ */
+bool SDWriter::takeError() {
+  return s_error.exchange(false, std::memory_order_acq_rel);
+}
+
+/**
+ * @brief SD 切断中か
+ */
+bool SDWriter::inOutage() {
+  return s_outage.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief 未処理レコードが無く、書き込み中でもないか
+ */
+bool SDWriter::idle() {
+  return s_ring.empty() && !s_busy.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief リング統計を出力
+ */
+void SDWriter::dump(Print& out) {
+  out.printf("[SDQ] queued=%u high_water=%lu/%u dropped=%lu\n",
+             (unsigned)s_ring.size(), (unsigned long)s_ring.highWater(),
+             (unsigned)s_ring.capacity(), (unsigned long)s_ring.dropped());
+  out.printf("[SDQ] outage=%s backlog=%lu/%u policy=%s\n", inOutage() ? "yes" : "no",
+             (unsigned long)s_backlogDepth.load(std::memory_order_relaxed),
+             (unsigned)s_backlog.capacity(),
+             (SD_OUTAGE_POLICY == BacklogPolicy::DECIMATE) ? "decimate" : "drop_oldest");
+  out.printf("[SDQ] raw=%s queued=%u high_water=%lu/%u dropped=%lu\n", s_rawOpen ? "on" : "off",
+             (unsigned)s_rawRing.size(), (unsigned long)s_rawRing.highWater(),
+             (unsigned)s_rawRing.capacity(), (unsigned long)s_rawRing.dropped());
+  out.printf("[SDQ] pretrigger=%u/%u snapshots_dropped=%lu\n", (unsigned)G.M_PreTrigger.size(),
+             (unsigned)G.M_PreTrigger.capacity(),
+             (unsigned long)s_snapshotDropped.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief リング統計のフッタ行
+ */
+size_t SDWriter::formatFooter(char* buf, size_t len) {
+  const int n = snprintf(buf, len, "# SDQ,high_water=%lu,capacity=%u,dropped=%lu\r\n",
+                         (unsigned long)s_ring.highWater(), (unsigned)s_ring.capacity(),
+                         (unsigned long)s_ring.dropped());
+  if (n <= 0) return 0;
+  return (static_cast<size_t>(n) < len) ? static_cast<size_t>(n) : len - 1;
+}
+
+// ================================ 内部メソッド ====================================
+
+/**
+ * @brief OPEN / CLOSE の依頼（空きができるまで短時間待つ）
+ */
+bool SDWriter::pushControl(const SDRecord& rec) {
+  const uint32_t start = millis();
+  for (;;) {
+    // push() 失敗は dropped に計上されるため、空きを確認してから積む
+    if (s_ring.size() < s_ring.capacity() && s_ring.push(rec)) break;
+    if (millis() - start >= SD_CONTROL_RECORD_WAIT_MS) {
+      Serial.println("[SDWriter] ring full, control record not queued");
+      if (usesControlSlot(rec)) s_controlBusy[rec.slot].store(false, std::memory_order_release);
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(1));
+  }
+  if (s_task != nullptr) xTaskNotifyGive(s_task);
+  return true;
+}
+
+/**
+ * @brief 書き込みタスク本体
+ *
+ * @details
+ * ファイルを開いている間は同期間隔（SDManager::syncIntervalMs()）ごとにも起き、行が途切れても
+ * 時間条件の同期（電源断時の損失上限）を守る。閉じている間は依頼が来るまで眠る。
+ */
+void SDWriter::taskEntry(void*) {
+  for (;;) {
+    const TickType_t wait = !s_fileOpen ? portMAX_DELAY
+                          : s_outage.load(std::memory_order_relaxed) ? pdMS_TO_TICKS(s_remountEveryMs)
+                          : pdMS_TO_TICKS(SDManager::syncIntervalMs());
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    s_busy.store(true, std::memory_order_release);
+    SDRecord rec;
+    while (s_ring.pop(rec)) {
+      handle(rec);
+      if (usesControlSlot(rec)) s_controlBusy[rec.slot].store(false, std::memory_order_release);
+    }
+    drainRaw();
+    if (s_fileOpen && s_outage.load(std::memory_order_relaxed)) {
+      if (millis() - s_lastRemountMs >= s_remountEveryMs) tryResume();
+    } else if (s_fileOpen) {
+      bool ok;
+      {
+        SpiBusGuard bus(SpiDevice::SD);
+        ok = SDManager::poll();
+      }
+      if (!ok) enterOutage();
+    }
+    s_busy.store(false, std::memory_order_release);
+  }
+}
+
+/**
+ * @brief レコード 1 件の処理
+ */
+void SDWriter::handle(const SDRecord& rec) {
+  switch (rec.type) {
+    case SDRecord::OPEN: {
+      const SDControl& c = s_controls[rec.slot];
+      RunCatalogEntry run = c.run;
+      if (!openLog(c)) run.flags |= RunCatalog::FLAG_SD_ERROR;
+      // 作成に失敗しても RUN 番号は使ったものとして記録する（次回起動で同じ名前を使わない）
+      appendCatalog(run);
+      break;
+    }
+
+    case SDRecord::SEGMENT: {
+      // 前の区間を閉じられなかった（切断から復帰しない）ら、エラーを通知して RUN の記録を止める
+      const SDControl& c = s_controls[rec.slot];
+      if (!s_fileOpen) break;
+      drainRaw();
+      char prev[SD_MAX_FILENAME];
+      strncpy(prev, s_fileName, sizeof(prev));
+      if (!closeLog(c, true)) break;
+      if (!openLog(c)) break;
+      char line[SoakLog::MAX_LINE];
+      SoakLog::formatSegmentLine(c.segment, prev, line);
+      SpiBusGuard bus(SpiDevice::SD);
+      SDManager::writeFooter(line);
+      break;
+    }
+
+    case SDRecord::DATA: {
+      if (!s_fileOpen) break;  // OPEN 失敗後の行は捨てる（エラーは通知済み）
+      if (s_outage.load(std::memory_order_relaxed)) {
+        backlog(rec.data);
+        break;
+      }
+      bool ok;
+      {
+        SpiBusGuard bus(SpiDevice::SD);
+        ok = SDManager::writeData(rec.data);
+      }
+      s_segmentBytes.store(SDManager::logBytes(), std::memory_order_relaxed);
+      if (!ok) {
+        // 失敗した行も退避する（RAM 上に途中まで入った分は再開時に捨てられる）
+        Serial.printf("[SDWriter] SD write failed: %s\n", SDManager::getLastError());
+        enterOutage();
+        backlog(rec.data);
+      }
+      break;
+    }
+
+    case SDRecord::ROLLUP: {
+      // 切断中の集約行は退避しない（生ログから作り直せる）
+      if (!s_fileOpen || s_outage.load(std::memory_order_relaxed)) break;
+      // 失敗した段は SDManager が記録を止める（生ログは続けるためエラーにはしない）
+      SpiBusGuard bus(SpiDevice::SD);
+      SDManager::writeRollup(rec.rollup);
+      break;
+    }
+
+    case SDRecord::CLOSE: {
+      drainRaw();   // RUN 終了までの読取値を先に
+      const SDControl& c = s_controls[rec.slot];
+      RunCatalogEntry run = c.run;
+      if (!(s_fileOpen && closeLog(c, false))) run.flags |= RunCatalog::FLAG_SD_ERROR;
+      s_segmentBytes.store(0, std::memory_order_relaxed);
+      appendCatalog(run);
+      break;
+    }
+
+    case SDRecord::SNAPSHOT: {
+      writeSnapshot(rec);
+      s_snapshotBusy[rec.slot].store(false, std::memory_order_release);
+      break;
+    }
+
+    case SDRecord::MOUNT: {
+      // SD.begin() は途中でバスを手放せないため呼び出しの間だけ保持する。
+      // 目録は SDManager が I/O ごとにバスを取って読む
+      bool ok;
+      {
+        SpiBusGuard bus(SpiDevice::SD);
+        if (rec.remount) {
+          // エラー後: マウント済みの状態は古いかもしれない（抜き差し・切断のまま閉じた）。
+          // 残っているファイルも外す（閉じられなかった分は復旧が閉じる）
+          SDManager::closeRaw();
+          SDManager::end();
+          s_fileOpen = false;
+          s_rawOpen  = false;
+          s_segmentBytes.store(0, std::memory_order_relaxed);
+        }
+        ok = SDManager::begin();
+      }
+      if (ok) s_mountNextRunId.store(SDManager::loadCatalog(), std::memory_order_relaxed);
+      s_mountResult.store(ok ? MOUNT_OK : MOUNT_FAILED, std::memory_order_release);
+      break;
+    }
+
+    case SDRecord::RECOVER: {
+      // バスは SDManager が I/O ごとに取る（復旧中も IO コアの読取を止めない）
+      const int n = SDManager::recoverUnclosed();
+      if (n > 0) Serial.printf("[SDWriter] Recovered %d unclosed log file(s)\n", n);
+      break;
+    }
+
+    case SDRecord::PROFILE: {
+      // 計測（初回のカードのみ数秒）もバスは SDBenchmark が I/O ごとに取る。
+      // 同期方針はこのタスクの持つ書き込み器へ反映される（制御タスクからは触らない）
+      SDManager::profileCard(Serial);
+      break;
+    }
+
+    case SDRecord::BENCH: {
+      // 依頼後に RUN が始まっていれば、開いたログと同じカードへの書き込みを混ぜない
+      if (s_fileOpen) {
+        Serial.println("[SDBENCH] not available while a log file is open");
+        break;
+      }
+      SDBenchmark::run(Serial, rec.rows);
+      break;
+    }
+
+    case SDRecord::LIST: {
+      SDManager::listRuns(Serial, rec.count);
+      break;
+    }
+  }
+}
+
+/**
+ * @brief ファイル作成 + ヘッダ（+ 生データ記録）（OPEN / SEGMENT）
+ * @return false : 作成またはヘッダ書き込みに失敗（エラーは通知済み）
+ */
+bool SDWriter::openLog(const SDControl& rec) {
+  // バスは呼び出しごとに取る（作成〜生データのファイルまで通しでは保持しない）。
+  // 各呼び出しの中でもファイル 1 つ・確保 1 段・1 セクタごとに SpiBus::yield() する
+  s_outageCount  = 0;
+  s_outageFilled = 0;
+  s_outageLost   = 0;
+  bool created;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    created = SDManager::createNewFile(rec.filename, rec.format);
+  }
+  bool headed = false;
+  if (created) {
+    SpiBusGuard bus(SpiDevice::SD);
+    headed = SDManager::writeHeader(rec.hiThreshold, rec.loThreshold);
+  }
+  if (!created || !headed) {
+    Serial.printf("[SDWriter] SD file create error: %s\n", SDManager::getLastError());
+    s_error.store(true, std::memory_order_release);
+    s_fileOpen = false;
+  } else {
+    Serial.printf("[SDWriter] SD file created: %s\n", rec.filename);
+    s_fileOpen = true;
+    // 経過時間 0 の実時刻（バイナリ形式の行には実時刻が無いため、ここから求める）
+    if (rec.wallMs >= 0) {
+      char line[48];
+      char* p = FixedFormat::putStr(line, "# WALLCLOCK,start=");
+      p = WallClock::putIso(p, rec.wallMs);
+      *p++ = '\r';
+      *p++ = '\n';
+      *p   = '\0';
+      SpiBusGuard bus(SpiDevice::SD);
+      SDManager::writeFooter(line);
+    }
+  }
+  strncpy(s_fileName, rec.filename, sizeof(s_fileName) - 1);
+  s_segmentBytes.store(SDManager::logBytes(), std::memory_order_relaxed);
+  s_segmentIndex.store(rec.segment.index, std::memory_order_release);
+  // 生データ記録は生ログがある RUN のみ（作成に失敗しても生ログは続ける）
+  if (s_fileOpen && rec.rawCapture) {
+    SpiBusGuard bus(SpiDevice::SD);
+    s_rawOpen = SDManager::openRaw(rec.filename, rec.hiThreshold, rec.loThreshold);
+  } else {
+    s_rawOpen = false;
+  }
+  s_rawStartMs     = rec.run.startUptimeMs;
+  s_rawSamples     = 0;
+  s_rawFaults      = 0;
+  s_rawDiscarded   = 0;
+  s_rawDroppedBase = s_rawRing.dropped();
+  return s_fileOpen;
+}
+
+/**
+ * @brief フッタ書き込み → flush → クローズ（CLOSE / SEGMENT）
+ * @param rec CLOSE なら RUN 全体の統計（積んだ時点の写し）をフッタへ。
+ *            SEGMENT なら次の区間（RUN 全体の統計は最後の区間にだけ書く）
+ * @param segment SEGMENT の切り替え（rec は次の区間）
+ * @return false : SD 切断から復帰できず、退避分を捨てて閉じた
+ */
+bool SDWriter::closeLog(const SDControl& rec, bool segment) {
+  const SDControl* next = segment ? &rec : nullptr;
+  if (s_outage.load(std::memory_order_relaxed) && !tryResume()) {
+    // 復帰しないまま RUN 終了: 退避分は捨て、ファイルは次回起動時の復旧に任せる
+    Serial.printf("[SDWriter] SD outage at close, %lu buffered rows discarded\n",
+                  (unsigned long)s_backlog.size());
+    s_backlog.clear();
+    s_backlogDepth.store(0, std::memory_order_relaxed);
+    s_outage.store(false, std::memory_order_release);
+    s_error.store(true, std::memory_order_release);
+    SpiBusGuard bus(SpiDevice::SD);
+    SDManager::closeRaw();
+    SDManager::closeFile();
+    s_fileOpen = false;
+    s_rawOpen  = false;
+    return false;
+  }
+  SpiBusGuard bus(SpiDevice::SD);
+  char footer[512];
+  if (next == nullptr) {
+    // RUN 中のタスク処理時間統計・リング統計をフッタとして残す（現場機の目標値確認用）
+    // 処理時間・記録判定の統計は CLOSE を積んだ時点の写し（処理が遅れても次の RUN の値が混ざらない）
+    if (PerfMonitor::formatFooter(rec.perf, footer, sizeof(footer)) > 0) {
+      SDManager::writeFooter(footer);
+    }
+    if (formatFooter(footer, sizeof(footer)) > 0) {
+      SDManager::writeFooter(footer);
+    }
+    if (rec.logFilter.formatFooter(footer, sizeof(footer)) > 0) {
+      SDManager::writeFooter(footer);
+    }
+  }
+  if (s_outageCount > 0) {
+    snprintf(footer, sizeof(footer), "# OUTAGES,count=%lu,filled=%lu,lost=%lu\r\n",
+             (unsigned long)s_outageCount, (unsigned long)s_outageFilled,
+             (unsigned long)s_outageLost);
+    SDManager::writeFooter(footer);
+  }
+  if (s_rawOpen || s_rawSamples > 0) {
+    // 生データの件数・取りこぼしを要約ログに残す（生データ側が途中で止まっていても分かるように）
+    const bool closed = SDManager::closeRaw();
+    snprintf(footer, sizeof(footer),
+             "# RAW,samples=%lu,faults=%lu,ring_high_water=%lu,ring_dropped=%lu,discarded=%lu,"
+             "closed=%s\r\n",
+             (unsigned long)s_rawSamples, (unsigned long)s_rawFaults,
+             (unsigned long)s_rawRing.highWater(),
+             (unsigned long)(s_rawRing.dropped() - s_rawDroppedBase),
+             (unsigned long)s_rawDiscarded, closed ? "true" : "false");
+    SDManager::writeFooter(footer);
+    s_rawOpen = false;
+  }
+  if (next != nullptr) {
+    snprintf(footer, sizeof(footer), "# SEGMENT_END,index=%u,next=%s\r\n",
+             (unsigned)s_segmentIndex.load(std::memory_order_relaxed),
+             next->filename[0] == '/' ? next->filename + 1 : next->filename);
+    SDManager::writeFooter(footer);
+  }
+  SDManager::flush();      // バッファをディスクに書き込み
+  SDManager::closeFile();  // ファイルをクローズ
+  s_fileOpen = false;
+  Serial.println("[SDWriter] SD file closed");
+  return true;
+}
+
+/**
+ * @brief プリトリガの窓を書き込む（SNAPSHOT）
+ *
+ * @details
+ * - RUN_START: 生ログのヘッダ直後に "# PRETRIGGER,..." と "# PRE,..." のコメント行として
+ * - アラーム変化: 独立した CSV（rec.filename）に書き、生ログには "# ALARM_SNAPSHOT,..." の参照行
+ * 切断中・ファイルが無い時は書かない（退避の RAM は行に使う）。
+ */
+void SDWriter::writeSnapshot(const SDRecord& rec) {
+  if (!s_fileOpen || s_outage.load(std::memory_order_relaxed)) {
+    s_snapshotDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const PreTriggerSnapshot<SD_PRETRIGGER_DEPTH>& snap = s_snapshots[rec.slot];
+  const PreTrigger::Event event = static_cast<PreTrigger::Event>(snap.event);
+  char* const  buf = s_snapshotText;
+  const size_t cap = sizeof(s_snapshotText);
+  SpiBusGuard bus(SpiDevice::SD);
+
+  if (event == PreTrigger::RUN_START) {
+    const int n = snprintf(buf, cap, "# PRETRIGGER,event=%s,window_ms=%lu,samples=%lu\r\n# PRE,%s\r\n",
+                           PreTrigger::eventName(event), (unsigned long)snap.windowMs,
+                           (unsigned long)snap.count, PreTrigger::COLUMNS);
+    if (n <= 0) return;
+    snap.formatRows("# PRE,", buf + n, cap - n);
+    SDManager::writeFooter(buf);
+    return;
+  }
+
+  const int n = snprintf(buf, cap,
+                         "# ALARM_SNAPSHOT,event=%s,elapsed_ms=%lu,window_ms=%lu,samples=%lu\r\n%s\r\n",
+                         PreTrigger::eventName(event), (unsigned long)rec.elapsedMs,
+                         (unsigned long)snap.windowMs, (unsigned long)snap.count,
+                         PreTrigger::COLUMNS);
+  if (n <= 0) return;
+  const size_t len = n + snap.formatRows("", buf + n, cap - n);
+  const char*  file = s_snapshotFiles[rec.slot];
+  const bool   ok  = SDManager::writeSnapshot(file, buf, len);
+  if (!ok) s_snapshotDropped.fetch_add(1, std::memory_order_relaxed);
+
+  // 生ログ側にも、どのファイルに何を残したか（失敗も）を記録する
+  char line[LogRecovery::MAX_LINE];
+  snprintf(line, sizeof(line), "# ALARM_SNAPSHOT,event=%s,elapsed_ms=%lu,file=%s,ok=%s\r\n",
+           PreTrigger::eventName(event), (unsigned long)rec.elapsedMs,
+           file[0] == '/' ? file + 1 : file, ok ? "true" : "false");
+  SDManager::writeFooter(line);
+}
+
+/**
+ * @brief 生データのリングを空にする（記録中なら書き、そうでなければ捨てる）
+ *
+ * @details
+ * 切断中の読取値は退避しない（要約ログの退避を優先し、RAM を分け合わない）。
+ * バスは 1 回分まとめて取る（ほとんどは RAM 上の符号化で、ブロックを書き出す
+ * write() ごとにセンサー読取へバスを譲る）。
+ */
+void SDWriter::drainRaw() {
+  RawSample s;
+  if (!s_rawOpen || s_outage.load(std::memory_order_relaxed)) {
+    while (s_rawRing.pop(s)) s_rawDiscarded++;
+    return;
+  }
+  if (s_rawRing.empty()) return;
+  SpiBusGuard bus(SpiDevice::SD);
+  while (s_rawRing.pop(s)) {
+    if (!s_rawOpen) {
+      s_rawDiscarded++;
+      continue;
+    }
+    // RUN 開始直前に読んだ値は経過 0ms として扱う（Storage_Task と同じ）
+    const int32_t  sinceStart = static_cast<int32_t>(s.timeMs - s_rawStartMs);
+    const uint32_t elapsedMs  = (sinceStart > 0) ? static_cast<uint32_t>(sinceStart) : 0;
+    if (!SDManager::writeRaw(elapsedMs, s)) {
+      // 生データ側の失敗は生ログを止めない（SDManager が記録を止める）
+      s_rawOpen = false;
+      s_rawDiscarded++;
+      continue;
+    }
+    s_rawSamples++;
+    if (s.q == INT32_MIN) s_rawFaults++;
+  }
+}
+
+/**
+ * @brief 目録へ追記（失敗してもログ自体は有効なため、エラーにはしない）
+ */
+void SDWriter::appendCatalog(const RunCatalogEntry& entry) {
+  if (!SDManager::appendCatalog(entry)) {
+    Serial.printf("[SDWriter] run catalog append failed (run %lu)\n",
+                  (unsigned long)entry.runId);
+  }
+}
+
+/**
+ * @brief SD 切断状態に入る（以降の DATA はバックログへ）
+ */
+void SDWriter::enterOutage() {
+  if (s_outage.load(std::memory_order_relaxed)) return;
+  Serial.println("[SDWriter] SD outage, buffering rows in RAM");
+  s_lastRemountMs  = millis();
+  s_remountEveryMs = SD_REMOUNT_INTERVAL_MS;
+  s_outage.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief 1 行をバックログへ退避（満杯なら SD_OUTAGE_POLICY に従う）
+ */
+void SDWriter::backlog(const SDData& data) {
+  if (s_backlog.offered() == 0) s_backlogFromMs = data.elapsedMs;
+  s_backlogToMs = data.elapsedMs;
+  s_backlog.push(data);
+  s_backlogDepth.store(static_cast<uint32_t>(s_backlog.size()), std::memory_order_relaxed);
+}
+
+/**
+ * @brief 再マウントを試み、成功したら欠損記録に続けてバックログを書き戻す
+ *
+ * @details
+ * 書き戻しの途中で再び失敗した場合は残りを退避したまま切断状態を続ける
+ * （書き戻し済みで未同期の分は次の再開時に失われた件数として数えられる）。
+ *
+ * @return true : 復帰した（バックログは空）
+ */
+bool SDWriter::tryResume() {
+  s_lastRemountMs = millis();
+  uint32_t lost = 0;
+  if (!SDManager::remount(lost)) {
+    // 抜かれたままなら試行のたびに間隔を倍にする（挿し直し後の復帰は最大でこの間隔だけ遅れる）
+    s_remountEveryMs = (s_remountEveryMs >= SD_REMOUNT_INTERVAL_MAX_MS / 2)
+                     ? SD_REMOUNT_INTERVAL_MAX_MS : s_remountEveryMs * 2;
+    Serial.printf("[SDWriter] SD remount failed: %s (next in %lu ms)\n",
+                  SDManager::getLastError(), (unsigned long)s_remountEveryMs);
+    return false;
+  }
+
+  const uint32_t filled = static_cast<uint32_t>(s_backlog.size());
+  char line[LogRecovery::MAX_LINE];
+  snprintf(line, sizeof(line),
+           "# OUTAGE,from_ms=%lu,to_ms=%lu,filled=%lu,dropped=%lu,unsynced_lost=%lu,"
+           "policy=%s,stride=%lu\r\n",
+           (unsigned long)s_backlogFromMs, (unsigned long)s_backlogToMs, (unsigned long)filled,
+           (unsigned long)s_backlog.dropped(), (unsigned long)lost,
+           (s_backlog.policy() == BacklogPolicy::DECIMATE) ? "decimate" : "drop_oldest",
+           (unsigned long)s_backlog.stride());
+  bool ok;
+  {
+    SpiBusGuard bus(SpiDevice::SD);
+    ok = SDManager::writeFooter(line);
+    while (ok && !s_backlog.empty()) {
+      ok = SDManager::writeData(s_backlog.front());
+      if (ok) s_backlog.pop();
+    }
+    ok = ok && SDManager::flush();
+  }
+  s_backlogDepth.store(static_cast<uint32_t>(s_backlog.size()), std::memory_order_relaxed);
+  s_outageLost += lost;
+  if (!ok) {
+    Serial.printf("[SDWriter] SD replay failed, %lu rows still buffered\n",
+                  (unsigned long)s_backlog.size());
+    return false;
+  }
+
+  s_outageCount++;
+  s_outageFilled += filled;
+  s_outageLost   += s_backlog.dropped();
+  Serial.printf("[SDWriter] SD resumed: %lu rows replayed (%lu ms - %lu ms), %lu lost\n",
+                (unsigned long)filled, (unsigned long)s_backlogFromMs,
+                (unsigned long)s_backlogToMs, (unsigned long)(lost + s_backlog.dropped()));
+  s_backlog.clear();
+  s_outage.store(false, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,149 @@
+#include "SpiBus.h"
+#include "Global.h"
+#include <M5Stack.h>   // TFCARD_CS_PIN
+
+// ── 静的メンバー変数の実装 ─────────────────────────────────────────────────────
+SemaphoreHandle_t     SpiBus::s_mutex = nullptr;
+std::atomic<uint32_t> SpiBus::s_sensorWaiting(0);
+TaskHandle_t          SpiBus::s_owner       = nullptr;
+uint32_t              SpiBus::s_depth       = 0;
+SpiDevice             SpiBus::s_holder      = SpiDevice::SD;
+uint32_t              SpiBus::s_holdStartUs = 0;
+SpiBus::Stats         SpiBus::s_stats[static_cast<size_t>(SpiDevice::COUNT)] = {};
+uint32_t              SpiBus::s_windowStartUs = 0;
+
+namespace {
+  // SpiDevice の順（SENSOR / LCD / SD）
+  const SpiDeviceConfig DEVICE_CONFIGS[] = {
+    {"sensor", MAX31855_CS,   SPI_SENSOR_CLOCK_HZ, SPI_MODE0},
+    {"lcd",    LCD_CS_PIN,    SPI_LCD_CLOCK_HZ,    SPI_MODE0},
+    {"sd",     TFCARD_CS_PIN, SPI_SD_CLOCK_HZ,     SPI_MODE0},
+  };
+}
+
+// ================================ 実装部分 ====================================
+
+/**
+ * @brief バス排他用の再帰ミューテックスを生成
+ */
+void SpiBus::init() {
+  if (s_mutex == nullptr) {
+    // UI 描画中に SD 書き込みを呼ぶ等の入れ子に備えて再帰ミューテックスを使う
+    s_mutex = xSemaphoreCreateRecursiveMutex();
+    s_windowStartUs = micros();
+  }
+}
+
+/**
+ * @brief バスを獲得
+ */
+void SpiBus::lock(SpiDevice dev) {
+  if (s_mutex == nullptr) return;
+  const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  if (s_depth > 0 && s_owner == self) {
+    // 入れ子: 既に保持している
+    xSemaphoreTakeRecursive(s_mutex, portMAX_DELAY);
+    s_depth++;
+    return;
+  }
+
+  const uint32_t t0 = micros();
+  if (dev == SpiDevice::SENSOR) {
+    s_sensorWaiting.fetch_add(1, std::memory_order_acq_rel);
+    xSemaphoreTakeRecursive(s_mutex, portMAX_DELAY);
+    s_sensorWaiting.fetch_sub(1, std::memory_order_acq_rel);
+  } else {
+    // センサーが待っている間は新たに獲得しない（センサー読取は数十 µs）
+    while (s_sensorWaiting.load(std::memory_order_acquire) > 0 &&
+           micros() - t0 < SPI_YIELD_SPIN_US) {
+    }
+    xSemaphoreTakeRecursive(s_mutex, portMAX_DELAY);
+  }
+
+  const uint32_t now  = micros();
+  Stats&         s    = s_stats[static_cast<size_t>(dev)];
+  const uint32_t wait = now - t0;
+  s.grants++;
+  if (wait > s.waitMaxUs) s.waitMaxUs = wait;
+  s_owner       = self;
+  s_depth       = 1;
+  s_holder      = dev;
+  s_holdStartUs = now;
+}
+
+/**
+ * @brief バスを解放
+ */
+void SpiBus::unlock() {
+  if (s_mutex == nullptr) return;
+  if (s_depth == 1) {
+    account();
+    s_owner = nullptr;
+  }
+  if (s_depth > 0) s_depth--;
+  xSemaphoreGiveRecursive(s_mutex);
+}
+
+/**
+ * @brief センサーが待っていればバスを一時的に明け渡す
+ */
+void SpiBus::yield() {
+  if (s_mutex == nullptr || s_depth == 0) return;
+  if (s_sensorWaiting.load(std::memory_order_acquire) == 0) return;
+  if (s_owner != xTaskGetCurrentTaskHandle()) return;
+
+  const SpiDevice dev   = s_holder;
+  const uint32_t  depth = s_depth;
+  account();
+  s_owner = nullptr;
+  s_depth = 0;
+  for (uint32_t i = 0; i < depth; ++i) xSemaphoreGiveRecursive(s_mutex);
+
+  // センサーが獲得するのを見届ける（別コアのため数 µs。同じコアの低優先タスクなら打ち切る）
+  const uint32_t t0 = micros();
+  while (s_sensorWaiting.load(std::memory_order_acquire) > 0 &&
+         micros() - t0 < SPI_YIELD_SPIN_US) {
+  }
+  for (uint32_t i = 0; i < depth; ++i) xSemaphoreTakeRecursive(s_mutex, portMAX_DELAY);
+
+  s_stats[static_cast<size_t>(dev)].yields++;
+  s_owner       = xTaskGetCurrentTaskHandle();
+  s_depth       = depth;
+  s_holder      = dev;
+  s_holdStartUs = micros();
+}
+
+/**
+ * @brief デバイスのトランザクション設定
+ */
+const SpiDeviceConfig& SpiBus::config(SpiDevice dev) {
+  return DEVICE_CONFIGS[static_cast<size_t>(dev)];
+}
+
+/**
+ * @brief デバイスごとの利用率・待ち時間を出力し、区間をリセット
+ *
+ * @details 他タスクがバス保持中でも読む（診断用の近似値）
+ */
+void SpiBus::dump(Print& out) {
+  const uint32_t now    = micros();
+  const uint32_t window = now - s_windowStartUs;
+  out.printf("[SPI] window=%lums\n", (unsigned long)(window / 1000));
+  for (size_t i = 0; i < static_cast<size_t>(SpiDevice::COUNT); ++i) {
+    const Stats&           s = s_stats[i];
+    const SpiDeviceConfig& c = DEVICE_CONFIGS[i];
+    const float util = (window > 0) ? 100.0f * static_cast<float>(s.busyUs) / window : 0.0f;
+    out.printf("[SPI] %-6s cs=%u clk=%luHz grants=%lu busy=%.1f%% wait_max=%luus yields=%lu\n",
+               c.name, (unsigned)c.csPin, (unsigned long)c.clockHz, (unsigned long)s.grants,
+               util, (unsigned long)s.waitMaxUs, (unsigned long)s.yields);
+    s_stats[i] = Stats();
+  }
+  s_windowStartUs = now;
+}
+
+/**
+ * @brief 保持時間を保持中のデバイスに計上（最も外側の解放・明け渡し時）
+ */
+void SpiBus::account() {
+  s_stats[static_cast<size_t>(s_holder)].busyUs += micros() - s_holdStartUs;
+}
@@ -1,20 +1,43 @@
 #include "Global.h"
 #include "SDManager.h"      // Phase 4: SD カード操作
+#include "SeqLock.h"        // コア間スナップショット
+#include "SpiBus.h"         // 共有 SPI バス排他
+#include "PerfMonitor.h"    // タスク処理時間ヒストグラム
+#include "ProfileZone.h"    // サイクルカウンタ・プロファイリング
+#include "PowerManager.h"   // 省電力ガバナー（操作検出）
+#include "SDBenchmark.h"    // SD 書き込み方式ベンチマーク
+#include "SDWriter.h"       // SD 書き込みタスク（SPSC リング経由）
+#include "RtcClock.h"       // 実時刻（RAM 上の時計、I²C は補正時のみ）
+#include "FixedFormat.h"    // printf を使わない数値整形
 #include <SPI.h>
 
-// センサー読み取りヘルパー
-static float readThermocouple() {
+// 区間内の経過時間は int32 で扱う（Storage_Task）ため、区間の長さはその範囲に収める
+static_assert(SD_SEGMENT_MAX_MS <= SoakLog::MAX_SEGMENT_MS,
+              "SD_SEGMENT_MAX_MS exceeds the int32 elapsed time of a segment");
+
+// センサー読み取りヘルパー（errorBits: NaN のときの故障ビット、生データ記録用）
+static float readThermocouple(uint8_t& errorBits) {
+  PROFILE_ZONE("readThermocouple");
   if (UI::SHOW_DEBUG_LOGS) Serial.println("[IO_Task] about to begin thermocouple read");
   const int maxRetry = 3;
   float temp = NAN;
   unsigned long start = 0, end = 0;
   for (int attempt = 0; attempt < maxRetry; ++attempt) {
     start = millis();
-    temp = thermocouple.readCelsius();
+    {
+      SpiBusGuard bus(SpiDevice::SENSOR);  // LCD / SD（制御コア）とのバス衝突を防ぐ
+      PROFILE_ZONE("readCelsius");
+      temp = thermocouple.readCelsius();
+    }
     end = millis();
     if (!isnan(temp) && fabs(temp) < 1000.0f) break;
     delay(5);
   }
+  errorBits = 0;
+  if (isnan(temp)) {
+    SpiBusGuard bus(SpiDevice::SENSOR);
+    errorBits = thermocouple.readError();
+  }
   if (UI::SHOW_DEBUG_LOGS) {
     Serial.printf("[IO_Task] readCelsius returned in %lums\n", (end - start));
     if (isnan(temp)) Serial.println("[IO_Task] readCelsius -> NAN");
@@ -33,10 +56,206 @@ bool EEPROM_ValidateSettings(bool printDetail = true);
 GlobalData        G;
 Adafruit_MAX31855 thermocouple(MAX31855_CS);
 
+// ── コア間スナップショット ────────────────────────────────────────────────────
+// s_io は IO コア専有の作業コピー。制御コアは s_ioSnapshot 経由でのみ参照する。
+namespace {
+  IOSnapshot               s_io            = {NAN, NAN, 0, 0, false, false, 0, 0, 0};
+  SeqLock<IOSnapshot>      s_ioSnapshot;
+  SeqLock<ControlSnapshot> s_controlSnapshot;
+  uint32_t                 s_alarmResetSeq = 0;  // 制御コア側で管理
+
+  /**
+   * @brief 閉じた集約区間を SD 書き込みタスクへ渡す（G.M_Rollup の出力先）
+   */
+  struct RollupToSD {
+    void operator()(const RollupRow& row) {
+      if (!SDWriter::pushRollup(row)) Serial.println("[Storage_Task] SD ring full, rollup dropped");
+    }
+  };
+  RollupToSD               s_rollupToSD;
+
+  // SD マウント（SDWriter の MOUNT）の依頼状態。制御コアのみが参照
+  bool          s_mountPending = false;   // 結果待ち
+  bool          s_mountTried   = false;   // 1 回以上依頼した（初回は起動直後に即時）
+  unsigned long s_mountLastMs  = 0;       // 最後に依頼した時刻 (millis)
+  unsigned long s_mountEveryMs = SD_MOUNT_RETRY_MS;  // 次の再試行までの間隔（失敗ごとに倍）
+
+  /**
+   * @brief SD マウントの依頼と結果の反映（Storage_Task から毎周期）
+   *
+   * @details
+   * マウント・目録の読み込みは書き込みタスクが行い、ここは結果を G に反映するだけ
+   * （カードが無いときの SD.begin() の待ちで制御周期を止めない）。
+   * 未マウント・エラーの間は IDLE で再試行し、起動後に挿した（挿し直した）カードも次の RUN から
+   * 記録する。間隔は SD_MOUNT_RETRY_MS から失敗ごとに倍（SD_MOUNT_RETRY_MAX_MS まで）にし、
+   * カードが無いままでも書き込みタスクがバスを取る回数を抑える（カードの有無は SD.begin() の
+   * 前に CMD0 で確かめる）。成功したらカードの計測と復旧を続けて依頼する。
+   */
+  void serviceMount(unsigned long now) {
+    if (s_mountPending) {
+      bool     ok;
+      uint32_t nextRunId;
+      if (!SDWriter::takeMount(ok, nextRunId)) return;
+      s_mountPending = false;
+      if (ok) {
+        G.M_SDReady    = true;
+        G.M_SDError    = false;
+        s_mountEveryMs = SD_MOUNT_RETRY_MS;
+        // 次の RUN 番号は目録の末尾から（ディレクトリは走査しない）。挿し直し後は目録に
+        // 書けなかった RUN もあり得るため、この起動中に使った番号より戻さない
+        if (nextRunId > G.M_NextRunId) G.M_NextRunId = nextRunId;
+        Serial.println("SD card OK");
+        Serial.printf("Next run: %lu\n", (unsigned long)G.M_NextRunId);
+        // カードを計測（初回のみ）して同期方針を選ぶ。結果はカード履歴（CARDS.LOG）にも残る。
+        // 計測は数秒かかるため書き込みタスクで行う（その間も UI・記録判定は止めない）
+        SDWriter::profileCard();
+        // 前回電源断で閉じられなかったログを書き込みタスクで復旧（計測開始は待たない）
+        SDWriter::recover();
+      } else {
+        // 再試行の失敗は報告しない（エラーになった時のみ）。LCD 表示は UI_Task() に委譲
+        if (!G.M_SDError) {
+          Serial.println("WARNING: SD card init failed");
+          Serial.printf("  Error: %s\n", SDManager::getLastError());
+        }
+        G.M_SDReady = false;
+        G.M_SDError = true;
+        s_mountEveryMs = (s_mountEveryMs >= SD_MOUNT_RETRY_MAX_MS / 2) ? SD_MOUNT_RETRY_MAX_MS
+                                                                       : s_mountEveryMs * 2;
+      }
+      return;
+    }
+
+    // 書き込みエラー（OPEN 失敗・切断のまま RUN 終了など）も、マウントし直せたら解除する
+    if ((G.M_SDReady && !G.M_SDError) || G.M_CurrentState != State::IDLE) return;
+    if (s_mountTried && now - s_mountLastMs < s_mountEveryMs) return;
+    s_mountTried   = true;
+    s_mountLastMs  = now;
+    s_mountPending = SDWriter::mount(G.M_SDError);
+  }
+
+  /**
+   * @brief アラーム変化ごとにプリトリガの窓を DATA_xxxx_aNN.csv へ（RUN あたり上限あり）
+   * @param before / after 変化前後のアラームフラグ
+   * @param eventMs トリガ時刻 (millis)
+   * @param elapsedMs トリガの RUN 開始からの経過時間
+   */
+  void snapshotAlarms(uint8_t before, uint8_t after, uint32_t eventMs, uint32_t elapsedMs) {
+    PreTrigger::Event events[2];
+    const size_t n = PreTrigger::eventsFor(before, after, events);
+    for (size_t i = 0; i < n; ++i) {
+      if (G.M_RunAlarmSnapshots >= SD_ALARM_SNAPSHOTS_PER_RUN) return;
+      // 記録中のログと並べた名前（"/DATA_0003.csv" → "/DATA_0003_a01.csv"）
+      const char* dot  = strrchr(G.M_SegmentFile, '.');
+      const int   stem = dot ? static_cast<int>(dot - G.M_SegmentFile)
+                             : static_cast<int>(strlen(G.M_SegmentFile));
+      char name[SD_MAX_FILENAME];
+      snprintf(name, sizeof(name), "%.*s_a%02u.csv", stem, G.M_SegmentFile,
+               (unsigned)(G.M_RunAlarmSnapshots + 1));
+      if (!SDWriter::pushSnapshot(G.M_PreTrigger, events[i], eventMs, elapsedMs, name)) {
+        Serial.println("[Storage_Task] alarm snapshot dropped");
+        continue;
+      }
+      G.M_RunAlarmSnapshots++;
+    }
+  }
+
+  /**
+   * @brief ソーク: 記録中の区間がサイズ・時間の上限に達していれば次の区間へ
+   * @param eventMs 次の区間の最初のレコードの時刻 (millis)。区間内の ElapsedMs の基準になる
+   * @return true : 切り替えを依頼した
+   */
+  bool rollSegment(uint32_t eventMs) {
+    if (G.M_SegmentIndex >= SoakLog::MAX_SEGMENTS) return false;
+    // 書き込みタスクがまだ前の切り替えを処理していなければバイト数は分からない（次の周期で）
+    uint32_t bytes = 0;
+    if (!SDWriter::segmentBytes(G.M_SegmentIndex, bytes)) return false;
+    const int32_t  sinceSeg  = static_cast<int32_t>(eventMs - G.M_SegmentStartTime);
+    const uint32_t segmentMs = (sinceSeg > 0) ? static_cast<uint32_t>(sinceSeg) : 0;
+    if (!SoakLog::segmentDue(bytes, segmentMs, SD_SEGMENT_MAX_BYTES, SD_SEGMENT_MAX_MS)) {
+      return false;
+    }
+
+    SegmentInfo seg;
+    seg.runId         = G.M_RunId;
+    seg.index         = static_cast<uint16_t>(G.M_SegmentIndex + 1);
+    seg.runOffsetMs   = G.M_RunClock.widen(eventMs) - G.M_RunStartTime64;
+    seg.samplesBefore = static_cast<uint64_t>(G.D_Count);
+    char name[SD_MAX_FILENAME];
+    SoakLog::segmentName(G.M_CurrentDataFile, seg.index, name, sizeof(name));
+
+    // 区間の集約ログは前の区間と一緒に閉じる（FIFO のため SEGMENT より先に書かれる）
+    G.M_Rollup.finish(s_rollupToSD);
+    if (!SDWriter::openSegment(name, G.M_LogFormat, G.D_HI_ALARM_CURRENT, G.D_LO_ALARM_CURRENT,
+                               G.M_RawCapture, eventMs, seg, RtcClock::wallMsAt(eventMs))) {
+      G.M_SDError = true;
+      Serial.println("[Storage_Task] SD segment request failed");
+      return false;
+    }
+    Serial.printf("[Storage_Task] SD segment %u: %s (%lu bytes, %lu ms)\n", (unsigned)seg.index,
+                  name, (unsigned long)bytes, (unsigned long)segmentMs);
+    G.M_Rollup.reset();
+    G.M_LogFilter.restart();   // 区間の最初のイベントは必ず記録（判定統計は RUN 全体で続ける）
+    G.M_SegmentIndex     = seg.index;
+    G.M_SegmentStartTime = eventMs;
+    strncpy(G.M_SegmentFile, name, sizeof(G.M_SegmentFile) - 1);
+    G.M_SegmentFile[sizeof(G.M_SegmentFile) - 1] = '\0';
+    return true;
+  }
+
+  /**
+   * @brief 終了した RUN の要約（目録の END レコード、RUN → RESULT 遷移時の統計から）
+   */
+  RunCatalogEntry runSummary() {
+    RunCatalogEntry e;
+    memset(&e, 0, sizeof(e));
+    e.runId         = G.M_RunId;
+    e.kind          = RunCatalog::END;
+    e.logFormat     = static_cast<uint8_t>(G.M_LogFormat);
+    e.flags         = G.M_SDError ? RunCatalog::FLAG_SD_ERROR : 0;
+    e.startUptimeMs = G.M_RunStartTime;
+    // 目録の欄は 32 ビット（ソークで超えたら飽和。区間の "# SEGMENT,..." 行に 64 ビットで残る）
+    const uint64_t duration = G.M_RunClock.extend(millis()) - G.M_RunStartTime64;
+    e.durationMs    = (duration > 0xFFFFFFFFull) ? 0xFFFFFFFFUL : static_cast<uint32_t>(duration);
+    e.samples       = (G.D_Count > 0xFFFFFFFFLL) ? 0xFFFFFFFFUL : static_cast<uint32_t>(G.D_Count);
+    e.average       = G.D_Average;
+    e.stdDev        = G.D_StdDev;
+    e.minimum       = (G.D_Count > 0) ? G.D_Min : NAN;
+    e.maximum       = (G.D_Count > 0) ? G.D_Max : NAN;
+    e.hiAlarms      = G.M_RunHiAlarms;
+    e.loAlarms      = G.M_RunLoAlarms;
+    strncpy(e.fileName, G.M_CurrentDataFile, sizeof(e.fileName) - 1);
+    return e;
+  }
+
+  /**
+   * @brief LCD の値表示 printf("%6.1f<sep><unit>") と同じ文字列（FixedFormat、静的バッファ）
+   */
+  const char* formatValue(float value, const char* sep, const char* unit) {
+    static char buf[64];
+    char* p = FixedFormat::putFloat(buf, value, 1, 6);
+    p = FixedFormat::putStr(p, sep);
+    p = FixedFormat::putStr(p, unit);
+    *p = '\0';
+    return buf;
+  }
+
+  /**
+   * @brief "Samples: %5ld" と同じ文字列（out は 40 バイト以上）
+   */
+  void formatSamples(char* out, int64_t count) {
+    char* p = FixedFormat::putStr(out, "Samples: ");
+    p = (count <= INT32_MAX) ? FixedFormat::putIntPad(p, static_cast<int32_t>(count), 5)
+                             : FixedFormat::putUint64(p, static_cast<uint64_t>(count));
+    *p = '\0';
+  }
+}
+
 // ── グローバルデータ初期化 ────────────────────────────────────────────────────
 void initGlobalData() {
   G.D_RawPV        = NAN;   // 未読取を明示 (isnan() で検査可能)
   G.D_FilteredPV   = NAN;   // setup() でセンサ初読取後に上書き
+  G.D_SampleSeq    = 0;
+  G.D_SampleTimeMs = 0;
   G.D_Sum          = 0.0;
   G.D_Count        = 0;
   G.D_Average      = NAN;
@@ -58,12 +277,29 @@ void initGlobalData() {
   // Phase 4: SDカード関連初期化
   G.M_SDReady          = false;      // SD未検出状態で開始
   G.M_SDError          = false;      // エラーなし
+  G.M_SDOutage         = false;
   G.M_CurrentDataFile[0] = '\0';     // ファイル名クリア (空文字列)
+  G.M_NextRunId        = 0;          // SD マウント後に目録から読む
+  G.M_RunId            = 0;
+  G.M_RunHiAlarms      = 0;
+  G.M_RunLoAlarms      = 0;
+  G.M_LogFormat        = SD_LOG_FORMAT_DEFAULT;
+  G.M_LogDeadband      = SD_DEADBAND_DEFAULT;
+  G.M_RawCapture       = SD_RAW_CAPTURE_DEFAULT;
+  G.M_RunAlarmSnapshots = 0;
+  G.M_PreTrigger.clear();
+  G.M_SoakMode         = SD_SOAK_DEFAULT;
+  G.M_RunClock.reset(millis());
+  G.M_RunStartTime64   = 0;
+  G.M_SegmentIndex     = 0;
+  G.M_SegmentStartTime = 0;
+  G.M_SegmentFile[0]   = '\0';
   G.M_SDWriteCounter   = 0;          // カウンタリセット
   G.M_RunStartTime     = 0;          // RUN開始時刻未定義
   
   // SDBuffer 初期化（メンバー初期化）
   G.M_SDBuffer.elapsedSeconds = 0;
+  G.M_SDBuffer.elapsedMs      = 0;
   G.M_SDBuffer.temperature    = NAN;
   G.M_SDBuffer.state          = "IDLE";
   G.M_SDBuffer.sampleCount    = 0;
@@ -73,6 +309,7 @@ void initGlobalData() {
   G.M_SDBuffer.minTemp        = NAN;
   G.M_SDBuffer.hiAlarm        = false;
   G.M_SDBuffer.loAlarm        = false;
+  G.M_SDBuffer.wallMs         = -1;
 }
 
 // ========== Phase 3 アラーム判定ロジック関数 ================================
@@ -160,8 +397,18 @@ void updateAlarmFlags(float currentTemp, float hiThreshold, float loThreshold,
   }
 }
 
-// ========== IO Layer (10ms周期) ==================================================
+// ========== IO Layer (10ms周期 / IO コア) =========================================
+/**
+ * @brief IO タスク本体（センサ読取・ボタン入力・アラーム判定）
+ *
+ * @details
+ * IO コア上で実行され、G には一切書き込まない。結果は IOSnapshot として
+ * s_ioSnapshot に publish し、制御コアは syncFromIOSnapshot() で取り込む。
+ * 閾値・状態は制御コアが公開した ControlSnapshot から読む（双方ロック無し）。
+ * SD 書き込みなど遅い処理は Storage_Task()（制御コア）へ移した。
+ */
 void IO_Task() {
+  PROFILE_ZONE("IO_Task");
   // DEBUG: エントリログ（出力頻度を制限してシリアル洪水を防ぐ）
   if (UI::SHOW_DEBUG_LOGS) {
     static unsigned long lastIoLogMs = 0;
@@ -172,23 +419,49 @@ void IO_Task() {
     }
   }
 
+  // 制御コアが公開した閾値・アラームリセット要求を取得
+  static uint32_t seenAlarmReset = 0;
+  const ControlSnapshot ctrl = s_controlSnapshot.read();
+  if (ctrl.alarmResetSeq != seenAlarmReset) {
+    seenAlarmReset = ctrl.alarmResetSeq;
+    s_io.hiAlarm = false;
+    s_io.loAlarm = false;
+  }
+
   // MAX31855 の変換時間に合わせ、TC_READ_INTERVAL_MS ごとに読み取る。
   // フィルタは新データ到着時のみ適用（同じ値で繰り返すとα=0.1の意味が消える）。
+  // 起動直後は初回の有効サンプルを早く得るため、パワーオン安定待ち
+  // （SETUP_SENSOR_DELAY_MS）経過後から BOOT_PROBE_INTERVAL_MS 間隔で読む。
+  // 生データ記録中は TC_CAPTURE_INTERVAL_MS（最大変換レート）で読み、全読取値を
+  // SD 書き込みタスクへ渡す。フィルタ・要約ログは従来どおり TC_READ_INTERVAL_MS 間隔
+  // （α の時定数と要約ログの行間隔を変えない）。
   static unsigned long lastTcRead = 0;
   const unsigned long  now        = millis();
+  const bool           probing    = (s_io.sampleSeq == 0);
+  const unsigned long  readInterval = probing        ? BOOT_PROBE_INTERVAL_MS
+                                    : ctrl.rawCapture ? TC_CAPTURE_INTERVAL_MS
+                                                      : TC_READ_INTERVAL_MS;
 
-  if (now - lastTcRead >= TC_READ_INTERVAL_MS) {
+  if ((!probing || now >= SETUP_SENSOR_DELAY_MS) &&
+      (lastTcRead == 0 || now - lastTcRead >= readInterval)) {
     lastTcRead = now;
 
-    float rawTemp = readThermocouple();
-    if (!isnan(rawTemp)) {
-      G.D_RawPV = rawTemp;
+    uint8_t errorBits = 0;
+    float rawTemp = readThermocouple(errorBits);
+    if (ctrl.rawCapture) {
+      // 満杯なら破棄（リング統計に計上、CLOSE 時のフッタで分かる）。IO 周期は止めない
+      SDWriter::pushRaw(RawCapture::sample(now, rawTemp, errorBits));
+    }
+    if (!isnan(rawTemp) && (probing || now - s_io.sampleTimeMs >= TC_READ_INTERVAL_MS)) {
+      s_io.rawPV = rawTemp;
       // 1次遅れフィルタ: y[n] = y[n-1]*(1-α) + x[n]*α
       // α=0.1 のとき約22サンプル(11秒)で新値の90%に収束
-      G.D_FilteredPV = isnan(G.D_FilteredPV)
-                     ? rawTemp
-                     : G.D_FilteredPV * (1.0f - FILTER_ALPHA)
-                       + rawTemp      *           FILTER_ALPHA;
+      s_io.filteredPV = isnan(s_io.filteredPV)
+                      ? rawTemp
+                      : s_io.filteredPV * (1.0f - FILTER_ALPHA)
+                        + rawTemp       *           FILTER_ALPHA;
+      s_io.sampleSeq++;
+      s_io.sampleTimeMs = now;
     }
   }
 
@@ -200,7 +473,7 @@ void IO_Task() {
   // ── BtnA 処理（シンプルなエッジ検出）──
   const bool  btnANow  = M5.BtnA.isPressed();
   if (btnANow && !btnAPrev) {
-    G.M_BtnA_Pressed = true;  // 立ち上がりエッジ
+    s_io.btnAEdges++;  // 立ち上がりエッジ（制御コアで M_BtnA_Pressed に変換）
     if (UI::SHOW_DEBUG_LOGS) Serial.println("[IO_Task] BtnA pressed (edge)");
   }
   btnAPrev = btnANow;
@@ -208,7 +481,7 @@ void IO_Task() {
   // ── BtnB 処理（RESULT ページング / 設定調整 / ALARM_SETTING進入）──
   const bool  btnBNow  = M5.BtnB.isPressed();
   if (btnBNow && !btnBPrev) {
-    G.M_BtnB_Pressed = true;  // 立ち上がりエッジ（Logic_Task で状態別に処理）
+    s_io.btnBEdges++;  // 立ち上がりエッジ（Logic_Task で状態別に処理）
     if (UI::SHOW_DEBUG_LOGS) Serial.println("[IO_Task] BtnB pressed (edge)");
   }
   btnBPrev = btnBNow;
@@ -216,11 +489,14 @@ void IO_Task() {
   // ── BtnC 処理（設定モード用）──
   const bool btnCNow = M5.BtnC.isPressed();
   if (btnCNow && !btnCPrev) {
-    G.M_BtnC_Pressed = true;  // 立ち上がりエッジ（ALARM_SETTING時に -5℃）
+    s_io.btnCEdges++;  // 立ち上がりエッジ（ALARM_SETTING時に -5℃）
     if (UI::SHOW_DEBUG_LOGS) Serial.println("[IO_Task] BtnC pressed (edge)");
   }
   btnCPrev = btnCNow;
 
+  // 押下中・押下直後は省電力ガバナーをフルクロックに保つ（画面遷移の描画用）
+  if (btnANow || btnBNow || btnCNow) PowerManager::noteActivity();
+
   // Phase 3: アラーム判定（ヒステリシス付き、EEPROM値を使用）
   // デバッグ出力用タイマー（5秒ごと）
   static unsigned long lastAlarmDebug = 0;
@@ -229,55 +505,183 @@ void IO_Task() {
     lastAlarmDebug = now;
     if (UI::SHOW_DEBUG_LOGS) {
       Serial.printf("[ALARM_DEBUG] Temp=%.1f, HI=%.1f, LO=%.1f, HiAlarm=%d, LoAlarm=%d\n",
-                    G.D_FilteredPV, G.D_HI_ALARM_CURRENT, G.D_LO_ALARM_CURRENT,
-                    G.M_HiAlarm, G.M_LoAlarm);
+                    s_io.filteredPV, ctrl.hiThreshold, ctrl.loThreshold,
+                    s_io.hiAlarm, s_io.loAlarm);
     }
   }
 
   // ← アラーム判定ロジックを専用関数に委譲
-  updateAlarmFlags(G.D_FilteredPV, G.D_HI_ALARM_CURRENT, G.D_LO_ALARM_CURRENT,
-                   ALARM_HYSTERESIS, G.M_HiAlarm, G.M_LoAlarm);
+  updateAlarmFlags(s_io.filteredPV, ctrl.hiThreshold, ctrl.loThreshold,
+                   ALARM_HYSTERESIS, s_io.hiAlarm, s_io.loAlarm);
+
+  // 制御コアへ公開（待ち無し）
+  s_ioSnapshot.publish(s_io);
+}
+
+// ========== コア間スナップショット操作 ==========================================
+
+/**
+ * @brief IO コアが最後に公開したスナップショットを取得
+ */
+IOSnapshot readIOSnapshot() {
+  return s_ioSnapshot.read();
+}
+
+/**
+ * @brief 制御コアが最後に公開したスナップショットを取得
+ */
+ControlSnapshot readControlSnapshot() {
+  return s_controlSnapshot.read();
+}
+
+/**
+ * @brief IOSnapshot を G に反映（制御コア周期の先頭で 1 回呼ぶ）
+ *
+ * @details
+ * ボタンはエッジ累計カウンタの差分で検出するため、IO 側で何回押されても
+ * 取りこぼしやコア間のフラグ競合が起きない。
+ */
+void syncFromIOSnapshot() {
+  static uint8_t seenBtnA = 0;
+  static uint8_t seenBtnB = 0;
+  static uint8_t seenBtnC = 0;
+
+  const IOSnapshot io = s_ioSnapshot.read();
+  G.D_RawPV      = io.rawPV;
+  G.D_FilteredPV = io.filteredPV;
+  G.D_SampleSeq    = io.sampleSeq;
+  G.D_SampleTimeMs = io.sampleTimeMs;
+  G.M_HiAlarm    = io.hiAlarm;
+  G.M_LoAlarm    = io.loAlarm;
+
+  if (io.btnAEdges != seenBtnA) { seenBtnA = io.btnAEdges; G.M_BtnA_Pressed = true; }
+  if (io.btnBEdges != seenBtnB) { seenBtnB = io.btnBEdges; G.M_BtnB_Pressed = true; }
+  if (io.btnCEdges != seenBtnC) { seenBtnC = io.btnCEdges; G.M_BtnC_Pressed = true; }
+}
+
+/**
+ * @brief 閾値・状態を IO コアへ公開（Logic_Task 終了時・EEPROM ロード後）
+ */
+void publishControlSnapshot() {
+  ControlSnapshot ctrl;
+  ctrl.state         = G.M_CurrentState;
+  ctrl.hiThreshold   = G.D_HI_ALARM_CURRENT;
+  ctrl.loThreshold   = G.D_LO_ALARM_CURRENT;
+  ctrl.alarmResetSeq = s_alarmResetSeq;
+  // 生データのファイルは RUN 開始時の OPEN で作られる（SD が無い・エラー中は読取間隔も変えない）
+  ctrl.rawCapture    = G.M_RawCapture && G.M_CurrentState == State::RUN &&
+                       G.M_SDReady && !G.M_SDError;
+  s_controlSnapshot.publish(ctrl);
+}
+
+/**
+ * @brief IO コアにアラームフラグのクリアを依頼
+ *
+ * @details
+ * アラームフラグの所有者は IO コアなので、G.M_HiAlarm を直接書き換えても
+ * 次周期の syncFromIOSnapshot() で上書きされる。カウンタを進めて依頼する。
+ */
+void requestAlarmReset() {
+  s_alarmResetSeq++;
+  G.M_HiAlarm = false;
+  G.M_LoAlarm = false;
+  publishControlSnapshot();
+}
+
+// ========== Storage Layer (10ms周期 / 制御コア) ==================================
+/**
+ * @brief RUN 中の SD 記録レコード生成（旧 IO_Task 後半）
+ *
+ * @details
+ * 制御コアで IO_CYCLE_MS ごとに呼び出す。記録のきっかけは「新しいセンサ値」
+ * （D_SampleSeq の更新）と「アラーム状態の変化」で、記録するかは
+ * G.M_LogFilter（LogFilter.h: 全件 / デッドバンド）が判定する。
+ * 集約ログ（G.M_Rollup、1 秒 / 1 分 / 1 時間）は間引き前の全サンプルから作る。
+ * 時刻はサンプル取得時刻（アラーム変化のみのときは現在時刻）の RUN 開始からの経過 ms。
+ * 実際の書き込みは SDWriter タスクが行うため、ここはリングに積むだけで SD のストールを待たない。
+ * SD 切断中（G.M_SDOutage）も積み続け、退避と再マウントは SDWriter に任せる。
+ */
+void Storage_Task() {
+  PROFILE_ZONE("Storage_Task");
+  const unsigned long now = millis();
+  G.M_RunClock.extend(now);   // 49.7 日の一周を取りこぼさないよう毎周期進める
+
+  serviceMount(now);
+
+  // 書き込みタスクで発生した失敗を UI / 状態に反映
+  if (SDWriter::takeError()) {
+    G.M_SDError = true;
+    Serial.printf("[Storage_Task] SD write failed: %s\n", SDManager::getLastError());
+  }
+  G.M_SDOutage = SDWriter::inOutage();
+
+  // RUN 外のサンプル・アラーム変化も追跡し、RUN 開始直前の値を新しいイベントと誤認しない
+  static uint32_t lastSeq   = 0;
+  static uint8_t  lastFlags = 0;
+  const uint8_t flags = (G.M_HiAlarm ? BinaryLog::FLAG_HI_ALARM : 0) |
+                        (G.M_LoAlarm ? BinaryLog::FLAG_LO_ALARM : 0);
+  const bool newSample   = (G.D_SampleSeq != lastSeq);
+  const bool alarmChange = (flags != lastFlags);
+  const uint8_t rising   = flags & ~lastFlags;
+  const uint8_t prevFlags = lastFlags;
+  lastSeq   = G.D_SampleSeq;
+  lastFlags = flags;
+
+  // プリトリガ: 状態に関係なく新しいセンサ値ごとに（RUN 開始・アラーム変化の直前を残す）
+  if (newSample) {
+    const PreTriggerSample sample = {G.D_SampleTimeMs, G.D_RawPV, G.D_FilteredPV, flags};
+    G.M_PreTrigger.add(sample);
+  }
+
+  // アラーム発生回数（目録の RUN 要約用）
+  if (G.M_CurrentState == State::RUN) {
+    if ((rising & BinaryLog::FLAG_HI_ALARM) && G.M_RunHiAlarms < UINT16_MAX) G.M_RunHiAlarms++;
+    if ((rising & BinaryLog::FLAG_LO_ALARM) && G.M_RunLoAlarms < UINT16_MAX) G.M_RunLoAlarms++;
+  }
 
   // ────── Phase 4: SDカード書き込みロジック ──────
   // RUN状態のみ、SD書き込みを実行
-  if (G.M_CurrentState == State::RUN && G.M_SDReady && !G.M_SDError) {
-    // 1. 現在のデータを SDBuffer に蓄積
-    G.M_SDBuffer.elapsedSeconds = (now - G.M_RunStartTime) / 1000UL;  // millis() → 秒単位
-    G.M_SDBuffer.temperature    = G.D_FilteredPV;
-    G.M_SDBuffer.state          = "RUN";
-    G.M_SDBuffer.sampleCount    = G.D_Count;
-    G.M_SDBuffer.averageTemp    = G.D_Average;
-    G.M_SDBuffer.stdDev         = G.D_StdDev;
-    G.M_SDBuffer.maxTemp        = G.D_Max;
-    G.M_SDBuffer.minTemp        = G.D_Min;
-    G.M_SDBuffer.hiAlarm        = G.M_HiAlarm;
-    G.M_SDBuffer.loAlarm        = G.M_LoAlarm;
-
-    // 2. 書き込みカウンタをインクリメント
-    G.M_SDWriteCounter++;
-
-    // 3. SD_WRITE_INTERVAL サンプル到達かつ、Welford計算が完了したら書き込み実行
-    // 【最適化】D_Count >= 10 により 100ms 経過を保証
-    //   - 100ms 時点で Logic_Task(50ms周期) が少なくとも2回実行完了
-    //   - よって D_Average, D_StdDev が確実に計算済み
-    // ※ 前回: D_Count >= 2 では 20-30ms で早期実行 → Welford未完了
-    if (G.M_SDWriteCounter >= SD_WRITE_INTERVAL && G.D_Count >= 10) {
-      // SDManager を使用してデータをSD カードに書き込み
-      if (!SDManager::writeData(G.M_SDBuffer)) {
-        // 書き込み失敗
-        G.M_SDError = true;
-        Serial.printf("[IO_Task] SD write failed: %s\n", SDManager::getLastError());
-      } else {
-        // 書き込み成功時のデバッグ出力
-        if (UI::SHOW_DEBUG_LOGS) {
-          Serial.printf("[IO_Task] SD Write: %.1f°C, Samples=%u, Avg=%.1f\n",
-                        G.M_SDBuffer.temperature, G.M_SDBuffer.sampleCount,
-                        isnan(G.M_SDBuffer.averageTemp) ? 0.0f : G.M_SDBuffer.averageTemp);
-        }
-      }
-      G.M_SDWriteCounter = 0;  // カウンタリセット
-    }
+  if (G.M_CurrentState != State::RUN || !G.M_SDReady || G.M_SDError) return;
+  if (G.M_SDWriteCounter < UINT16_MAX) G.M_SDWriteCounter++;
+  if (!newSample && !alarmChange) return;
+
+  // RUN（区間）開始直前に取得した値は経過 0ms として扱う。ソークでは区間の開始が基準
+  const uint32_t eventMs   = newSample ? G.D_SampleTimeMs : static_cast<uint32_t>(now);
+  if (G.M_SoakMode && newSample && !G.M_SDOutage) rollSegment(eventMs);
+  const int32_t  sinceStart = static_cast<int32_t>(eventMs - G.M_SegmentStartTime);
+  const uint32_t elapsedMs  = (sinceStart > 0) ? static_cast<uint32_t>(sinceStart) : 0;
+  if (alarmChange) snapshotAlarms(prevFlags, flags, eventMs, elapsedMs);
+  if (newSample) G.M_Rollup.add(elapsedMs, G.D_FilteredPV, s_rollupToSD);
+  if (G.M_LogFilter.offer(elapsedMs, G.D_FilteredPV, flags) == LogFilter::NONE) return;
+
+  // 1. 現在のデータを SDBuffer に蓄積
+  G.M_SDBuffer.elapsedSeconds = elapsedMs / 1000UL;
+  G.M_SDBuffer.elapsedMs      = elapsedMs;
+  G.M_SDBuffer.temperature    = G.D_FilteredPV;
+  G.M_SDBuffer.state          = "RUN";
+  G.M_SDBuffer.sampleCount    = static_cast<uint64_t>(G.D_Count);
+  G.M_SDBuffer.averageTemp    = G.D_Average;
+  G.M_SDBuffer.stdDev         = G.D_StdDev;
+  G.M_SDBuffer.maxTemp        = G.D_Max;
+  G.M_SDBuffer.minTemp        = G.D_Min;
+  G.M_SDBuffer.hiAlarm        = G.M_HiAlarm;
+  G.M_SDBuffer.loAlarm        = G.M_LoAlarm;
+  G.M_SDBuffer.wallMs         = RtcClock::wallMsAt(eventMs);   // RAM 上の計算のみ（I²C 無し）
+
+  // 2. SDWriter タスクへ依頼（待ち無し。満杯なら破棄してリング統計に計上）
+  bool queued;
+  {
+    PROFILE_ZONE("Storage.push");
+    queued = SDWriter::pushData(G.M_SDBuffer);
   }
+  if (!queued) {
+    Serial.println("[Storage_Task] SD ring full, row dropped");
+  } else if (UI::SHOW_DEBUG_LOGS) {
+    Serial.printf("[Storage_Task] SD Queue: %.1f°C, Samples=%lu, Avg=%.1f\n",
+                  G.M_SDBuffer.temperature, (unsigned long)G.M_SDBuffer.sampleCount,
+                  isnan(G.M_SDBuffer.averageTemp) ? 0.0f : G.M_SDBuffer.averageTemp);
+  }
+  G.M_SDWriteCounter = 0;  // UI の "SD Writing..." 表示用
 }
 
 // ========== Logic Layer ヘルパー関数（状態遷移・ボタン処理封遠）================
@@ -329,34 +733,50 @@ void handleButtonA() {
       
       G.M_CurrentState = State::RUN;
 
+      // 処理時間統計は RUN 単位で取り直す（RUN 終了時に SD フッタへ出力）
+      PerfMonitor::requestReset();
+
+      // 記録判定も RUN 単位（最初のイベントは必ず記録、判定統計は RUN 終了時に SD フッタへ）
+      G.M_LogFilter.configure(G.M_LogDeadband, SD_DEADBAND_C, SD_DEADBAND_MAX_INTERVAL_MS);
+      G.M_LogFilter.reset();
+      G.M_Rollup.reset();
+      G.M_RunHiAlarms = 0;
+      G.M_RunLoAlarms = 0;
+
       // ────── Phase 4: SD ファイル作成処理 ──────
-      // RUN開始時にファイルを新規作成（RTC未実装時は相対時間ベースのファイル名使用）
+      // RUN開始時にファイルを新規作成
       if (G.M_SDReady && !G.M_SDError) {
-        // ※ 応急処置: RTC未実装のため、ファイル名を簡易的に生成
-        //   RTC追加後は正式な YYYYMMDD_HHMMSS フォーマットに切り替え
-        static unsigned int fileCounter = 0;
-        snprintf(G.M_CurrentDataFile, sizeof(G.M_CurrentDataFile)-1, 
-                 "/DATA_%04u.csv", fileCounter++);
+        // ファイル名は目録（RUNS.CAT）の RUN 番号から（再起動しても前回の RUN を上書きしない）
+        G.M_RunId = G.M_NextRunId++;
+        RunCatalog::fileNameFor(G.M_RunId, G.M_LogFormat == LogFormat::CSV,
+                                G.M_CurrentDataFile, sizeof(G.M_CurrentDataFile));
         
-        // ファイル作成
-        if (!SDManager::createNewFile(G.M_CurrentDataFile)) {
+        // ファイル作成・ヘッダ書き込み・目録への START は SDWriter タスクが行う
+        // （失敗は takeError() で通知）。バイナリ形式のヘッダには RUN 開始時の閾値を記録する
+        if (!SDWriter::openFile(G.M_CurrentDataFile, G.M_LogFormat,
+                                G.D_HI_ALARM_CURRENT, G.D_LO_ALARM_CURRENT, G.M_RunId,
+                                G.M_RawCapture, RtcClock::wallMsAt(millis()))) {
           G.M_SDError = true;
-          Serial.printf("[handleButtonA] SD file create error: %s\n", 
-                        SDManager::getLastError());
+          Serial.println("[handleButtonA] SD file create request failed");
         } else {
-          // ヘッダ行を書き込み
-          if (!SDManager::writeHeader()) {
-            G.M_SDError = true;
-            Serial.printf("[handleButtonA] SD header write error: %s\n",
-                          SDManager::getLastError());
-          } else {
-            // 開始時刻を記録（相対時間の基準点）
-            G.M_RunStartTime = millis();
-            Serial.printf("[handleButtonA] SD file created: %s\n", 
-                          G.M_CurrentDataFile);
-          }
+          Serial.printf("[handleButtonA] SD file requested: %s\n", G.M_CurrentDataFile);
         }
       }
+      // 開始時刻を記録（相対時間の基準点）
+      G.M_RunStartTime     = millis();
+      G.M_RunStartTime64   = G.M_RunClock.extend(G.M_RunStartTime);
+      G.M_SegmentIndex     = 0;
+      G.M_SegmentStartTime = G.M_RunStartTime;
+      strncpy(G.M_SegmentFile, G.M_CurrentDataFile, sizeof(G.M_SegmentFile) - 1);
+      G.M_SegmentFile[sizeof(G.M_SegmentFile) - 1] = '\0';
+
+      // 開始直前の SD_PRETRIGGER_WINDOW_MS を生ログの先頭へ（OPEN の後に処理される）
+      G.M_RunAlarmSnapshots = 0;
+      if (G.M_SDReady && !G.M_SDError &&
+          !SDWriter::pushSnapshot(G.M_PreTrigger, PreTrigger::RUN_START, G.M_RunStartTime, 0,
+                                  nullptr)) {
+        Serial.println("[handleButtonA] pre-trigger snapshot dropped");
+      }
 
       break;
     }
@@ -375,10 +795,15 @@ void handleButtonA() {
 
       // ────── Phase 4: SD ファイルクローズ処理 ──────
       // RUN終了時（RESULT遷移時）にファイルをフラッシュ・クローズ
-      if (G.M_SDReady && !G.M_SDError) {
-        SDManager::flush();      // バッファをディスクに書き込み
-        SDManager::closeFile();  // ファイルをクローズ
-        Serial.printf("[handleButtonA] SD file closed: %s\n", G.M_CurrentDataFile);
+      // フッタ（処理時間・リング統計）→ flush → クローズは SDWriter タスクが行う
+      // （書き込みエラー後も、開いているファイルは閉じておく）
+      if (G.M_SDReady) {
+        G.M_Rollup.finish(s_rollupToSD);   // 途中の区間（最後の 1 秒・1 分・1 時間）
+        if (SDWriter::closeFile(runSummary(), G.M_LogFilter)) {
+          Serial.printf("[handleButtonA] SD file close requested: %s\n", G.M_CurrentDataFile);
+        } else {
+          G.M_SDError = true;
+        }
       }
       
       G.M_ResultPage   = 0;  // ページングをリセット
@@ -398,9 +823,8 @@ void handleButtonA() {
       } else {
         // LO → IDLE へ戻る（EEPROM保存）
         if (EEPROM_SaveFromGlobal()) {
-          // 保存成功時はアラームフラグをリセット
-          G.M_HiAlarm = false;
-          G.M_LoAlarm = false;
+          // 保存成功時はアラームフラグをリセット（所有者の IO コアへ依頼）
+          requestAlarmReset();
           Serial.printf("[ALARM_SETTING] Confirmed: HI=%.1f, LO=%.1f (flags reset)\n",
                         G.D_HI_ALARM_CURRENT, G.D_LO_ALARM_CURRENT);
         } else {
@@ -416,6 +840,7 @@ void handleButtonA() {
 
 // ========== Logic Layer (50ms周期) ===============================================
 void Logic_Task() {
+  PROFILE_ZONE("Logic_Task");
   // ── BtnA イベント処理 ──
   if (G.M_BtnA_Pressed) {
     G.M_BtnA_Pressed = false;
@@ -507,6 +932,9 @@ void Logic_Task() {
       }
     }
   }
+
+  // 閾値・状態の変更を IO コアへ公開
+  publishControlSnapshot();
 }
 
 // ========== UI描画ヘルパー関数群（テスト・保守性向上） ===========================
@@ -558,6 +986,8 @@ void Logic_Task() {
  * 毎回 setCursor() と setTextColor() を明示的に設定し、残像を防ぐ
  */
 void renderSimpleLine(uint16_t y, const char *text, uint16_t textColor) {
+  PROFILE_ZONE("renderSimpleLine");
+  SpiBusGuard bus(SpiDevice::LCD);
   M5.Lcd.setTextSize(UI::TEXTSIZE_GUIDE);
   M5.Lcd.setCursor(UI::PosX::LEFT, y);
   M5.Lcd.setTextColor(textColor, BLACK);
@@ -587,6 +1017,8 @@ void renderLabelValueLine(uint16_t y,
                           const char *unit,
                           uint16_t textColor,
                           bool isNaN = false) {
+  PROFILE_ZONE("renderLabelValueLine");
+  SpiBusGuard bus(SpiDevice::LCD);
   // ラベルを小さいサイズで表示
   M5.Lcd.setTextSize(UI::TEXTSIZE_GUIDE);
   M5.Lcd.setCursor(UI::PosX::LEFT, y);
@@ -601,7 +1033,7 @@ void renderLabelValueLine(uint16_t y,
   if (isnan(value) || isNaN) {
     M5.Lcd.printf("---.--  %s", unit);
   } else {
-    M5.Lcd.printf("%6.1f  %s", value, unit);
+    M5.Lcd.print(formatValue(value, "  ", unit));
   }
   M5.Lcd.printf("\n");
 }
@@ -617,6 +1049,7 @@ void renderLabelValueLine(uint16_t y,
  * 固定幅フォント（1文字6px）で中央揃え計算
  */
 void renderCenterLine(uint16_t y, const char *text, uint16_t textColor) {
+  SpiBusGuard bus(SpiDevice::LCD);
   M5.Lcd.setTextSize(UI::TEXTSIZE_GUIDE);
   uint16_t textWidth = strlen(text) * 6;  // 固定幅フォント: 1文字 6px
   uint16_t x = (320 - textWidth) / 2;
@@ -632,24 +1065,29 @@ void renderTwoValueLine(uint16_t y,
                         const char *leftLabel, float leftValue, const char *leftUnit,
                         const char *rightLabel, float rightValue, const char *rightUnit,
                         uint16_t textColor) {
-  // 左側ラベル
-  M5.Lcd.setTextSize(UI::TEXTSIZE_GUIDE);
-  M5.Lcd.setCursor(UI::PosX::LEFT, y);
-  M5.Lcd.setTextColor(textColor, BLACK);
-  M5.Lcd.printf("%s", leftLabel);
-
-  // 左側値（大）
-  M5.Lcd.setTextSize(UI::TEXTSIZE_VALUE);
-  M5.Lcd.setCursor(UI::PosX::VALUE_START, y - 4);
-  if (isnan(leftValue)) {
-    M5.Lcd.printf("---.-- %s", leftUnit);
-  } else {
-    M5.Lcd.printf("%6.1f %s", leftValue, leftUnit);
+  // バスは左右の半分ごとに保持する（その間でセンサー読取を先に通せる）
+  {
+    SpiBusGuard bus(SpiDevice::LCD);
+    // 左側ラベル
+    M5.Lcd.setTextSize(UI::TEXTSIZE_GUIDE);
+    M5.Lcd.setCursor(UI::PosX::LEFT, y);
+    M5.Lcd.setTextColor(textColor, BLACK);
+    M5.Lcd.printf("%s", leftLabel);
+
+    // 左側値（大）
+    M5.Lcd.setTextSize(UI::TEXTSIZE_VALUE);
+    M5.Lcd.setCursor(UI::PosX::VALUE_START, y - 4);
+    if (isnan(leftValue)) {
+      M5.Lcd.printf("---.-- %s", leftUnit);
+    } else {
+      M5.Lcd.print(formatValue(leftValue, " ", leftUnit));
+    }
   }
 
   // 右側ラベル
   uint16_t rightLabelX = UI::PosX::CENTER;
   uint16_t rightValueX = UI::PosX::CENTER + (UI::PosX::VALUE_START - UI::PosX::LEFT);
+  SpiBusGuard bus(SpiDevice::LCD);
   M5.Lcd.setTextSize(UI::TEXTSIZE_GUIDE);
   M5.Lcd.setCursor(rightLabelX, y);
   M5.Lcd.setTextColor(textColor, BLACK);
@@ -661,7 +1099,7 @@ void renderTwoValueLine(uint16_t y,
   if (isnan(rightValue)) {
     M5.Lcd.printf("---.-- %s", rightUnit);
   } else {
-    M5.Lcd.printf("%6.1f %s", rightValue, rightUnit);
+    M5.Lcd.print(formatValue(rightValue, " ", rightUnit));
   }
 
   M5.Lcd.printf("\n");
@@ -678,10 +1116,29 @@ void renderTwoValueLine(uint16_t y,
  * ちらつき削減のための部分更新
  */
 void clearLine(uint16_t y_start, uint16_t y_end) {
+  PROFILE_ZONE("clearLine");
   uint16_t height = (y_end > y_start) ? (y_end - y_start) : 1;
+  SpiBusGuard bus(SpiDevice::LCD);   // 1 行（SPI_LCD_CHUNK_ROWS 以下）の塗りだけ保持
   M5.Lcd.fillRect(0, y_start, 320, height, BLACK);
 }
 
+/**
+ * @brief 全画面消去（SPI_LCD_CHUNK_ROWS 行ずつ）
+ *
+ * @details
+ * fillScreen() は 1 回で 16ms～25ms バスを占有し、その間 MAX31855 の読取が
+ * 待たされる。帯に分けて塗り、バスは帯ごとに取り直す。
+ */
+void clearScreen() {
+  PROFILE_ZONE("clearScreen");
+  const int32_t height = UI::LCD_HEIGHT;
+  for (int32_t y = 0; y < height; y += SPI_LCD_CHUNK_ROWS) {
+    const int32_t rows = (height - y < SPI_LCD_CHUNK_ROWS) ? height - y : SPI_LCD_CHUNK_ROWS;
+    SpiBusGuard bus(SpiDevice::LCD);
+    M5.Lcd.fillRect(0, y, UI::LCD_WIDTH, rows, BLACK);
+  }
+}
+
 // ════════════════════════════════════════════════════════════════════════════
 
 void renderIDLE() {
@@ -811,7 +1268,7 @@ void renderRUN() {
   // ────────────────────────────────────────────────────────────────────
   {
     char sampleLine[40];
-    snprintf(sampleLine, sizeof(sampleLine), "Samples: %5ld", G.D_Count);
+    formatSamples(sampleLine, G.D_Count);
     renderSimpleLine(UI::PosY::ROW4_START, sampleLine, WHITE);
   }
   
@@ -825,6 +1282,9 @@ void renderRUN() {
     if (G.M_SDError) {
       snprintf(sdLine, sizeof(sdLine), "SD Error!");
       sdColor = RED;
+    } else if (G.M_SDOutage) {
+      snprintf(sdLine, sizeof(sdLine), "SD Outage (buffering)");
+      sdColor = YELLOW;
     } else if (G.M_SDReady) {
       if (G.M_SDWriteCounter == 0) {
         snprintf(sdLine, sizeof(sdLine), "SD Writing...");
@@ -1114,7 +1574,7 @@ void renderRESULT() {
  * 3. 現在の G.M_CurrentState に応じて適切な render関数を呼び出し
  * 
  * 【画面クリアタイミング】
- * - State遷移時: M5.Lcd.fillScreen(BLACK) 実行
+ * - State遷移時: clearScreen()（帯ごとにバスを取り直す）実行
  * - RESULT内ページング時: 同様にクリア
  * - それ以外: クリアなし（毎回 renderXXX() で上書き）
  * 
@@ -1130,7 +1590,7 @@ void renderRESULT() {
  * - RESULT→IDLE遷移時に handleButtonA() が統計最終計算を実行
  * 
  * 【パフォーマンス最適化】
- * - fillScreen() は 16ms～25ms かかるため有効な時のみ実行
+ * - 全消去は 16ms～25ms かかるため有効な時のみ実行
  * - prevState / prevPage で画面クリアの必要性を判定
  * - 通常フレーム更新は render関数内での上書き描画で対応
  * 
@@ -1138,13 +1598,17 @@ void renderRESULT() {
  * @see handleButtonA()
  */
 void UI_Task() {
+  PROFILE_ZONE("UI_Task");
+  // LCD は SD / MAX31855 と SPI バスを共有する。バスは描画の部品（1 行・1 帯）ごとに
+  // その関数内で取る（フレーム全体では保持しない。部品の境目でセンサー読取を先に通す）
+
   // 部分更新モード: 前回描画値を保持して差分のみ更新
   static State prevState = State::IDLE;
   static int   prevPage  = -1;  // RESULTページ遷移検出用
 
   // 前回の値スナップショット
   static float prevTemp = NAN;
-  static long  prevSamples = -1;
+  static int64_t prevSamples = -1;
   static int   prevSDState = -1; // 0=NotReady,1=Ready,2=Error
   static float prevAvg = NAN;
   static float prevStd = NAN;
@@ -1154,8 +1618,9 @@ void UI_Task() {
   static bool  prevHiAlarm = false;
   static bool  prevLoAlarm = false;
 
-  auto sdState = [](bool sdReady, bool sdError)->int {
+  auto sdState = [](bool sdReady, bool sdError, bool sdOutage)->int {
     if (sdError) return 2;
+    if (sdOutage) return 3;
     if (sdReady) return 1;
     return 0;
   };
@@ -1166,7 +1631,7 @@ void UI_Task() {
   if (G.M_CurrentState == State::RESULT && prevPage != G.M_ResultPage) doFullClear = true;
 
   if (doFullClear) {
-    M5.Lcd.fillScreen(BLACK);
+    clearScreen();
     prevState = G.M_CurrentState;
     prevPage = (G.M_CurrentState == State::RESULT) ? G.M_ResultPage : -1;
     // force re-render by resetting snapshots
@@ -1292,18 +1757,19 @@ void UI_Task() {
     if (G.D_Count != prevSamples) {
       clearLine(UI::PosY::ROW4_START, UI::PosY::ROW4_END);
       char sampleLine[40];
-      snprintf(sampleLine, sizeof(sampleLine), "Samples: %5ld", G.D_Count);
+      formatSamples(sampleLine, G.D_Count);
       renderSimpleLine(UI::PosY::ROW4_START, sampleLine, WHITE);
       prevSamples = G.D_Count;
     }
 
     // SD status
-    int curSD = sdState(G.M_SDReady, G.M_SDError);
+    int curSD = sdState(G.M_SDReady, G.M_SDError, G.M_SDOutage);
     if (curSD != prevSDState) {
       // ROW6 に移動して ROW2/ROW4 と重ならないようにする
       clearLine(UI::PosY::ROW6_START, UI::PosY::ROW6_END);
       char sdLine[40]; uint16_t sdColor = WHITE;
       if (G.M_SDError) { snprintf(sdLine, sizeof(sdLine), "SD Error: %s", SDManager::getLastError()); sdColor = RED; }
+      else if (G.M_SDOutage) { snprintf(sdLine, sizeof(sdLine), "SD Outage (buffering)"); sdColor = YELLOW; }
       else if (G.M_SDReady) { snprintf(sdLine, sizeof(sdLine), "SD Ready"); sdColor = GREEN; }
       else { snprintf(sdLine, sizeof(sdLine), "SD Not Ready"); sdColor = YELLOW; }
       renderSimpleLine(UI::PosY::ROW6_START, sdLine, sdColor);
@@ -1329,7 +1795,7 @@ void UI_Task() {
       prevHiAlarm = G.M_HiAlarm; prevLoAlarm = G.M_LoAlarm;
     }
 
-    int curSD = sdState(G.M_SDReady, G.M_SDError);
+    int curSD = sdState(G.M_SDReady, G.M_SDError, G.M_SDOutage);
     if (curSD != prevSDState) {
       // ROW6 に移動して上の行と重ならないようにする
       clearLine(UI::PosY::ROW6_START, UI::PosY::ROW6_END);
@@ -1345,6 +1811,173 @@ void UI_Task() {
   }
 }
 
+// ========== シリアルコンソール (10ms周期 / 制御コア) ==============================
+/**
+ * @brief シリアルから 1 文字コマンドを読み取り実行
+ *
+ * @details
+ * 現場機でも PC を繋ぐだけで処理時間統計を確認できるようにするための入口。
+ * 1 周期あたり最大数文字だけ処理し、制御コアの周期を乱さない。
+ *
+ * | コマンド | 動作 |
+ * |---------|------|
+ * | p | タスク処理時間統計（count / p50 / p99 / max / 超過数）+ SD リング統計 + SD 操作レイテンシ + SPI バス利用率 |
+ * | P | 上記 + 非ゼロのヒストグラムバケット |
+ * | r | 処理時間統計・SD 操作レイテンシのリセット |
+ * | z | プロファイリングゾーンのダンプ（PROFILE_ZONES_ENABLED=1 時） |
+ * | Z | プロファイリングゾーンのクリア |
+ * | w | 省電力ガバナーの統計（現在クロック・スリープ率） |
+ * | b | SD 書き込みベンチマーク（旧方式 / セクタ整列、IDLE・RESULT 中のみ） |
+ * | f | ログ形式の切替（CSV → BINARY → DELTA、RUN 中以外・次の RUN から有効） |
+ * | d | 記録判定の切替（全サンプル ⇔ デッドバンド、RUN 中以外・次の RUN から有効） |
+ * | c | 生データ記録の切替（全読取値を DATA_xxxx_raw.bin へ、RUN 中以外・次の RUN から有効） |
+ * | s | ソークモードの切替（ログを 256MB / 24 時間ごとの区間に分割、RUN 中以外・次の RUN から有効） |
+ * | l | RUN の目録（RUNS.CAT）の末尾 SD_CATALOG_LIST_RUNS 件、RUN 中以外 |
+ * | t | 実時刻の状態（RTC の有無・現在時刻・millis() の進み・最後の補正誤差） |
+ * | T | 続く 14 桁 "YYYYMMDDhhmmss" で RTC を設定（RUN 中以外、数字以外で取り消し） |
+ * | h | ヘルプ |
+ */
+void Console_Task() {
+  static char   timeEntry[15];     // 'T' に続く "YYYYMMDDhhmmss"
+  static int8_t timeLen = -1;      // -1 = 入力中でない
+  for (int budget = 0; budget < 4 && Serial.available() > 0; ++budget) {
+    const int c = Serial.read();
+    PowerManager::noteActivity();  // 操作中はライトスリープしない（UART 受信取りこぼし防止）
+    if (timeLen >= 0) {
+      if (c < '0' || c > '9') {
+        Serial.println("[Console] RTC set cancelled");
+        timeLen = -1;
+        continue;
+      }
+      timeEntry[timeLen++] = static_cast<char>(c);
+      if (timeLen < 14) continue;
+      timeEntry[14] = '\0';
+      timeLen = -1;
+      CivilTime t;
+      if (!WallClock::parseCompact(timeEntry, t)) {
+        Serial.printf("[Console] invalid time: %s (YYYYMMDDhhmmss, 2000-2099)\n", timeEntry);
+      } else if (!RtcClock::set(t)) {
+        Serial.println("[Console] RTC set failed (not present?)");
+      } else {
+        Serial.printf("[Console] RTC set: %s\n", timeEntry);
+      }
+      continue;
+    }
+    switch (c) {
+      case 'p': PerfMonitor::dump(Serial, false); SDWriter::dump(Serial); SDManager::dumpLatency(Serial); SpiBus::dump(Serial); break;
+      case 'P': PerfMonitor::dump(Serial, true);  SDWriter::dump(Serial); SDManager::dumpLatency(Serial); SpiBus::dump(Serial); break;
+      case 'r':
+        PerfMonitor::requestReset();
+        SDManager::requestLatencyReset();
+        Serial.println("[Console] perf stats reset");
+        break;
+      case 'z':
+#if PROFILE_ZONES_ENABLED
+        // 1 行ずつ Serial へ（scripts/profile_to_trace.py の入力形式）
+        ProfileRecorder::dump([](const char* line, void*) { Serial.print(line); }, nullptr);
+#else
+        Serial.println("[Console] profiling zones disabled (build env m5stack-profile)");
+#endif
+        break;
+      case 'Z':
+        ProfileRecorder::clear();
+        Serial.println("[Console] profile ring cleared");
+        break;
+      case 'w': PowerManager::dump(Serial); break;
+      case 'b':
+        // 実行は書き込みタスク（他の SD 操作とリングの順で直列）。記録中は行わない
+        if (G.M_CurrentState == State::RUN) {
+          Serial.println("[SDBENCH] not available during RUN");
+        } else if (!G.M_SDReady || G.M_SDError) {
+          Serial.println("[SDBENCH] SD not ready");
+        } else if (SDWriter::benchmark()) {
+          Serial.println("[SDBENCH] queued on the SD writer task");
+        }
+        break;
+      case 'f': {
+        // RUN 中に変えると Storage_Task と開いているファイルの形式が食い違うため不可
+        if (G.M_CurrentState == State::RUN) {
+          Serial.println("[Console] log format cannot be changed during RUN");
+          break;
+        }
+        static const char* const names[] = {"CSV", "BINARY", "DELTA"};
+        const uint8_t next = (static_cast<uint8_t>(G.M_LogFormat) + 1) % 3;
+        G.M_LogFormat = static_cast<LogFormat>(next);
+        Serial.printf("[Console] log format: %s (from next RUN)\n", names[next]);
+        break;
+      }
+      case 'd':
+        // RUN 中の判定条件は RUN 開始時に固定する（フッタの統計と食い違わないように）
+        if (G.M_CurrentState == State::RUN) {
+          Serial.println("[Console] log trigger cannot be changed during RUN");
+          break;
+        }
+        G.M_LogDeadband = !G.M_LogDeadband;
+        if (G.M_LogDeadband) {
+          Serial.printf("[Console] log trigger: deadband %.2f C / max %lu ms (from next RUN)\n",
+                        SD_DEADBAND_C, (unsigned long)SD_DEADBAND_MAX_INTERVAL_MS);
+        } else {
+          Serial.println("[Console] log trigger: every sample (from next RUN)");
+        }
+        break;
+      case 'c':
+        // RUN 中に変えると読取間隔と開いているファイルが食い違うため不可
+        if (G.M_CurrentState == State::RUN) {
+          Serial.println("[Console] raw capture cannot be changed during RUN");
+          break;
+        }
+        G.M_RawCapture = !G.M_RawCapture;
+        if (G.M_RawCapture) {
+          Serial.printf("[Console] raw capture: on, every %lu ms (from next RUN)\n",
+                        (unsigned long)TC_CAPTURE_INTERVAL_MS);
+        } else {
+          Serial.println("[Console] raw capture: off (from next RUN)");
+        }
+        break;
+      case 's':
+        // RUN 中に変えると区間の状態と開いているファイルが食い違うため不可
+        if (G.M_CurrentState == State::RUN) {
+          Serial.println("[Console] soak mode cannot be changed during RUN");
+          break;
+        }
+        G.M_SoakMode = !G.M_SoakMode;
+        if (G.M_SoakMode) {
+          Serial.printf("[Console] soak mode: on, segment every %lu MB / %lu h (from next RUN)\n",
+                        (unsigned long)(SD_SEGMENT_MAX_BYTES / (1024UL * 1024UL)),
+                        (unsigned long)(SD_SEGMENT_MAX_MS / 3600000UL));
+        } else {
+          Serial.println("[Console] soak mode: off (from next RUN)");
+        }
+        break;
+      case 'l':
+        // 読み出しは書き込みタスク（他の SD 操作とリングの順で直列）。記録中はリングを塞がない
+        if (G.M_CurrentState == State::RUN || !G.M_SDReady) {
+          Serial.println("[Console] run list not available during RUN / without SD");
+          break;
+        }
+        SDWriter::listRuns();
+        break;
+      case 't': RtcClock::dump(Serial); break;
+      case 'T':
+        // RUN 中に合わせ直すとログの実時刻が途中で跳ぶため不可
+        if (G.M_CurrentState == State::RUN) {
+          Serial.println("[Console] RTC cannot be set during RUN");
+          break;
+        }
+        timeLen = 0;
+        Serial.println("[Console] enter YYYYMMDDhhmmss");
+        break;
+      case 'h':
+      case '?':
+        Serial.println("[Console] p: perf stats, P: perf + histogram, r: reset perf, "
+                       "z: dump profile, Z: clear profile, w: power stats, b: SD bench, f: log format, d: deadband, c: raw capture, s: soak, l: list runs, t: clock, T: set RTC, h: help");
+        break;
+      default:
+        break;  // 改行などは無視
+    }
+  }
+}
+
 // ========== EEPROM 操作 (EEPROMManager による一元管理) =====================
 
 /**
@@ -1,119 +1,218 @@
 #include "Global.h"
-#include "SDManager.h"      // Phase 4: SD カード操作
+#include "SpiBus.h"         // 共有 SPI バス排他
+#include "PerfMonitor.h"    // タスク処理時間ヒストグラム
+#include "BootTimeline.h"   // 起動段階の所要時間
+#include "PowerManager.h"   // 省電力ガバナー（クロック・ライトスリープ）
+#include "SDWriter.h"       // SD 書き込みタスク
+#include "RtcClock.h"       // DS3231 と RAM 上の実時刻
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 namespace {
-  unsigned long T_IO_Last    = 0;
-  unsigned long T_Logic_Last = 0;
-  unsigned long T_UI_Last    = 0;
+  TaskHandle_t s_ioTaskHandle      = nullptr;
+  TaskHandle_t s_controlTaskHandle = nullptr;
+  BootTimeline s_boot;  // setup() が書き、タスク起動後は制御コアのみが更新
+
+  /**
+   * @brief IO コアのタスク本体（IO_CYCLE_MS 固定周期）
+   *
+   * @details
+   * vTaskDelayUntil() により、処理時間に関係なく周期の位相を保つ。
+   * 制御コアで LCD 全消去や SD flush が長引いてもこの周期は乱れない。
+   *
+   * 周期末尾で省電力ガバナーを呼ぶ。IDLE / RESULT で操作が無く制御コアも
+   * 待機中なら、次の締め切り（次のセンサ読取・制御タスクの起床）まで
+   * ライトスリープする。スリープ中は tick が止まるため、明けたら周期基準を
+   * 取り直し、タスク通知で待っている制御タスクを起こす。
+   */
+  void ioTaskEntry(void*) {
+    TickType_t lastWake = xTaskGetTickCount();
+    bool prevHiAlarm = false;
+    bool prevLoAlarm = false;
+    for (;;) {
+      const uint32_t t0 = micros();
+      IO_Task();
+      PerfMonitor::record(PerfTask::IO, micros() - t0);
+
+      const IOSnapshot io = readIOSnapshot();
+      if (io.hiAlarm != prevHiAlarm || io.loAlarm != prevLoAlarm) {
+        prevHiAlarm = io.hiAlarm;
+        prevLoAlarm = io.loAlarm;
+        PowerManager::noteActivity();  // アラーム音・表示の間はフルクロック
+      }
+      // 初回サンプル前（プローブ中）は締め切り = 現在 → 眠らない
+      const uint32_t ioDeadline = (io.sampleSeq == 0) ? millis()
+                                : io.sampleTimeMs + TC_READ_INTERVAL_MS;
+      const uint8_t  state      = static_cast<uint8_t>(readControlSnapshot().state);
+      if (PowerManager::govern(state, ioDeadline, SDWriter::idle())) {
+        xTaskNotifyGive(s_controlTaskHandle);
+        lastWake = xTaskGetTickCount();
+        continue;
+      }
+      vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(IO_CYCLE_MS));
+    }
+  }
+
+  /**
+   * @brief 制御コアのタスク本体（Logic / UI / SD を協調スケジューリング）
+   *
+   * @details
+   * 3 つの処理は同じタスク内で順に実行するため、G を読み書きするのは
+   * 常にこのタスクだけになる（IO コアとの受け渡しはスナップショット経由）。
+   *
+   * IDLE / RESULT では SD 書き込みが無いため、次の Logic / UI の締め切りまで
+   * タスク通知で待つ（ライトスリープ明けに IO タスクが起こす）。
+   */
+  void controlTaskEntry(void*) {
+    unsigned long tLogicLast = 0;
+    unsigned long tUILast    = 0;
+    TickType_t    lastWake   = xTaskGetTickCount();
+    for (;;) {
+      const unsigned long now = millis();
+
+      syncFromIOSnapshot();  // IO コアの最新値を G に取り込む
+      Boot_Task();           // 起動完了まで: 初回サンプル待ち・SD マウント
+
+      if (now - tLogicLast >= LOGIC_CYCLE_MS) {
+        tLogicLast = now;
+        const uint32_t t0 = micros();
+        Logic_Task();
+        PerfMonitor::record(PerfTask::LOGIC, micros() - t0);
+      }
+      {
+        const uint32_t t0 = micros();
+        Storage_Task();
+        PerfMonitor::record(PerfTask::STORAGE, micros() - t0);
+      }
+      if (now - tUILast >= UI_CYCLE_MS) {
+        tUILast = now;
+        const uint32_t t0 = micros();
+        UI_Task();
+        PerfMonitor::record(PerfTask::UI, micros() - t0);
+      }
+      Console_Task();
+      RtcClock::service(millis());   // 補正の時だけ I²C（1 周期に 1 回の読み出し）
+
+      if (PowerGovernor::isLowPowerState(static_cast<uint8_t>(G.M_CurrentState))) {
+        const uint32_t nextWake = PowerGovernor::earlier(tLogicLast + LOGIC_CYCLE_MS,
+                                                         tUILast + UI_CYCLE_MS, millis());
+        PowerManager::setControlIdle(nextWake);
+        for (;;) {
+          const int32_t remaining = static_cast<int32_t>(nextWake - millis());
+          if (remaining <= 0) break;
+          ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(remaining) + 1);
+        }
+        lastWake = xTaskGetTickCount();
+      } else {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(IO_CYCLE_MS));
+      }
+      PowerManager::setControlBusy();
+    }
+  }
 }
 
 // ── setup ────────────────────────────────────────────────────────────────────
+/**
+ * @brief 起動（同期部分のみ）
+ *
+ * @details
+ * setup() では待ち時間を伴う処理を行わず、タスクを起動した時点で抜ける。
+ * センサの初回サンプル待ちと SD マウントは Boot_Task()（制御コア）が
+ * 非ブロッキングで進めるため、電源瞬断後もサンプリングは初回の有効
+ * フレーム到着と同時に再開する（従来は固定待ちとリトライで数秒）。
+ */
 void setup() {
+  s_boot.begin(millis());
+  s_boot.start(BootStage::HARDWARE, millis());
   M5.begin();
   M5.Power.begin();
   Serial.begin(SERIAL_BAUD_RATE);
   Serial.println("=== Setup start ===");
-
-  Serial.println("[Setup] Begin hardware initialization sequence");
-
-  M5.Lcd.setTextSize(2);
-  M5.Lcd.println("Temperature Eval Tool");
-  M5.Lcd.println("Refactored Version");
-  M5.Lcd.println();
-
   initGlobalData();
+  RtcClock::init();   // 検出と発振停止の確認のみ（時刻の補正は制御タスクが進める）
+  s_boot.finish(BootStage::HARDWARE, millis());
 
   // Phase 3拡張: EEPROM 初期化と設定値読み込み
-  Serial.println("Initializing EEPROM...");
+  // （フラッシュ読み出しのみで数 ms。アラーム判定前に閾値が必要なため同期で行う）
+  s_boot.start(BootStage::EEPROM, millis());
   EEPROMManager::init(EEPROM_SIZE);
   EEPROM_LoadToGlobal();  // EEPROMから設定値をロード
-  Serial.printf("  HI_ALARM: %.1f C, LO_ALARM: %.1f C\n", 
+  publishControlSnapshot();  // IO_Task のアラーム判定に閾値を渡す
+  s_boot.finish(BootStage::EEPROM, millis());
+  Serial.printf("  HI_ALARM: %.1f C, LO_ALARM: %.1f C\n",
                 G.D_HI_ALARM_CURRENT, G.D_LO_ALARM_CURRENT);
 
-  // MAX31855 接続確認 (最大MAX_SETUP_RETRIES回リトライ)
-  // MAX31855 はパワーオン後最低 100ms の安定待ちが必要（データシート p.1）
-  delay(SETUP_SENSOR_DELAY_MS);
-  Serial.println("Checking MAX31855...");
-  // SPI と CS ピンを明示的に初期化（setup 中の IO_Task 呼び出し前）
+  // ────── デュアルコア・タスク起動 ──────
+  // ここまでは単一スレッド。以降 SPI バスは SpiBus で排他する。
+  // MAX31855 のパワーオン安定待ちは IO_Task() 側で SETUP_SENSOR_DELAY_MS を守る。
+  s_boot.start(BootStage::TASKS, millis());
   SPI.begin();
   pinMode(MAX31855_CS, OUTPUT);
   digitalWrite(MAX31855_CS, HIGH); // CS を非選択状態にする
-  Serial.println("[Setup] SPI and CS pin initialized");
-  float testTemp = NAN;
-  for (int i = 0; i < MAX_SETUP_RETRIES; ++i) {
-    // g_ioにtickを呼び出して温度を読み取らせる
-    Serial.printf("[Setup] loop %d: calling IO_Task()\n", i);
-    IO_Task();
-    Serial.printf("[Setup] loop %d: IO_Task() returned\n", i);
-    testTemp = G.D_FilteredPV;
-    if (isnan(testTemp)) {
-      Serial.printf("  try %d -> NAN\n", i);
-    } else {
-      Serial.printf("  try %d -> %.3f\n", i, testTemp);
-    }
-    if (!isnan(testTemp)) break;
-    M5.Lcd.print('.');
-    delay(SETUP_RETRY_INTERVAL_MS);
-  }
+  SpiBus::init();
+  PowerManager::init();
+  s_boot.finish(BootStage::TASKS, millis());
 
-  if (isnan(testTemp)) {
-    Serial.println("ERROR: MAX31855 not found after retries");
-    M5.Lcd.println();
-    M5.Lcd.println("ERROR: MAX31855");
-    M5.Lcd.println("Check wiring!");
-    // センサ未接続でも動作継続 (UI に ---.- C を表示)
-    Serial.println("[Setup] Continuing boot despite missing MAX31855 (fallback)");
-    // フォールバック値を設定して UI が停止しないようにする
-    G.D_FilteredPV = NAN; // 明示的に NAN のままにしてUIで表示される
-  } else {
-    G.D_FilteredPV = testTemp;  // フィルタ初期値を実測値で設定 (収束時間短縮)
-    M5.Lcd.println();
-    M5.Lcd.println("MAX31855 OK");
-    Serial.printf("MAX31855 OK: %.3f C\n", testTemp);
-  }
-
-  delay(SETUP_FINAL_DELAY_MS);
-  M5.Lcd.fillScreen(BLACK);
-  
-  // ⚠️ 重要: setup中のIO_Task呼び出しで立てられたアラームフラグをリセット
-  // loop()での正常な判定を確保
-  G.M_HiAlarm = false;
-  G.M_LoAlarm = false;
-  Serial.println("[Setup] Alarm flags reset before entering main loop");
+  // 以降の段階は Boot_Task() が並行して進める。
+  // s_boot はタスク生成後は制御コアのみが触るため、開始時刻は生成前に記録する。
+  s_boot.start(BootStage::FIRST_SAMPLE, millis());
+  s_boot.start(BootStage::SD_MOUNT, millis());
+  xTaskCreatePinnedToCore(ioTaskEntry, "IO", IO_TASK_STACK_BYTES, nullptr,
+                          IO_TASK_PRIORITY, &s_ioTaskHandle, IO_TASK_CORE);
+  xTaskCreatePinnedToCore(controlTaskEntry, "Control", CONTROL_TASK_STACK_BYTES, nullptr,
+                          CONTROL_TASK_PRIORITY, &s_controlTaskHandle, CONTROL_TASK_CORE);
+  SDWriter::start();
+  Serial.printf("[Setup] Tasks started: IO@core%d, Control@core%d, SDWriter@core%d\n",
+                IO_TASK_CORE, CONTROL_TASK_CORE, SD_WRITER_TASK_CORE);
 
-  // ────── Phase 4: SD カード初期化 ──────
-  Serial.println("Initializing SD card...");
-  SDManager::init();
-  if (SDManager::isReady()) {
-    G.M_SDReady = true;
-    Serial.println("SD card OK");
-    // UI 側で SD 状態を一元管理するため、setup() では LCD に表示しない
-  } else {
-    Serial.println("WARNING: SD card init failed");
-    Serial.printf("  Error: %s\n", SDManager::getLastError());
-    G.M_SDReady = false;
-    G.M_SDError = true;
-    // エラーも Serial のみで報告。LCD 表示は UI_Task() に委譲。
-  }
-  
   Serial.println("=== Setup complete ===");
 }
 
-// ── loop ─────────────────────────────────────────────────────────────────────
-void loop() {
+// ── 起動シーケンス（制御コア）──────────────────────────────────────────────────
+/**
+ * @brief 初回サンプル待ちと SD マウントを進める（完了後は何もしない）
+ *
+ * @details
+ * - 初回サンプル: IO コアが有効値を公開した時刻（sampleTimeMs）で完了。
+ *   BOOT_SENSOR_TIMEOUT_MS 以内に来なければ「センサ未接続」として記録し、
+ *   そのまま起動を続ける（UI は ---.- C を表示、IO コアは読取を継続）
+ * - SD マウント: 書き込みタスクで行い、最初の結果で完了（失敗後は IDLE で再試行、
+ *   Storage_Task）。マウント中も IO コア・制御タスクは止まらない
+ * - 全段階の完了時に [BOOT] 行で内訳を 1 回出力
+ */
+void Boot_Task() {
+  if (s_boot.allDone()) return;
   const unsigned long now = millis();
 
-  if (now - T_IO_Last >= IO_CYCLE_MS) {
-    T_IO_Last = now;
-    IO_Task();
+  if (!s_boot.isDone(BootStage::FIRST_SAMPLE)) {
+    const IOSnapshot io = readIOSnapshot();
+    if (io.sampleSeq > 0) {
+      s_boot.finish(BootStage::FIRST_SAMPLE, io.sampleTimeMs);
+      Serial.printf("MAX31855 OK: %.3f C\n", io.rawPV);
+    } else if (now >= SETUP_SENSOR_DELAY_MS + BOOT_SENSOR_TIMEOUT_MS) {
+      s_boot.finish(BootStage::FIRST_SAMPLE, now, false);
+      // センサ未接続でも動作継続 (UI に ---.- C を表示)
+      Serial.println("ERROR: MAX31855 not found (continuing, check wiring)");
+    }
   }
-  if (now - T_Logic_Last >= LOGIC_CYCLE_MS) {
-    T_Logic_Last = now;
-    Logic_Task();
+
+  // ────── Phase 4: SD カード初期化 ──────
+  // マウントは Storage_Task が書き込みタスクへ依頼する。最初の結果が G に届いた時点で完了
+  // （失敗時は M_SDError。以後の再試行は起動の所要時間に含めない）
+  if (!s_boot.isDone(BootStage::SD_MOUNT) && (G.M_SDReady || G.M_SDError)) {
+    s_boot.finish(BootStage::SD_MOUNT, millis(), G.M_SDReady);
   }
-  if (now - T_UI_Last >= UI_CYCLE_MS) {
-    T_UI_Last = now;
-    UI_Task();
+
+  if (s_boot.allDone()) {
+    char line[160];
+    s_boot.format(line, sizeof(line));
+    Serial.println(line);
   }
 }
 
+// ── loop ─────────────────────────────────────────────────────────────────────
+// 周期処理はすべて FreeRTOS タスクへ移行済み。Arduino の loopTask は不要なので削除する。
+void loop() {
+  vTaskDelete(nullptr);
+}
+
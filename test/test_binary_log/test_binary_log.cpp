@@ -0,0 +1,174 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "BinaryLog.h"
+
+/**
+ * @brief SDManager::formatCSVLine() と同じ規則で CSV 1 行を作る（比較用）
+ */
+static std::string legacyCsv(uint32_t elapsedMs, float temp, const char* state, uint32_t samples,
+                             float avg, float sd, float mx, float mn, bool hi, bool lo) {
+  char buf[160];
+  const char* hiStr = hi ? "true" : "false";
+  const char* loStr = lo ? "true" : "false";
+  const unsigned elapsed = elapsedMs / 1000u;
+  if (std::isnan(temp)) {
+    snprintf(buf, sizeof(buf), "%u,NaN,%s,%u,NaN,NaN,NaN,NaN,%s,%s,%u\r\n",
+             elapsed, state, samples, hiStr, loStr, elapsedMs);
+  } else {
+    snprintf(buf, sizeof(buf), "%u,%.1f,%s,%u,%.1f,%.1f,%.1f,%.1f,%s,%s,%u\r\n",
+             elapsed, temp, state, samples,
+             std::isnan(avg) ? 0.0f : avg, std::isnan(sd) ? 0.0f : sd,
+             std::isnan(mx) ? 0.0f : mx, std::isnan(mn) ? 0.0f : mn, hiStr, loStr, elapsedMs);
+  }
+  return buf;
+}
+
+static BinLogRecord makeRecord(uint32_t elapsedMs, float temp, const char* state, uint32_t samples,
+                               float avg, float sd, float mx, float mn, bool hi, bool lo) {
+  BinLogRecord r;
+  r.elapsedMs      = elapsedMs;
+  r.sampleCount    = samples;
+  r.temperature    = BinaryLog::toDeci(temp);
+  r.average        = BinaryLog::toDeci(avg);
+  r.stdDev         = BinaryLog::toDeci(sd);
+  r.maxTemp        = BinaryLog::toDeci(mx);
+  r.minTemp        = BinaryLog::toDeci(mn);
+  r.state          = BinaryLog::stateCode(state);
+  r.flags          = (hi ? BinaryLog::FLAG_HI_ALARM : 0) | (lo ? BinaryLog::FLAG_LO_ALARM : 0);
+  return r;
+}
+
+static std::string roundTripCsv(const BinLogRecord& in) {
+  uint8_t raw[BinaryLog::RECORD_SIZE];
+  BinaryLog::encodeRecord(in, raw);
+  BinLogRecord out;
+  BinaryLog::decodeRecord(raw, out);
+  char buf[112];
+  const size_t n = BinaryLog::formatCsvRow(out, buf);
+  return std::string(buf, n);
+}
+
+void test_csv_rows_match_legacy_formatter(void) {
+  // 0.25°C 刻み（MAX31855 の分解能 = %.1f の同値ケース）を含む値で比較
+  const float temps[] = {540.25f, 540.75f, 21.05f, -12.35f, 0.0f, 1372.0f, -200.125f, 99.95f};
+  for (size_t i = 0; i < sizeof(temps) / sizeof(temps[0]); ++i) {
+    const float t = temps[i];
+    const std::string expected =
+        legacyCsv(100490 + i * 500, t, "RUN", 1000 + i, t - 1.25f, 0.35f, t + 2.5f, t - 3.75f,
+                  (i & 1) != 0, (i & 2) != 0);
+    const BinLogRecord r =
+        makeRecord(100490 + i * 500, t, "RUN", 1000 + i, t - 1.25f, 0.35f, t + 2.5f, t - 3.75f,
+                   (i & 1) != 0, (i & 2) != 0);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), roundTripCsv(r).c_str());
+  }
+}
+
+void test_nan_rules_match_legacy_formatter(void) {
+  // 温度 NaN → 統計列もすべて NaN
+  TEST_ASSERT_EQUAL_STRING(
+      legacyCsv(3010, NAN, "RUN", 10, 25.0f, 0.1f, 26.0f, 24.0f, false, true).c_str(),
+      roundTripCsv(makeRecord(3010, NAN, "RUN", 10, 25.0f, 0.1f, 26.0f, 24.0f, false, true)).c_str());
+  // 温度が数値で統計が NaN → 0.0
+  TEST_ASSERT_EQUAL_STRING(
+      legacyCsv(4500, 25.5f, "RUN", 11, NAN, NAN, NAN, NAN, true, false).c_str(),
+      roundTripCsv(makeRecord(4500, 25.5f, "RUN", 11, NAN, NAN, NAN, NAN, true, false)).c_str());
+}
+
+void test_schema1_records_read_as_milliseconds(void) {
+  // schema 1 の経過秒レコード → ms に換算し、当時の 10 列で出力
+  BinLogRecord in = makeRecord(0, 25.0f, "RUN", 7, 25.0f, 0.0f, 25.0f, 25.0f, false, false);
+  in.elapsedMs = 42;   // 秒のまま書かれていた値
+  uint8_t raw[BinaryLog::RECORD_SIZE];
+  BinaryLog::encodeRecord(in, raw);
+  BinLogRecord out;
+  BinaryLog::decodeRecord(raw, out, 1);
+  TEST_ASSERT_EQUAL_UINT32(42000, out.elapsedMs);
+  char buf[112];
+  BinaryLog::formatCsvRow(out, buf, false);
+  TEST_ASSERT_EQUAL_STRING("42,25.0,RUN,7,25.0,0.0,25.0,25.0,false,false\r\n", buf);
+}
+
+void test_header_round_trip_and_crc(void) {
+  BinLogHeader h;
+  memset(&h, 0, sizeof(h));
+  h.schemaVersion   = BinaryLog::SCHEMA_VERSION;
+  h.samplePeriodMs  = 100;
+  h.hiThresholdDeci = BinaryLog::toDeci(600.0f);
+  h.loThresholdDeci = BinaryLog::toDeci(-5.5f);
+  strcpy(h.firmware, "1.0.0 Mar  2 2026 10:00:00");
+  strcpy(h.columns, "ElapsedSec,Temp_C,State");
+
+  uint8_t raw[BinaryLog::HEADER_SIZE];
+  BinaryLog::encodeHeader(h, raw);
+
+  BinLogHeader out;
+  TEST_ASSERT_TRUE(BinaryLog::decodeHeader(raw, out));
+  TEST_ASSERT_EQUAL_UINT32(100, out.samplePeriodMs);
+  TEST_ASSERT_EQUAL_INT(6000, out.hiThresholdDeci);
+  TEST_ASSERT_EQUAL_INT(-55, out.loThresholdDeci);
+  TEST_ASSERT_EQUAL_STRING(h.firmware, out.firmware);
+  TEST_ASSERT_EQUAL_STRING(h.columns, out.columns);
+
+  raw[30] ^= 0x01;   // 1 ビット反転 → CRC 不一致
+  TEST_ASSERT_FALSE(BinaryLog::decodeHeader(raw, out));
+}
+
+void test_block_fills_at_sector_size_and_detects_corruption(void) {
+  TEST_ASSERT_EQUAL(512, (int)(BinaryLog::BLOCK_HEADER_SIZE +
+                               BinaryLog::RECORDS_PER_BLOCK * BinaryLog::RECORD_SIZE));
+  BinLogBlock block;
+  block.reset(7);
+  const BinLogRecord r = makeRecord(1, 25.0f, "RUN", 1, 25.0f, 0.0f, 25.0f, 25.0f, false, false);
+  for (size_t i = 0; i + 1 < BinaryLog::RECORDS_PER_BLOCK; ++i) {
+    TEST_ASSERT_FALSE(block.add(r));
+  }
+  TEST_ASSERT_TRUE(block.add(r));   // 25 件目で満杯
+
+  uint8_t sealed[BinaryLog::BLOCK_SIZE];
+  memcpy(sealed, block.seal(), sizeof(sealed));
+  TEST_ASSERT_TRUE(block.empty());
+  TEST_ASSERT_EQUAL_UINT32(8, block.seq());
+
+  uint8_t  type = 0;
+  uint16_t count = 0;
+  uint32_t seq = 0;
+  TEST_ASSERT_TRUE(BinaryLog::checkBlock(sealed, type, count, seq) == BinaryLog::BlockStatus::OK);
+  TEST_ASSERT_EQUAL(BinaryLog::BLOCK_DATA, type);
+  TEST_ASSERT_EQUAL(25, count);
+  TEST_ASSERT_EQUAL_UINT32(7, seq);
+
+  sealed[200] ^= 0x40;
+  TEST_ASSERT_TRUE(BinaryLog::checkBlock(sealed, type, count, seq) ==
+                   BinaryLog::BlockStatus::CORRUPT);
+
+  uint8_t zero[BinaryLog::BLOCK_SIZE] = {0};
+  TEST_ASSERT_TRUE(BinaryLog::checkBlock(zero, type, count, seq) == BinaryLog::BlockStatus::EMPTY);
+}
+
+void test_text_block_carries_footer_verbatim(void) {
+  const char* footer = "# PERF,task=IO,count=100\r\n";
+  uint8_t block[BinaryLog::BLOCK_SIZE];
+  BinaryLog::encodeTextBlock(footer, strlen(footer), 3, block);
+
+  uint8_t  type = 0;
+  uint16_t count = 0;
+  uint32_t seq = 0;
+  TEST_ASSERT_TRUE(BinaryLog::checkBlock(block, type, count, seq) == BinaryLog::BlockStatus::OK);
+  TEST_ASSERT_EQUAL(BinaryLog::BLOCK_TEXT, type);
+  TEST_ASSERT_EQUAL((int)strlen(footer), count);
+  TEST_ASSERT_EQUAL_MEMORY(footer, block + BinaryLog::BLOCK_HEADER_SIZE, count);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_csv_rows_match_legacy_formatter);
+  RUN_TEST(test_nan_rules_match_legacy_formatter);
+  RUN_TEST(test_schema1_records_read_as_milliseconds);
+  RUN_TEST(test_header_round_trip_and_crc);
+  RUN_TEST(test_block_fills_at_sector_size_and_detects_corruption);
+  RUN_TEST(test_text_block_carries_footer_verbatim);
+  return UNITY_END();
+}
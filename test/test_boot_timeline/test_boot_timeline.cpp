@@ -0,0 +1,71 @@
+#include <unity.h>
+#include <cstring>
+#include "BootTimeline.h"
+
+static BootTimeline makeBooted() {
+  BootTimeline t;
+  t.begin(300);
+  t.start(BootStage::HARDWARE, 300);
+  t.finish(BootStage::HARDWARE, 480);
+  t.start(BootStage::EEPROM, 480);
+  t.finish(BootStage::EEPROM, 483);
+  t.start(BootStage::TASKS, 483);
+  t.finish(BootStage::TASKS, 484);
+  t.start(BootStage::FIRST_SAMPLE, 484);
+  t.start(BootStage::SD_MOUNT, 484);
+  return t;
+}
+
+void test_parallel_stages_pending_until_finished(void) {
+  BootTimeline t = makeBooted();
+  TEST_ASSERT_FALSE(t.allDone());
+  TEST_ASSERT_EQUAL(180, t.durationMs(BootStage::HARDWARE));
+  TEST_ASSERT_EQUAL(0, t.durationMs(BootStage::SD_MOUNT));
+
+  char line[200];
+  t.format(line, sizeof(line));
+  TEST_ASSERT_TRUE(strstr(line, "sd_mount=pending") != nullptr);
+}
+
+void test_breakdown_and_ready_time(void) {
+  BootTimeline t = makeBooted();
+  t.finish(BootStage::SD_MOUNT, 720);       // SD の方が遅い
+  t.finish(BootStage::FIRST_SAMPLE, 590);
+  TEST_ASSERT_TRUE(t.allDone());
+  TEST_ASSERT_EQUAL(720, t.readyAtMs());
+
+  char line[200];
+  t.format(line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("[BOOT] pre_setup=300ms hardware=180ms eeprom=3ms tasks=1ms "
+                           "first_sample=106ms sd_mount=236ms ready=720ms", line);
+}
+
+void test_failed_stages_are_marked(void) {
+  BootTimeline t = makeBooted();
+  t.finish(BootStage::SD_MOUNT, 600, false);
+  t.finish(BootStage::FIRST_SAMPLE, 3200, false);
+  TEST_ASSERT_TRUE(t.allDone());
+  TEST_ASSERT_FALSE(t.isOk(BootStage::FIRST_SAMPLE));
+
+  char line[200];
+  t.format(line, sizeof(line));
+  TEST_ASSERT_TRUE(strstr(line, "first_sample=2716ms(timeout)") != nullptr);
+  TEST_ASSERT_TRUE(strstr(line, "sd_mount=116ms(fail)") != nullptr);
+}
+
+void test_format_truncates_safely(void) {
+  BootTimeline t = makeBooted();
+  char line[16];
+  const size_t n = t.format(line, sizeof(line));
+  TEST_ASSERT_EQUAL(15, n);
+  TEST_ASSERT_EQUAL(15, strlen(line));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_parallel_stages_pending_until_finished);
+  RUN_TEST(test_breakdown_and_ready_time);
+  RUN_TEST(test_failed_stages_are_marked);
+  RUN_TEST(test_format_truncates_safely);
+  return UNITY_END();
+}
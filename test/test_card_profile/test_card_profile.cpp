@@ -0,0 +1,107 @@
+#include <unity.h>
+#include <cstring>
+#include "CardProfile.h"
+
+/**
+ * @brief Global.h と同じ選択範囲
+ */
+static const CardProfile::Limits LIMITS = {
+    2048, 8192,        // 同期バイト数
+    1000, 5000, 2000,  // 同期間隔 [ms]（最小 / 最大 / 既定）
+    80, 50,            // 速度 80% / 同期時間 1/50
+    250000, 100,       // BAD: 最大 250ms 超 / 100kB/s 未満
+};
+
+/**
+ * @brief ブロック長ごとの書き込み速度と p99 を与えたプロファイル
+ */
+static CardProfile makeProfile(const uint32_t* kbps, const uint32_t* p99, uint32_t maxUs) {
+  CardProfile p;
+  p.cardType = 3;
+  p.sectors  = 62333952;   // 32GB SDHC
+  p.count    = CardProfile::MAX_RESULTS;
+  for (uint8_t i = 0; i < p.count; ++i) {
+    CardBlockResult& r = p.results[i];
+    r.blockBytes = CardProfile::blockSize(i);
+    r.writeKBps  = kbps[i];
+    r.readKBps   = kbps[i] * 2;
+    r.writeP50Us = p99[i] / 2;
+    r.writeP99Us = p99[i];
+    r.writeMaxUs = maxUs;
+  }
+  return p;
+}
+
+void test_good_card_gets_small_blocks_and_short_interval(void) {
+  // 2KB で最速の 80% に達する。p99 6ms × 50 = 300ms → 最小 1 秒
+  const uint32_t kbps[] = {300, 600, 900, 1050, 1100};
+  const uint32_t p99[]  = {4000, 5000, 6000, 8000, 12000};
+  CardProfile p = makeProfile(kbps, p99, 20000);
+  p.tune(LIMITS);
+  TEST_ASSERT_EQUAL(2048, (int)p.syncBytes);
+  TEST_ASSERT_EQUAL(1000, (int)p.syncIntervalMs);
+  TEST_ASSERT_EQUAL(CardProfile::GRADE_OK, p.grade);
+}
+
+void test_slow_card_gets_large_blocks_and_long_interval(void) {
+  // 8KB でしか速度が出ず、1 回の同期が 70ms かかる → 3.5 秒間隔
+  const uint32_t kbps[] = {40, 60, 90, 130, 400};
+  const uint32_t p99[]  = {30000, 35000, 40000, 50000, 70000};
+  CardProfile p = makeProfile(kbps, p99, 120000);
+  p.tune(LIMITS);
+  TEST_ASSERT_EQUAL(8192, (int)p.syncBytes);
+  TEST_ASSERT_EQUAL(3500, (int)p.syncIntervalMs);
+  TEST_ASSERT_EQUAL(CardProfile::GRADE_SLOW, p.grade);
+
+  p.results[2].writeMaxUs = 400000;            // 1 回でも 400ms 止まったら BAD
+  p.tune(LIMITS);
+  TEST_ASSERT_EQUAL(CardProfile::GRADE_BAD, p.grade);
+  TEST_ASSERT_EQUAL_STRING("BAD", CardProfile::gradeName(p.grade));
+}
+
+void test_encode_decode_roundtrip_and_card_match(void) {
+  const uint32_t kbps[] = {300, 600, 900, 1050, 1100};
+  const uint32_t p99[]  = {4000, 5000, 6000, 8000, 12000};
+  CardProfile p = makeProfile(kbps, p99, 20000);
+  p.tune(LIMITS);
+
+  uint8_t rec[CardProfile::RECORD_SIZE];
+  p.encode(rec);
+  CardProfile q;
+  TEST_ASSERT_TRUE(q.decode(rec));
+  TEST_ASSERT_EQUAL(0, memcmp(p.results, q.results, sizeof(p.results)));
+  TEST_ASSERT_EQUAL((int)p.syncBytes, (int)q.syncBytes);
+  TEST_ASSERT_EQUAL((int)p.syncIntervalMs, (int)q.syncIntervalMs);
+  TEST_ASSERT_TRUE(q.matches(3, 62333952));
+  TEST_ASSERT_FALSE(q.matches(3, 31116288));   // 別の容量のカード
+  TEST_ASSERT_FALSE(q.matches(2, 62333952));
+
+  rec[30] ^= 0x01;                             // 破損は CRC で検出
+  TEST_ASSERT_FALSE(q.decode(rec));
+}
+
+void test_log_line(void) {
+  const uint32_t kbps[] = {300, 600, 900, 1050, 1100};
+  const uint32_t p99[]  = {4000, 5000, 6000, 8000, 12000};
+  CardProfile p = makeProfile(kbps, p99, 20000);
+  p.count = 2;
+  p.tune(LIMITS);
+
+  char line[256];
+  p.formatLogLine(1234, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("1234,3,62333952,OK,2048,1000,512:300/600/4000/20000,"
+                           "1024:600/1200/5000/20000\r\n", line);
+
+  char small[24];                              // 切り詰めても終端される
+  p.formatLogLine(1234, small, sizeof(small));
+  TEST_ASSERT_EQUAL(sizeof(small) - 1, strlen(small));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_good_card_gets_small_blocks_and_short_interval);
+  RUN_TEST(test_slow_card_gets_large_blocks_and_long_interval);
+  RUN_TEST(test_encode_decode_roundtrip_and_card_match);
+  RUN_TEST(test_log_line);
+  return UNITY_END();
+}
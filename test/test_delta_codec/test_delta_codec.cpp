@@ -0,0 +1,150 @@
+#include <unity.h>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "DeltaCodec.h"
+
+struct Sample {
+  uint32_t t;
+  int32_t  v;
+  uint8_t  flags;
+};
+
+/**
+ * @brief 実機相当の系列: 500ms 周期 ± IO 周期の揺らぎ、0.25°C 量子化の緩やかな昇温
+ */
+static std::vector<Sample> realisticSeries(size_t n) {
+  std::vector<Sample> s;
+  srand(1);
+  uint32_t t = 0;
+  double   temp = 25.0;
+  for (size_t i = 0; i < n; ++i) {
+    t += 500 + (rand() % 3 - 1) * 10;           // 490 / 500 / 510ms
+    temp += 0.02 + (rand() % 100 - 50) * 0.001;  // ゆっくり上昇 + ノイズ
+    Sample x;
+    x.t     = t;
+    x.v     = static_cast<int32_t>(temp * 4.0 + 0.5);
+    x.flags = (temp > 40.0) ? BinaryLog::FLAG_HI_ALARM : 0;
+    s.push_back(x);
+  }
+  return s;
+}
+
+/**
+ * @brief 系列を DeltaBlock で符号化し、復号して元と一致するか確認
+ * @param blocksOut [out] 使ったブロック数
+ */
+static void roundTrip(const std::vector<Sample>& in, size_t& blocksOut) {
+  blocksOut = 0;
+  DeltaBlock block;
+  block.reset(0);
+  std::vector<std::vector<uint8_t> > sealed;
+  for (size_t i = 0; i < in.size(); ++i) {
+    if (!block.add(in[i].t, in[i].v, in[i].flags)) {
+      const uint8_t* b = block.seal();
+      sealed.push_back(std::vector<uint8_t>(b, b + BinaryLog::BLOCK_SIZE));
+      TEST_ASSERT_TRUE(block.add(in[i].t, in[i].v, in[i].flags));
+    }
+  }
+  const uint8_t* last = block.seal();
+  sealed.push_back(std::vector<uint8_t>(last, last + BinaryLog::BLOCK_SIZE));
+
+  size_t k = 0;
+  for (size_t b = 0; b < sealed.size(); ++b) {
+    uint8_t  type = 0;
+    uint16_t count = 0;
+    uint32_t seq = 0;
+    TEST_ASSERT_TRUE(BinaryLog::checkBlock(&sealed[b][0], type, count, seq) ==
+                     BinaryLog::BlockStatus::OK);
+    TEST_ASSERT_EQUAL(BinaryLog::BLOCK_DELTA, type);
+    TEST_ASSERT_EQUAL_UINT32(b, seq);
+
+    DeltaDecoder dec;
+    dec.reset(&sealed[b][BinaryLog::BLOCK_HEADER_SIZE], BinaryLog::PAYLOAD_SIZE, count);
+    uint32_t t;
+    int32_t  v;
+    uint8_t  f;
+    while (dec.next(t, v, f)) {
+      TEST_ASSERT_TRUE(k < in.size());
+      TEST_ASSERT_EQUAL_UINT32(in[k].t, t);
+      TEST_ASSERT_EQUAL_INT32(in[k].v, v);
+      TEST_ASSERT_EQUAL_UINT8(in[k].flags, f);
+      ++k;
+    }
+  }
+  TEST_ASSERT_EQUAL((int)in.size(), (int)k);
+  blocksOut = sealed.size();
+}
+
+void test_realistic_series_round_trips_across_blocks(void) {
+  size_t blocks = 0;
+  roundTrip(realisticSeries(5000), blocks);
+  TEST_ASSERT_TRUE(blocks > 1);
+}
+
+void test_extreme_values_use_escape_codes(void) {
+  std::vector<Sample> s;
+  const Sample xs[] = {
+      {0u, 0, 0},
+      {1u, INT32_MAX, 3},
+      {2u, INT32_MIN, 0},                // NaN 相当
+      {0x7FFFFFF0u, -5, 1},             // 巨大な時刻の飛び
+      {0x80000010u, 6, 2},              // 32bit 境界をまたぐ
+      {0x80000010u, 6, 2},              // 同一時刻・同一値
+      {0x00000005u, -1000000, 0},       // 巻き戻り
+  };
+  s.assign(xs, xs + sizeof(xs) / sizeof(xs[0]));
+  size_t blocks = 0;
+  roundTrip(s, blocks);
+  TEST_ASSERT_EQUAL(1, (int)blocks);
+}
+
+void test_compression_is_tenfold_against_fixed_records(void) {
+  // 1 ブロックに入るサンプル数 = 固定長 20B レコード換算の圧縮率
+  const std::vector<Sample> s = realisticSeries(20000);
+  size_t blocks = 0;
+  roundTrip(s, blocks);
+  TEST_ASSERT_TRUE(blocks > 0);
+  const double bytesPerSample =
+      static_cast<double>(blocks * BinaryLog::BLOCK_SIZE) / static_cast<double>(s.size());
+  TEST_ASSERT_TRUE(bytesPerSample * 10.0 <= static_cast<double>(BinaryLog::RECORD_SIZE));
+}
+
+void test_snapshot_keeps_block_open(void) {
+  DeltaBlock block;
+  block.reset(4);
+  TEST_ASSERT_TRUE(block.add(100, 40, 0));
+  TEST_ASSERT_TRUE(block.add(600, 41, 0));
+  uint8_t first[BinaryLog::BLOCK_SIZE];
+  memcpy(first, block.snapshot(), sizeof(first));
+  TEST_ASSERT_TRUE(block.add(1100, 41, 1));
+  TEST_ASSERT_EQUAL_UINT32(4, block.seq());   // snapshot() は進めない
+  TEST_ASSERT_EQUAL(3, block.count());
+
+  uint8_t  type = 0;
+  uint16_t count = 0;
+  uint32_t seq = 0;
+  TEST_ASSERT_TRUE(BinaryLog::checkBlock(first, type, count, seq) == BinaryLog::BlockStatus::OK);
+  TEST_ASSERT_EQUAL(2, count);
+}
+
+void test_delta_row_format(void) {
+  char buf[64];
+  formatDeltaRow(1500, -43, BinaryLog::FLAG_LO_ALARM, 250, buf);
+  TEST_ASSERT_EQUAL_STRING("1500,-10.75,false,true\r\n", buf);
+  formatDeltaRow(2000, 2161, 0, 250, buf);
+  TEST_ASSERT_EQUAL_STRING("2000,540.25,false,false\r\n", buf);
+  formatDeltaRow(2500, INT32_MIN, BinaryLog::FLAG_HI_ALARM, 250, buf);
+  TEST_ASSERT_EQUAL_STRING("2500,NaN,true,false\r\n", buf);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_realistic_series_round_trips_across_blocks);
+  RUN_TEST(test_extreme_values_use_escape_codes);
+  RUN_TEST(test_compression_is_tenfold_against_fixed_records);
+  RUN_TEST(test_snapshot_keeps_block_open);
+  RUN_TEST(test_delta_row_format);
+  return UNITY_END();
+}
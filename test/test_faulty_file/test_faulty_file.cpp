@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <cstring>
+#include <string>
+#include "FaultyFile.h"
+#include "SectorWriter.h"
+
+typedef SectorWriter<FaultyFile> Writer;
+
+static std::string row(int i) {
+  char buf[80];
+  snprintf(buf, sizeof(buf), "%d,540.2,RUN,%d,538.7,1.3,545.0,531.9,false,false\r\n", i, i * 10);
+  return buf;
+}
+
+/**
+ * @brief ログ経路の模擬: 500ms ごとに 1 行を append() + service()
+ */
+struct Pipeline {
+  FaultyFile       file;
+  Writer           writer;
+  std::string      expected;
+  LatencyHistogram appendUs;    // append() だけの模擬時間
+  LatencyHistogram serviceUs;   // service() の模擬時間
+  uint32_t         errors;
+
+  Pipeline(const FaultPlan& plan, SdLatency* lat = nullptr)
+      : file(plan, lat), writer(file, 2000, 4096), errors(0) {
+    file.open();
+    writer.reset(0);
+  }
+
+  void run(int rows) {
+    for (int i = 0; i < rows; ++i) {
+      file.advanceTo(static_cast<uint64_t>(i) * 500000);
+      const std::string r = row(i);
+      expected += r;
+      uint64_t t0 = file.nowUs();
+      if (!writer.append(r.data(), r.size())) ++errors;
+      appendUs.record(static_cast<uint32_t>(file.nowUs() - t0));
+      t0 = file.nowUs();
+      if (!writer.service(static_cast<uint32_t>(file.nowUs() / 1000))) ++errors;
+      serviceUs.record(static_cast<uint32_t>(file.nowUs() - t0));
+    }
+  }
+};
+
+void test_spikes_are_recorded_per_operation(void) {
+  FaultPlan plan;
+  plan.spikePermille = 50;
+  plan.spikeUs       = 300000;
+  SdLatency lat;
+  Pipeline  p(plan, &lat);
+  p.run(2000);
+
+  TEST_ASSERT_EQUAL(0, (int)p.errors);
+  TEST_ASSERT_TRUE(p.file.stats().spikes > 0);
+  TEST_ASSERT_EQUAL(1, (int)lat.histogram(SdOp::OPEN).count());
+  TEST_ASSERT_TRUE(lat.histogram(SdOp::WRITE).count() > 0);
+  TEST_ASSERT_TRUE(lat.histogram(SdOp::FLUSH).count() > 0);
+  TEST_ASSERT_TRUE(lat.histogram(SdOp::WRITE).max() >= 150000);   // スパイクが分布に出る
+  TEST_ASSERT_TRUE(lat.histogram(SdOp::WRITE).percentile(500) < 1000);
+
+  char line[112];
+  lat.formatLine(SdOp::FLUSH, line, sizeof(line));
+  TEST_ASSERT_EQUAL(0, strncmp(line, "flush n=", 8));
+}
+
+void test_append_never_waits_for_the_card(void) {
+  // 書き出しが追いついていれば、止まるカードでも append() は RAM コピーのみ
+  FaultPlan plan;
+  plan.spikePermille = 100;
+  plan.spikeUs       = 500000;
+  Pipeline p(plan);
+  p.run(3000);
+
+  TEST_ASSERT_EQUAL(0, (int)p.errors);
+  TEST_ASSERT_EQUAL(0, (int)p.appendUs.max());
+  TEST_ASSERT_EQUAL(0, (int)p.writer.stats().stalls);
+  TEST_ASSERT_TRUE(p.serviceUs.max() >= 250000);     // 停止は service() 側に出る
+
+  TEST_ASSERT_TRUE(p.writer.sync(0));
+  TEST_ASSERT_TRUE(p.file.data() == p.expected);     // 内容は欠けない
+}
+
+void test_short_writes_and_failures_are_reported(void) {
+  FaultPlan shortPlan;
+  shortPlan.shortWritePermille = 200;
+  Pipeline s(shortPlan);
+  s.run(500);
+  TEST_ASSERT_TRUE(s.file.stats().shortWrites > 0);
+  TEST_ASSERT_TRUE(s.errors > 0);                    // 黙って失われない
+
+  FaultPlan gone;
+  gone.failAfterOps = 20;                            // カード抜け
+  Pipeline g(gone);
+  g.run(500);
+  TEST_ASSERT_TRUE(g.file.stats().failures > 0);
+  TEST_ASSERT_TRUE(g.errors > 0);
+  TEST_ASSERT_FALSE(g.writer.sync(0));
+}
+
+void test_same_plan_gives_same_run(void) {
+  FaultPlan plan;
+  plan.spikePermille      = 30;
+  plan.spikeUs            = 200000;
+  plan.shortWritePermille = 10;
+  plan.seed               = 42;
+  Pipeline a(plan);
+  Pipeline b(plan);
+  a.run(1000);
+  b.run(1000);
+  TEST_ASSERT_EQUAL((int)a.file.stats().spikes, (int)b.file.stats().spikes);
+  TEST_ASSERT_EQUAL((int)a.errors, (int)b.errors);
+  TEST_ASSERT_TRUE(a.file.nowUs() == b.file.nowUs());
+  TEST_ASSERT_TRUE(a.file.data() == b.file.data());
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_spikes_are_recorded_per_operation);
+  RUN_TEST(test_append_never_waits_for_the_card);
+  RUN_TEST(test_short_writes_and_failures_are_reported);
+  RUN_TEST(test_same_plan_gives_same_run);
+  return UNITY_END();
+}
@@ -0,0 +1,162 @@
+#include <unity.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "FixedFormat.h"
+#include "Rollup.h"
+
+static void expectFloat(float v, int decimals, int width) {
+  char expect[64];
+  char got[64];
+  snprintf(expect, sizeof(expect), "%*.*f", width, decimals, static_cast<double>(v));
+  char* e = FixedFormat::putFloat(got, v, static_cast<uint8_t>(decimals), static_cast<uint8_t>(width));
+  *e = '\0';
+  TEST_ASSERT_EQUAL_STRING(expect, got);
+}
+
+void test_integers_match_printf(void) {
+  char buf[32];
+  char expect[32];
+  const int32_t values[] = {0, 7, -7, 42, 99999, 100000, -12345, 2147483647, -2147483647 - 1};
+  for (int32_t v : values) {
+    *FixedFormat::putInt(buf, v) = '\0';
+    snprintf(expect, sizeof(expect), "%ld", static_cast<long>(v));
+    TEST_ASSERT_EQUAL_STRING(expect, buf);
+
+    *FixedFormat::putIntPad(buf, v, 5) = '\0';
+    snprintf(expect, sizeof(expect), "%5ld", static_cast<long>(v));
+    TEST_ASSERT_EQUAL_STRING(expect, buf);
+
+    *FixedFormat::putIntPad(buf, v, 6, '0') = '\0';
+    snprintf(expect, sizeof(expect), "%06ld", static_cast<long>(v));
+    TEST_ASSERT_EQUAL_STRING(expect, buf);
+  }
+  *FixedFormat::putUint(buf, 4294967295u) = '\0';
+  TEST_ASSERT_EQUAL_STRING("4294967295", buf);
+}
+
+void test_fixed_and_milli(void) {
+  char buf[32];
+  *FixedFormat::putFixed(buf, -1234, 1) = '\0';
+  TEST_ASSERT_EQUAL_STRING("-123.4", buf);
+  *FixedFormat::putFixed(buf, 5, 3) = '\0';
+  TEST_ASSERT_EQUAL_STRING("0.005", buf);
+  *FixedFormat::putFixed(buf, 0, 1, true) = '\0';
+  TEST_ASSERT_EQUAL_STRING("-0.0", buf);
+
+  // ミリ度 → 小数 1 位（0 から遠い方へ四捨五入）
+  *FixedFormat::putMilli(buf, 25349, 1) = '\0';
+  TEST_ASSERT_EQUAL_STRING("25.3", buf);
+  *FixedFormat::putMilli(buf, 25350, 1) = '\0';
+  TEST_ASSERT_EQUAL_STRING("25.4", buf);
+  *FixedFormat::putMilli(buf, -25350, 1) = '\0';
+  TEST_ASSERT_EQUAL_STRING("-25.4", buf);
+  *FixedFormat::putMilli(buf, -1250, 3) = '\0';
+  TEST_ASSERT_EQUAL_STRING("-1.250", buf);
+}
+
+void test_float_edge_cases_match_printf(void) {
+  const float values[] = {0.0f, -0.0f, 0.05f, 0.25f, 25.25f, 25.35f, -0.04f, -0.05f, 0.95f,
+                          99.95f, 1023.75f, -270.0f, 1e6f, 3e9f, -3.4e38f, INFINITY, -INFINITY, NAN};
+  for (float v : values) {
+    for (int d = 0; d <= 3; ++d) {
+      expectFloat(v, d, 0);
+      expectFloat(v, d, 6);
+    }
+  }
+}
+
+void test_random_floats_match_printf(void) {
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> temp(-300.0f, 1400.0f);
+  std::uniform_int_distribution<uint32_t> bits;
+  for (int i = 0; i < 200000; ++i) {
+    const float v = temp(rng);
+    expectFloat(v, 1, 0);
+    expectFloat(v, 2, 0);
+    expectFloat(v, 3, 6);
+  }
+  // 全ビットパターンからの抜き取り（非正規化数・巨大値・NaN を含む）
+  for (int i = 0; i < 100000; ++i) {
+    uint32_t b = bits(rng);
+    float    v;
+    memcpy(&v, &b, sizeof(v));
+    expectFloat(v, 1, 6);
+  }
+}
+
+void test_rollup_row_matches_previous_snprintf(void) {
+  RollupRow r;
+  memset(&r, 0, sizeof(r));
+  r.startMs = 3600000;
+  r.count   = 10;
+  r.mean    = 25.125f;
+  r.minV    = -0.004f;
+  r.maxV    = 26.995f;
+  r.stdDev  = 0.0625f;
+  char expect[128];
+  char got[128];
+  snprintf(expect, sizeof(expect), "%lu,%lu,%.2f,%.2f,%.2f,%.3f\r\n",
+           static_cast<unsigned long>(r.startMs), static_cast<unsigned long>(r.count),
+           static_cast<double>(r.mean), static_cast<double>(r.minV),
+           static_cast<double>(r.maxV), static_cast<double>(r.stdDev));
+  const size_t n = RollupCascade::formatCsv(r, got, sizeof(got));
+  TEST_ASSERT_EQUAL_STRING(expect, got);
+  TEST_ASSERT_EQUAL(strlen(expect), n);
+
+  // 短いバッファでは snprintf と同じく切り詰める
+  char small[8];
+  TEST_ASSERT_EQUAL(7, RollupCascade::formatCsv(r, small, sizeof(small)));
+  TEST_ASSERT_EQUAL_STRING("3600000", small);
+}
+
+/**
+ * @brief CSV 1 行相当（%.1f × 5）の整形時間を snprintf と比較（native ベンチマーク）
+ */
+void test_benchmark_against_snprintf(void) {
+  const int N = 200000;
+  float vals[5] = {25.3f, 25.1f, 0.12f, 26.9f, 24.0f};
+  char  buf[128];
+  volatile size_t sink = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; ++i) {
+    vals[0] += 0.01f;
+    const int n = snprintf(buf, sizeof(buf), "%.1f,%.1f,%.1f,%.1f,%.1f", vals[0], vals[1],
+                           vals[2], vals[3], vals[4]);
+    sink = sink + static_cast<size_t>(n);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  vals[0] = 25.3f;
+  for (int i = 0; i < N; ++i) {
+    vals[0] += 0.01f;
+    char* p = buf;
+    for (int k = 0; k < 5; ++k) {
+      if (k > 0) *p++ = ',';
+      p = FixedFormat::putFloat(p, vals[k], 1);
+    }
+    *p = '\0';
+    sink = sink + static_cast<size_t>(p - buf);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  const double printfNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / N;
+  const double fixedNs  = std::chrono::duration<double, std::nano>(t2 - t1).count() / N;
+  printf("[BENCH] 5 x %%.1f: snprintf %.0f ns, FixedFormat %.0f ns (x%.1f)\n", printfNs,
+         fixedNs, printfNs / fixedNs);
+  TEST_ASSERT_TRUE(sink > 0);
+  TEST_ASSERT_TRUE(fixedNs < printfNs);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_integers_match_printf);
+  RUN_TEST(test_fixed_and_milli);
+  RUN_TEST(test_float_edge_cases_match_printf);
+  RUN_TEST(test_random_floats_match_printf);
+  RUN_TEST(test_rollup_row_matches_previous_snprintf);
+  RUN_TEST(test_benchmark_against_snprintf);
+  return UNITY_END();
+}
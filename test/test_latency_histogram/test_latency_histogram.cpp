@@ -0,0 +1,76 @@
+#include <unity.h>
+#include "LatencyHistogram.h"
+
+void test_bucket_bounds_are_contiguous(void) {
+  // 各バケットの下限は直前バケットの上限 + 1
+  for (uint8_t i = 1; i < LatencyHistogram::BUCKETS; ++i) {
+    TEST_ASSERT_EQUAL(LatencyHistogram::bucketUpper(i - 1) + 1,
+                      LatencyHistogram::bucketLower(i));
+  }
+  TEST_ASSERT_EQUAL(0, LatencyHistogram::bucketLower(0));
+  TEST_ASSERT_EQUAL(LatencyHistogram::MAX_VALUE,
+                    LatencyHistogram::bucketUpper(LatencyHistogram::BUCKETS - 1));
+}
+
+void test_value_falls_inside_its_bucket(void) {
+  const uint32_t samples[] = {0, 1, 3, 4, 7, 8, 9, 15, 16, 100, 999, 1000,
+                              4095, 4096, 5000, 30000, 100000, 1234567};
+  for (uint32_t v : samples) {
+    const uint8_t b = LatencyHistogram::bucketIndex(v);
+    TEST_ASSERT_LESS_OR_EQUAL(v, LatencyHistogram::bucketLower(b));
+    TEST_ASSERT_GREATER_OR_EQUAL(v, LatencyHistogram::bucketUpper(b));
+  }
+  // 上限超えは最終バケットへ丸める
+  TEST_ASSERT_EQUAL(LatencyHistogram::BUCKETS - 1,
+                    LatencyHistogram::bucketIndex(0xFFFFFFFFUL));
+}
+
+void test_relative_error_within_25_percent(void) {
+  for (uint8_t i = 4; i < LatencyHistogram::BUCKETS; ++i) {
+    const double lo = LatencyHistogram::bucketLower(i);
+    const double hi = LatencyHistogram::bucketUpper(i);
+    TEST_ASSERT_TRUE((hi - lo) / lo <= 0.25);
+  }
+}
+
+void test_count_max_and_overruns(void) {
+  LatencyHistogram h;
+  h.record(100, 5000);
+  h.record(6000, 5000);
+  h.record(5000, 5000);  // 予算ちょうどは超過ではない
+  TEST_ASSERT_EQUAL(3, h.count());
+  TEST_ASSERT_EQUAL(6000, h.max());
+  TEST_ASSERT_EQUAL(1, h.overruns());
+  h.reset();
+  TEST_ASSERT_EQUAL(0, h.count());
+  TEST_ASSERT_EQUAL(0, h.max());
+  TEST_ASSERT_EQUAL(0, h.percentile(990));
+}
+
+void test_percentiles(void) {
+  LatencyHistogram h;
+  // 990 件の 400us と 10 件の 20ms（2 件目以降の外れ値）
+  for (int i = 0; i < 990; ++i) h.record(400);
+  for (int i = 0; i < 10; ++i) h.record(20000);
+
+  const uint32_t p50 = h.percentile(500);
+  TEST_ASSERT_GREATER_OR_EQUAL(400, p50);
+  TEST_ASSERT_LESS_OR_EQUAL(500, p50);
+
+  const uint32_t p99 = h.percentile(990);
+  TEST_ASSERT_LESS_OR_EQUAL(500, p99);  // 99% 点はまだ 400us 側
+
+  const uint32_t p999 = h.percentile(999);
+  TEST_ASSERT_GREATER_OR_EQUAL(16384, p999);
+  TEST_ASSERT_LESS_OR_EQUAL(20000, p999);  // max を超えない
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bucket_bounds_are_contiguous);
+  RUN_TEST(test_value_falls_inside_its_bucket);
+  RUN_TEST(test_relative_error_within_25_percent);
+  RUN_TEST(test_count_max_and_overruns);
+  RUN_TEST(test_percentiles);
+  return UNITY_END();
+}
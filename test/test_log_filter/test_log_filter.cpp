@@ -0,0 +1,100 @@
+#include <unity.h>
+#include <cmath>
+#include <cstring>
+#include "LogFilter.h"
+
+void test_sample_mode_records_every_event(void) {
+  LogFilter f;
+  f.configure(false, 0.5f, 10000);
+  f.reset();
+  TEST_ASSERT_EQUAL(LogFilter::FIRST, f.offer(0, 25.0f, 0));
+  TEST_ASSERT_EQUAL(LogFilter::SAMPLE, f.offer(500, 25.0f, 0));   // 同じ値でも新サンプルなら記録
+  TEST_ASSERT_EQUAL(LogFilter::ALARM, f.offer(700, 25.0f, 1));
+  TEST_ASSERT_EQUAL_UINT32(3, f.stats().offered);
+  TEST_ASSERT_EQUAL_UINT32(3, f.stats().written);
+  TEST_ASSERT_EQUAL_UINT32(1, f.stats().byAlarm);
+}
+
+void test_deadband_drops_flat_samples_and_keeps_changes(void) {
+  LogFilter f;
+  f.configure(true, 0.5f, 10000);
+  f.reset();
+  TEST_ASSERT_EQUAL(LogFilter::FIRST, f.offer(0, 25.0f, 0));
+  TEST_ASSERT_EQUAL(LogFilter::NONE, f.offer(500, 25.25f, 0));
+  TEST_ASSERT_EQUAL(LogFilter::NONE, f.offer(1000, 25.5f, 0));    // |Δ| = ε は記録しない
+  TEST_ASSERT_EQUAL(LogFilter::CHANGE, f.offer(1500, 25.75f, 0));
+  // 基準は最後に記録した値（少しずつのドリフトも ε を超えた時点で記録）
+  TEST_ASSERT_EQUAL(LogFilter::NONE, f.offer(2000, 25.5f, 0));
+  TEST_ASSERT_EQUAL(LogFilter::CHANGE, f.offer(2500, 25.0f, 0));
+  TEST_ASSERT_EQUAL_UINT32(6, f.stats().offered);
+  TEST_ASSERT_EQUAL_UINT32(3, f.stats().written);
+  TEST_ASSERT_EQUAL_UINT32(2, f.stats().byChange);
+}
+
+void test_deadband_max_interval_forces_a_row(void) {
+  LogFilter f;
+  f.configure(true, 0.5f, 10000);
+  f.reset();
+  f.offer(1000, 25.0f, 0);
+  uint32_t written = 1;
+  for (uint32_t t = 1500; t <= 31000; t += 500) {
+    if (f.offer(t, 25.0f, 0) != LogFilter::NONE) ++written;
+  }
+  TEST_ASSERT_EQUAL_UINT32(4, written);   // 1000, 11000, 21000, 31000
+  TEST_ASSERT_EQUAL_UINT32(3, f.stats().byInterval);
+}
+
+void test_deadband_always_records_alarm_and_nan_transitions(void) {
+  LogFilter f;
+  f.configure(true, 0.5f, 0);
+  f.reset();
+  f.offer(0, 25.0f, 0);
+  TEST_ASSERT_EQUAL(LogFilter::ALARM, f.offer(500, 25.0f, 2));
+  TEST_ASSERT_EQUAL(LogFilter::ALARM, f.offer(1000, 25.0f, 0));
+  TEST_ASSERT_EQUAL(LogFilter::CHANGE, f.offer(1500, NAN, 0));   // 断線開始
+  TEST_ASSERT_EQUAL(LogFilter::NONE, f.offer(2000, NAN, 0));
+  TEST_ASSERT_EQUAL(LogFilter::CHANGE, f.offer(2500, 25.0f, 0));  // 復帰
+  TEST_ASSERT_EQUAL(LogFilter::NONE, f.offer(600000, 25.0f, 0));  // 間隔上限なし
+}
+
+void test_reset_starts_a_new_run(void) {
+  LogFilter f;
+  f.configure(true, 0.5f, 10000);
+  f.reset();
+  f.offer(0, 25.0f, 0);
+  f.offer(500, 25.0f, 0);
+  f.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, f.stats().offered);
+  TEST_ASSERT_EQUAL(LogFilter::FIRST, f.offer(0, 25.0f, 0));
+
+  char buf[160];
+  const size_t n = f.formatFooter(buf, sizeof(buf));
+  TEST_ASSERT_EQUAL(strlen(buf), n);
+  TEST_ASSERT_EQUAL_STRING("# LOGF,mode=deadband,eps=0.50,max_interval_ms=10000,offered=1,"
+                           "written=1,change=0,interval=0,alarm=0\r\n", buf);
+}
+
+void test_restart_keeps_stats_for_a_new_segment(void) {
+  LogFilter f;
+  f.configure(true, 0.5f, 10000);
+  f.reset();
+  f.offer(0, 25.0f, 0);
+  f.offer(500, 25.0f, 0);
+  // 区間の切り替え: 時刻の基準が 0 に戻っても最初のイベントは必ず記録、統計は続く
+  f.restart();
+  TEST_ASSERT_EQUAL(LogFilter::FIRST, f.offer(0, 25.0f, 0));
+  TEST_ASSERT_EQUAL(LogFilter::NONE, f.offer(500, 25.0f, 0));
+  TEST_ASSERT_EQUAL_UINT32(4, f.stats().offered);
+  TEST_ASSERT_EQUAL_UINT32(2, f.stats().written);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sample_mode_records_every_event);
+  RUN_TEST(test_deadband_drops_flat_samples_and_keeps_changes);
+  RUN_TEST(test_deadband_max_interval_forces_a_row);
+  RUN_TEST(test_deadband_always_records_alarm_and_nan_transitions);
+  RUN_TEST(test_reset_starts_a_new_run);
+  RUN_TEST(test_restart_keeps_stats_for_a_new_segment);
+  return UNITY_END();
+}
@@ -0,0 +1,292 @@
+#include <unity.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "LogIndex.h"
+#include "LogPrealloc.h"
+
+/**
+ * @brief メモリ上のファイル（読み出し回数を数える）
+ */
+struct MemSource {
+  std::vector<uint8_t> data;
+  size_t               reads;
+
+  MemSource() : reads(0) {}
+  size_t read(uint32_t offset, uint8_t* buf, size_t len) {
+    ++reads;
+    if (offset >= data.size()) return 0;
+    if (len > data.size() - offset) len = data.size() - offset;
+    memcpy(buf, &data[offset], len);
+    return len;
+  }
+  void append(const std::string& s) { data.insert(data.end(), s.begin(), s.end()); }
+  void append(const uint8_t* p, size_t n) { data.insert(data.end(), p, p + n); }
+  uint32_t size() const { return static_cast<uint32_t>(data.size()); }
+};
+
+/**
+ * @brief 書き込み側（SDManager）と同じく、エントリを配列に集める
+ */
+struct Collect {
+  std::vector<LogIndexEntry> entries;
+  void operator()(const LogIndexEntry& e) { entries.push_back(e); }
+};
+
+static const char* COLUMNS =
+    "ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,HI_ALARM,LO_ALARM,ElapsedMs";
+
+static std::string csvRow(uint32_t ms) {
+  char buf[128];
+  snprintf(buf, sizeof(buf), "%u,%.1f,RUN,%u,%.1f,%.1f,%.1f,%.1f,false,false,%u\r\n",
+           ms / 1000, 25.0 + ms * 0.0001, ms / 100, 25.0, 0.5, 30.0, 20.0, ms);
+  return buf;
+}
+
+/**
+ * @brief 索引ファイル（ヘッダ + エントリ）をメモリ上に
+ */
+static void buildIndexFile(MemSource& idx, const std::vector<LogIndexEntry>& entries,
+                           uint32_t count, uint8_t complete) {
+  LogIndexHeader h = {120, count, complete, 0};
+  uint8_t head[LogIndex::HEADER_SIZE];
+  LogIndex::encodeHeader(h, head);
+  idx.append(head, sizeof(head));
+  for (size_t i = 0; i < entries.size(); ++i) {
+    uint8_t buf[LogIndex::ENTRY_SIZE];
+    LogIndex::encodeEntry(entries[i], buf);
+    idx.append(buf, sizeof(buf));
+  }
+}
+
+/**
+ * @brief 先頭セクタ + rows 行（ckptEvery 行ごとに '#' 行）の CSV。書き込み側の索引も作る
+ */
+static void buildCsv(MemSource& f, uint32_t rows, uint32_t ckptEvery, uint32_t interval,
+                     Collect& written) {
+  uint8_t sector[LogPrealloc::SECTOR_SIZE];
+  LogPrealloc::formatCsvHeaderSector(COLUMNS, 0, false, sector);
+  f.append(sector, sizeof(sector));
+  LogIndex::Builder builder(interval);
+  for (uint32_t i = 0; i < rows; ++i) {
+    LogIndexEntry e;
+    if (builder.offer(i, i * 500, f.size(), e)) written(e);
+    f.append(csvRow(i * 500));
+    if ((i + 1) % ckptEvery == 0) f.append("# CKPT,seq=0\r\n");
+  }
+}
+
+static void assertSameEntries(const std::vector<LogIndexEntry>& a,
+                              const std::vector<LogIndexEntry>& b) {
+  TEST_ASSERT_EQUAL(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    TEST_ASSERT_EQUAL_UINT32(a[i].elapsedMs, b[i].elapsedMs);
+    TEST_ASSERT_EQUAL_UINT32(a[i].offset, b[i].offset);
+    TEST_ASSERT_EQUAL_UINT32(a[i].recordSeq, b[i].recordSeq);
+  }
+}
+
+void test_header_and_entry_round_trip(void) {
+  LogIndexHeader h = {120, 42, 1, 2};
+  uint8_t head[LogIndex::HEADER_SIZE];
+  LogIndex::encodeHeader(h, head);
+  LogIndexHeader out;
+  TEST_ASSERT_TRUE(LogIndex::decodeHeader(head, out));
+  TEST_ASSERT_EQUAL_UINT32(120, out.interval);
+  TEST_ASSERT_EQUAL_UINT32(42, out.count);
+  TEST_ASSERT_EQUAL_UINT8(1, out.complete);
+  TEST_ASSERT_EQUAL_UINT8(2, out.logFormat);
+  head[16] ^= 0x01;
+  TEST_ASSERT_FALSE(LogIndex::decodeHeader(head, out));   // CRC 不一致
+
+  LogIndexEntry e = {3600000UL, 0x12345678UL, 7200};
+  uint8_t buf[LogIndex::ENTRY_SIZE];
+  LogIndex::encodeEntry(e, buf);
+  TEST_ASSERT_EQUAL_UINT8(0x78, buf[4]);                // リトルエンディアン
+  LogIndexEntry back;
+  LogIndex::decodeEntry(buf, back);
+  TEST_ASSERT_EQUAL_UINT32(3600000UL, back.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(0x12345678UL, back.offset);
+  TEST_ASSERT_EQUAL_UINT32(7200, back.recordSeq);
+
+  // 未確定はファイルサイズから（末尾の書きかけエントリは数えない）、確定済みはヘッダから
+  LogIndexHeader open = {120, 0, 0, 0};
+  TEST_ASSERT_EQUAL_UINT32(3, LogIndex::entryCount(open, LogIndex::entryOffset(3) + 5));
+  LogIndexHeader done = {120, 2, 1, 0};
+  TEST_ASSERT_EQUAL_UINT32(2, LogIndex::entryCount(done, LogIndex::entryOffset(3)));
+}
+
+void test_builder_spaces_entries_by_record_count(void) {
+  // 1 レコードごとの同期点（CSV）
+  LogIndex::Builder rows(120);
+  std::vector<uint32_t> seqs;
+  for (uint32_t i = 0; i < 500; ++i) {
+    LogIndexEntry e;
+    if (rows.offer(i, i * 500, i * 80, e)) seqs.push_back(e.recordSeq);
+  }
+  TEST_ASSERT_EQUAL(5, (int)seqs.size());
+  TEST_ASSERT_EQUAL_UINT32(480, seqs[4]);
+
+  // 25 レコードごとの同期点（BINARY のブロック）: 間隔以上離れた最初のブロック
+  LogIndex::Builder blocks(120);
+  seqs.clear();
+  for (uint32_t seq = 0; seq < 500; seq += 25) {
+    LogIndexEntry e;
+    if (blocks.offer(seq, seq * 500, 512 + seq / 25 * 512, e)) seqs.push_back(e.recordSeq);
+  }
+  TEST_ASSERT_EQUAL(4, (int)seqs.size());
+  TEST_ASSERT_EQUAL_UINT32(125, seqs[1]);
+  TEST_ASSERT_EQUAL_UINT32(375, seqs[3]);
+}
+
+void test_lookup_is_logarithmic(void) {
+  std::vector<LogIndexEntry> entries;
+  for (uint32_t i = 0; i < 10000; ++i) {
+    LogIndexEntry e = {static_cast<uint32_t>(1000 + i * 60000UL),
+                       static_cast<uint32_t>(512 + i * 9600UL), i * 120};
+    entries.push_back(e);
+  }
+  MemSource idx;
+  buildIndexFile(idx, entries, 10000, 1);
+
+  LogIndexEntry e;
+  uint32_t      index = 0;
+  idx.reads = 0;
+  TEST_ASSERT_TRUE(LogIndex::lookup(idx, 10000, 3 * 3600000UL + 15 * 60000UL, false, e, index));
+  TEST_ASSERT_TRUE(idx.reads <= 14);                     // ⌈log2(10000)⌉ = 14
+  TEST_ASSERT_EQUAL_UINT32(194, index);                  // 1000 + 194 × 60000 <= 3:15:00 < 次
+  TEST_ASSERT_EQUAL_UINT32(512 + 194 * 9600UL, e.offset);
+
+  TEST_ASSERT_TRUE(LogIndex::lookup(idx, 10000, 1000, false, e, index));   // ちょうど一致
+  TEST_ASSERT_EQUAL_UINT32(0, index);
+  TEST_ASSERT_FALSE(LogIndex::lookup(idx, 10000, 999, false, e, index));   // 最初より前
+  TEST_ASSERT_TRUE(LogIndex::lookup(idx, 10000, 0xFFFFFFFFUL, false, e, index));
+  TEST_ASSERT_EQUAL_UINT32(9999, index);
+
+  // オフセットで探す（復旧時: 有効長より手前の最後のエントリ）
+  TEST_ASSERT_TRUE(LogIndex::lookup(idx, 10000, 512 + 50 * 9600UL - 1, true, e, index));
+  TEST_ASSERT_EQUAL_UINT32(49, index);
+}
+
+void test_csv_rescan_matches_writer_index(void) {
+  MemSource log;
+  Collect   written;
+  buildCsv(log, 1000, 60, 120, written);
+  TEST_ASSERT_EQUAL(9, (int)written.entries.size());
+
+  Collect rebuilt;
+  LogIndex::Builder builder(120);
+  uint32_t seq = 0;
+  const uint32_t end = LogIndex::scanCsv(log, LogPrealloc::SECTOR_SIZE, log.size(), seq, builder,
+                                         rebuilt);
+  TEST_ASSERT_EQUAL_UINT32(log.size(), end);
+  TEST_ASSERT_EQUAL_UINT32(1000, seq);                   // '#' 行は数えない
+  assertSameEntries(written.entries, rebuilt.entries);
+
+  // 同期点から読めば目的の時刻の行に着く
+  const LogIndexEntry& e = written.entries[4];
+  TEST_ASSERT_EQUAL_UINT32(480 * 500, e.elapsedMs);
+  const std::string row = csvRow(e.elapsedMs);
+  TEST_ASSERT_EQUAL_MEMORY(row.data(), &log.data[e.offset], row.size());
+}
+
+void test_block_rescan_matches_writer_index(void) {
+  BinLogHeader h;
+  memset(&h, 0, sizeof(h));
+  h.schemaVersion = BinaryLog::SCHEMA_VERSION;
+  h.encoding      = BinaryLog::ENCODING_DELTA;
+  h.quantumMilliC = 250;
+  MemSource log;
+  uint8_t header[BinaryLog::HEADER_SIZE];
+  BinaryLog::encodeHeader(h, header);
+  log.append(header, sizeof(header));
+
+  // SDManager と同じく、ブロックの最初のサンプルを同期点にする（間にチェックポイントの TEXT）
+  Collect written;
+  LogIndex::Builder builder(120);
+  DeltaBlock block;
+  block.reset(0);
+  uint32_t seq = 0;
+  for (uint32_t i = 0; i < 3000; ++i, ++seq) {
+    const int32_t v = 100 + static_cast<int32_t>((i * 7) % 13) - static_cast<int32_t>(i % 5);
+    if (!block.add(i * 500, v, 0)) {
+      log.append(block.seal(), BinaryLog::BLOCK_SIZE);
+      uint8_t text[BinaryLog::BLOCK_SIZE];
+      BinaryLog::encodeTextBlock("# CKPT\r\n", 8, block.seq(), text);
+      log.append(text, sizeof(text));
+      block.reset(block.seq() + 1);
+      block.add(i * 500, v, 0);
+    }
+    LogIndexEntry e;
+    if (block.count() == 1 && builder.offer(seq, i * 500, log.size(), e)) written(e);
+  }
+  log.append(block.seal(), BinaryLog::BLOCK_SIZE);
+  TEST_ASSERT_TRUE(written.entries.size() >= 3);
+
+  Collect rebuilt;
+  LogIndex::Builder again(120);
+  uint32_t n = 0;
+  const uint32_t end = LogIndex::scanBlocks(log, h, BinaryLog::HEADER_SIZE, log.size(), n, again,
+                                            rebuilt);
+  TEST_ASSERT_EQUAL_UINT32(log.size(), end);
+  TEST_ASSERT_EQUAL_UINT32(3000, n);
+  assertSameEntries(written.entries, rebuilt.entries);
+}
+
+void test_recovery_trims_and_resumes_index(void) {
+  MemSource log;
+  Collect   written;
+  buildCsv(log, 1000, 60, 100, written);
+  // 電源断: 生ログは 700 行目の先頭までが有効、索引は先まで同期済み
+  Collect reference;
+  {
+    LogIndex::Builder b(100);
+    uint32_t seq = 0;
+    LogIndex::scanCsv(log, LogPrealloc::SECTOR_SIZE, log.size(), seq, b, reference);
+  }
+  uint32_t validEnd = 0;
+  for (size_t i = 0; i < reference.entries.size(); ++i) {
+    if (reference.entries[i].recordSeq == 700) validEnd = reference.entries[i].offset;
+  }
+  TEST_ASSERT_TRUE(validEnd > 0);
+  MemSource idx;
+  buildIndexFile(idx, written.entries, 0, 0);
+
+  // 有効長より手前の最後のエントリ（600 行目）から続ける
+  LogIndexEntry last = {0, 0, 0};
+  uint32_t      lastIndex = 0;
+  const uint32_t n = LogIndex::entryCount(LogIndexHeader{100, 0, 0, 0}, idx.size());
+  TEST_ASSERT_EQUAL_UINT32(10, n);
+  TEST_ASSERT_TRUE(LogIndex::lookup(idx, n, validEnd - 1, true, last, lastIndex));
+  TEST_ASSERT_EQUAL_UINT32(600, last.recordSeq);
+
+  Collect resumed;
+  LogIndex::Builder b(100);
+  b.resumeAfter(last);
+  uint32_t seq = last.recordSeq;
+  LogIndex::scanCsv(log, last.offset, validEnd, seq, b, resumed);
+  TEST_ASSERT_EQUAL_UINT32(700, seq);
+  TEST_ASSERT_EQUAL(0, (int)resumed.entries.size());    // 700 行目は有効長の外
+
+  // 書きかけの行で止まる（有効長が行の途中）
+  Collect partial;
+  seq = last.recordSeq;
+  LogIndex::Builder b2(50);
+  b2.resumeAfter(last);
+  const uint32_t stop = LogIndex::scanCsv(log, last.offset, validEnd + 10, seq, b2, partial);
+  TEST_ASSERT_EQUAL_UINT32(validEnd, stop);
+  TEST_ASSERT_EQUAL(1, (int)partial.entries.size());    // 650 行目
+  TEST_ASSERT_EQUAL_UINT32(650, partial.entries[0].recordSeq);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_header_and_entry_round_trip);
+  RUN_TEST(test_builder_spaces_entries_by_record_count);
+  RUN_TEST(test_lookup_is_logarithmic);
+  RUN_TEST(test_csv_rescan_matches_writer_index);
+  RUN_TEST(test_block_rescan_matches_writer_index);
+  RUN_TEST(test_recovery_trims_and_resumes_index);
+  return UNITY_END();
+}
@@ -0,0 +1,88 @@
+#include <unity.h>
+#include <cstring>
+#include <string>
+#include "BinaryLog.h"
+#include "LogPrealloc.h"
+
+static const char* COLUMNS =
+    "ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,HI_ALARM,LO_ALARM";
+
+void test_plan_rounds_up_to_allocation_unit(void) {
+  // CSV 相当: 720 B/s × 1h = 2,592,000 → 32KB 単位へ切り上げ
+  TEST_ASSERT_EQUAL_UINT32(2621440u, LogPrealloc::planBytes(720, 3600, 32768));
+  // 極小レートでも最低 1 単位
+  TEST_ASSERT_EQUAL_UINT32(32768u, LogPrealloc::planBytes(1, 10, 32768));
+  // FAT32 のファイルサイズ上限で頭打ち
+  TEST_ASSERT_TRUE(LogPrealloc::planBytes(0xFFFFFFFFu, 3600, 32768) <= 0xFFFFFFFFu - 32767u);
+}
+
+void test_extension_triggers_inside_margin(void) {
+  TEST_ASSERT_FALSE(LogPrealloc::needsExtension(100000, 262144, 65536));
+  TEST_ASSERT_TRUE(LogPrealloc::needsExtension(200000, 262144, 65536));
+  TEST_ASSERT_TRUE(LogPrealloc::needsExtension(0xFFFFFF00u, 0xFFFFFFFFu, 65536));   // 桁あふれしない
+}
+
+void test_csv_header_sector_is_one_sector_and_round_trips(void) {
+  uint8_t sector[LogPrealloc::SECTOR_SIZE];
+  TEST_ASSERT_TRUE(LogPrealloc::formatCsvHeaderSector(COLUMNS, 1234567, false, sector));
+
+  // 1 行目は従来の列名行のまま、2 行目がマーカー、末尾は CRLF
+  const std::string text(reinterpret_cast<const char*>(sector), sizeof(sector));
+  TEST_ASSERT_EQUAL(0, (int)text.find(std::string(COLUMNS) + "\r\n# LOG,valid_bytes=0001234567,closed=0 "));
+  TEST_ASSERT_EQUAL('\r', sector[510]);
+  TEST_ASSERT_EQUAL('\n', sector[511]);
+  TEST_ASSERT_EQUAL(510, (int)text.find("\r\n", strlen(COLUMNS) + 2));   // 2 行でちょうど 512B
+
+  uint32_t valid = 0;
+  bool     closed = true;
+  TEST_ASSERT_TRUE(LogPrealloc::parseCsvHeaderSector(sector, valid, closed));
+  TEST_ASSERT_EQUAL_UINT32(1234567u, valid);
+  TEST_ASSERT_FALSE(closed);
+
+  // 書き直しても長さが変わらない（同じセクタの上書きで済む）
+  uint8_t again[LogPrealloc::SECTOR_SIZE];
+  TEST_ASSERT_TRUE(LogPrealloc::formatCsvHeaderSector(COLUMNS, 4000000000u, true, again));
+  TEST_ASSERT_TRUE(LogPrealloc::parseCsvHeaderSector(again, valid, closed));
+  TEST_ASSERT_EQUAL_UINT32(4000000000u, valid);
+  TEST_ASSERT_TRUE(closed);
+}
+
+void test_csv_without_marker_is_rejected(void) {
+  uint8_t sector[LogPrealloc::SECTOR_SIZE];
+  memset(sector, 0, sizeof(sector));
+  const std::string legacy = std::string(COLUMNS) + "\r\n0,25.0,RUN,1,25.0,0.0,25.0,25.0,false,false\r\n";
+  memcpy(sector, legacy.data(), legacy.size());
+  uint32_t valid = 99;
+  bool     closed = false;
+  TEST_ASSERT_FALSE(LogPrealloc::parseCsvHeaderSector(sector, valid, closed));
+  TEST_ASSERT_EQUAL_UINT32(99u, valid);
+
+  // 列名が長すぎて 1 セクタに収まらない
+  const std::string tooLong(500, 'X');
+  TEST_ASSERT_FALSE(LogPrealloc::formatCsvHeaderSector(tooLong.c_str(), 0, false, sector));
+}
+
+void test_binary_header_carries_valid_bytes(void) {
+  BinLogHeader h;
+  memset(&h, 0, sizeof(h));
+  h.schemaVersion = BinaryLog::SCHEMA_VERSION;
+  h.validBytes    = 512u * 4001u;
+  h.closed        = 1;
+  uint8_t raw[BinaryLog::HEADER_SIZE];
+  BinaryLog::encodeHeader(h, raw);
+
+  BinLogHeader out;
+  TEST_ASSERT_TRUE(BinaryLog::decodeHeader(raw, out));
+  TEST_ASSERT_EQUAL_UINT32(512u * 4001u, out.validBytes);
+  TEST_ASSERT_EQUAL_UINT8(1, out.closed);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_plan_rounds_up_to_allocation_unit);
+  RUN_TEST(test_extension_triggers_inside_margin);
+  RUN_TEST(test_csv_header_sector_is_one_sector_and_round_trips);
+  RUN_TEST(test_csv_without_marker_is_rejected);
+  RUN_TEST(test_binary_header_carries_valid_bytes);
+  return UNITY_END();
+}
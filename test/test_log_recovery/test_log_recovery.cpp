@@ -0,0 +1,308 @@
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "LogPrealloc.h"
+#include "LogRecovery.h"
+
+/**
+ * @brief メモリ上のファイル（読んだバイト数を数える）
+ */
+struct MemSource {
+  std::vector<uint8_t> data;
+  size_t               bytesRead;
+
+  MemSource() : bytesRead(0) {}
+  size_t read(uint32_t offset, uint8_t* buf, size_t len) {
+    if (offset >= data.size()) return 0;
+    if (len > data.size() - offset) len = data.size() - offset;
+    memcpy(buf, &data[offset], len);
+    bytesRead += len;
+    return len;
+  }
+  void append(const std::string& s) { data.insert(data.end(), s.begin(), s.end()); }
+  void append(const uint8_t* p, size_t n) { data.insert(data.end(), p, p + n); }
+};
+
+static const char* COLUMNS =
+    "ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,HI_ALARM,LO_ALARM";
+
+static std::string csvRow(uint32_t i) {
+  char buf[128];
+  snprintf(buf, sizeof(buf), "%u,%.1f,RUN,%u,%.1f,%.1f,%.1f,%.1f,false,false\r\n",
+           i / 10, 25.0 + i * 0.1, i * 5, 25.0 + i * 0.05, 0.5, 25.0 + i * 0.1, 25.0);
+  return buf;
+}
+
+static LogCheckpoint checkpointAt(uint32_t seq) {
+  LogCheckpoint c;
+  c.seq       = seq;
+  c.elapsedMs = seq * 100;
+  c.samples   = seq * 5;
+  c.average   = 30.5f;
+  c.stdDev    = 1.25f;
+  c.maxTemp   = 40.0f;
+  c.minTemp   = 20.0f;
+  return c;
+}
+
+/**
+ * @brief 先頭セクタ + rows 行（ckptEvery 行ごとにチェックポイント）の CSV
+ */
+static void buildCsv(MemSource& f, uint32_t rows, uint32_t ckptEvery) {
+  uint8_t sector[LogPrealloc::SECTOR_SIZE];
+  LogPrealloc::formatCsvHeaderSector(COLUMNS, 0, false, sector);
+  f.append(sector, sizeof(sector));
+  for (uint32_t i = 1; i <= rows; ++i) {
+    f.append(csvRow(i));
+    if (i % ckptEvery == 0) {
+      char line[160];
+      const size_t n = LogRecovery::formatCheckpoint("CKPT", checkpointAt(i), line, sizeof(line));
+      f.append(std::string(line, n));
+    }
+  }
+}
+
+void test_checkpoint_line_round_trips_with_nan(void) {
+  LogCheckpoint c = checkpointAt(1200);
+  c.stdDev = NAN;
+  char line[160];
+  const size_t n = LogRecovery::formatCheckpoint("CKPT", c, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING(
+      "# CKPT,seq=1200,elapsed_ms=120000,samples=6000,avg=30.50,sd=NaN,max=40.00,min=20.00\r\n",
+      line);
+
+  LogCheckpoint out;
+  TEST_ASSERT_TRUE(LogRecovery::parseCheckpoint(line, n, out));
+  TEST_ASSERT_EQUAL_UINT32(1200, out.seq);
+  TEST_ASSERT_EQUAL_UINT32(6000, out.samples);
+  TEST_ASSERT_TRUE(std::isnan(out.stdDev));
+  TEST_ASSERT_EQUAL_FLOAT(40.0f, out.maxTemp);
+
+  TEST_ASSERT_FALSE(LogRecovery::parseCheckpoint(line, n - 20, out));          // 途中で切れた
+  TEST_ASSERT_FALSE(LogRecovery::parseCheckpoint("# PERF,task=IO", 14, out));  // 別のフッタ
+}
+
+void test_csv_torn_row_is_cut_at_last_complete_row(void) {
+  MemSource f;
+  buildCsv(f, 95, 20);
+  const uint32_t goodEnd = static_cast<uint32_t>(f.data.size());
+  f.append(std::string("9,34.6,RU"));   // 電源断で途切れた行
+  const uint32_t valid = static_cast<uint32_t>(f.data.size());
+
+  LogRecovery::Result r;
+  LogRecovery::scanCsv(f, LogPrealloc::SECTOR_SIZE, valid, 1u << 20, r);
+  TEST_ASSERT_EQUAL_UINT32(goodEnd, r.validEnd);
+  TEST_ASSERT_TRUE(r.haveCheckpoint);
+  TEST_ASSERT_EQUAL_UINT32(15, r.recordsAfter);      // 行 81〜95
+  TEST_ASSERT_EQUAL_UINT32(95, r.summary.seq);
+  TEST_ASSERT_EQUAL_UINT32(9000, r.summary.elapsedMs);   // 最後の行の経過秒
+  TEST_ASSERT_EQUAL_UINT32(475, r.summary.samples);
+}
+
+void test_csv_garbage_inside_valid_length_stops_scan(void) {
+  MemSource f;
+  buildCsv(f, 30, 10);
+  const uint32_t goodEnd = static_cast<uint32_t>(f.data.size());
+  f.append(std::string("\x7f\x13garbage,,\r\n31,1.0,RUN,1,1,1,1,1,false,false\r\n"));
+
+  LogRecovery::Result r;
+  LogRecovery::scanCsv(f, LogPrealloc::SECTOR_SIZE, static_cast<uint32_t>(f.data.size()),
+                       1u << 20, r);
+  TEST_ASSERT_EQUAL_UINT32(goodEnd, r.validEnd);
+  TEST_ASSERT_EQUAL_UINT32(30, r.summary.seq);
+  TEST_ASSERT_EQUAL_UINT32(0, r.recordsAfter);
+}
+
+void test_csv_scan_reads_only_the_window(void) {
+  MemSource f;
+  buildCsv(f, 40000, 300);   // 約 2MB
+  const uint32_t valid  = static_cast<uint32_t>(f.data.size());
+  const uint32_t window = 32768;
+
+  LogRecovery::Result r;
+  LogRecovery::scanCsv(f, LogPrealloc::SECTOR_SIZE, valid, window, r);
+  TEST_ASSERT_TRUE(f.bytesRead <= window);
+  TEST_ASSERT_EQUAL_UINT32(valid, r.validEnd);
+  TEST_ASSERT_TRUE(r.haveCheckpoint);
+  TEST_ASSERT_EQUAL_UINT32(40000, r.summary.seq);
+}
+
+/**
+ * @brief DELTA 形式: ckpt までに 2 ブロック、以降 1 ブロック + 有効長外の続き 1 ブロック
+ */
+void test_delta_recovers_tail_beyond_marker_and_extends_range(void) {
+  BinLogHeader h;
+  memset(&h, 0, sizeof(h));
+  h.schemaVersion = BinaryLog::SCHEMA_VERSION;
+  h.encoding      = BinaryLog::ENCODING_DELTA;
+  h.quantumMilliC = 250;
+
+  MemSource f;
+  uint8_t header[BinaryLog::HEADER_SIZE];
+  BinaryLog::encodeHeader(h, header);
+  f.append(header, sizeof(header));
+
+  // チェックポイントまでに 50 サンプル × 2 ブロック
+  DeltaBlock block;
+  block.reset(0);
+  uint32_t t = 0, samples = 0;
+  for (int b = 0; b < 2; ++b) {
+    for (int i = 0; i < 50; ++i, ++samples) {
+      block.add(t += 500, 100 + static_cast<int32_t>(samples % 7), 0);
+    }
+    f.append(block.seal(), BinaryLog::BLOCK_SIZE);
+  }
+  LogCheckpoint c = checkpointAt(samples);
+  char line[160];
+  const size_t n = LogRecovery::formatCheckpoint("CKPT", c, line, sizeof(line));
+  uint8_t text[BinaryLog::BLOCK_SIZE];
+  BinaryLog::encodeTextBlock(line, n, block.seq(), text);
+  f.append(text, sizeof(text));
+  block.reset(block.seq() + 1);
+
+  block.add(t += 500, 200, 0);   // 50.00°C（最高を更新）
+  block.add(t += 500, 40, 0);    // 10.00°C（最低を更新）
+  f.append(block.seal(), BinaryLog::BLOCK_SIZE);
+  const uint32_t valid = static_cast<uint32_t>(f.data.size());
+
+  block.add(t += 500, 120, 1);   // マーカー更新前に同期済みだったブロック
+  f.append(block.seal(), BinaryLog::BLOCK_SIZE);
+  const uint32_t goodEnd = static_cast<uint32_t>(f.data.size());
+  const uint32_t lastT = t;
+
+  // 事前確保領域の旧データ（前回の RUN の DELTA ブロック = 番号が続かない）
+  DeltaBlock stale;
+  stale.reset(900);
+  stale.add(1, 1, 0);
+  f.append(stale.seal(), BinaryLog::BLOCK_SIZE);
+  f.data.resize(f.data.size() + 8192, 0xA5);
+
+  h.validBytes = valid;
+  LogRecovery::Result r;
+  LogRecovery::scanBinary(f, h, static_cast<uint32_t>(f.data.size()), 1u << 20, 4096, r);
+  TEST_ASSERT_EQUAL_UINT32(goodEnd, r.validEnd);
+  TEST_ASSERT_EQUAL_UINT32(block.seq(), r.nextBlockSeq);
+  TEST_ASSERT_TRUE(r.haveCheckpoint);
+  TEST_ASSERT_EQUAL_UINT32(3, r.recordsAfter);
+  TEST_ASSERT_EQUAL_UINT32(samples + 3, r.summary.seq);
+  TEST_ASSERT_EQUAL_UINT32(lastT, r.summary.elapsedMs);
+  TEST_ASSERT_EQUAL_FLOAT(30.5f, r.summary.average);   // 統計はチェックポイントの値
+  TEST_ASSERT_EQUAL_FLOAT(50.0f, r.summary.maxTemp);
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, r.summary.minTemp);
+}
+
+void test_binary_records_skip_corrupt_block_and_use_last_record(void) {
+  BinLogHeader h;
+  memset(&h, 0, sizeof(h));
+  h.schemaVersion = BinaryLog::SCHEMA_VERSION;
+  h.encoding      = BinaryLog::ENCODING_RECORDS;
+
+  MemSource f;
+  uint8_t header[BinaryLog::HEADER_SIZE];
+  BinaryLog::encodeHeader(h, header);
+  f.append(header, sizeof(header));
+
+  BinLogBlock block;
+  block.reset(0);
+  BinLogRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  for (uint32_t i = 1; i <= 60; ++i) {
+    rec.elapsedMs = i * 1000UL;
+    rec.sampleCount    = i * 10;
+    rec.average        = static_cast<int16_t>(300 + i);
+    rec.maxTemp        = 500;
+    rec.minTemp        = 200;
+    if (block.add(rec)) f.append(block.seal(), BinaryLog::BLOCK_SIZE);
+  }
+  f.append(block.seal(), BinaryLog::BLOCK_SIZE);   // 10 件の途中ブロック
+  f.data[BinaryLog::HEADER_SIZE + 100] ^= 0x01;    // 最初のブロックを破損させる
+  h.validBytes = static_cast<uint32_t>(f.data.size());
+  f.data.resize(f.data.size() + 4096, 0);          // 事前確保の未使用領域
+
+  LogRecovery::Result r;
+  LogRecovery::scanBinary(f, h, static_cast<uint32_t>(f.data.size()), 1u << 20, 4096, r);
+  TEST_ASSERT_EQUAL_UINT32(h.validBytes, r.validEnd);
+  TEST_ASSERT_EQUAL_UINT32(1, r.corruptBlocks);
+  TEST_ASSERT_EQUAL_UINT32(3, r.nextBlockSeq);
+  TEST_ASSERT_EQUAL_UINT32(35, r.summary.seq);      // 破損ブロックの 25 件は数えない
+  TEST_ASSERT_EQUAL_UINT32(60000, r.summary.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(600, r.summary.samples);
+  TEST_ASSERT_EQUAL_FLOAT(36.0f, r.summary.average);
+}
+
+void test_csv_row_with_elapsed_ms_column(void) {
+  // ElapsedMs 列付き（11 列）は ms 列を優先、列が多すぎる行は不正
+  LogCheckpoint c;
+  const char* row = "12,25.0,RUN,24,24.9,0.1,25.0,24.5,false,true,12490";
+  TEST_ASSERT_TRUE(LogRecovery::parseCsvRow(row, strlen(row), c));
+  TEST_ASSERT_EQUAL_UINT32(12490, c.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(24, c.samples);
+  const char* extra = "12,25.0,RUN,24,24.9,0.1,25.0,24.5,false,true,12490,1";
+  TEST_ASSERT_FALSE(LogRecovery::parseCsvRow(extra, strlen(extra), c));
+}
+
+void test_csv_row_with_wall_time_column(void) {
+  // WallTime 列付き（12 列）。実時刻が不明なら空
+  LogCheckpoint c;
+  const char* row = "12,25.0,RUN,24,24.9,0.1,25.0,24.5,false,true,12490,2026-10-19T07:05:09.042";
+  TEST_ASSERT_TRUE(LogRecovery::parseCsvRow(row, strlen(row), c));
+  TEST_ASSERT_EQUAL_UINT32(12490, c.elapsedMs);
+  const char* unknown = "12,25.0,RUN,24,24.9,0.1,25.0,24.5,false,true,12490,";
+  TEST_ASSERT_TRUE(LogRecovery::parseCsvRow(unknown, strlen(unknown), c));
+  // 書きかけの実時刻・13 列は不正
+  const char* torn = "12,25.0,RUN,24,24.9,0.1,25.0,24.5,false,true,12490,2026-10-19T07:0";
+  TEST_ASSERT_FALSE(LogRecovery::parseCsvRow(torn, strlen(torn), c));
+  const char* extra = "12,25.0,RUN,24,24.9,0.1,25.0,24.5,false,true,12490,,1";
+  TEST_ASSERT_FALSE(LogRecovery::parseCsvRow(extra, strlen(extra), c));
+}
+
+void test_lean_csv_keeps_checkpoint_stats_and_extends_range(void) {
+  // LeanLogLayout: 累積統計の列が無いため、統計はチェックポイントから、範囲と時間は以降の行から
+  MemSource f;
+  uint8_t sector[LogPrealloc::SECTOR_SIZE];
+  LogPrealloc::formatCsvHeaderSector("ElapsedMs,Temp_C,HI_ALARM,LO_ALARM,WallTime", 0, false,
+                                     sector);
+  f.append(sector, sizeof(sector));
+  char line[160];
+  for (uint32_t i = 1; i <= 25; ++i) {
+    snprintf(line, sizeof(line), "%u,%.1f,false,false,%s\r\n", i * 500, 30.0 + i,
+             (i % 2) ? "2026-10-19T07:05:09.042" : "");
+    f.append(line);
+    if (i == 20) {
+      const size_t n = LogRecovery::formatCheckpoint("CKPT", checkpointAt(20), line, sizeof(line));
+      f.append(std::string(line, n));
+    }
+  }
+  const uint32_t goodEnd = static_cast<uint32_t>(f.data.size());
+  f.append(std::string("13000,56.0,fal"));
+
+  LogRecovery::Result r;
+  LogRecovery::scanCsv(f, LogPrealloc::SECTOR_SIZE, static_cast<uint32_t>(f.data.size()),
+                       1u << 20, r);
+  TEST_ASSERT_EQUAL_UINT32(goodEnd, r.validEnd);
+  TEST_ASSERT_TRUE(r.haveCheckpoint);
+  TEST_ASSERT_EQUAL_UINT32(5, r.recordsAfter);
+  TEST_ASSERT_EQUAL_UINT32(25, r.summary.seq);
+  TEST_ASSERT_EQUAL_UINT32(12500, r.summary.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(100, r.summary.samples);     // チェックポイントの値
+  TEST_ASSERT_EQUAL_FLOAT(30.5f, r.summary.average);
+  TEST_ASSERT_EQUAL_FLOAT(55.0f, r.summary.maxTemp);    // 以降の行で伸ばす
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, r.summary.minTemp);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_checkpoint_line_round_trips_with_nan);
+  RUN_TEST(test_csv_torn_row_is_cut_at_last_complete_row);
+  RUN_TEST(test_csv_garbage_inside_valid_length_stops_scan);
+  RUN_TEST(test_csv_scan_reads_only_the_window);
+  RUN_TEST(test_delta_recovers_tail_beyond_marker_and_extends_range);
+  RUN_TEST(test_binary_records_skip_corrupt_block_and_use_last_record);
+  RUN_TEST(test_csv_row_with_elapsed_ms_column);
+  RUN_TEST(test_csv_row_with_wall_time_column);
+  RUN_TEST(test_lean_csv_keeps_checkpoint_stats_and_extends_range);
+  return UNITY_END();
+}
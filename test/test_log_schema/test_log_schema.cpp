@@ -0,0 +1,113 @@
+#include <unity.h>
+#include <cmath>
+#include <cstring>
+#include "LogSchema.h"
+#include "LogRecovery.h"
+
+/**
+ * @brief SDData と同じメンバー名の行（Global.h はハードウェア依存のため）
+ */
+struct Row {
+  uint32_t    elapsedSeconds;
+  uint32_t    elapsedMs;
+  float       temperature;
+  const char* state;
+  uint64_t    sampleCount;
+  float       averageTemp;
+  float       stdDev;
+  float       maxTemp;
+  float       minTemp;
+  bool        hiAlarm;
+  bool        loAlarm;
+  int64_t     wallMs;
+};
+
+static Row sampleRow(void) {
+  Row r = {12, 12490, 540.25f, "RUN", 24, 539.94f, 0.31f, 541.0f, NAN, true, false,
+           WallClock::toEpochSec(CivilTime{2026, 10, 19, 7, 5, 9}) * 1000 + 42};
+  return r;
+}
+
+void test_full_layout_matches_the_fixed_row_format(void) {
+  char buf[FullLogLayout::MAX_ROW];
+  Row r = sampleRow();
+  size_t n = FullLogLayout::formatRow(r, buf);
+  TEST_ASSERT_EQUAL_STRING("12,540.2,RUN,24,539.9,0.3,541.0,0.0,true,false,12490,"
+                           "2026-10-19T07:05:09.042\r\n", buf);
+  TEST_ASSERT_EQUAL((int)strlen(buf), (int)n);
+
+  // 温度が NaN なら統計列もすべて NaN、実時刻が不明なら WallTime は空
+  r.temperature = NAN;
+  r.wallMs      = -1;
+  FullLogLayout::formatRow(r, buf);
+  TEST_ASSERT_EQUAL_STRING("12,NaN,RUN,24,NaN,NaN,NaN,NaN,true,false,12490,\r\n", buf);
+}
+
+void test_lean_layout_has_only_raw_columns(void) {
+  char buf[LeanLogLayout::MAX_ROW];
+  Row r = sampleRow();
+  LeanLogLayout::formatRow(r, buf);
+  TEST_ASSERT_EQUAL_STRING("12490,540.2,true,false,2026-10-19T07:05:09.042\r\n", buf);
+  TEST_ASSERT_EQUAL(5, (int)LeanLogLayout::COUNT);
+  TEST_ASSERT_TRUE(LeanLogLayout::MAX_ROW < FullLogLayout::MAX_ROW);
+}
+
+void test_columns_are_generated_from_the_layout(void) {
+  char cols[160];
+  FullLogLayout::formatColumns(cols, sizeof(cols));
+  TEST_ASSERT_EQUAL_STRING("ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,"
+                           "HI_ALARM,LO_ALARM,ElapsedMs,WallTime", cols);
+  // BINARY のヘッダはレコードに無い列（WallTime）を除く
+  FullLogLayout::formatColumns(cols, sizeof(cols), true);
+  TEST_ASSERT_EQUAL_STRING("ElapsedSec,Temp_C,State,Samples,Average_C,StdDev_C,Max_C,Min_C,"
+                           "HI_ALARM,LO_ALARM,ElapsedMs", cols);
+  LeanLogLayout::formatColumns(cols, sizeof(cols), true);
+  TEST_ASSERT_EQUAL_STRING("ElapsedMs,Temp_C,HI_ALARM,LO_ALARM", cols);
+
+  // 収まらなければ 0
+  char small[16];
+  TEST_ASSERT_EQUAL(0, (int)LeanLogLayout::formatColumns(small, sizeof(small)));
+}
+
+void test_parse_columns_reads_the_schema_back(void) {
+  LogColumn list[LogSchema::MAX_COLUMNS];
+  TEST_ASSERT_EQUAL(5, (int)LogSchema::parseColumns("ElapsedMs,Temp_C,HI_ALARM,LO_ALARM,WallTime\r\n",
+                                                    list, LogSchema::MAX_COLUMNS));
+  TEST_ASSERT_TRUE(list[0] == LogColumn::ELAPSED_MS);
+  TEST_ASSERT_TRUE(list[1] == LogColumn::TEMP);
+  TEST_ASSERT_TRUE(list[4] == LogColumn::WALL_TIME);
+  // 知らない列名・上限を超える列数は 0
+  TEST_ASSERT_EQUAL(0, (int)LogSchema::parseColumns("ElapsedMs,Pressure", list,
+                                                    LogSchema::MAX_COLUMNS));
+  TEST_ASSERT_EQUAL(0, (int)LogSchema::parseColumns("ElapsedMs,Temp_C", list, 1));
+}
+
+void test_both_layouts_are_recoverable(void) {
+  // 起動時の復旧・索引（LogRecovery::parseCsvRow）がどちらの構成の行も読めること
+  char buf[FullLogLayout::MAX_ROW];
+  Row r = sampleRow();
+  LogCheckpoint c;
+  bool cumulative = false;
+
+  size_t n = FullLogLayout::formatRow(r, buf);
+  TEST_ASSERT_TRUE(LogRecovery::parseCsvRow(buf, n - 2, c, &cumulative));
+  TEST_ASSERT_TRUE(cumulative);
+  TEST_ASSERT_EQUAL_UINT32(12490, c.elapsedMs);
+  TEST_ASSERT_EQUAL_UINT32(24, c.samples);
+
+  n = LeanLogLayout::formatRow(r, buf);
+  TEST_ASSERT_TRUE(LogRecovery::parseCsvRow(buf, n - 2, c, &cumulative));
+  TEST_ASSERT_FALSE(cumulative);
+  TEST_ASSERT_EQUAL_UINT32(12490, c.elapsedMs);
+  TEST_ASSERT_EQUAL_FLOAT(540.2f, c.maxTemp);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_layout_matches_the_fixed_row_format);
+  RUN_TEST(test_lean_layout_has_only_raw_columns);
+  RUN_TEST(test_columns_are_generated_from_the_layout);
+  RUN_TEST(test_parse_columns_reads_the_schema_back);
+  RUN_TEST(test_both_layouts_are_recoverable);
+  return UNITY_END();
+}
@@ -0,0 +1,71 @@
+#include <unity.h>
+#include "OutageBacklog.h"
+
+void test_drop_oldest_keeps_latest_in_order(void) {
+  OutageBacklog<uint32_t, 4> b(BacklogPolicy::DROP_OLDEST);
+  for (uint32_t i = 0; i < 4; ++i) TEST_ASSERT_TRUE(b.push(i));
+  TEST_ASSERT_FALSE(b.push(4));   // 0 を捨てる
+  TEST_ASSERT_FALSE(b.push(5));   // 1 を捨てる
+  TEST_ASSERT_EQUAL(4, b.size());
+  TEST_ASSERT_EQUAL(2, b.dropped());
+  TEST_ASSERT_EQUAL(6, b.offered());
+  TEST_ASSERT_EQUAL(1, b.stride());
+
+  for (uint32_t i = 2; i < 6; ++i) {
+    TEST_ASSERT_FALSE(b.empty());
+    TEST_ASSERT_EQUAL(i, b.front());
+    b.pop();
+  }
+  TEST_ASSERT_TRUE(b.empty());
+}
+
+void test_decimate_doubles_stride_with_uniform_spacing(void) {
+  OutageBacklog<uint32_t, 8> b(BacklogPolicy::DECIMATE);
+  for (uint32_t i = 0; i < 8; ++i) TEST_ASSERT_TRUE(b.push(i));
+  TEST_ASSERT_EQUAL(1, b.stride());
+
+  // 満杯で 1 つおきに間引き、以降は 2 個に 1 個だけ受け付ける
+  TEST_ASSERT_TRUE(b.push(8));
+  TEST_ASSERT_EQUAL(2, b.stride());
+  TEST_ASSERT_EQUAL(5, b.size());
+  TEST_ASSERT_FALSE(b.push(9));
+
+  for (uint32_t i = 10; i <= 16; ++i) b.push(i);
+  TEST_ASSERT_EQUAL(4, b.stride());
+  TEST_ASSERT_EQUAL(17, b.offered());
+  TEST_ASSERT_EQUAL(17 - 5, b.dropped());
+  TEST_ASSERT_EQUAL(5, b.size());
+
+  // 残るのは 0, 4, 8, 12, 16（切断期間全体を等間隔で）
+  for (uint32_t expect = 0; expect <= 16; expect += 4) {
+    TEST_ASSERT_EQUAL(expect, b.front());
+    b.pop();
+  }
+  TEST_ASSERT_TRUE(b.empty());
+}
+
+void test_partial_replay_then_clear(void) {
+  OutageBacklog<uint32_t, 4> b(BacklogPolicy::DECIMATE);
+  b.push(10);
+  b.push(11);
+  b.pop();                        // 1 件だけ書き戻せた
+  TEST_ASSERT_EQUAL(11, b.front());
+  b.push(12);
+  TEST_ASSERT_EQUAL(2, b.size());
+
+  b.clear();
+  TEST_ASSERT_TRUE(b.empty());
+  TEST_ASSERT_EQUAL(0, b.offered());
+  TEST_ASSERT_EQUAL(0, b.dropped());
+  TEST_ASSERT_EQUAL(1, b.stride());
+  b.pop();                        // 空でも安全
+  TEST_ASSERT_TRUE(b.empty());
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_drop_oldest_keeps_latest_in_order);
+  RUN_TEST(test_decimate_doubles_stride_with_uniform_spacing);
+  RUN_TEST(test_partial_replay_then_clear);
+  return UNITY_END();
+}
@@ -0,0 +1,107 @@
+#include <unity.h>
+#include "PowerGovernor.h"
+
+static const uint32_t HOLD   = 3000;
+static const uint32_t MIN_MS = 10;
+static const uint32_t MAX_MS = 1000;
+static const uint32_t MARGIN = 2;
+
+static PowerInputs idleInputs(uint32_t now, uint32_t deadline) {
+  PowerInputs in;
+  in.state          = PowerGovernor::STATE_IDLE;
+  in.nowMs          = now;
+  in.nextDeadlineMs = deadline;
+  in.lastActivityMs = 0;
+  in.controlIdle    = true;
+  in.backlightOn    = false;
+  return in;
+}
+
+static PowerDecision decide(const PowerInputs& in) {
+  return PowerGovernor::decide(in, HOLD, MIN_MS, MAX_MS, MARGIN);
+}
+
+void test_run_and_setting_stay_at_full_speed(void) {
+  PowerInputs in = idleInputs(10000, 10400);
+  in.state = PowerGovernor::STATE_RUN;
+  PowerDecision d = decide(in);
+  TEST_ASSERT_EQUAL(240, d.cpuMhz);
+  TEST_ASSERT_EQUAL(0, d.sleepMs);
+
+  in.state = PowerGovernor::STATE_ALARM_SETTING;
+  d = decide(in);
+  TEST_ASSERT_EQUAL(240, d.cpuMhz);
+  TEST_ASSERT_EQUAL(0, d.sleepMs);
+}
+
+void test_idle_sleeps_until_deadline_minus_margin(void) {
+  PowerDecision d = decide(idleInputs(10000, 10048));
+  TEST_ASSERT_EQUAL(80, d.cpuMhz);
+  TEST_ASSERT_EQUAL(46, d.sleepMs);
+
+  PowerInputs in = idleInputs(10000, 10190);
+  in.state = PowerGovernor::STATE_RESULT;
+  d = decide(in);
+  TEST_ASSERT_EQUAL(188, d.sleepMs);
+}
+
+void test_recent_activity_keeps_full_speed(void) {
+  PowerInputs in = idleInputs(10000, 10200);
+  in.lastActivityMs = 7500;  // 2.5 秒前
+  PowerDecision d = decide(in);
+  TEST_ASSERT_EQUAL(240, d.cpuMhz);
+  TEST_ASSERT_EQUAL(0, d.sleepMs);
+
+  in.lastActivityMs = 7000;  // ちょうど 3 秒経過
+  d = decide(in);
+  TEST_ASSERT_EQUAL(80, d.cpuMhz);
+  TEST_ASSERT_EQUAL(198, d.sleepMs);
+}
+
+void test_no_sleep_when_control_busy_or_gap_too_short(void) {
+  PowerInputs in = idleInputs(10000, 10200);
+  in.controlIdle = false;
+  PowerDecision d = decide(in);
+  TEST_ASSERT_EQUAL(80, d.cpuMhz);   // クロックだけ下げる
+  TEST_ASSERT_EQUAL(0, d.sleepMs);
+
+  d = decide(idleInputs(10000, 10011));  // 残り 11ms - 余裕 2ms < 10ms
+  TEST_ASSERT_EQUAL(0, d.sleepMs);
+
+  d = decide(idleInputs(10000, 9990));   // 締め切り超過
+  TEST_ASSERT_EQUAL(0, d.sleepMs);
+}
+
+void test_no_sleep_while_backlight_on(void) {
+  PowerInputs in = idleInputs(10000, 10200);
+  in.backlightOn = true;
+  PowerDecision d = decide(in);
+  TEST_ASSERT_EQUAL(80, d.cpuMhz);   // クロックだけ下げる
+  TEST_ASSERT_EQUAL(0, d.sleepMs);
+}
+
+void test_sleep_is_capped(void) {
+  PowerDecision d = decide(idleInputs(10000, 15000));
+  TEST_ASSERT_EQUAL(MAX_MS, d.sleepMs);
+}
+
+void test_millis_wraparound(void) {
+  const uint32_t now = 0xFFFFFFF0UL;
+  PowerDecision d = decide(idleInputs(now, now + 100));  // 締め切りは巻き戻り後
+  TEST_ASSERT_EQUAL(98, d.sleepMs);
+
+  TEST_ASSERT_EQUAL(now + 20, PowerGovernor::earlier(now + 200, now + 20, now));
+  TEST_ASSERT_EQUAL(now - 5, PowerGovernor::earlier(now + 50, now - 5, now));  // 超過側が先
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_run_and_setting_stay_at_full_speed);
+  RUN_TEST(test_idle_sleeps_until_deadline_minus_margin);
+  RUN_TEST(test_recent_activity_keeps_full_speed);
+  RUN_TEST(test_no_sleep_when_control_busy_or_gap_too_short);
+  RUN_TEST(test_no_sleep_while_backlight_on);
+  RUN_TEST(test_sleep_is_capped);
+  RUN_TEST(test_millis_wraparound);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <cmath>
+#include <cstring>
+#include "PreTrigger.h"
+
+static PreTriggerSample sampleAt(uint32_t t, float raw, float filtered, uint8_t flags) {
+  PreTriggerSample s = {t, raw, filtered, flags};
+  return s;
+}
+
+void test_ring_overwrites_oldest_when_full(void) {
+  PreTriggerRing<8> ring;
+  TEST_ASSERT_EQUAL(0, (int)ring.size());
+  for (uint32_t i = 0; i < 5; ++i) ring.add(sampleAt(i * 500, 0.0f, 0.0f, 0));
+  TEST_ASSERT_EQUAL(5, (int)ring.size());
+  TEST_ASSERT_EQUAL(0, (int)ring.at(0).timeMs);
+
+  // 満杯後は容量のまま、最も古いものから入れ替わる
+  for (uint32_t i = 5; i < 21; ++i) ring.add(sampleAt(i * 500, 0.0f, 0.0f, 0));
+  TEST_ASSERT_EQUAL(8, (int)ring.size());
+  for (size_t i = 0; i < ring.size(); ++i) {
+    TEST_ASSERT_EQUAL((int)((13 + i) * 500), (int)ring.at(i).timeMs);
+  }
+
+  ring.clear();
+  TEST_ASSERT_EQUAL(0, (int)ring.size());
+}
+
+void test_snapshot_keeps_only_the_window(void) {
+  PreTriggerRing<16> ring;
+  // 500ms 周期で 10 秒分（最後の 8 秒だけ残る）
+  for (uint32_t t = 500; t <= 10000; t += 500) ring.add(sampleAt(t, 500.0f + t / 1000.0f, 500.0f, 0));
+
+  PreTriggerSnapshot<16> snap;
+  ring.snapshot(PreTrigger::HI_SET, 10000, 3000, snap);
+  TEST_ASSERT_EQUAL(PreTrigger::HI_SET, snap.event);
+  TEST_ASSERT_EQUAL(10000, (int)snap.triggerMs);
+  TEST_ASSERT_EQUAL(7, (int)snap.count);                   // 7000, 7500, ... 10000
+  TEST_ASSERT_EQUAL(7000, (int)snap.samples[0].timeMs);
+  TEST_ASSERT_EQUAL(10000, (int)snap.samples[6].timeMs);
+
+  // 窓が保持分より長ければ全件（トリガより後の値も含める）
+  ring.snapshot(PreTrigger::RUN_START, 9800, 60000, snap);
+  TEST_ASSERT_EQUAL(16, (int)snap.count);
+  TEST_ASSERT_EQUAL(2500, (int)snap.samples[0].timeMs);
+
+  // millis() の桁あふれをまたいでも窓で切れる
+  PreTriggerRing<4> wrap;
+  wrap.add(sampleAt(0xFFFFF000UL, 1.0f, 1.0f, 0));
+  wrap.add(sampleAt(0xFFFFFC00UL, 2.0f, 2.0f, 0));
+  wrap.add(sampleAt(0x00000200UL, 3.0f, 3.0f, 0));
+  PreTriggerSnapshot<4> w;
+  wrap.snapshot(PreTrigger::LO_SET, 0x00000200UL, 2000, w);
+  TEST_ASSERT_EQUAL(2, (int)w.count);
+  TEST_ASSERT_EQUAL(0xFFFFFC00UL, w.samples[0].timeMs);
+}
+
+void test_format_row_uses_signed_offset(void) {
+  char buf[PreTrigger::MAX_ROW];
+  size_t n = PreTrigger::formatRow(sampleAt(8500, 540.25f, 539.875f, BinaryLog::FLAG_HI_ALARM),
+                                   10000, "# PRE,", buf);
+  TEST_ASSERT_EQUAL_STRING("# PRE,-1500,540.25,539.88,true,false\r\n", buf);
+  TEST_ASSERT_EQUAL((int)strlen(buf), (int)n);
+
+  PreTrigger::formatRow(sampleAt(10500, NAN, 539.5f, BinaryLog::FLAG_LO_ALARM), 10000, "", buf);
+  TEST_ASSERT_EQUAL_STRING("500,NaN,539.50,false,true\r\n", buf);
+
+  // 最長の行も MAX_ROW に収まる
+  n = PreTrigger::formatRow(sampleAt(0, -9999.99f, -9999.99f, 3), 0x7FFFFFFFUL, "# PRE,", buf);
+  TEST_ASSERT_TRUE(n < PreTrigger::MAX_ROW);
+}
+
+void test_format_rows_stops_before_overflow(void) {
+  PreTriggerRing<8> ring;
+  for (uint32_t t = 0; t < 8; ++t) ring.add(sampleAt(t * 500, 1.0f, 1.0f, 0));
+  PreTriggerSnapshot<8> snap;
+  ring.snapshot(PreTrigger::RUN_START, 3500, 10000, snap);
+
+  char big[8 * PreTrigger::MAX_ROW];
+  const size_t all = snap.formatRows("", big, sizeof(big));
+  TEST_ASSERT_EQUAL(0, strncmp(big, "-3500,1.00,1.00,false,false\r\n", 29));
+
+  char small[2 * PreTrigger::MAX_ROW + 10];
+  const size_t part = snap.formatRows("", small, sizeof(small));
+  TEST_ASSERT_TRUE(part < all);
+  TEST_ASSERT_TRUE(part <= sizeof(small));
+  TEST_ASSERT_EQUAL(0, strncmp(small, big, part));
+}
+
+void test_events_for_alarm_transitions(void) {
+  PreTrigger::Event ev[2];
+  TEST_ASSERT_EQUAL(0, (int)PreTrigger::eventsFor(0, 0, ev));
+
+  TEST_ASSERT_EQUAL(1, (int)PreTrigger::eventsFor(0, BinaryLog::FLAG_HI_ALARM, ev));
+  TEST_ASSERT_EQUAL(PreTrigger::HI_SET, ev[0]);
+
+  TEST_ASSERT_EQUAL(1, (int)PreTrigger::eventsFor(BinaryLog::FLAG_LO_ALARM, 0, ev));
+  TEST_ASSERT_EQUAL(PreTrigger::LO_CLEAR, ev[0]);
+
+  // HI 解除と LO 発生が同じ周期なら HI → LO の順
+  TEST_ASSERT_EQUAL(2, (int)PreTrigger::eventsFor(BinaryLog::FLAG_HI_ALARM,
+                                                  BinaryLog::FLAG_LO_ALARM, ev));
+  TEST_ASSERT_EQUAL(PreTrigger::HI_CLEAR, ev[0]);
+  TEST_ASSERT_EQUAL(PreTrigger::LO_SET, ev[1]);
+  TEST_ASSERT_EQUAL_STRING("LO_SET", PreTrigger::eventName(ev[1]));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_ring_overwrites_oldest_when_full);
+  RUN_TEST(test_snapshot_keeps_only_the_window);
+  RUN_TEST(test_format_row_uses_signed_offset);
+  RUN_TEST(test_format_rows_stops_before_overflow);
+  RUN_TEST(test_events_for_alarm_transitions);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <unity.h>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#define PROFILE_ZONES_ENABLED 1
+#define PROFILE_RING_SIZE 8
+#include "ProfileZone.h"
+
+static void collect(const char* line, void* ctx) {
+  static_cast<std::string*>(ctx)->append(line);
+}
+
+static int countLines(const std::string& s, const char* prefix) {
+  int n = 0;
+  size_t pos = 0;
+  const size_t len = strlen(prefix);
+  while (pos < s.size()) {
+    if (s.compare(pos, len, prefix) == 0) ++n;
+    const size_t nl = s.find('\n', pos);
+    if (nl == std::string::npos) break;
+    pos = nl + 1;
+  }
+  return n;
+}
+
+void setUp(void) { ProfileRecorder::clear(); }
+void tearDown(void) {}
+
+void test_zone_records_on_scope_exit(void) {
+  {
+    PROFILE_ZONE("outer");
+    {
+      PROFILE_ZONE("inner");
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    TEST_ASSERT_EQUAL(1, ProfileRecorder::recorded(0));  // inner のみ終了
+  }
+  TEST_ASSERT_EQUAL(2, ProfileRecorder::recorded(0));
+
+  std::string out;
+  ProfileRecorder::dump(collect, &out);
+  TEST_ASSERT_EQUAL(2, countLines(out, "Z,"));
+  // ゾーン終了順（inner → outer）で並ぶ
+  TEST_ASSERT_TRUE(out.find(",inner\n") < out.find(",outer\n"));
+  TEST_ASSERT_TRUE(out.find("# PROFILE clock_hz=1000000") == 0);
+}
+
+void test_duration_uses_clock(void) {
+  ProfileRecorder::record("fixed", 1000, 1250);
+  std::string out;
+  ProfileRecorder::dump(collect, &out);
+  TEST_ASSERT_TRUE(out.find("Z,0,1000,250,fixed\n") != std::string::npos);
+}
+
+void test_duration_across_counter_wrap(void) {
+  ProfileRecorder::record("wrap", 0xFFFFFF00UL, 0x00000010UL);
+  std::string out;
+  ProfileRecorder::dump(collect, &out);
+  TEST_ASSERT_TRUE(out.find(",272,wrap\n") != std::string::npos);  // 0x110
+}
+
+void test_ring_keeps_newest_events(void) {
+  static const char* names[] = {"e0", "e1", "e2", "e3", "e4", "e5",
+                                "e6", "e7", "e8", "e9", "e10", "e11"};
+  for (uint32_t i = 0; i < 12; ++i) ProfileRecorder::record(names[i], i, i + 1);
+  std::string out;
+  ProfileRecorder::dump(collect, &out);
+  TEST_ASSERT_EQUAL(8, countLines(out, "Z,"));
+  TEST_ASSERT_TRUE(out.find(",e3\n") == std::string::npos);  // 上書き済み
+  TEST_ASSERT_TRUE(out.find(",e4\n") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find(",e11\n") != std::string::npos);
+  TEST_ASSERT_TRUE(out.find("events=8 dropped=0") != std::string::npos);
+}
+
+void test_two_tasks_on_one_core_do_not_share_a_slot(void) {
+  // 制御タスクと SDWriter タスクが同じコアで記録する状況を 2 スレッドで再現
+  // （native では currentCore() が常に 0）
+  const uint32_t perTask = 20000;
+  std::thread a([&]() {
+    for (uint32_t i = 0; i < perTask; ++i) ProfileRecorder::record("a", i, i + 7);
+  });
+  std::thread b([&]() {
+    for (uint32_t i = 0; i < perTask; ++i) ProfileRecorder::record("b", i, i + 11);
+  });
+  a.join();
+  b.join();
+  TEST_ASSERT_EQUAL(2 * perTask, ProfileRecorder::recorded(0));
+
+  std::string out;
+  ProfileRecorder::dump(collect, &out);
+  // 一周して同じ枠に重なったイベントは捨てる（dropped）ため 8 件以下
+  TEST_ASSERT_TRUE(countLines(out, "Z,") >= 1 && countLines(out, "Z,") <= 8);
+  // 名前と長さの組が混ざった（別々のタスクが同じ枠を書いた）イベントが無い
+  size_t pos = 0;
+  while ((pos = out.find("Z,", pos)) != std::string::npos) {
+    const size_t nl   = out.find('\n', pos);
+    const std::string ev = out.substr(pos, nl - pos);
+    TEST_ASSERT_TRUE((ev.find(",7,a") != std::string::npos) ||
+                     (ev.find(",11,b") != std::string::npos));
+    pos = nl;
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_zone_records_on_scope_exit);
+  RUN_TEST(test_duration_uses_clock);
+  RUN_TEST(test_duration_across_counter_wrap);
+  RUN_TEST(test_ring_keeps_newest_events);
+  RUN_TEST(test_two_tasks_on_one_core_do_not_share_a_slot);
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+#include <unity.h>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "RawCapture.h"
+
+/**
+ * @brief 最大変換レートの生データ: 100ms 周期 ± IO 周期、0.25°C 量子化のノイズ、時々断線
+ */
+static std::vector<RawSample> noisySeries(size_t n) {
+  std::vector<RawSample> s;
+  srand(7);
+  uint32_t t    = 0;
+  double   temp = 540.0;
+  for (size_t i = 0; i < n; ++i) {
+    t    += 100 + (rand() % 2) * 10;            // 100 / 110ms
+    temp += (rand() % 100 - 50) * 0.01;         // ±0.5°C の揺らぎ
+    const bool    broken = (rand() % 500 == 0);
+    const uint8_t errors = broken ? 0x01 : 0;
+    s.push_back(RawCapture::sample(t, broken ? NAN : static_cast<float>(temp), errors));
+  }
+  return s;
+}
+
+void test_sample_quantizes_losslessly_and_maps_faults(void) {
+  RawSample s = RawCapture::sample(1234, 540.25f, 0);
+  TEST_ASSERT_EQUAL(1234, (int)s.timeMs);
+  TEST_ASSERT_EQUAL(2161, (int)s.q);                 // 540.25 / 0.25
+  TEST_ASSERT_EQUAL(RawCapture::FAULT_NONE, s.fault);
+
+  s = RawCapture::sample(10, -0.75f, 0);
+  TEST_ASSERT_EQUAL(-3, (int)s.q);
+
+  s = RawCapture::sample(20, NAN, 0x04);
+  TEST_ASSERT_TRUE(s.q == INT32_MIN);
+  TEST_ASSERT_EQUAL(RawCapture::FAULT_SHORT_VCC, s.fault);
+
+  // 断線を優先
+  TEST_ASSERT_EQUAL(RawCapture::FAULT_OPEN, RawCapture::faultFromError(0x07));
+  TEST_ASSERT_EQUAL(RawCapture::FAULT_SHORT_GND, RawCapture::faultFromError(0x06));
+  TEST_ASSERT_EQUAL(RawCapture::FAULT_NONE, RawCapture::faultFromError(0));
+}
+
+void test_format_row(void) {
+  char buf[64];
+  size_t n = RawCapture::formatRow(12345, 2161, RawCapture::FAULT_NONE,
+                                   RawCapture::QUANTUM_MILLIC, buf);
+  TEST_ASSERT_EQUAL_STRING("12345,540.25,\r\n", buf);
+  TEST_ASSERT_EQUAL((int)strlen(buf), (int)n);
+
+  RawCapture::formatRow(12445, INT32_MIN, RawCapture::FAULT_OPEN, RawCapture::QUANTUM_MILLIC, buf);
+  TEST_ASSERT_EQUAL_STRING("12445,NaN,OC\r\n", buf);
+
+  RawCapture::formatRow(0, -3, RawCapture::FAULT_NONE, RawCapture::QUANTUM_MILLIC, buf);
+  TEST_ASSERT_EQUAL_STRING("0,-0.75,\r\n", buf);
+}
+
+void test_blocks_round_trip_with_fault_codes(void) {
+  const std::vector<RawSample> in = noisySeries(20000);
+  DeltaBlock block;
+  block.reset(0);
+  std::vector<std::vector<uint8_t> > sealed;
+  for (size_t i = 0; i < in.size(); ++i) {
+    if (!block.add(in[i].timeMs, in[i].q, in[i].fault)) {
+      const uint8_t* b = block.seal();
+      sealed.push_back(std::vector<uint8_t>(b, b + BinaryLog::BLOCK_SIZE));
+      TEST_ASSERT_TRUE(block.add(in[i].timeMs, in[i].q, in[i].fault));
+    }
+  }
+  const uint8_t* last = block.seal();
+  sealed.push_back(std::vector<uint8_t>(last, last + BinaryLog::BLOCK_SIZE));
+
+  size_t k      = 0;
+  size_t faults = 0;
+  for (size_t b = 0; b < sealed.size(); ++b) {
+    uint8_t  type  = 0;
+    uint16_t count = 0;
+    uint32_t seq   = 0;
+    TEST_ASSERT_TRUE(BinaryLog::checkBlock(&sealed[b][0], type, count, seq) ==
+                     BinaryLog::BlockStatus::OK);
+    DeltaDecoder dec;
+    dec.reset(&sealed[b][BinaryLog::BLOCK_HEADER_SIZE], BinaryLog::PAYLOAD_SIZE, count);
+    uint32_t t = 0;
+    int32_t  v = 0;
+    uint8_t  f = 0;
+    while (dec.next(t, v, f)) {
+      TEST_ASSERT_TRUE(k < in.size());
+      TEST_ASSERT_EQUAL((int)in[k].timeMs, (int)t);
+      TEST_ASSERT_TRUE(in[k].q == v);
+      TEST_ASSERT_EQUAL(in[k].fault, f);
+      if (f != RawCapture::FAULT_NONE) ++faults;
+      ++k;
+    }
+  }
+  TEST_ASSERT_EQUAL((int)in.size(), (int)k);
+  TEST_ASSERT_TRUE(faults > 0);
+}
+
+void test_stream_stays_within_bandwidth_budget(void) {
+  // 1 時間分を最大変換レートで符号化し、実際の書き込み量が見積り上限を超えないこと
+  const std::vector<RawSample> in = noisySeries(36000);
+  DeltaBlock block;
+  block.reset(0);
+  size_t blocks = 1;
+  for (size_t i = 0; i < in.size(); ++i) {
+    if (!block.add(in[i].timeMs, in[i].q, in[i].fault)) {
+      block.seal();
+      ++blocks;
+      block.add(in[i].timeMs, in[i].q, in[i].fault);
+    }
+  }
+  const uint32_t seconds     = in.back().timeMs / 1000;
+  const uint32_t blockBytesS = static_cast<uint32_t>(blocks * BinaryLog::BLOCK_SIZE / seconds);
+  const uint32_t worstBlockS = RawCapture::worstBytesPerSec(100, 1000000000UL);  // 書き直し分を除く
+  TEST_ASSERT_TRUE(blockBytesS <= worstBlockS);
+  TEST_ASSERT_TRUE(blockBytesS * 2 < worstBlockS);    // 実際の系列は最長符号よりずっと短い
+
+  // 最短の同期間隔（1 秒）でも途中ブロックの書き直しを含めて 1KB/s 以内
+  TEST_ASSERT_TRUE(RawCapture::worstBytesPerSec(100, 1000) <= 1024);
+  TEST_ASSERT_TRUE(RawCapture::MIN_SAMPLES_PER_BLOCK >= 50);
+}
+
+void test_header_accepts_raw_encoding(void) {
+  BinLogHeader h;
+  memset(&h, 0, sizeof(h));
+  h.schemaVersion  = BinaryLog::SCHEMA_VERSION;
+  h.samplePeriodMs = 100;
+  strncpy(h.columns, RawCapture::COLUMNS, sizeof(h.columns) - 1);
+  h.encoding       = BinaryLog::ENCODING_RAW;
+  h.quantumMilliC  = RawCapture::QUANTUM_MILLIC;
+  h.validBytes     = BinaryLog::HEADER_SIZE;
+  uint8_t buf[BinaryLog::HEADER_SIZE];
+  BinaryLog::encodeHeader(h, buf);
+
+  BinLogHeader out;
+  TEST_ASSERT_TRUE(BinaryLog::decodeHeader(buf, out));
+  TEST_ASSERT_EQUAL(BinaryLog::ENCODING_RAW, out.encoding);
+  TEST_ASSERT_EQUAL(250, out.quantumMilliC);
+  TEST_ASSERT_EQUAL_STRING("ElapsedMs,Raw_C,Fault", out.columns);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sample_quantizes_losslessly_and_maps_faults);
+  RUN_TEST(test_format_row);
+  RUN_TEST(test_blocks_round_trip_with_fault_codes);
+  RUN_TEST(test_stream_stays_within_bandwidth_budget);
+  RUN_TEST(test_header_accepts_raw_encoding);
+  return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include <unity.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "Rollup.h"
+
+/**
+ * @brief 出力された行を段ごとに保持
+ */
+struct Collect {
+  std::vector<RollupRow> rows[RollupCascade::LEVELS];
+  void operator()(const RollupRow& r) { rows[r.level].push_back(r); }
+};
+
+void test_one_second_rows_from_500ms_samples(void) {
+  RollupCascade c;
+  Collect out;
+  c.add(0, 20.0f, out);
+  c.add(500, 22.0f, out);
+  TEST_ASSERT_EQUAL(0, (int)out.rows[0].size());
+  c.add(1000, 30.0f, out);   // 区間 [0, 1000) が閉じる
+  TEST_ASSERT_EQUAL(1, (int)out.rows[0].size());
+  const RollupRow& r = out.rows[0][0];
+  TEST_ASSERT_EQUAL_UINT32(0, r.startMs);
+  TEST_ASSERT_EQUAL_UINT32(2, r.count);
+  TEST_ASSERT_EQUAL_FLOAT(21.0f, r.mean);
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, r.minV);
+  TEST_ASSERT_EQUAL_FLOAT(22.0f, r.maxV);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, r.stdDev);
+}
+
+void test_cascade_matches_direct_statistics(void) {
+  // 2 時間分を加え、1 時間の行が全サンプルの直接計算と一致するか
+  RollupCascade c;
+  Collect out;
+  RollupStats direct[2];
+  direct[0].clear();
+  direct[1].clear();
+  for (uint32_t t = 0; t < 7200000UL; t += 500) {
+    const float v = 100.0f + 50.0f * static_cast<float>(std::sin(t / 600000.0)) +
+                    0.25f * static_cast<float>((t / 500) % 3);
+    c.add(t, v, out);
+    direct[t / 3600000UL].add(v);
+  }
+  c.finish(out);
+  TEST_ASSERT_EQUAL(7200, (int)out.rows[0].size());
+  TEST_ASSERT_EQUAL(120, (int)out.rows[1].size());
+  TEST_ASSERT_EQUAL(2, (int)out.rows[2].size());
+  for (int h = 0; h < 2; ++h) {
+    const RollupRow& r = out.rows[2][h];
+    TEST_ASSERT_EQUAL_UINT32(h * 3600000UL, r.startMs);
+    TEST_ASSERT_EQUAL_UINT32(direct[h].count, r.count);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, static_cast<float>(direct[h].mean), r.mean);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, direct[h].stdDev(), r.stdDev);
+    TEST_ASSERT_EQUAL_FLOAT(direct[h].minV, r.minV);
+    TEST_ASSERT_EQUAL_FLOAT(direct[h].maxV, r.maxV);
+  }
+  // 1 分の行の件数の合計 = 全サンプル数
+  uint32_t total = 0;
+  for (size_t i = 0; i < out.rows[1].size(); ++i) total += out.rows[1][i].count;
+  TEST_ASSERT_EQUAL_UINT32(14400, total);
+}
+
+void test_gaps_and_nan_are_skipped(void) {
+  RollupCascade c;
+  Collect out;
+  c.add(0, 10.0f, out);
+  c.add(500, NAN, out);          // 断線中の値は数えない
+  c.add(125000, 12.0f, out);     // 2 分の空白（その間の区間は行を出さない）
+  c.finish(out);
+  TEST_ASSERT_EQUAL(2, (int)out.rows[0].size());
+  TEST_ASSERT_EQUAL_UINT32(1, out.rows[0][0].count);
+  TEST_ASSERT_EQUAL_UINT32(125000, out.rows[0][1].startMs);
+  TEST_ASSERT_EQUAL(2, (int)out.rows[1].size());
+  TEST_ASSERT_EQUAL_UINT32(120000, out.rows[1][1].startMs);
+  TEST_ASSERT_EQUAL(1, (int)out.rows[2].size());
+  TEST_ASSERT_EQUAL_UINT32(2, out.rows[2][0].count);
+  TEST_ASSERT_EQUAL_FLOAT(11.0f, out.rows[2][0].mean);
+}
+
+void test_names_and_csv_format(void) {
+  char name[8];
+  RollupCascade::periodName(RollupCascade::defaultPeriodMs(0), name, sizeof(name));
+  TEST_ASSERT_EQUAL_STRING("1s", name);
+  RollupCascade::periodName(RollupCascade::defaultPeriodMs(1), name, sizeof(name));
+  TEST_ASSERT_EQUAL_STRING("1m", name);
+  RollupCascade::periodName(RollupCascade::defaultPeriodMs(2), name, sizeof(name));
+  TEST_ASSERT_EQUAL_STRING("1h", name);
+
+  RollupRow r;
+  r.level   = 1;
+  r.startMs = 60000;
+  r.count   = 120;
+  r.mean    = 25.25f;
+  r.minV    = 24.5f;
+  r.maxV    = 26.0f;
+  r.stdDev  = 0.4f;
+  char buf[96];
+  const size_t n = RollupCascade::formatCsv(r, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL(strlen(buf), n);
+  TEST_ASSERT_EQUAL_STRING("60000,120,25.25,24.50,26.00,0.400\r\n", buf);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_one_second_rows_from_500ms_samples);
+  RUN_TEST(test_cascade_matches_direct_statistics);
+  RUN_TEST(test_gaps_and_nan_are_skipped);
+  RUN_TEST(test_names_and_csv_format);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+#include <unity.h>
+#include <cstring>
+#include <vector>
+#include "RunCatalog.h"
+
+/**
+ * @brief メモリ上の目録ファイル（読み出し回数を数える）
+ */
+struct MemSource {
+  std::vector<uint8_t> data;
+  size_t               reads;
+
+  MemSource() : reads(0) {}
+  size_t read(uint32_t offset, uint8_t* buf, size_t len) {
+    ++reads;
+    if (offset >= data.size()) return 0;
+    if (len > data.size() - offset) len = data.size() - offset;
+    memcpy(buf, &data[offset], len);
+    return len;
+  }
+  /**
+   * @brief SDManager::appendCatalog() と同じく、端数を上書きして追記
+   */
+  void append(const RunCatalogEntry& e) {
+    uint8_t rec[RunCatalog::RECORD_SIZE];
+    RunCatalog::encode(e, rec);
+    data.resize(RunCatalog::appendOffset(size()));
+    data.insert(data.end(), rec, rec + sizeof(rec));
+  }
+  uint32_t size() const { return static_cast<uint32_t>(data.size()); }
+};
+
+static RunCatalogEntry makeEntry(uint32_t runId, uint8_t kind) {
+  RunCatalogEntry e;
+  memset(&e, 0, sizeof(e));
+  e.runId         = runId;
+  e.kind          = kind;
+  e.logFormat     = 2;
+  e.startUptimeMs = 1000 * runId;
+  e.durationMs    = 3600000;
+  e.samples       = 7200;
+  e.average       = 25.5f;
+  e.stdDev        = 0.125f;
+  e.minimum       = 24.0f;
+  e.maximum       = 27.25f;
+  e.hiAlarms      = 3;
+  e.loAlarms      = 1;
+  RunCatalog::fileNameFor(runId, false, e.fileName, sizeof(e.fileName));
+  return e;
+}
+
+void test_encode_decode_roundtrip(void) {
+  const RunCatalogEntry in = makeEntry(42, RunCatalog::END);
+  uint8_t rec[RunCatalog::RECORD_SIZE];
+  RunCatalog::encode(in, rec);
+
+  RunCatalogEntry out;
+  TEST_ASSERT_TRUE(RunCatalog::decode(rec, out));
+  TEST_ASSERT_EQUAL_UINT32(42, out.runId);
+  TEST_ASSERT_EQUAL_UINT8(RunCatalog::END, out.kind);
+  TEST_ASSERT_EQUAL_UINT8(2, out.logFormat);
+  TEST_ASSERT_EQUAL_UINT32(7200, out.samples);
+  TEST_ASSERT_EQUAL_FLOAT(25.5f, out.average);
+  TEST_ASSERT_EQUAL_FLOAT(27.25f, out.maximum);
+  TEST_ASSERT_EQUAL_UINT16(3, out.hiAlarms);
+  TEST_ASSERT_EQUAL_STRING("/DATA_0042.bin", out.fileName);
+
+  rec[20] ^= 0x01;   // 1 ビット破損 → CRC で検出
+  TEST_ASSERT_FALSE(RunCatalog::decode(rec, out));
+}
+
+void test_next_run_id_reads_only_the_tail(void) {
+  MemSource cat;
+  TEST_ASSERT_EQUAL_UINT32(0, RunCatalog::nextRunId(cat, cat.size()));   // 空
+
+  for (uint32_t id = 0; id < 100; ++id) {
+    cat.append(makeEntry(id, RunCatalog::START));
+    cat.append(makeEntry(id, RunCatalog::END));
+  }
+  cat.reads = 0;
+  TEST_ASSERT_EQUAL_UINT32(100, RunCatalog::nextRunId(cat, cat.size()));
+  TEST_ASSERT_EQUAL(1, cat.reads);   // 件数によらず末尾 1 レコード
+}
+
+void test_torn_tail_is_skipped_and_overwritten(void) {
+  MemSource cat;
+  cat.append(makeEntry(7, RunCatalog::START));
+  cat.append(makeEntry(7, RunCatalog::END));
+  cat.append(makeEntry(8, RunCatalog::START));
+  // 書きかけで電源断: 最後のレコードの途中まで
+  cat.data.resize(cat.size() - 20);
+
+  RunCatalogEntry last;
+  uint32_t        offset = 0;
+  TEST_ASSERT_TRUE(RunCatalog::findLast(cat, cat.size(), last, 8, &offset));
+  TEST_ASSERT_EQUAL_UINT32(7, last.runId);
+  TEST_ASSERT_EQUAL_UINT8(RunCatalog::END, last.kind);
+  TEST_ASSERT_EQUAL_UINT32(RunCatalog::RECORD_SIZE, offset);
+
+  // 中身が壊れた完全長のレコードも遡って読み飛ばす
+  cat.data.resize(RunCatalog::appendOffset(cat.size()));
+  cat.data.insert(cat.data.end(), RunCatalog::RECORD_SIZE, 0xFF);
+  TEST_ASSERT_EQUAL_UINT32(8, RunCatalog::nextRunId(cat, cat.size()));
+
+  // 次の追記は端数を上書きし、レコード境界は崩れない
+  MemSource torn;
+  torn.append(makeEntry(1, RunCatalog::END));
+  torn.data.resize(torn.size() + 30, 0xAA);
+  torn.append(makeEntry(2, RunCatalog::START));
+  TEST_ASSERT_EQUAL_UINT32(2 * RunCatalog::RECORD_SIZE, torn.size());
+  TEST_ASSERT_EQUAL_UINT32(3, RunCatalog::nextRunId(torn, torn.size()));
+}
+
+void test_format_line(void) {
+  char line[160];
+  RunCatalog::formatLine(makeEntry(3, RunCatalog::START), line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("#0003 START /DATA_0003.bin at 3s\n", line);
+
+  RunCatalogEntry e = makeEntry(3, RunCatalog::END);
+  e.flags = RunCatalog::FLAG_SD_ERROR;
+  RunCatalog::formatLine(e, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("#0003 END   /DATA_0003.bin 3600s n=7200 avg=25.50 sd=0.125 "
+                           "min=24.00 max=27.25 hi=3 lo=1 sd_error\n", line);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_encode_decode_roundtrip);
+  RUN_TEST(test_next_run_id_reads_only_the_tail);
+  RUN_TEST(test_torn_tail_is_skipped_and_overwritten);
+  RUN_TEST(test_format_line);
+  return UNITY_END();
+}
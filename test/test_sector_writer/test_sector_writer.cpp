@@ -0,0 +1,189 @@
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "SectorWriter.h"
+
+/**
+ * @brief ファイルを模したメモリ Sink（書き込み位置・長さを記録）
+ */
+struct MemorySink {
+  std::string data;
+  uint32_t    pos = 0;
+  int         flushes = 0;
+  bool        failWrites = false;
+  std::vector<std::pair<uint32_t, size_t>> writes;  // (offset, len)
+
+  bool seek(uint32_t offset) {
+    if (offset > data.size()) return false;
+    pos = offset;
+    return true;
+  }
+  size_t write(const uint8_t* d, size_t len) {
+    if (failWrites) return 0;
+    writes.push_back(std::make_pair(pos, len));
+    if (data.size() < pos + len) data.resize(pos + len);
+    data.replace(pos, len, reinterpret_cast<const char*>(d), len);
+    pos += static_cast<uint32_t>(len);
+    return len;
+  }
+  void flush() { ++flushes; }
+};
+
+typedef SectorWriter<MemorySink> Writer;
+
+static std::string row(int i) {
+  char buf[80];
+  snprintf(buf, sizeof(buf), "%d,540.2,RUN,%d,538.7,1.3,545.0,531.9,false,false\r\n", i, i * 10);
+  return buf;
+}
+
+void test_rows_stay_in_ram_until_sector_fills(void) {
+  MemorySink sink;
+  Writer w(sink, 2000, 4096);
+  w.reset(0);
+
+  std::string expected;
+  int i = 0;
+  while (expected.size() + row(i).size() < 512) {
+    const std::string r = row(i++);
+    expected += r;
+    TEST_ASSERT_TRUE(w.append(r.data(), r.size()));
+    TEST_ASSERT_TRUE(w.service(10));
+  }
+  TEST_ASSERT_EQUAL(0, (int)sink.writes.size());   // まだ 1 回も書いていない
+  TEST_ASSERT_EQUAL((int)expected.size(), (int)w.unsyncedBytes());
+}
+
+void test_only_full_aligned_sectors_are_written(void) {
+  MemorySink sink;
+  Writer w(sink, 1000000, 1000000);  // 同期は明示的に行う
+  w.reset(0);
+
+  std::string expected;
+  for (int i = 0; i < 100; ++i) {
+    const std::string r = row(i);
+    expected += r;
+    TEST_ASSERT_TRUE(w.append(r.data(), r.size()));
+    TEST_ASSERT_TRUE(w.service(0));
+  }
+  TEST_ASSERT_TRUE(sink.writes.size() > 0);
+  for (size_t k = 0; k < sink.writes.size(); ++k) {
+    TEST_ASSERT_EQUAL(0, (int)(sink.writes[k].first % 512));
+    TEST_ASSERT_EQUAL(512, (int)sink.writes[k].second);
+  }
+  TEST_ASSERT_EQUAL((int)(expected.size() / 512), (int)w.stats().sectorWrites);
+
+  TEST_ASSERT_TRUE(w.sync(0));
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), sink.data.c_str());
+  TEST_ASSERT_EQUAL((int)expected.size(), (int)w.size());
+}
+
+void test_tail_is_rewritten_from_sector_start(void) {
+  MemorySink sink;
+  Writer w(sink, 1000000, 1000000);
+  w.reset(0);
+
+  std::string expected(300, 'a');
+  w.append(expected.data(), expected.size());
+  TEST_ASSERT_TRUE(w.sync(0));
+  TEST_ASSERT_EQUAL(1, sink.flushes);
+  TEST_ASSERT_EQUAL(0, (int)sink.writes.back().first);
+  TEST_ASSERT_EQUAL(300, (int)sink.writes.back().second);
+
+  const std::string more(400, 'b');  // セクタを跨ぐ
+  expected += more;
+  w.append(more.data(), more.size());
+  TEST_ASSERT_TRUE(w.sync(0));
+  // 先頭セクタは 512 バイト丸ごと offset 0 へ、残りは offset 512 から
+  TEST_ASSERT_EQUAL(0, (int)sink.writes[1].first);
+  TEST_ASSERT_EQUAL(512, (int)sink.writes[1].second);
+  TEST_ASSERT_EQUAL(512, (int)sink.writes[2].first);
+  TEST_ASSERT_EQUAL(188, (int)sink.writes[2].second);
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), sink.data.c_str());
+}
+
+void test_sync_policy_by_time_and_bytes(void) {
+  MemorySink sink;
+  Writer w(sink, 2000, 1024);
+  w.reset(1000);
+
+  const std::string r = row(1);
+  w.append(r.data(), r.size());
+  TEST_ASSERT_TRUE(w.service(2999));
+  TEST_ASSERT_EQUAL(0, sink.flushes);
+  TEST_ASSERT_TRUE(w.service(3000));           // 2 秒経過
+  TEST_ASSERT_EQUAL(1, sink.flushes);
+  TEST_ASSERT_EQUAL(0, (int)w.unsyncedBytes());
+
+  const std::string big(1100, 'x');            // バイト数条件
+  w.append(big.data(), big.size());
+  TEST_ASSERT_TRUE(w.service(3001));
+  TEST_ASSERT_EQUAL(2, sink.flushes);
+}
+
+void test_sync_policy_can_be_retuned(void) {
+  MemorySink sink;
+  Writer w(sink, 2000, 4096);
+  w.reset(0);
+  w.setSyncPolicy(5000, 8192);                 // 遅いカード: 間隔・バイト数とも延ばす
+  TEST_ASSERT_EQUAL(5000, (int)w.syncIntervalMs());
+
+  const std::string big(5000, 'y');
+  w.append(big.data(), big.size());
+  TEST_ASSERT_TRUE(w.service(4999));
+  TEST_ASSERT_EQUAL(0, sink.flushes);          // 旧方針なら 4096B / 2 秒で同期していた
+  TEST_ASSERT_TRUE(w.service(5000));
+  TEST_ASSERT_EQUAL(1, sink.flushes);
+}
+
+void test_backpressure_writes_inside_append(void) {
+  MemorySink sink;
+  Writer w(sink, 1000000, 1000000);
+  w.reset(0);
+  const std::string big(1536, 'z');            // service() 無しで 3 セクタ
+  TEST_ASSERT_TRUE(w.append(big.data(), big.size()));
+  TEST_ASSERT_EQUAL(2, (int)w.stats().stalls);
+  TEST_ASSERT_TRUE(w.sync(0));
+  TEST_ASSERT_EQUAL(1536, (int)sink.data.size());
+}
+
+void test_write_failure_is_reported(void) {
+  MemorySink sink;
+  Writer w(sink, 1000000, 1000000);
+  w.reset(0);
+  sink.failWrites = true;
+  const std::string big(600, 'q');
+  w.append(big.data(), big.size());
+  TEST_ASSERT_FALSE(w.service(0));
+  TEST_ASSERT_FALSE(w.sync(0));
+}
+
+void test_resume_continues_existing_file(void) {
+  // 再マウント後: 既存の 700B（2 セクタ目の途中まで）に続けて書く
+  MemorySink sink;
+  sink.data = std::string(512, 'a') + std::string(188, 'b');
+  Writer w(sink, 1000000, 1000000);
+  w.resume(700, reinterpret_cast<const uint8_t*>(sink.data.data()) + 512, 0);
+  TEST_ASSERT_EQUAL(700, (int)w.size());
+  TEST_ASSERT_EQUAL(0, (int)w.unsyncedBytes());
+
+  const std::string more(400, 'c');
+  TEST_ASSERT_TRUE(w.append(more.data(), more.size()));
+  TEST_ASSERT_TRUE(w.sync(0));
+  TEST_ASSERT_EQUAL(1100, (int)sink.data.size());
+  TEST_ASSERT_EQUAL(512u, sink.writes[0].first);        // 途中のセクタの先頭から書き直す
+  TEST_ASSERT_TRUE(sink.data == std::string(512, 'a') + std::string(188, 'b') + more);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rows_stay_in_ram_until_sector_fills);
+  RUN_TEST(test_only_full_aligned_sectors_are_written);
+  RUN_TEST(test_tail_is_rewritten_from_sector_start);
+  RUN_TEST(test_sync_policy_by_time_and_bytes);
+  RUN_TEST(test_sync_policy_can_be_retuned);
+  RUN_TEST(test_backpressure_writes_inside_append);
+  RUN_TEST(test_write_failure_is_reported);
+  RUN_TEST(test_resume_continues_existing_file);
+  return UNITY_END();
+}
@@ -0,0 +1,104 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "SeqLock.h"
+
+// IOSnapshot 相当のサイズ・構成を持つテスト用スナップショット
+// （a, b, c の間に不変条件を持たせ、ちぎれた読み出しを検出する）
+struct TestSnapshot {
+  uint32_t a;
+  float    b;      // = a * 0.5f
+  uint32_t c;      // = ~a
+  bool     flag;   // = (a & 1) != 0
+  uint8_t  edges;  // = a & 0xFF
+};
+
+static bool isConsistent(const TestSnapshot& s) {
+  return s.b == static_cast<float>(s.a) * 0.5f &&
+         s.c == ~s.a &&
+         s.flag == ((s.a & 1U) != 0) &&
+         s.edges == static_cast<uint8_t>(s.a & 0xFFU);
+}
+
+static TestSnapshot make(uint32_t a) {
+  TestSnapshot s;
+  s.a = a;
+  s.b = static_cast<float>(a) * 0.5f;
+  s.c = ~a;
+  s.flag = (a & 1U) != 0;
+  s.edges = static_cast<uint8_t>(a & 0xFFU);
+  return s;
+}
+
+void test_initial_value_is_zeroed(void) {
+  SeqLock<TestSnapshot> lock;
+  TestSnapshot s = lock.read();
+  TEST_ASSERT_EQUAL(0, s.a);
+  TEST_ASSERT_EQUAL(0, lock.sequence());
+}
+
+void test_publish_then_read(void) {
+  SeqLock<TestSnapshot> lock;
+  lock.publish(make(42));
+  TestSnapshot s = lock.read();
+  TEST_ASSERT_EQUAL(42, s.a);
+  TEST_ASSERT_TRUE(isConsistent(s));
+  TEST_ASSERT_EQUAL(2, lock.sequence());
+}
+
+void test_latest_value_wins(void) {
+  SeqLock<TestSnapshot> lock(make(1));
+  lock.publish(make(2));
+  lock.publish(make(3));
+  TestSnapshot s;
+  TEST_ASSERT_TRUE(lock.tryRead(s));
+  TEST_ASSERT_EQUAL(3, s.a);
+}
+
+// std::thread を IO コア / 制御コアの代わりに使い、
+// 1 ライター + 複数リーダーで「ちぎれ」と「巻き戻り」が無いことを確認
+void test_concurrent_readers_never_see_torn_snapshot(void) {
+  SeqLock<TestSnapshot> lock(make(0));
+  std::atomic<bool> done(false);
+  std::atomic<uint32_t> torn(0);
+  std::atomic<uint32_t> regressions(0);
+  std::atomic<uint32_t> reads(0);
+  const uint32_t kPublishes = 200000;
+
+  auto reader = [&]() {
+    uint32_t last = 0;
+    while (!done.load(std::memory_order_acquire)) {
+      TestSnapshot s = lock.read();
+      if (!isConsistent(s)) torn.fetch_add(1);
+      if (s.a < last) regressions.fetch_add(1);
+      last = s.a;
+      reads.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i) readers.emplace_back(reader);
+
+  std::thread writer([&]() {
+    for (uint32_t i = 1; i <= kPublishes; ++i) lock.publish(make(i));
+    done.store(true, std::memory_order_release);
+  });
+
+  writer.join();
+  for (auto& t : readers) t.join();
+
+  TEST_ASSERT_EQUAL(0, torn.load());
+  TEST_ASSERT_EQUAL(0, regressions.load());
+  TEST_ASSERT_GREATER_THAN(0, reads.load());
+  TEST_ASSERT_EQUAL(kPublishes, lock.read().a);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_initial_value_is_zeroed);
+  RUN_TEST(test_publish_then_read);
+  RUN_TEST(test_latest_value_wins);
+  RUN_TEST(test_concurrent_readers_never_see_torn_snapshot);
+  return UNITY_END();
+}
@@ -0,0 +1,87 @@
+#include <unity.h>
+#include <cstring>
+#include "SoakLog.h"
+
+void test_clock_extends_across_millis_wrap(void) {
+  WrapClock clock;
+  clock.reset(0xFFFFF000UL);
+  TEST_ASSERT_TRUE(clock.extend(0xFFFFF800UL) == 0xFFFFF800ull);
+  // 一周した後も単調に増える
+  TEST_ASSERT_TRUE(clock.extend(0x00000400UL) == 0x100000400ull);
+  TEST_ASSERT_TRUE(clock.extend(0x00001000UL) == 0x100001000ull);
+
+  // 一周前に取得したサンプル時刻も正しく伸ばす
+  TEST_ASSERT_TRUE(clock.widen(0xFFFFFC00UL) == 0xFFFFFC00ull);
+  TEST_ASSERT_TRUE(clock.widen(0x00000800UL) == 0x100000800ull);
+
+  // 2 周目
+  for (uint32_t q = 1; q <= 3; ++q) clock.extend(q * 0x40000000UL);
+  TEST_ASSERT_TRUE(clock.extend(0x00000100UL) == 0x200000100ull);
+}
+
+void test_clock_counts_weeks_without_overflow(void) {
+  // 8 週間、10ms ごとに進める代わりに 1 時間ごとに（一周 49.7 日より十分短い間隔）
+  WrapClock clock;
+  clock.reset(12345);
+  const uint64_t start = clock.extend(12345);
+  uint32_t       now   = 12345;
+  const uint32_t hour  = 3600000UL;
+  for (int h = 0; h < 8 * 7 * 24; ++h) {
+    now += hour;
+    clock.extend(now);
+  }
+  TEST_ASSERT_TRUE(clock.extend(now) - start == 8ull * 7 * 24 * hour);
+}
+
+void test_segment_due_by_size_or_time(void) {
+  const uint32_t mb = 1024UL * 1024UL;
+  TEST_ASSERT_FALSE(SoakLog::segmentDue(10 * mb, 3600000UL, 256 * mb, 86400000UL));
+  TEST_ASSERT_TRUE(SoakLog::segmentDue(256 * mb, 3600000UL, 256 * mb, 86400000UL));
+  TEST_ASSERT_TRUE(SoakLog::segmentDue(1 * mb, 86400000UL, 256 * mb, 86400000UL));
+  // 0 はその条件を使わない
+  TEST_ASSERT_FALSE(SoakLog::segmentDue(0xFFFFFFFFUL, 1000, 0, 86400000UL));
+  TEST_ASSERT_FALSE(SoakLog::segmentDue(0, 0x7FFFFFFFUL, 256 * mb, 0));
+}
+
+void test_segment_names_follow_the_run_file(void) {
+  char name[32];
+  SoakLog::segmentName("/DATA_0003.csv", 0, name, sizeof(name));
+  TEST_ASSERT_EQUAL_STRING("/DATA_0003.csv", name);
+  SoakLog::segmentName("/DATA_0003.csv", 2, name, sizeof(name));
+  TEST_ASSERT_EQUAL_STRING("/DATA_0003_s002.csv", name);
+  SoakLog::segmentName("/DATA_12345.bin", SoakLog::MAX_SEGMENTS, name, sizeof(name));
+  TEST_ASSERT_EQUAL_STRING("/DATA_12345_s999.bin", name);
+  // 派生ファイル（集約・生データ・スナップショット）を付けても SD_MAX_FILENAME に収まる
+  TEST_ASSERT_TRUE(strlen(name) + strlen("_raw") < 32);
+}
+
+void test_segment_line_links_to_the_run(void) {
+  SegmentInfo seg;
+  seg.runId         = 3;
+  seg.index         = 2;
+  seg.runOffsetMs   = 5000000000ull;    // 約 58 日（32 ビットを超える）
+  seg.samplesBefore = 10000000000ull;
+  char buf[SoakLog::MAX_LINE];
+  const size_t n = SoakLog::formatSegmentLine(seg, "/DATA_0003_s001.csv", buf);
+  TEST_ASSERT_EQUAL_STRING("# SEGMENT,run=3,index=2,prev=DATA_0003_s001.csv,"
+                           "run_offset_ms=5000000000,samples_before=10000000000\r\n", buf);
+  TEST_ASSERT_EQUAL((int)strlen(buf), (int)n);
+
+  // 最長でも MAX_LINE に収まる
+  seg.runId         = 0xFFFFFFFFUL;
+  seg.index         = 0xFFFF;
+  seg.runOffsetMs   = 0xFFFFFFFFFFFFFFFFull;
+  seg.samplesBefore = 0xFFFFFFFFFFFFFFFFull;
+  const size_t m = SoakLog::formatSegmentLine(seg, "/DATA_99999_s999_with_a_long_suffix.csv", buf);
+  TEST_ASSERT_TRUE(m < SoakLog::MAX_LINE);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_clock_extends_across_millis_wrap);
+  RUN_TEST(test_clock_counts_weeks_without_overflow);
+  RUN_TEST(test_segment_due_by_size_or_time);
+  RUN_TEST(test_segment_names_follow_the_run_file);
+  RUN_TEST(test_segment_line_links_to_the_run);
+  return UNITY_END();
+}
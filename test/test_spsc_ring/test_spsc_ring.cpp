@@ -0,0 +1,122 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "SpscRing.h"
+
+struct Record {
+  uint32_t seq;
+  uint32_t check;   // seq から導出（破損検出用）
+  float    value;
+};
+
+static Record makeRecord(uint32_t seq) {
+  Record r;
+  r.seq   = seq;
+  r.check = seq * 2654435761u;
+  r.value = static_cast<float>(seq) * 0.5f;
+  return r;
+}
+
+void test_fifo_order_and_full_ring(void) {
+  SpscRing<Record, 4> ring;
+  TEST_ASSERT_TRUE(ring.empty());
+  for (uint32_t i = 0; i < 4; ++i) TEST_ASSERT_TRUE(ring.push(makeRecord(i)));
+  TEST_ASSERT_FALSE(ring.push(makeRecord(99)));   // 満杯 → 破棄
+  TEST_ASSERT_EQUAL(1, ring.dropped());
+  TEST_ASSERT_EQUAL(4, ring.highWater());
+
+  Record r;
+  for (uint32_t i = 0; i < 4; ++i) {
+    TEST_ASSERT_TRUE(ring.pop(r));
+    TEST_ASSERT_EQUAL(i, r.seq);
+  }
+  TEST_ASSERT_FALSE(ring.pop(r));
+}
+
+void test_indices_wrap(void) {
+  SpscRing<Record, 8> ring;
+  Record r;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    TEST_ASSERT_TRUE(ring.push(makeRecord(i)));
+    TEST_ASSERT_TRUE(ring.pop(r));
+    TEST_ASSERT_EQUAL(i, r.seq);
+  }
+  TEST_ASSERT_EQUAL(1, ring.highWater());
+  TEST_ASSERT_EQUAL(0, ring.dropped());
+}
+
+// 生成側が満杯時に再試行する場合: 全件が順序通り・無破損で届く
+void test_concurrent_lossless_when_producer_retries(void) {
+  static SpscRing<Record, 64> ring;
+  const uint32_t COUNT = 500000;
+  std::atomic<bool> failed(false);
+
+  std::thread consumer([&]() {
+    Record r;
+    uint32_t expected = 0;
+    while (expected < COUNT) {
+      if (!ring.pop(r)) continue;
+      if (r.seq != expected || r.check != expected * 2654435761u ||
+          r.value != static_cast<float>(expected) * 0.5f) {
+        failed = true;
+        return;
+      }
+      ++expected;
+    }
+  });
+
+  uint32_t retries = 0;
+  for (uint32_t i = 0; i < COUNT; ++i) {
+    while (!ring.push(makeRecord(i))) ++retries;
+  }
+  consumer.join();
+
+  TEST_ASSERT_FALSE(failed.load());
+  TEST_ASSERT_TRUE(ring.empty());
+  TEST_ASSERT_TRUE(ring.highWater() <= 64);
+  TEST_ASSERT_EQUAL(retries, ring.dropped());   // 失敗した push は全て計上
+}
+
+// 消費側が遅い場合: 受信は単調増加、受信 + 破棄 = 送信
+void test_concurrent_drops_are_counted(void) {
+  static SpscRing<Record, 16> ring;
+  const uint32_t COUNT = 200000;
+  std::atomic<bool> done(false);
+  std::atomic<bool> failed(false);
+  std::atomic<uint32_t> received(0);
+
+  std::thread consumer([&]() {
+    Record r;
+    int64_t last = -1;
+    uint32_t n = 0;
+    for (;;) {
+      if (ring.pop(r)) {
+        if (static_cast<int64_t>(r.seq) <= last || r.check != r.seq * 2654435761u) failed = true;
+        last = r.seq;
+        ++n;
+        if ((n & 7) == 0) std::this_thread::yield();  // わざと遅らせる
+      } else if (done.load()) {
+        if (!ring.pop(r)) break;
+        ++n;
+      }
+    }
+    received = n;
+  });
+
+  for (uint32_t i = 0; i < COUNT; ++i) ring.push(makeRecord(i));
+  done = true;
+  consumer.join();
+
+  TEST_ASSERT_FALSE(failed.load());
+  TEST_ASSERT_EQUAL(COUNT, received.load() + ring.dropped());
+  TEST_ASSERT_TRUE(ring.highWater() <= 16);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fifo_order_and_full_ring);
+  RUN_TEST(test_indices_wrap);
+  RUN_TEST(test_concurrent_lossless_when_producer_retries);
+  RUN_TEST(test_concurrent_drops_are_counted);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <cstdlib>
+#include <cstring>
+#include "WallClock.h"
+
+static CivilTime civil(uint16_t y, uint8_t mo, uint8_t d, uint8_t h, uint8_t mi, uint8_t s) {
+  CivilTime t = {y, mo, d, h, mi, s};
+  return t;
+}
+
+void test_epoch_round_trip_and_leap_years(void) {
+  TEST_ASSERT_TRUE(WallClock::toEpochSec(civil(2000, 1, 1, 0, 0, 0)) == 946684800LL);
+  TEST_ASSERT_TRUE(WallClock::toEpochSec(civil(2024, 2, 29, 12, 0, 0)) == 1709208000LL);
+  TEST_ASSERT_TRUE(WallClock::toEpochSec(civil(2038, 1, 19, 3, 14, 8)) == 2147483648LL);
+
+  // 2000-01-01 から 2099-12-31 まで 1 日ずつ往復
+  int64_t sec = WallClock::toEpochSec(civil(2000, 1, 1, 23, 59, 59));
+  for (int d = 0; d < 36524; ++d, sec += 86400) {
+    CivilTime t;
+    WallClock::fromEpochSec(sec, t);
+    TEST_ASSERT_TRUE(WallClock::validCivil(t));
+    TEST_ASSERT_TRUE(WallClock::toEpochSec(t) == sec);
+  }
+
+  TEST_ASSERT_TRUE(WallClock::validCivil(civil(2000, 2, 29, 0, 0, 0)));    // 400 年周期
+  TEST_ASSERT_FALSE(WallClock::validCivil(civil(2023, 2, 29, 0, 0, 0)));
+  TEST_ASSERT_FALSE(WallClock::validCivil(civil(2026, 4, 31, 0, 0, 0)));
+  TEST_ASSERT_FALSE(WallClock::validCivil(civil(2026, 10, 19, 24, 0, 0)));
+}
+
+void test_iso_and_compact_formats(void) {
+  char buf[32];
+  const int64_t ms = WallClock::toEpochSec(civil(2026, 10, 19, 7, 5, 9)) * 1000 + 42;
+  char* e = WallClock::putIso(buf, ms);
+  *e = '\0';
+  TEST_ASSERT_EQUAL_STRING("2026-10-19T07:05:09.042", buf);
+  TEST_ASSERT_EQUAL((int)WallClock::ISO_LEN, (int)(e - buf));
+
+  CivilTime t;
+  TEST_ASSERT_TRUE(WallClock::parseCompact("20261019070509", t));
+  TEST_ASSERT_TRUE(WallClock::toEpochSec(t) * 1000 + 42 == ms);
+  TEST_ASSERT_FALSE(WallClock::parseCompact("2026101907050", t));    // 桁不足
+  TEST_ASSERT_FALSE(WallClock::parseCompact("20261319070509", t));   // 13 月
+  TEST_ASSERT_FALSE(WallClock::parseCompact("2026101907050x", t));
+}
+
+void test_ds3231_registers(void) {
+  uint8_t r[WallClock::DS3231_TIME_BYTES];
+  WallClock::encodeDs3231(civil(2026, 10, 19, 23, 59, 58), r);
+  TEST_ASSERT_EQUAL_HEX8(0x58, r[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x59, r[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x23, r[2]);
+  TEST_ASSERT_EQUAL(1, r[3]);                // 2026-10-19 は月曜
+  TEST_ASSERT_EQUAL_HEX8(0x19, r[4]);
+  TEST_ASSERT_EQUAL_HEX8(0x10, r[5]);
+  TEST_ASSERT_EQUAL_HEX8(0x26, r[6]);
+
+  CivilTime t;
+  TEST_ASSERT_TRUE(WallClock::decodeDs3231(r, t));
+  TEST_ASSERT_TRUE(WallClock::toEpochSec(t) == WallClock::toEpochSec(civil(2026, 10, 19, 23, 59, 58)));
+
+  // 12 時間制（PM 11 時 / AM 12 時）
+  r[2] = 0x40 | 0x20 | 0x11;
+  TEST_ASSERT_TRUE(WallClock::decodeDs3231(r, t));
+  TEST_ASSERT_EQUAL(23, t.hour);
+  r[2] = 0x40 | 0x12;
+  TEST_ASSERT_TRUE(WallClock::decodeDs3231(r, t));
+  TEST_ASSERT_EQUAL(0, t.hour);
+
+  // 未設定（電源投入直後の 0 埋め）は無効
+  memset(r, 0, sizeof(r));
+  TEST_ASSERT_FALSE(WallClock::decodeDs3231(r, t));
+}
+
+/**
+ * @brief millis() が RTC より ppm 進む系で、10 分ごとに秒の変わり目を観測する
+ * @param jitterMs 観測の誤差（制御周期ぶん、±）
+ * @param monotonic 補正しても時刻が逆行しなかったか
+ * @return 最後の 1 時間の最大誤差 [ms]
+ */
+static int64_t simulateDrift(WallClock& clock, int32_t ppm, int32_t jitterMs, uint32_t localStart,
+                             int hours, bool& monotonic) {
+  srand(11);
+  const int64_t rtcStart = WallClock::toEpochSec(civil(2026, 10, 19, 0, 0, 0)) * 1000;
+  const int64_t total    = static_cast<int64_t>(hours) * 3600000;
+  int64_t worst = 0;
+  int64_t prevWall = -1;
+  monotonic = true;
+  for (int64_t rtc = 0; rtc <= total; rtc += 1000) {
+    const uint32_t local = localStart + static_cast<uint32_t>(rtc + rtc * ppm / 1000000);
+    if (rtc % 600000 == 0) {
+      const int32_t j = jitterMs ? static_cast<int32_t>(rand() % (2 * jitterMs + 1)) - jitterMs : 0;
+      clock.discipline(rtcStart + rtc, local + static_cast<uint32_t>(j));
+    }
+    const int64_t wall = clock.nowMs(local);
+    if (wall <= prevWall) monotonic = false;
+    prevWall = wall;
+    const int64_t err = llabs(wall - (rtcStart + rtc));
+    if (rtc >= total - 3600000 && err > worst) worst = err;
+  }
+  return worst;
+}
+
+void test_discipline_learns_drift(void) {
+  WallClock clock;
+  TEST_ASSERT_FALSE(clock.valid());
+  TEST_ASSERT_TRUE(clock.nowMs(0) == -1);
+
+  // millis() が 40ppm 速い: 補正無しなら 24 時間で 3.5 秒ずれる
+  bool monotonic = false;
+  const int64_t worst = simulateDrift(clock, 40, 0, 1000, 24, monotonic);
+  TEST_ASSERT_TRUE(monotonic);
+  TEST_ASSERT_TRUE(worst <= 2);
+  TEST_ASSERT_INT_WITHIN(2000, -40000, clock.driftPpb());
+  TEST_ASSERT_EQUAL(0, (int)clock.steps());
+}
+
+void test_discipline_with_observation_jitter_and_millis_wrap(void) {
+  WallClock clock;
+  // 観測が ±25ms ぶれ（省電力状態の制御周期）、millis() が途中で一周する（開始 20 分後）
+  bool monotonic = false;
+  const int64_t worst = simulateDrift(clock, -25, 25, 0xFFFFFFFFUL - 1200000UL, 12, monotonic);
+  TEST_ASSERT_TRUE(monotonic);
+  TEST_ASSERT_TRUE(worst <= 30);                           // 観測 1 回分の揺れ以内
+  TEST_ASSERT_INT_WITHIN(2000, 25000, clock.driftPpb());   // 基線が長いので揺れは効かない
+}
+
+void test_large_error_steps_and_resets_drift(void) {
+  WallClock clock;
+  bool monotonic = false;
+  simulateDrift(clock, 40, 0, 1000, 2, monotonic);
+  TEST_ASSERT_TRUE(clock.driftPpb() != 0);
+
+  // RTC を設定し直した（1 時間進めた）
+  const uint32_t local  = 1000 + 7200000UL + 288UL + 60000UL;
+  const int64_t  rtcNew = clock.nowMs(local) + 3600000;
+  clock.discipline(rtcNew, local);
+  TEST_ASSERT_EQUAL(1, (int)clock.steps());
+  TEST_ASSERT_EQUAL(0, clock.driftPpb());
+  TEST_ASSERT_TRUE(clock.nowMs(local) == rtcNew);
+  TEST_ASSERT_TRUE(clock.nowMs(local + 1500) == rtcNew + 1500);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_epoch_round_trip_and_leap_years);
+  RUN_TEST(test_iso_and_compact_formats);
+  RUN_TEST(test_ds3231_registers);
+  RUN_TEST(test_discipline_learns_drift);
+  RUN_TEST(test_discipline_with_observation_jitter_and_millis_wrap);
+  RUN_TEST(test_large_error_steps_and_resets_drift);
+  return UNITY_END();
+}
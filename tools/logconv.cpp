@@ -0,0 +1,298 @@
+/**
+ * @file logconv.cpp
+ * @brief バイナリログ（*.bin）→ CSV 変換ツール（ホスト PC 用）
+ *
+ * @details
+ * SD カードに記録したバイナリ形式のログ（include/BinaryLog.h）を、
+ * CSV 形式で記録した場合と同じ列構成の CSV に変換する（schema 1 の旧ファイルは
+ * ElapsedMs 列の無い当時の列構成のまま）。レコードは常に全列を持つが、出力する列は
+ * ファイルヘッダの列名（配備時の列構成、include/LogSchema.h）に従う。
+ * フッタ（'# PERF,...' 等）も TEXT ブロックからそのまま出力する。
+ * 差分符号化（DELTA、include/DeltaCodec.h）のログは
+ * ElapsedMs,Temp_C,HI_ALARM,LO_ALARM の列で、生データ記録（*_raw.bin、
+ * include/RawCapture.h）は ElapsedMs,Raw_C,Fault の列で出力する。
+ *
+ * ビルド:
+ *   g++ -O2 -std=c++11 -I include tools/logconv.cpp -o logconv
+ *
+ * 使い方:
+ *   ./logconv DATA_0003.bin > DATA_0003.csv
+ *   ./logconv DATA_0003.bin DATA_0003.csv
+ *   ./logconv --info DATA_0003.bin          （ヘッダ情報のみ表示）
+ *
+ * 入出力は数 MB 単位のバッファでまとめて行い、行の整形に printf を使わない
+ * （BinaryLog::formatCsvRow）ため、GB 級のログでも数秒で変換できる。
+ *
+ * CRC 不一致のブロックは飛ばして件数を標準エラーに出し、終了コード 2 を返す。
+ * 全ゼロのブロックはファイル終端（未使用領域）として扱う。
+ * ヘッダの有効長マーカー（validBytes）があればそこで読み終える（事前確保した
+ * ファイルが電源断で切り詰められずに残った場合、以降は不定値のため）。
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "BinaryLog.h"
+#include "DeltaCodec.h"
+#include "RawCapture.h"
+#include "LogSchema.h"
+
+namespace {
+
+const size_t READ_CHUNK_BLOCKS = 8192;               // 4 MB ずつ読む
+const size_t WRITE_BUFFER      = 4u * 1024u * 1024u; // 出力バッファ
+
+/**
+ * @brief まとめ書き用の出力バッファ
+ */
+class Output {
+public:
+  explicit Output(FILE* fp) : m_fp(fp), m_buf(WRITE_BUFFER), m_used(0), m_ok(true) {}
+  ~Output() { flush(); }
+
+  void write(const char* data, size_t len) {
+    if (m_used + len > m_buf.size()) flush();
+    if (len > m_buf.size()) {
+      m_ok = m_ok && fwrite(data, 1, len, m_fp) == len;
+      return;
+    }
+    memcpy(&m_buf[m_used], data, len);
+    m_used += len;
+  }
+
+  /**
+   * @brief 1 行分の書き込み先を確保（reserve バイト以上の空きを保証）
+   */
+  char* reserve(size_t len) {
+    if (m_used + len > m_buf.size()) flush();
+    return &m_buf[m_used];
+  }
+  void commit(size_t len) { m_used += len; }
+
+  void flush() {
+    if (m_used > 0) {
+      m_ok = m_ok && fwrite(&m_buf[0], 1, m_used, m_fp) == m_used;
+      m_used = 0;
+    }
+  }
+
+  bool ok() const { return m_ok; }
+
+private:
+  FILE*             m_fp;
+  std::vector<char> m_buf;
+  size_t            m_used;
+  bool              m_ok;
+};
+
+void printInfo(const char* path, const BinLogHeader& h) {
+  printf("file            : %s\n", path);
+  printf("schema_version  : %u\n", (unsigned)h.schemaVersion);
+  printf("sample_period_ms: %lu\n", (unsigned long)h.samplePeriodMs);
+  if (h.hiThresholdDeci == BinaryLog::NAN_DECI) {
+    printf("hi_threshold_c  : NaN\n");
+  } else {
+    printf("hi_threshold_c  : %.1f\n", h.hiThresholdDeci / 10.0);
+  }
+  if (h.loThresholdDeci == BinaryLog::NAN_DECI) {
+    printf("lo_threshold_c  : NaN\n");
+  } else {
+    printf("lo_threshold_c  : %.1f\n", h.loThresholdDeci / 10.0);
+  }
+  printf("encoding        : %s\n", (h.encoding == BinaryLog::ENCODING_DELTA) ? "delta"
+                                   : (h.encoding == BinaryLog::ENCODING_RAW) ? "raw"
+                                                                               : "records");
+  printf("quantum_milli_c : %u\n", (unsigned)h.quantumMilliC);
+  printf("valid_bytes     : %lu\n", (unsigned long)h.validBytes);
+  printf("firmware        : %s\n", h.firmware);
+  printf("columns         : %s\n", h.columns);
+}
+
+/**
+ * @brief ヘッダの列名から、全列の行（formatCsvRow）のどの列を出すかを決める
+ * @param pick 出す列の、全列の行での位置（LogColumn の数値）
+ * @return false : 全列をそのまま出す（従来どおりの列名・知らない列名）
+ */
+bool selectColumns(const char* columns, bool withMs, std::vector<uint8_t>& pick) {
+  LogColumn    list[LogSchema::MAX_COLUMNS];
+  const size_t n = LogSchema::parseColumns(columns, list, LogSchema::MAX_COLUMNS);
+  const size_t full = withMs ? static_cast<size_t>(LogColumn::ELAPSED_MS) + 1
+                             : static_cast<size_t>(LogColumn::LO_ALARM) + 1;
+  bool same = (n == full);
+  for (size_t i = 0; i < n && same; ++i) same = (static_cast<size_t>(list[i]) == i);
+  if (n == 0 || same) return false;
+  pick.clear();
+  for (size_t i = 0; i < n; ++i) pick.push_back(static_cast<uint8_t>(list[i]));
+  return true;
+}
+
+/**
+ * @brief 全列の行（CRLF 付き）から pick の列だけを out へ（レコードに無い列は空）
+ */
+size_t projectRow(const char* row, size_t len, const std::vector<uint8_t>& pick, char* out) {
+  const char* start[LogSchema::MAX_COLUMNS];
+  size_t      width[LogSchema::MAX_COLUMNS];
+  size_t      n = 0;
+  const char* field = row;
+  const char* end   = row + len - 2;   // CRLF を除く
+  for (const char* p = row; p <= end && n < LogSchema::MAX_COLUMNS; ++p) {
+    if (p == end || *p == ',') {
+      start[n] = field;
+      width[n] = static_cast<size_t>(p - field);
+      ++n;
+      field = p + 1;
+    }
+  }
+  char* q = out;
+  for (size_t i = 0; i < pick.size(); ++i) {
+    if (i > 0) *q++ = ',';
+    if (pick[i] < n) {
+      memcpy(q, start[pick[i]], width[pick[i]]);
+      q += width[pick[i]];
+    }
+  }
+  *q++ = '\r';
+  *q++ = '\n';
+  return static_cast<size_t>(q - out);
+}
+
+int usage() {
+  fprintf(stderr, "usage: logconv [--info] <input.bin> [output.csv]\n");
+  return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool infoOnly = false;
+  int  arg = 1;
+  if (arg < argc && strcmp(argv[arg], "--info") == 0) {
+    infoOnly = true;
+    ++arg;
+  }
+  if (arg >= argc) return usage();
+  const char* inPath  = argv[arg++];
+  const char* outPath = (arg < argc) ? argv[arg++] : nullptr;
+  if (arg < argc) return usage();
+
+  FILE* in = fopen(inPath, "rb");
+  if (in == nullptr) {
+    fprintf(stderr, "logconv: cannot open %s\n", inPath);
+    return 1;
+  }
+
+  uint8_t      headerBuf[BinaryLog::HEADER_SIZE];
+  BinLogHeader header;
+  if (fread(headerBuf, 1, sizeof(headerBuf), in) != sizeof(headerBuf) ||
+      !BinaryLog::decodeHeader(headerBuf, header)) {
+    fprintf(stderr, "logconv: %s is not a binary log (bad magic, CRC or schema version)\n",
+            inPath);
+    fclose(in);
+    return 1;
+  }
+  if (infoOnly) {
+    printInfo(inPath, header);
+    fclose(in);
+    return 0;
+  }
+
+  FILE* outFp = (outPath != nullptr) ? fopen(outPath, "wb") : stdout;
+  if (outFp == nullptr) {
+    fprintf(stderr, "logconv: cannot create %s\n", outPath);
+    fclose(in);
+    return 1;
+  }
+
+  unsigned long rows = 0, badBlocks = 0, seqGaps = 0;
+  bool          ioOk = true;
+  {
+    Output out(outFp);
+    out.write(header.columns, strlen(header.columns));
+    out.write("\r\n", 2);
+
+    std::vector<uint8_t> chunk(READ_CHUNK_BLOCKS * BinaryLog::BLOCK_SIZE);
+    uint32_t expectedSeq = 0;
+    bool     end = false;
+    // schema 1 の列名には ElapsedMs が無い（列構成をヘッダ行と揃える）
+    const bool withMs = header.schemaVersion >= 2;
+    std::vector<uint8_t> pick;
+    const bool projected = (header.encoding == BinaryLog::ENCODING_RECORDS) &&
+                           selectColumns(header.columns, withMs, pick);
+    // 有効長マーカー以降は読まない（0 = 不明 → ファイル末尾 / 全ゼロブロックまで）
+    size_t remaining = (header.validBytes > BinaryLog::HEADER_SIZE)
+                           ? header.validBytes - BinaryLog::HEADER_SIZE
+                           : (header.validBytes == 0 ? static_cast<size_t>(-1) : 0);
+    while (!end && remaining > 0) {
+      const size_t want   = (remaining < chunk.size()) ? remaining : chunk.size();
+      const size_t got    = fread(&chunk[0], 1, want, in);
+      const size_t blocks = got / BinaryLog::BLOCK_SIZE;   // 末尾の半端は書きかけとして捨てる
+      if (blocks == 0) break;
+      remaining -= got;
+
+      for (size_t b = 0; b < blocks && !end; ++b) {
+        const uint8_t* block = &chunk[b * BinaryLog::BLOCK_SIZE];
+        uint8_t  type  = 0;
+        uint16_t count = 0;
+        uint32_t seq   = 0;
+        switch (BinaryLog::checkBlock(block, type, count, seq)) {
+          case BinaryLog::BlockStatus::EMPTY:
+            end = true;
+            break;
+          case BinaryLog::BlockStatus::CORRUPT:
+            ++badBlocks;
+            ++expectedSeq;
+            break;
+          case BinaryLog::BlockStatus::OK:
+            if (seq != expectedSeq) ++seqGaps;
+            expectedSeq = seq + 1;
+            if (type == BinaryLog::BLOCK_TEXT) {
+              out.write(reinterpret_cast<const char*>(block + BinaryLog::BLOCK_HEADER_SIZE),
+                        count);
+            } else if (type == BinaryLog::BLOCK_DELTA) {
+              DeltaDecoder dec;
+              dec.reset(block + BinaryLog::BLOCK_HEADER_SIZE, BinaryLog::PAYLOAD_SIZE, count);
+              uint32_t t = 0;
+              int32_t  v = 0;
+              uint8_t  flags = 0;
+              const bool raw = (header.encoding == BinaryLog::ENCODING_RAW);
+              while (dec.next(t, v, flags)) {
+                char* buf = out.reserve(64);
+                out.commit(raw ? RawCapture::formatRow(t, v, flags, header.quantumMilliC, buf)
+                               : formatDeltaRow(t, v, flags, header.quantumMilliC, buf));
+                ++rows;
+              }
+            } else {
+              const uint8_t* rec = block + BinaryLog::BLOCK_HEADER_SIZE;
+              for (uint16_t i = 0; i < count; ++i, rec += BinaryLog::RECORD_SIZE) {
+                BinLogRecord r;
+                BinaryLog::decodeRecord(rec, r, header.schemaVersion);
+                if (projected) {
+                  char full[112];
+                  const size_t n = BinaryLog::formatCsvRow(r, full, withMs);
+                  out.commit(projectRow(full, n, pick, out.reserve(112)));
+                } else {
+                  out.commit(BinaryLog::formatCsvRow(r, out.reserve(112), withMs));
+                }
+              }
+              rows += count;
+            }
+            break;
+        }
+      }
+      if (got < want) break;
+    }
+    out.flush();
+    ioOk = out.ok();
+  }
+
+  fclose(in);
+  if (outFp != stdout) ioOk = (fclose(outFp) == 0) && ioOk;
+
+  fprintf(stderr, "logconv: %lu rows, %lu corrupt blocks, %lu sequence gaps\n",
+          rows, badBlocks, seqGaps);
+  if (!ioOk) {
+    fprintf(stderr, "logconv: write error\n");
+    return 1;
+  }
+  return (badBlocks > 0 || seqGaps > 0) ? 2 : 0;
+}
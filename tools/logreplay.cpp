@@ -0,0 +1,244 @@
+/**
+ * @file logreplay.cpp
+ * @brief 記録判定（LogFilter.h）の効果見積りツール（ホスト PC 用）
+ *
+ * @details
+ * 従来形式（IO 10 周期 = 100ms ごとに 1 行）で記録した CSV ログ、または
+ * 合成した温度プロファイルを LogFilter に通し、次の 3 方式の行数・バイト数・
+ * 512B セクタ書き込み数を比較する。
+ *   - legacy  : 100ms ごとに 1 行（熱電対の更新は 500ms ごとのため 5 行中 4 行は複製）
+ *   - sample  : 新しいセンサ値（500ms）ごと + アラーム変化時に 1 行
+ *   - deadband: |Δ| > eps、または max_interval 経過、またはアラーム変化時のみ
+ * sample / deadband の行は ElapsedMs 列付き（元の行 + ",<ms>"）として数える。
+ *
+ * 従来形式の CSV は ElapsedSec が秒単位のため、行番号 × 100ms を時刻とし、
+ * 5 行ごとを新しいセンサ値とみなす。ElapsedMs 列付き（11 列、WallTime 列付きは 12 列）と
+ * LeanLogLayout（ElapsedMs,Temp_C,HI_ALARM,LO_ALARM[,WallTime]）の CSV は各行を
+ * そのままイベントとして扱う（deadband の効果だけを見積もる）。
+ *
+ * ビルド:
+ *   g++ -O2 -std=c++11 -I include tools/logreplay.cpp -o logreplay
+ *
+ * 使い方:
+ *   ./logreplay DATA_0003.csv                 （eps = 0.5°C, max_interval = 10000ms）
+ *   ./logreplay --eps 0.25 --max 30000 DATA_0003.csv
+ *   ./logreplay --synthetic 3600              （昇温・保持・降温の合成 RUN [s]）
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "LogFilter.h"
+
+namespace {
+
+const uint32_t LEGACY_ROW_MS   = 100;   // IO_CYCLE_MS × 旧 SD_WRITE_INTERVAL
+const uint32_t SAMPLE_MS       = 500;   // TC_READ_INTERVAL_MS
+const size_t   SECTOR_BYTES    = 512;
+
+/**
+ * @brief 方式ごとの集計
+ */
+struct Tally {
+  unsigned long rows;
+  unsigned long bytes;
+
+  Tally() : rows(0), bytes(0) {}
+  void add(size_t len) {
+    ++rows;
+    bytes += static_cast<unsigned long>(len);
+  }
+  unsigned long sectors() const {
+    return static_cast<unsigned long>((bytes + SECTOR_BYTES - 1) / SECTOR_BYTES);
+  }
+};
+
+/**
+ * @brief 1 イベントを sample / deadband の両方式に通す
+ */
+class Replay {
+public:
+  Replay(float eps, uint32_t maxIntervalMs) {
+    m_sample.configure(false, eps, maxIntervalMs);
+    m_sample.reset();
+    m_deadband.configure(true, eps, maxIntervalMs);
+    m_deadband.reset();
+  }
+
+  void legacyRow(size_t len) { m_legacy.add(len); }
+
+  void event(uint32_t tMs, float value, uint8_t flags, size_t rowLen) {
+    char ms[16];
+    const size_t len = rowLen + static_cast<size_t>(snprintf(ms, sizeof(ms), ",%lu",
+                                                             static_cast<unsigned long>(tMs)));
+    if (m_sample.offer(tMs, value, flags) != LogFilter::NONE) m_sampleTally.add(len);
+    if (m_deadband.offer(tMs, value, flags) != LogFilter::NONE) m_deadbandTally.add(len);
+  }
+
+  void report(bool haveLegacy) const {
+    printf("%-9s %10s %12s %10s\n", "mode", "rows", "bytes", "sectors");
+    if (haveLegacy) print("legacy", m_legacy);
+    print("sample", m_sampleTally);
+    print("deadband", m_deadbandTally);
+    const LogFilter::Stats& s = m_deadband.stats();
+    printf("deadband rows by reason: change=%lu interval=%lu alarm=%lu\n",
+           static_cast<unsigned long>(s.byChange), static_cast<unsigned long>(s.byInterval),
+           static_cast<unsigned long>(s.byAlarm));
+  }
+
+private:
+  void print(const char* name, const Tally& t) const {
+    const Tally& base = (m_legacy.rows > 0) ? m_legacy : m_sampleTally;
+    const double ratio = (base.bytes > 0) ? 100.0 * t.bytes / base.bytes : 0.0;
+    printf("%-9s %10lu %12lu %10lu  (%.1f%% of %s bytes)\n", name, t.rows, t.bytes, t.sectors(),
+           ratio, (m_legacy.rows > 0) ? "legacy" : "sample");
+  }
+
+  LogFilter m_sample;
+  LogFilter m_deadband;
+  Tally     m_legacy;
+  Tally     m_sampleTally;
+  Tally     m_deadbandTally;
+};
+
+/**
+ * @brief CSV の 1 行を分割（温度・アラーム・ElapsedMs 列の取り出し）
+ * @return 列数（データ行でなければ 0）
+ */
+size_t parseRow(const std::string& line, float& temp, uint8_t& flags, uint32_t& ms) {
+  if (line.empty() || line[0] == '#' || line[0] < '0' || line[0] > '9') return 0;
+  std::string fields[12];
+  size_t n = 0;
+  size_t start = 0;
+  for (size_t i = 0; i <= line.size() && n < 12; ++i) {
+    if (i == line.size() || line[i] == ',') {
+      fields[n++] = line.substr(start, i - start);
+      start = i + 1;
+    }
+  }
+  if (n == 4 || n == 5) {
+    // LeanLogLayout（LogSchema.h）
+    ms    = static_cast<uint32_t>(strtoul(fields[0].c_str(), nullptr, 10));
+    temp  = (fields[1] == "NaN") ? NAN : strtof(fields[1].c_str(), nullptr);
+    flags = static_cast<uint8_t>((fields[2] == "true" ? 1 : 0) | (fields[3] == "true" ? 2 : 0));
+    return n;
+  }
+  if (n < 10) return 0;
+  temp  = (fields[1] == "NaN") ? NAN : strtof(fields[1].c_str(), nullptr);
+  flags = static_cast<uint8_t>((fields[8] == "true" ? 1 : 0) | (fields[9] == "true" ? 2 : 0));
+  ms    = (n >= 11) ? static_cast<uint32_t>(strtoul(fields[10].c_str(), nullptr, 10)) : 0;
+  return n;
+}
+
+int replayCsv(const char* path, Replay& replay) {
+  FILE* fp = fopen(path, "rb");
+  if (fp == nullptr) {
+    fprintf(stderr, "logreplay: cannot open %s\n", path);
+    return 1;
+  }
+  char          buf[512];
+  unsigned long row = 0;
+  bool          legacy = true;
+  uint8_t       lastFlags = 0;
+  while (fgets(buf, sizeof(buf), fp) != nullptr) {
+    std::string line(buf);
+    const size_t rawLen = line.size();
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+    float    temp = NAN;
+    uint8_t  flags = 0;
+    uint32_t ms = 0;
+    const size_t cols = parseRow(line, temp, flags, ms);
+    if (cols == 0) continue;
+    if (cols != 10) {
+      legacy = false;
+      // event() が ",<ms>" を足すため、元の行からは ElapsedMs 列の分だけ引く（WallTime 列は残す）
+      char msText[16];
+      const size_t msLen = static_cast<size_t>(snprintf(msText, sizeof(msText), ",%lu",
+                                                        static_cast<unsigned long>(ms)));
+      replay.event(ms, temp, flags, rawLen - msLen);
+    } else {
+      replay.legacyRow(rawLen);
+      const uint32_t t = static_cast<uint32_t>(row * LEGACY_ROW_MS);
+      if (row % (SAMPLE_MS / LEGACY_ROW_MS) == 0 || flags != lastFlags) {
+        replay.event(t, temp, flags, rawLen);
+      }
+    }
+    lastFlags = flags;
+    ++row;
+  }
+  fclose(fp);
+  replay.report(legacy);
+  return 0;
+}
+
+/**
+ * @brief 合成 RUN: 10 分で 25→200°C、保持、最後の 10 分で 60°C へ降温
+ * @details 0.25°C 量子化（MAX31855）+ ±0.25°C のノイズ、保持中に 2 回の HI アラーム
+ */
+int replaySynthetic(uint32_t seconds, Replay& replay) {
+  srand(1);
+  const uint32_t rampMs = 600000;
+  const uint32_t endMs  = seconds * 1000UL;
+  char line[128];
+  for (uint32_t t = 0; t < endMs; t += LEGACY_ROW_MS) {
+    // 熱電対の値は 500ms ごとにしか変わらない
+    const uint32_t ts = t / SAMPLE_MS * SAMPLE_MS;
+    double temp;
+    if (ts < rampMs) {
+      temp = 25.0 + 175.0 * ts / rampMs;
+    } else if (endMs > rampMs * 2 && ts > endMs - rampMs) {
+      temp = 200.0 - 140.0 * (ts - (endMs - rampMs)) / rampMs;
+    } else {
+      temp = 200.0;
+    }
+    srand(ts + 1);
+    temp += (rand() % 3 - 1) * 0.25;
+    const float   q    = static_cast<float>(std::floor(temp * 4.0 + 0.5) / 4.0);
+    const uint32_t min = ts / 60000;
+    const uint8_t flags = (min == 20 || min == 35) ? 1 : 0;
+    const int len = snprintf(line, sizeof(line), "%lu,%.1f,RUN,%lu,%.1f,%.1f,%.1f,%.1f,%s,false\r\n",
+                             static_cast<unsigned long>(t / 1000),
+                             static_cast<double>(q), static_cast<unsigned long>(ts / SAMPLE_MS),
+                             150.0, 60.0, 201.0, 25.0, flags ? "true" : "false");
+    replay.legacyRow(static_cast<size_t>(len));
+    if (t % SAMPLE_MS == 0) replay.event(ts, q, flags, static_cast<size_t>(len));
+  }
+  replay.report(true);
+  return 0;
+}
+
+int usage() {
+  fprintf(stderr, "usage: logreplay [--eps C] [--max MS] (<log.csv> | --synthetic SECONDS)\n");
+  return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  float       eps = 0.5f;            // SD_DEADBAND_C
+  uint32_t    maxIntervalMs = 10000; // SD_DEADBAND_MAX_INTERVAL_MS
+  long        synthetic = -1;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--eps") == 0 && i + 1 < argc) {
+      eps = strtof(argv[++i], nullptr);
+    } else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+      maxIntervalMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc) {
+      synthetic = strtol(argv[++i], nullptr, 10);
+    } else if (path == nullptr && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      return usage();
+    }
+  }
+  if ((path == nullptr) == (synthetic < 0)) return usage();
+
+  printf("eps=%.2f C, max_interval=%lu ms\n", static_cast<double>(eps),
+         static_cast<unsigned long>(maxIntervalMs));
+  Replay replay(eps, maxIntervalMs);
+  return (path != nullptr) ? replayCsv(path, replay)
+                           : replaySynthetic(static_cast<uint32_t>(synthetic), replay);
+}
@@ -0,0 +1,327 @@
+/**
+ * @file logseek.cpp
+ * @brief 時刻索引（*.idx、include/LogIndex.h）を使ったログの途中読み出しツール（ホスト PC 用）
+ *
+ * @details
+ * 指定した経過時間以降の行を、索引の二分探索で得たオフセットから読み出す。
+ * GB 級のログでも読むのは索引の O(log n) エントリと、同期点から目的の時刻
+ * までの高々 1 間隔（SD_INDEX_INTERVAL_RECORDS レコード）分だけ。
+ * CSV はそのままの行、BINARY / DELTA は logconv と同じ列構成の行を出力する。
+ *
+ * 索引が無い・壊れている・未確定（電源断後に復旧しきれなかった）場合、
+ * または --rebuild 指定時は、生ログを先頭から走査して索引を作り直して保存する。
+ *
+ * ビルド:
+ *   g++ -O2 -std=c++11 -I include tools/logseek.cpp -o logseek
+ *
+ * 使い方:
+ *   ./logseek DATA_0003.csv                  （索引の情報のみ表示）
+ *   ./logseek DATA_0003.bin 3:15:00          （経過 3:15:00 以降の 10 行）
+ *   ./logseek -n 100 DATA_0003.csv 11700000  （経過時間は ms でも指定可）
+ *   ./logseek --rebuild DATA_0003.bin        （索引を作り直す）
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "BinaryLog.h"
+#include "DeltaCodec.h"
+#include "LogIndex.h"
+#include "LogPrealloc.h"
+#include "LogRecovery.h"
+#include "RawCapture.h"
+
+namespace {
+
+const uint32_t DEFAULT_INTERVAL = 120;   // SD_INDEX_INTERVAL_RECORDS
+
+/**
+ * @brief ファイルを LogIndex / LogRecovery の Source として読む（読み出し回数を数える）
+ */
+struct FileSource {
+  FILE*         fp;
+  unsigned long reads;
+
+  size_t read(uint32_t offset, uint8_t* buf, size_t len) {
+    ++reads;
+    if (fseek(fp, static_cast<long>(offset), SEEK_SET) != 0) return 0;
+    return fread(buf, 1, len, fp);
+  }
+};
+
+/**
+ * @brief 生ログの形式と有効長
+ */
+struct LogInfo {
+  bool         binary;
+  BinLogHeader header;
+  uint32_t     validEnd;
+};
+
+bool readLogInfo(FileSource& src, uint32_t fileSize, LogInfo& info) {
+  alignas(4) uint8_t head[LogPrealloc::SECTOR_SIZE];
+  if (src.read(0, head, sizeof(head)) != sizeof(head)) return false;
+  uint32_t valid  = 0;
+  bool     closed = false;
+  info.binary = BinaryLog::decodeHeader(head, info.header);
+  if (info.binary) {
+    valid = info.header.validBytes;
+  } else if (!LogPrealloc::parseCsvHeaderSector(head, valid, closed)) {
+    valid = 0;   // 有効長マーカーの無い旧形式
+  }
+  info.validEnd = (valid > 0 && valid < fileSize) ? valid : fileSize;
+  return true;
+}
+
+std::string indexPathFor(const char* logPath) {
+  std::string path(logPath);
+  const size_t dot   = path.rfind('.');
+  const size_t slash = path.find_last_of("/\\");
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) path.resize(dot);
+  return path + ".idx";
+}
+
+/**
+ * @brief 生ログを先頭から走査して索引を作り直し、保存する
+ */
+bool rebuildIndex(FileSource& log, const LogInfo& info, uint32_t interval, const std::string& path,
+                  std::vector<LogIndexEntry>& entries) {
+  struct Collect {
+    std::vector<LogIndexEntry>* out;
+    void operator()(const LogIndexEntry& e) { out->push_back(e); }
+  } collect = {&entries};
+  entries.clear();
+  LogIndex::Builder builder(interval);
+  uint32_t seq = 0;
+  const uint32_t from = static_cast<uint32_t>(LogPrealloc::SECTOR_SIZE);
+  if (info.binary) {
+    LogIndex::scanBlocks(log, info.header, from, info.validEnd, seq, builder, collect);
+  } else {
+    LogIndex::scanCsv(log, from, info.validEnd, seq, builder, collect);
+  }
+
+  FILE* fp = fopen(path.c_str(), "wb");
+  if (fp == nullptr) return false;
+  LogIndexHeader h = {builder.interval(), static_cast<uint32_t>(entries.size()), 1,
+                      static_cast<uint8_t>(info.binary
+                          ? (info.header.encoding == BinaryLog::ENCODING_RECORDS ? 1 : 2) : 0)};
+  uint8_t head[LogIndex::HEADER_SIZE];
+  LogIndex::encodeHeader(h, head);
+  bool ok = fwrite(head, 1, sizeof(head), fp) == sizeof(head);
+  for (size_t i = 0; i < entries.size() && ok; ++i) {
+    uint8_t buf[LogIndex::ENTRY_SIZE];
+    LogIndex::encodeEntry(entries[i], buf);
+    ok = fwrite(buf, 1, sizeof(buf), fp) == sizeof(buf);
+  }
+  ok = (fclose(fp) == 0) && ok;
+  fprintf(stderr, "logseek: rebuilt %s (%lu entries, %lu records)\n", path.c_str(),
+          static_cast<unsigned long>(entries.size()), static_cast<unsigned long>(seq));
+  return ok;
+}
+
+/**
+ * @brief "H:MM:SS[.mmm]" / "M:SS" / ms の整数を経過時間 [ms] に
+ */
+bool parseTime(const char* s, uint32_t& ms) {
+  if (strchr(s, ':') == nullptr) {
+    char* end = nullptr;
+    ms = static_cast<uint32_t>(strtoul(s, &end, 10));
+    return end != s && *end == '\0';
+  }
+  double total = 0.0;
+  const char* p = s;
+  while (true) {
+    char* end = nullptr;
+    const double v = strtod(p, &end);
+    if (end == p) return false;
+    total = total * 60.0 + v;
+    if (*end == '\0') break;
+    if (*end != ':') return false;
+    p = end + 1;
+  }
+  ms = static_cast<uint32_t>(total * 1000.0 + 0.5);
+  return true;
+}
+
+/**
+ * @brief CSV: offset から読み、経過時間が target 以上の行を rows 行出力
+ */
+unsigned long printCsv(FILE* fp, uint32_t offset, uint32_t validEnd, uint32_t target,
+                       unsigned long rows) {
+  fseek(fp, static_cast<long>(offset), SEEK_SET);
+  char          line[LogRecovery::MAX_LINE + 2];
+  uint32_t      pos     = offset;
+  unsigned long printed = 0;
+  while (printed < rows && pos < validEnd && fgets(line, sizeof(line), fp) != nullptr) {
+    const size_t len = strlen(line);
+    pos += static_cast<uint32_t>(len);
+    if (line[0] == '#') continue;
+    size_t n = len;
+    while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) --n;
+    LogCheckpoint row;
+    if (!LogRecovery::parseCsvRow(line, n, row)) break;
+    if (row.elapsedMs < target) continue;
+    fwrite(line, 1, len, stdout);
+    ++printed;
+  }
+  return printed;
+}
+
+/**
+ * @brief BINARY / DELTA: offset のブロックから読み、経過時間が target 以上の行を rows 行出力
+ */
+unsigned long printBlocks(FILE* fp, const LogInfo& info, uint32_t offset, uint32_t target,
+                          unsigned long rows) {
+  fseek(fp, static_cast<long>(offset), SEEK_SET);
+  alignas(4) uint8_t block[BinaryLog::BLOCK_SIZE];
+  char          buf[112];
+  unsigned long printed = 0;
+  const bool    withMs  = info.header.schemaVersion >= 2;
+  for (uint32_t pos = offset; printed < rows && pos + BinaryLog::BLOCK_SIZE <= info.validEnd;
+       pos += static_cast<uint32_t>(BinaryLog::BLOCK_SIZE)) {
+    if (fread(block, 1, sizeof(block), fp) != sizeof(block)) break;
+    uint8_t  type  = 0;
+    uint16_t count = 0;
+    uint32_t seq   = 0;
+    if (BinaryLog::checkBlock(block, type, count, seq) != BinaryLog::BlockStatus::OK) break;
+    const uint8_t* payload = block + BinaryLog::BLOCK_HEADER_SIZE;
+    if (type == BinaryLog::BLOCK_DELTA) {
+      DeltaDecoder dec;
+      dec.reset(payload, BinaryLog::PAYLOAD_SIZE, count);
+      uint32_t t = 0;
+      int32_t  v = 0;
+      uint8_t  flags = 0;
+      const bool raw = (info.header.encoding == BinaryLog::ENCODING_RAW);
+      while (printed < rows && dec.next(t, v, flags)) {
+        if (t < target) continue;
+        const size_t n = raw ? RawCapture::formatRow(t, v, flags, info.header.quantumMilliC, buf)
+                             : formatDeltaRow(t, v, flags, info.header.quantumMilliC, buf);
+        fwrite(buf, 1, n, stdout);
+        ++printed;
+      }
+    } else if (type == BinaryLog::BLOCK_DATA) {
+      for (uint16_t i = 0; i < count && printed < rows; ++i) {
+        BinLogRecord r;
+        BinaryLog::decodeRecord(payload + i * BinaryLog::RECORD_SIZE, r, info.header.schemaVersion);
+        if (r.elapsedMs < target) continue;
+        fwrite(buf, 1, BinaryLog::formatCsvRow(r, buf, withMs), stdout);
+        ++printed;
+      }
+    }
+  }
+  return printed;
+}
+
+int usage() {
+  fprintf(stderr, "usage: logseek [--rebuild] [-n ROWS] <log.csv|log.bin> [H:MM:SS | ms]\n");
+  return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool          rebuild = false;
+  unsigned long rows    = 10;
+  const char*   logPath = nullptr;
+  const char*   timeArg = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--rebuild") == 0) {
+      rebuild = true;
+    } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      rows = strtoul(argv[++i], nullptr, 10);
+    } else if (argv[i][0] == '-') {
+      return usage();
+    } else if (logPath == nullptr) {
+      logPath = argv[i];
+    } else if (timeArg == nullptr) {
+      timeArg = argv[i];
+    } else {
+      return usage();
+    }
+  }
+  uint32_t target = 0;
+  if (logPath == nullptr || (timeArg != nullptr && !parseTime(timeArg, target))) return usage();
+
+  FILE* fp = fopen(logPath, "rb");
+  if (fp == nullptr) {
+    fprintf(stderr, "logseek: cannot open %s\n", logPath);
+    return 1;
+  }
+  fseek(fp, 0, SEEK_END);
+  const uint32_t fileSize = static_cast<uint32_t>(ftell(fp));
+  FileSource     log      = {fp, 0};
+  LogInfo        info;
+  if (!readLogInfo(log, fileSize, info)) {
+    fprintf(stderr, "logseek: %s is too short\n", logPath);
+    fclose(fp);
+    return 1;
+  }
+
+  // 索引を開く（使えなければ作り直す）
+  const std::string idxPath = indexPathFor(logPath);
+  std::vector<LogIndexEntry> rebuilt;
+  LogIndexHeader h   = {DEFAULT_INTERVAL, 0, 0, 0};
+  uint32_t       n   = 0;
+  FILE*          idx = rebuild ? nullptr : fopen(idxPath.c_str(), "rb");
+  FileSource     src = {idx, 0};
+  if (idx != nullptr) {
+    uint8_t head[LogIndex::HEADER_SIZE];
+    fseek(idx, 0, SEEK_END);
+    const uint32_t idxSize = static_cast<uint32_t>(ftell(idx));
+    if (src.read(0, head, sizeof(head)) == sizeof(head) && LogIndex::decodeHeader(head, h) &&
+        h.complete) {
+      n = LogIndex::entryCount(h, idxSize);
+    } else {
+      fprintf(stderr, "logseek: %s is %s\n", idxPath.c_str(),
+              LogIndex::decodeHeader(head, h) ? "incomplete" : "invalid");
+      fclose(idx);
+      idx = nullptr;
+    }
+  }
+  if (idx == nullptr) {
+    if (!rebuildIndex(log, info, h.interval, idxPath, rebuilt)) {
+      fprintf(stderr, "logseek: cannot write %s\n", idxPath.c_str());
+    }
+    idx = fopen(idxPath.c_str(), "rb");
+    if (idx == nullptr) {
+      fclose(fp);
+      return 1;
+    }
+    src.fp = idx;
+    n      = static_cast<uint32_t>(rebuilt.size());
+  }
+
+  if (timeArg == nullptr) {
+    LogIndexEntry first, last;
+    printf("log             : %s (%s, %lu bytes valid)\n", logPath,
+           info.binary ? "binary" : "csv", static_cast<unsigned long>(info.validEnd));
+    printf("index           : %s\n", idxPath.c_str());
+    printf("interval        : %lu records\n", static_cast<unsigned long>(h.interval));
+    printf("entries         : %lu\n", static_cast<unsigned long>(n));
+    if (n > 0 && LogIndex::readEntry(src, 0, first) && LogIndex::readEntry(src, n - 1, last)) {
+      printf("first_ms        : %lu\n", static_cast<unsigned long>(first.elapsedMs));
+      printf("last_ms         : %lu (record %lu)\n", static_cast<unsigned long>(last.elapsedMs),
+             static_cast<unsigned long>(last.recordSeq));
+    }
+    fclose(idx);
+    fclose(fp);
+    return 0;
+  }
+
+  // 二分探索で同期点を引き、そこから目的の時刻まで読み飛ばす
+  src.reads = 0;
+  LogIndexEntry e = {0, static_cast<uint32_t>(LogPrealloc::SECTOR_SIZE), 0};
+  uint32_t      index = 0;
+  const bool    found = LogIndex::lookup(src, n, target, false, e, index);
+  fprintf(stderr, "logseek: %lu ms -> offset %lu (entry %lu/%lu, record %lu, %lu index reads)\n",
+          static_cast<unsigned long>(target), static_cast<unsigned long>(e.offset),
+          static_cast<unsigned long>(found ? index : 0), static_cast<unsigned long>(n),
+          static_cast<unsigned long>(e.recordSeq), src.reads);
+  const unsigned long printed = info.binary ? printBlocks(fp, info, e.offset, target, rows)
+                                            : printCsv(fp, e.offset, info.validEnd, target, rows);
+  fclose(idx);
+  fclose(fp);
+  return (printed > 0) ? 0 : 2;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file sdsim.cpp
+ * @brief 障害を注入した SD 上でログ経路の最悪時挙動を見積もるツール（ホスト PC 用）
+ *
+ * @details
+ * 実機と同じ SectorWriter（include/SectorWriter.h）を、遅延スパイク・短い書き込み・
+ * 失敗を注入する FaultyFile（include/FaultyFile.h）の上で動かす。
+ * 行は一定間隔で SD リング（SD_RING_DEPTH 行）に入り、書き込みタスクが
+ * 1 行ずつ append() + service() する、という実機の流れを模擬時計で回すため、
+ * 数時間分の RUN が一瞬で終わる。リング深さ・同期方針の既定値は SDConfig.h、
+ * 行は実機と同じ列構成（SdLogLayout、-DSD_LOG_LAYOUT_LEAN=1 で Lean）で整形する。
+ *
+ * 出力:
+ * - 行の遅れ（リングに入ってから書き終わるまで）の p50 / p99 / max
+ * - リングの最大使用数と、満杯で捨てた行数（実機では記録の欠け）
+ * - 操作ごとのレイテンシ（実機のシリアル 'p' の [SDLAT] 行と同じ形式）
+ *
+ * ビルド:
+ *   g++ -O2 -std=c++11 -I include tools/sdsim.cpp -o sdsim
+ *
+ * 使い方:
+ *   ./sdsim                                   （1 時間、500ms 周期、障害無し）
+ *   ./sdsim --hours 8 --spike 5 --spike-ms 800 （0.5% の操作が最大 800ms 止まる）
+ *   ./sdsim --short 1 --fail 1 --seed 7        （短い書き込み・失敗を 0.1% ずつ）
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "FaultyFile.h"
+#include "SectorWriter.h"
+#include "SDConfig.h"
+#include "LogSchema.h"
+
+namespace {
+
+const uint32_t RING_DEPTH = static_cast<uint32_t>(SD_RING_DEPTH);
+
+/**
+ * @brief 模擬に使う 1 行（実機と同じ列構成 SdLogLayout で、RUN 中の典型的な値を整形）
+ */
+size_t sampleRow(char* buf) {
+  SDData d;
+  d.elapsedSeconds = 1234;
+  d.elapsedMs      = 1234500;
+  d.temperature    = 540.2f;
+  d.state          = "RUN";
+  d.sampleCount    = 2469;
+  d.averageTemp    = 538.7f;
+  d.stdDev         = 1.3f;
+  d.maxTemp        = 545.0f;
+  d.minTemp        = 531.9f;
+  d.hiAlarm        = false;
+  d.loAlarm        = false;
+  d.wallMs         = WallClock::toEpochSec(CivilTime{2026, 10, 19, 12, 0, 0}) * 1000 + 500;
+  return SdLogLayout::formatRow(d, buf);
+}
+
+struct Options {
+  double    hours;
+  uint32_t  rateMs;
+  uint32_t  syncIntervalMs;
+  uint32_t  syncBytes;
+  FaultPlan plan;
+};
+
+/**
+ * @brief 模擬結果
+ */
+struct Result {
+  uint32_t         rows;
+  uint32_t         dropped;      // リング満杯で捨てた行
+  uint32_t         errors;       // append() / service() の失敗
+  uint32_t         maxDepth;     // リングの最大使用数
+  uint32_t         rowBytes;     // 1 行の長さ
+  LatencyHistogram rowDelayUs;   // リングに入ってから書き終わるまで
+
+  Result() : rows(0), dropped(0), errors(0), maxDepth(0), rowBytes(0) {}
+};
+
+/**
+ * @brief 書き込みタスクを模擬
+ *
+ * @details
+ * 行 i は i × rateMs に到着し、書き込みタスクが空いていれば即座に、そうでなければ
+ * 前の行が終わってから処理される。到着時点で未処理の行が RING_DEPTH 個あれば
+ * 捨てる（実機の SDWriter::post() が満杯で失敗するのと同じ）。
+ */
+void simulate(const Options& opt, FaultyFile& file, SectorWriter<FaultyFile>& writer, Result& res) {
+  const uint64_t rows = static_cast<uint64_t>(opt.hours * 3600000.0 / opt.rateMs);
+  char row[SdLogLayout::MAX_ROW];
+  const size_t rowLen = sampleRow(row);
+  res.rowBytes = static_cast<uint32_t>(rowLen);
+
+  // 処理待ち行の到着時刻（リング）
+  static uint64_t queue[RING_DEPTH];
+  uint32_t head = 0;
+  uint32_t count = 0;
+
+  for (uint64_t i = 0; i <= rows; ++i) {
+    const uint64_t arrival = i * static_cast<uint64_t>(opt.rateMs) * 1000;
+    // 次の到着までに書き込みタスクが処理できる行を処理する
+    while (count > 0 && (file.nowUs() < arrival || i == rows)) {
+      const uint64_t start = queue[head];
+      file.advanceTo(start);
+      if (!writer.append(row, rowLen)) res.errors++;
+      if (!writer.service(static_cast<uint32_t>(file.nowUs() / 1000))) res.errors++;
+      res.rowDelayUs.record(static_cast<uint32_t>(file.nowUs() - start));
+      head = (head + 1) % RING_DEPTH;
+      count--;
+    }
+    if (i == rows) break;
+
+    res.rows++;
+    if (count == RING_DEPTH) {
+      res.dropped++;
+      continue;
+    }
+    queue[(head + count) % RING_DEPTH] = arrival;
+    count++;
+    if (count > res.maxDepth) res.maxDepth = count;
+  }
+  if (!writer.sync(static_cast<uint32_t>(file.nowUs() / 1000))) res.errors++;
+}
+
+void printHistogram(const char* name, const LatencyHistogram& h) {
+  printf("%-9s n=%lu p50_us=%lu p99_us=%lu max_us=%lu\n", name,
+         static_cast<unsigned long>(h.count()), static_cast<unsigned long>(h.percentile(500)),
+         static_cast<unsigned long>(h.percentile(990)), static_cast<unsigned long>(h.max()));
+}
+
+int usage() {
+  fprintf(stderr,
+          "usage: sdsim [--hours H] [--rate MS] [--sync-ms MS] [--sync-bytes N]\n"
+          "             [--spike PERMILLE] [--spike-ms MS] [--short PERMILLE]\n"
+          "             [--fail PERMILLE] [--fail-after OPS] [--seed N]\n");
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opt;
+  opt.hours          = 1.0;
+  opt.rateMs         = 500;
+  opt.syncIntervalMs = SD_SYNC_INTERVAL_MS;
+  opt.syncBytes      = SD_SYNC_BYTES;
+  for (int i = 1; i < argc; ++i) {
+    const bool hasArg = i + 1 < argc;
+    if (strcmp(argv[i], "--hours") == 0 && hasArg) {
+      opt.hours = strtod(argv[++i], nullptr);
+    } else if (strcmp(argv[i], "--rate") == 0 && hasArg) {
+      opt.rateMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--sync-ms") == 0 && hasArg) {
+      opt.syncIntervalMs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--sync-bytes") == 0 && hasArg) {
+      opt.syncBytes = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--spike") == 0 && hasArg) {
+      opt.plan.spikePermille = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--spike-ms") == 0 && hasArg) {
+      opt.plan.spikeUs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)) * 1000;
+    } else if (strcmp(argv[i], "--short") == 0 && hasArg) {
+      opt.plan.shortWritePermille = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--fail") == 0 && hasArg) {
+      opt.plan.failPermille = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--fail-after") == 0 && hasArg) {
+      opt.plan.failAfterOps = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (strcmp(argv[i], "--seed") == 0 && hasArg) {
+      opt.plan.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else {
+      return usage();
+    }
+  }
+  if (opt.rateMs == 0 || opt.hours <= 0.0) return usage();
+  if (opt.plan.spikePermille > 0 && opt.plan.spikeUs == 0) opt.plan.spikeUs = 500000;
+
+  SdLatency                lat;
+  FaultyFile               file(opt.plan, &lat);
+  SectorWriter<FaultyFile> writer(file, opt.syncIntervalMs, opt.syncBytes);
+  Result                   res;
+  if (!file.open()) {
+    printf("open failed\n");
+    return 1;
+  }
+  writer.reset(0);
+  simulate(opt, file, writer, res);
+  file.close();
+
+  printf("%.2f h, row every %lu ms (%lu B), sync %lu ms / %lu B, ring %lu rows\n", opt.hours,
+         static_cast<unsigned long>(opt.rateMs), static_cast<unsigned long>(res.rowBytes),
+         static_cast<unsigned long>(opt.syncIntervalMs), static_cast<unsigned long>(opt.syncBytes),
+         static_cast<unsigned long>(RING_DEPTH));
+  printf("rows=%lu dropped=%lu errors=%lu ring_max=%lu\n", static_cast<unsigned long>(res.rows),
+         static_cast<unsigned long>(res.dropped), static_cast<unsigned long>(res.errors),
+         static_cast<unsigned long>(res.maxDepth));
+  printf("injected: ops=%lu spikes=%lu short=%lu failed=%lu\n",
+         static_cast<unsigned long>(file.stats().ops), static_cast<unsigned long>(file.stats().spikes),
+         static_cast<unsigned long>(file.stats().shortWrites),
+         static_cast<unsigned long>(file.stats().failures));
+  printHistogram("row_delay", res.rowDelayUs);
+  char line[112];
+  for (size_t i = 0; i < SdLatency::OPS; ++i) {
+    lat.formatLine(static_cast<SdOp>(i), line, sizeof(line));
+    printf("[SDLAT] %s\n", line);
+  }
+  return (res.dropped > 0 || res.errors > 0) ? 1 : 0;
+}